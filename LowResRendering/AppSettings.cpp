@@ -34,6 +34,7 @@ namespace AppSettings
     DirectionSetting SunDirection;
     FloatSetting SunAzimuth;
     FloatSetting SunElevation;
+    BoolSetting BakedSunShadows;
     FloatSetting Turbidity;
     ColorSetting GroundAlbedo;
     MSAAModesSetting MSAAMode;
@@ -44,6 +45,10 @@ namespace AppSettings
     FloatSetting DiffuseIntensity;
     FloatSetting Roughness;
     FloatSetting SpecularIntensity;
+    BoolSetting EnableClusterCulling;
+    BoolSetting EnableLODs;
+    FloatSetting LODErrorThreshold;
+    FloatSetting ShadowLODBias;
     IntSetting NumParticles;
     FloatSetting EmitRadius;
     FloatSetting EmitCenterX;
@@ -65,6 +70,7 @@ namespace AppSettings
     FloatSetting BloomBlurSigma;
     BoolSetting EnableVSync;
     Button TakeScreenshot;
+    BoolSetting CaptureFrames;
     BoolSetting ShowMSAAEdges;
 
     ConstantBuffer<AppSettingsCBuffer> CBuffer;
@@ -103,6 +109,9 @@ namespace AppSettings
         SunElevation.Initialize(tweakBar, "SunElevation", "Sun Light", "Sun Elevation", "Elevation of sun from ground. 0 degrees is aligned on the horizon while 90 degrees is directly overhead", 0.0000f, 0.0000f, 90.0000f, 0.0100f, ConversionMode::None, 1.0000f);
         Settings.AddSetting(&SunElevation);
 
+        BakedSunShadows.Initialize(tweakBar, "BakedSunShadows", "Sun Light", "Baked Sun Shadows", "Shadows the scene with a single static shadow map that's baked on the CPU and cached on disk, instead of rendering the cascades every frame. The map is re-baked when the sun direction changes.", false);
+        Settings.AddSetting(&BakedSunShadows);
+
         Turbidity.Initialize(tweakBar, "Turbidity", "Sky", "Turbidity", "Atmospheric turbidity (thickness) uses for procedural sun and sky model", 2.0000f, 1.0000f, 10.0000f, 0.0100f, ConversionMode::None, 1.0000f);
         Settings.AddSetting(&Turbidity);
 
@@ -133,6 +142,18 @@ namespace AppSettings
         SpecularIntensity.Initialize(tweakBar, "SpecularIntensity", "Scene", "Specular Intensity", "Specular intensity parameter for the material", 0.0400f, 0.0000f, 1.0000f, 0.0010f, ConversionMode::None, 1.0000f);
         Settings.AddSetting(&SpecularIntensity);
 
+        EnableClusterCulling.Initialize(tweakBar, "EnableClusterCulling", "Scene", "Enable Cluster Culling", "Culls meshlets against the view frustum and by their normal cones before drawing", true);
+        Settings.AddSetting(&EnableClusterCulling);
+
+        EnableLODs.Initialize(tweakBar, "EnableLODs", "Scene", "Enable LODs", "Draws simplified LODs for mesh parts whose simplification error is small enough on screen", true);
+        Settings.AddSetting(&EnableLODs);
+
+        LODErrorThreshold.Initialize(tweakBar, "LODErrorThreshold", "Scene", "LOD Error Threshold", "The largest simplification error allowed for a LOD, in pixels", 1.0000f, 0.0000f, 16.0000f, 0.1000f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&LODErrorThreshold);
+
+        ShadowLODBias.Initialize(tweakBar, "ShadowLODBias", "Scene", "Shadow LOD Bias", "Scales the LOD error threshold for the shadow cascades, so that they use coarser LODs", 4.0000f, 1.0000f, 16.0000f, 0.1000f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&ShadowLODBias);
+
         NumParticles.Initialize(tweakBar, "NumParticles", "Particles", "Num Particles (x1024)", "The number of particles to render, in increments of 1024", 8, 0, 32);
         Settings.AddSetting(&NumParticles);
 
@@ -197,6 +218,9 @@ namespace AppSettings
         TakeScreenshot.Initialize(tweakBar, "TakeScreenshot", "Debug", "Take Screenshot", "Captures the screen output (before HUD rendering), and saves it to a file");
         Settings.AddSetting(&TakeScreenshot);
 
+        CaptureFrames.Initialize(tweakBar, "CaptureFrames", "Debug", "Capture Frames", "Saves every frame (before HUD rendering) to a numbered PNG file in the Captures directory, without waiting on the readback or the encoding", false);
+        Settings.AddSetting(&CaptureFrames);
+
         ShowMSAAEdges.Initialize(tweakBar, "ShowMSAAEdges", "Debug", "Show MSAAEdges", "When using MSAA low-res render mode, shows pixels that use subpixel data", false);
         Settings.AddSetting(&ShowMSAAEdges);
 
@@ -85,6 +85,10 @@ public class Settings
         [MinValue(0.0f)]
         [MaxValue(90.0f)]
         float SunElevation;
+
+        [HelpText("Shadows the scene with a single static shadow map that's baked on the CPU and cached on disk, instead of rendering the cascades every frame. The map is re-baked when the sun direction changes.")]
+        [UseAsShaderConstant(false)]
+        bool BakedSunShadows = false;
     }
 
     [ExpandGroup(false)]
@@ -153,6 +157,32 @@ public class Settings
         [StepSize(0.001f)]
         [HelpText("Specular intensity parameter for the material")]
         float SpecularIntensity = 0.04f;
+
+        [DisplayName("Enable Cluster Culling")]
+        [UseAsShaderConstant(false)]
+        [HelpText("Culls meshlets against the view frustum and by their normal cones before drawing")]
+        bool EnableClusterCulling = true;
+
+        [DisplayName("Enable LODs")]
+        [UseAsShaderConstant(false)]
+        [HelpText("Draws simplified LODs for mesh parts whose simplification error is small enough on screen")]
+        bool EnableLODs = true;
+
+        [DisplayName("LOD Error Threshold")]
+        [MinValue(0.0f)]
+        [MaxValue(16.0f)]
+        [StepSize(0.1f)]
+        [UseAsShaderConstant(false)]
+        [HelpText("The largest simplification error allowed for a LOD, in pixels")]
+        float LODErrorThreshold = 1.0f;
+
+        [DisplayName("Shadow LOD Bias")]
+        [MinValue(1.0f)]
+        [MaxValue(16.0f)]
+        [StepSize(0.1f)]
+        [UseAsShaderConstant(false)]
+        [HelpText("Scales the LOD error threshold for the shadow cascades, so that they use coarser LODs")]
+        float ShadowLODBias = 4.0f;
     }
 
     const int MaxParticles = 1024 * 32;
@@ -273,6 +303,11 @@ public class Settings
         [HelpText("Captures the screen output (before HUD rendering), and saves it to a file")]
         Button TakeScreenshot;
 
+        [DisplayName("Capture Frames")]
+        [UseAsShaderConstant(false)]
+        [HelpText("Saves every frame (before HUD rendering) to a numbered PNG file in the Captures directory, without waiting on the readback or the encoding")]
+        bool CaptureFrames = false;
+
         [HelpText("When using MSAA low-res render mode, shows pixels that use subpixel data")]
         bool ShowMSAAEdges = false;
     }
@@ -52,6 +52,7 @@ namespace AppSettings
     extern DirectionSetting SunDirection;
     extern FloatSetting SunAzimuth;
     extern FloatSetting SunElevation;
+    extern BoolSetting BakedSunShadows;
     extern FloatSetting Turbidity;
     extern ColorSetting GroundAlbedo;
     extern MSAAModesSetting MSAAMode;
@@ -62,6 +63,10 @@ namespace AppSettings
     extern FloatSetting DiffuseIntensity;
     extern FloatSetting Roughness;
     extern FloatSetting SpecularIntensity;
+    extern BoolSetting EnableClusterCulling;
+    extern BoolSetting EnableLODs;
+    extern FloatSetting LODErrorThreshold;
+    extern FloatSetting ShadowLODBias;
     extern IntSetting NumParticles;
     extern FloatSetting EmitRadius;
     extern FloatSetting EmitCenterX;
@@ -83,6 +88,7 @@ namespace AppSettings
     extern FloatSetting BloomBlurSigma;
     extern BoolSetting EnableVSync;
     extern Button TakeScreenshot;
+    extern BoolSetting CaptureFrames;
     extern BoolSetting ShowMSAAEdges;
 
     struct AppSettingsCBuffer
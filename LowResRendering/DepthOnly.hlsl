@@ -18,6 +18,14 @@ cbuffer VSConstants : register(b0)
     float4x4 WorldViewProjection;
 }
 
+#if CompressedVertices_
+cbuffer MeshDecodeConstants : register(b2)
+{
+    float3 PositionScale;
+    float3 PositionBias;
+}
+#endif
+
 // ================================================================================================
 // Input/Output structs
 // ================================================================================================
@@ -38,8 +46,15 @@ VSOutput VS(in VSInput input)
 {
     VSOutput output;
 
+    #if CompressedVertices_
+        // Compressed positions are 16-bit UNORM, relative to the mesh bounds
+        float3 positionOS = input.PositionOS.xyz * PositionScale + PositionBias;
+    #else
+        float3 positionOS = input.PositionOS.xyz;
+    #endif
+
     // Calc the clip-space position
-    output.PositionCS = mul(input.PositionOS, WorldViewProjection);
+    output.PositionCS = mul(float4(positionOS, 1.0f), WorldViewProjection);
 
     return output;
 }
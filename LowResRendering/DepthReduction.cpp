@@ -0,0 +1,73 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include "DepthReduction.h"
+#include "DepthReductionKernel.h"
+
+#include <Assert.h>
+#include <ThreadPool.h>
+
+// Number of texels processed per ParallelFor work item
+static const uint64 ReductionGrainSize = 64 * 1024;
+
+Float2 ReduceRawDepthCPU(const float* depthTexels, uint64 numTexels)
+{
+    const uint32 numThreads = NumWorkerThreads();
+    std::vector<Float2> threadResults(numThreads, Float2(1.0f, -1.0f));
+
+    ParallelFor(numTexels, ReductionGrainSize, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        Float2& result = threadResults[threadIdx];
+        ReduceRawDepthRange(depthTexels + start, end - start, result.x, result.y);
+    });
+
+    Float2 result = Float2(1.0f, -1.0f);
+    for(uint32 i = 0; i < numThreads; ++i)
+    {
+        result.x = std::min(result.x, threadResults[i].x);
+        result.y = std::max(result.y, threadResults[i].y);
+    }
+
+    return result;
+}
+
+Float2 ReduceDepthCPU(const TextureData<float>& depthData, const Float4x4& projection,
+                      float nearClip, float farClip, uint32 numSamples)
+{
+    const uint64 numTexels = uint64(depthData.Width) * depthData.Height * std::max<uint32>(numSamples, 1);
+    Assert_(depthData.Texels.size() >= numTexels);
+
+    Float2 rawDepth = ReduceRawDepthCPU(depthData.Texels.data(), numTexels);
+    if(rawDepth.y < 0.0f)
+        return Float2(1.0f, 0.0f);
+
+    // The conversion to linear depth is monotonic, so it only needs to be done for the final
+    // min and max instead of for every texel
+    const float clipRange = farClip - nearClip;
+    float minDepth = 0.0f;
+    float maxDepth = 0.0f;
+    if(projection._44 == 1.0f)
+    {
+        // Orthographic projections store a linear depth that's just scaled and biased
+        minDepth = (rawDepth.x - projection._43) / projection._33;
+        maxDepth = (rawDepth.y - projection._43) / projection._33;
+    }
+    else
+    {
+        minDepth = projection._43 / (rawDepth.x - projection._33);
+        maxDepth = projection._43 / (rawDepth.y - projection._33);
+    }
+    minDepth = Saturate((minDepth - nearClip) / clipRange);
+    maxDepth = Saturate((maxDepth - nearClip) / clipRange);
+
+    return Float2(std::min(minDepth, maxDepth), std::max(minDepth, maxDepth));
+}
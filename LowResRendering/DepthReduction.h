@@ -0,0 +1,33 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include <SF11_Math.h>
+#include <Graphics/Textures.h>
+
+using namespace SampleFramework11;
+
+// CPU equivalent of the DepthReductionInitialCS/DepthReductionCS chain in DepthReduction.hlsl.
+// Computes the min/max depth of a depth buffer that's been read back to the CPU, and converts
+// the result to linear depth normalized to [NearClip, FarClip] the same way that the shader
+// does. Texels with a depth of 1.0 are skipped. Returns (1, 0) if every texel was skipped.
+// Both perspective and orthographic projections are supported.
+//
+// MSAA depth buffers can be passed with the samples either interleaved per-pixel or stored as
+// separate array slices, since min/max doesn't depend on the order of the texels.
+Float2 ReduceDepthCPU(const TextureData<float>& depthData, const Float4x4& projection,
+                      float nearClip, float farClip, uint32 numSamples = 1);
+
+// Returns the min/max of the raw (non-linear) depth values, skipping texels with a depth of 1.0.
+// Returns (1, -1) if every texel was skipped.
+Float2 ReduceRawDepthCPU(const float* depthTexels, uint64 numTexels);
@@ -0,0 +1,58 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "DepthReductionKernel.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+
+// Uses SSE with 4 independent accumulators to hide the latency of the min/max instructions
+void ReduceRawDepthRange(const float* texels, uint64_t numTexels, float& minDepth, float& maxDepth)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 skipped = _mm_set1_ps(-1.0f);
+
+    __m128 mins[4] = { one, one, one, one };
+    __m128 maxes[4] = { skipped, skipped, skipped, skipped };
+
+    // The GPU version ignores depth == 1.0, which only matters for the max since nothing
+    // can be greater than 1.0
+    uint64_t i = 0;
+    for(; i + 16 <= numTexels; i += 16)
+    {
+        for(uint64_t j = 0; j < 4; ++j)
+        {
+            const __m128 depth = _mm_loadu_ps(texels + i + j * 4);
+            const __m128 valid = _mm_cmplt_ps(depth, one);
+            mins[j] = _mm_min_ps(mins[j], depth);
+            maxes[j] = _mm_max_ps(maxes[j], _mm_or_ps(_mm_and_ps(valid, depth), _mm_andnot_ps(valid, skipped)));
+        }
+    }
+
+    const __m128 minVec = _mm_min_ps(_mm_min_ps(mins[0], mins[1]), _mm_min_ps(mins[2], mins[3]));
+    const __m128 maxVec = _mm_max_ps(_mm_max_ps(maxes[0], maxes[1]), _mm_max_ps(maxes[2], maxes[3]));
+
+    float minVals[4];
+    float maxVals[4];
+    _mm_storeu_ps(minVals, minVec);
+    _mm_storeu_ps(maxVals, maxVec);
+    minDepth = std::min(minDepth, std::min(std::min(minVals[0], minVals[1]), std::min(minVals[2], minVals[3])));
+    maxDepth = std::max(maxDepth, std::max(std::max(maxVals[0], maxVals[1]), std::max(maxVals[2], maxVals[3])));
+
+    for(; i < numTexels; ++i)
+    {
+        const float depth = texels[i];
+        minDepth = std::min(minDepth, depth);
+        if(depth < 1.0f)
+            maxDepth = std::max(maxDepth, depth);
+    }
+}
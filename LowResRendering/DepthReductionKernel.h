@@ -0,0 +1,22 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// This header is platform-neutral, and doesn't include PCH.h, so that the reduction can be
+// benchmarked on its own (see Tests/DepthReductionBenchmark.cpp)
+
+#include <stdint.h>
+
+// Reduces a contiguous run of raw (non-linear) depth texels on a single thread, and folds the
+// result into minDepth and maxDepth. Texels with a depth of 1.0 are skipped for the max, the same
+// way that DepthReduction.hlsl skips them. Start with (1, -1) to be able to tell when every texel
+// was skipped.
+void ReduceRawDepthRange(const float* texels, uint64_t numTexels, float& minDepth, float& maxDepth);
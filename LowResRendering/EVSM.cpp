@@ -0,0 +1,234 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include "EVSM.h"
+
+#include <Assert.h>
+#include <ThreadPool.h>
+
+// Number of rows processed per ParallelFor work item
+static const uint64 RowsPerWorkItem = 8;
+
+// XMVectorExp computes 2^x, so scale by log2(e) to get e^x
+static const float Log2E = 1.44269504f;
+
+Float2 GetEVSMExponents(float positiveExponent, float negativeExponent, const Float3& cascadeScale)
+{
+    const float maxExponent = 42.0f;
+
+    // Make sure exponents say consistent in light space regardless of partition
+    // scaling. This prevents the exponentials from ever getting too rediculous
+    // and maintains consistency across partitions.
+    // Clamp to maximum range of fp32/fp16 to prevent overflow/underflow
+    Float2 lightSpaceExponents = Float2(positiveExponent, negativeExponent);
+    return Float2(std::min(lightSpaceExponents.x / cascadeScale.z, maxExponent),
+                  std::min(lightSpaceExponents.y / cascadeScale.z, maxExponent));
+}
+
+Float2 WarpDepth(float depth, Float2 exponents)
+{
+    // Rescale depth into [-1, 1]
+    depth = 2.0f * depth - 1.0f;
+    float pos =  std::exp( exponents.x * depth);
+    float neg = -std::exp(-exponents.y * depth);
+    return Float2(pos, neg);
+}
+
+// Computes the moments for 4 depth values at once, and returns them transposed so that
+// each row is the (pos, neg, pos^2, neg^2) of a single depth value
+static XMMATRIX WarpDepth4(XMVECTOR depth, XMVECTOR posScale, XMVECTOR negScale)
+{
+    depth = XMVectorMultiplyAdd(depth, XMVectorReplicate(2.0f), XMVectorReplicate(-1.0f));
+    XMVECTOR pos = XMVectorExp(XMVectorMultiply(depth, posScale));
+    XMVECTOR neg = XMVectorNegate(XMVectorExp(XMVectorMultiply(depth, negScale)));
+
+    XMMATRIX moments;
+    moments.r[0] = pos;
+    moments.r[1] = neg;
+    moments.r[2] = XMVectorMultiply(pos, pos);
+    moments.r[3] = XMVectorMultiply(neg, neg);
+    return XMMatrixTranspose(moments);
+}
+
+void ConvertToEVSMCPU(const float* depthTexels, uint32 numSamples, const Float3& cascadeScale,
+                      float positiveExponent, float negativeExponent,
+                      TextureData<Float4>& evsmMap, const EVSMRegion& region)
+{
+    Assert_(depthTexels != nullptr);
+    Assert_(region.Slice < evsmMap.NumSlices);
+    Assert_(region.Rect.X + region.Rect.Width <= evsmMap.Width);
+    Assert_(region.Rect.Y + region.Rect.Height <= evsmMap.Height);
+
+    numSamples = std::max<uint32>(numSamples, 1);
+    const Float2 exponents = GetEVSMExponents(positiveExponent, negativeExponent, cascadeScale);
+    const XMVECTOR posScale = XMVectorReplicate(exponents.x * Log2E);
+    const XMVECTOR negScale = XMVectorReplicate(-exponents.y * Log2E);
+    const XMVECTOR sampleWeight = XMVectorReplicate(1.0f / numSamples);
+
+    const uint32 width = region.Rect.Width;
+    const uint64 sliceOffset = uint64(evsmMap.Width) * evsmMap.Height * region.Slice;
+
+    ParallelFor(region.Rect.Height, RowsPerWorkItem, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        for(uint64 y = startRow; y < endRow; ++y)
+        {
+            const float* srcRow = depthTexels + y * width * numSamples;
+            Float4* dstRow = &evsmMap.Texels[sliceOffset + (region.Rect.Y + y) * evsmMap.Width + region.Rect.X];
+
+            if(numSamples == 1)
+            {
+                uint32 x = 0;
+                for(; x + 4 <= width; x += 4)
+                {
+                    XMVECTOR depth = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(srcRow + x));
+                    XMMATRIX moments = WarpDepth4(depth, posScale, negScale);
+                    for(uint32 i = 0; i < 4; ++i)
+                        XMStoreFloat4(&dstRow[x + i], moments.r[i]);
+                }
+
+                for(; x < width; ++x)
+                {
+                    Float2 warpedDepth = WarpDepth(srcRow[x], exponents);
+                    dstRow[x] = Float4(warpedDepth.x, warpedDepth.y, warpedDepth.x * warpedDepth.x,
+                                       warpedDepth.y * warpedDepth.y);
+                }
+            }
+            else
+            {
+                for(uint32 x = 0; x < width; ++x)
+                {
+                    const float* samples = srcRow + x * numSamples;
+                    XMVECTOR average = XMVectorZero();
+
+                    uint32 s = 0;
+                    for(; s + 4 <= numSamples; s += 4)
+                    {
+                        XMVECTOR depth = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples + s));
+                        XMMATRIX moments = WarpDepth4(depth, posScale, negScale);
+                        average = XMVectorAdd(average, XMVectorAdd(XMVectorAdd(moments.r[0], moments.r[1]),
+                                                                   XMVectorAdd(moments.r[2], moments.r[3])));
+                    }
+
+                    for(; s < numSamples; ++s)
+                    {
+                        Float2 warpedDepth = WarpDepth(samples[s], exponents);
+                        average = XMVectorAdd(average, XMVectorSet(warpedDepth.x, warpedDepth.y,
+                                                                   warpedDepth.x * warpedDepth.x,
+                                                                   warpedDepth.y * warpedDepth.y));
+                    }
+
+                    XMStoreFloat4(&dstRow[x], XMVectorMultiply(average, sampleWeight));
+                }
+            }
+        }
+    });
+}
+
+// Builds normalized filter weights for taps in [-radius, radius]
+static int32 ComputeFilterWeights(float filterSize, EVSMFilterMode filterMode, std::vector<float>& weights)
+{
+    const float radius = filterSize / 2.0f;
+    const int32 sampleRadius = int32(radius + 0.499f);
+    weights.resize(sampleRadius * 2 + 1);
+
+    float weightSum = 0.0f;
+    for(int32 i = -sampleRadius; i <= sampleRadius; ++i)
+    {
+        float weight = 0.0f;
+        if(filterMode == EVSMFilterMode::Box)
+        {
+            // Same as BlurEVSM, which gives partial weights to the outer samples
+            // for fractional filter sizes
+            weight = Saturate((radius + 0.5f) - std::abs(float(i)));
+        }
+        else
+        {
+            // Fit +/- 3 standard deviations into the filter
+            const float sigma = std::max(filterSize / 6.0f, 0.0001f);
+            weight = std::exp(-(i * i) / (2.0f * sigma * sigma));
+        }
+
+        weights[i + sampleRadius] = weight;
+        weightSum += weight;
+    }
+
+    for(uint64 i = 0; i < weights.size(); ++i)
+        weights[i] /= weightSum;
+
+    return sampleRadius;
+}
+
+void BlurEVSMCPU(TextureData<Float4>& evsmMap, const EVSMRegion& region, Float2 filterSize,
+                 EVSMFilterMode filterMode)
+{
+    Assert_(region.Slice < evsmMap.NumSlices);
+    Assert_(region.Rect.X + region.Rect.Width <= evsmMap.Width);
+    Assert_(region.Rect.Y + region.Rect.Height <= evsmMap.Height);
+
+    const int32 width = int32(region.Rect.Width);
+    const int32 height = int32(region.Rect.Height);
+    const uint64 sliceOffset = uint64(evsmMap.Width) * evsmMap.Height * region.Slice;
+    const uint64 rowPitch = evsmMap.Width;
+    Float4* regionTexels = &evsmMap.Texels[sliceOffset + region.Rect.Y * rowPitch + region.Rect.X];
+
+    std::vector<Float4> temp(uint64(width) * height);
+    std::vector<float> weights;
+
+    // Horizontal pass, from the map to the temporary buffer
+    int32 sampleRadius = ComputeFilterWeights(std::max(filterSize.x, 1.0f), filterMode, weights);
+    ParallelFor(height, RowsPerWorkItem, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        for(uint64 y = startRow; y < endRow; ++y)
+        {
+            const Float4* srcRow = regionTexels + y * rowPitch;
+            Float4* dstRow = &temp[y * width];
+            for(int32 x = 0; x < width; ++x)
+            {
+                XMVECTOR sum = XMVectorZero();
+                for(int32 i = -sampleRadius; i <= sampleRadius; ++i)
+                {
+                    const int32 sampleX = Clamp(x + i, 0, width - 1);
+                    XMVECTOR texel = XMLoadFloat4(&srcRow[sampleX]);
+                    sum = XMVectorMultiplyAdd(texel, XMVectorReplicate(weights[i + sampleRadius]), sum);
+                }
+
+                XMStoreFloat4(&dstRow[x], sum);
+            }
+        }
+    });
+
+    // Vertical pass, from the temporary buffer back to the map. Whole rows are accumulated at
+    // a time so that all of the memory accesses are sequential.
+    sampleRadius = ComputeFilterWeights(std::max(filterSize.y, 1.0f), filterMode, weights);
+    ParallelFor(height, RowsPerWorkItem, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        for(uint64 y = startRow; y < endRow; ++y)
+        {
+            Float4* dstRow = regionTexels + y * rowPitch;
+            for(int32 x = 0; x < width; ++x)
+                dstRow[x] = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+            for(int32 i = -sampleRadius; i <= sampleRadius; ++i)
+            {
+                const int32 sampleY = Clamp(int32(y) + i, 0, height - 1);
+                const Float4* srcRow = &temp[sampleY * width];
+                const XMVECTOR weight = XMVectorReplicate(weights[i + sampleRadius]);
+                for(int32 x = 0; x < width; ++x)
+                {
+                    XMVECTOR sum = XMLoadFloat4(&dstRow[x]);
+                    sum = XMVectorMultiplyAdd(XMLoadFloat4(&srcRow[x]), weight, sum);
+                    XMStoreFloat4(&dstRow[x], sum);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,80 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include <SF11_Math.h>
+#include <Serialization.h>
+#include <Graphics/Textures.h>
+#include <Graphics/AtlasAllocator.h>
+
+using namespace SampleFramework11;
+
+// CPU implementations of the helpers in EVSM.hlsl and the EVSMConvert.hlsl passes, for baking
+// the shadow maps of static geometry offline instead of converting and blurring every frame
+
+Float2 GetEVSMExponents(float positiveExponent, float negativeExponent, const Float3& cascadeScale);
+
+// Input depth should be in [0, 1]
+Float2 WarpDepth(float depth, Float2 exponents);
+
+enum class EVSMFilterMode
+{
+    Box,                // Matches BlurEVSM in EVSMConvert.hlsl
+    Gaussian,
+};
+
+// The part of an EVSM map that belongs to a single cascade. For a Texture2DArray-style map
+// this is a full array slice, for an atlas it's the cascade's rectangle in slice 0.
+struct EVSMRegion
+{
+    uint32 Slice = 0;
+    AtlasRect Rect;
+};
+
+// Converts a cascade's depth map to EVSM moments, and writes them to the given region. The
+// depth map must be the same size as the region, with MSAA samples stored consecutively
+// for each pixel. The samples are averaged, like ConvertToEVSM in EVSMConvert.hlsl.
+void ConvertToEVSMCPU(const float* depthTexels, uint32 numSamples, const Float3& cascadeScale,
+                      float positiveExponent, float negativeExponent,
+                      TextureData<Float4>& evsmMap, const EVSMRegion& region);
+
+// Separable blur of an EVSM region, clamping at the edges of the region. The filter
+// size is specified in texels.
+void BlurEVSMCPU(TextureData<Float4>& evsmMap, const EVSMRegion& region, Float2 filterSize,
+                 EVSMFilterMode filterMode = EVSMFilterMode::Box);
+
+// A pre-converted and pre-filtered EVSM map, which can be saved with a FileWriteSerializer and
+// uploaded with CreateSRVFromTextureData without any per-frame conversion cost. ShadowMatrix
+// goes from world space to the [0, 1] UV and depth space of the first region, and LightDirection
+// is the direction towards the light that the map was rendered with.
+struct BakedEVSM
+{
+    TextureData<Float4> Moments;
+    std::vector<EVSMRegion> Regions;
+    std::vector<Float4> CascadeScales;
+    float PositiveExponent = 0.0f;
+    float NegativeExponent = 0.0f;
+    Float4x4 ShadowMatrix;
+    Float3 LightDirection;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, Moments);
+        SerializeRawVector(serializer, Regions);
+        SerializeItem(serializer, CascadeScales);
+        SerializeItem(serializer, PositiveExponent);
+        SerializeItem(serializer, NegativeExponent);
+        SerializeRawArray(serializer, &ShadowMatrix, 1);
+        SerializeItem(serializer, LightDirection);
+    }
+};
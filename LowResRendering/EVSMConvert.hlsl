@@ -33,11 +33,7 @@
     Texture2D<float> ShadowMap : register(t0);
 #endif
 
-#if Vertical_
-    Texture2D EVSMMap : register(t0);
-#else
-    Texture2DArray EVSMMap : register(t0);
-#endif
+Texture2D EVSMMap : register(t0);
 
 cbuffer EVSMConstants : register(b0)
 {
@@ -46,6 +42,7 @@ cbuffer EVSMConstants : register(b0)
     float NegativeExponent;
     float FilterSize;
     float2 ShadowMapSize;
+    float2 AtlasOffset;
 }
 
 struct VSOutput
@@ -80,7 +77,7 @@ VSOutput FullScreenVS(in uint VertexID : SV_VertexID)
 float4 ConvertToEVSM(in VSOutput input) : SV_Target0
 {
     float sampleWeight = 1.0f / float(MSAASamples_);
-    uint2 coords = uint2(input.Position.xy);
+    uint2 coords = uint2(input.Position.xy - AtlasOffset);
 
     float2 exponents = GetEVSMExponents(PositiveExponent, NegativeExponent, CascadeScale);
 
@@ -104,16 +101,18 @@ float4 ConvertToEVSM(in VSOutput input) : SV_Target0
     return average;
 }
 
+// The horizontal pass reads from the cascade's region of the atlas and writes to the temporary
+// target, while the vertical pass reads from the temporary target and writes back to the atlas
 float4 BlurSample(in float2 screenPos, in float offset, in float2 mapSize)
 {
     #if Vertical_
-        float2 samplePos = screenPos;
-        samplePos.y = clamp(screenPos.y + offset, 0, mapSize.y);
+        float2 samplePos = screenPos - AtlasOffset;
+        samplePos.y = clamp(samplePos.y + offset, 0, mapSize.y - 1.0f);
         return EVSMMap[uint2(samplePos)];
     #else
         float2 samplePos = screenPos;
-        samplePos.x = clamp(screenPos.x + offset, 0, mapSize.x);
-        return EVSMMap[uint3(samplePos, 0)];
+        samplePos.x = clamp(samplePos.x + offset, 0, mapSize.x - 1.0f);
+        return EVSMMap[uint2(samplePos + AtlasOffset)];
     #endif
 }
 
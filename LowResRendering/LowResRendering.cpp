@@ -16,6 +16,7 @@
 #include <Window.h>
 #include <Input.h>
 #include <Utility.h>
+#include <FileIO.h>
 #include <Graphics/DeviceManager.h>
 #include <Graphics/ShaderCompilation.h>
 #include <Graphics/Profiler.h>
@@ -43,14 +44,30 @@ using std::wstring;
 static const float NearClip = 0.01f;
 static const float FarClip = 100.0f;
 
+// Scene meshes are imported with quantized positions, octahedral normals/tangents and half UVs
+static const bool CompressVertices = true;
+
+// Meshes with more than 64K vertices get split up so that they can still use 16-bit indices
+static const bool Force16BitIndices = true;
+
+// Each mesh part gets a chain of simplified LODs, which MeshRenderer picks from per view
+static const bool GenerateLODs = true;
+
+// Diffuse maps are compressed to BC7 and normal maps to BC5 when they're loaded, and the results are
+// cached as DDS files next to the source images
+static const TextureCompression DiffuseCompression = TextureCompression::BC7;
+static const TextureCompression NormalMapCompression = TextureCompression::BC5;
+
 // Model filenames
 static const wstring ModelPaths[] =
 {
     L"..\\Content\\Models\\Box\\Box_Grill.fbx",
 };
 
-// Saves the specified SRV as a PNG file, using a save file dialog to pick the path
-static void SavePNGScreenshot(HWND parentWindow, ID3D11Texture2D* texture)
+// Queues up a screenshot of the texture, using a save file dialog to pick the path. The readback
+// and encoding happen in the background, and errors are reported by FrameCapture::Update.
+static void SaveScreenshot(HWND parentWindow, FrameCapture& frameCapture, ID3D11DeviceContext* context,
+                           ID3D11Texture2D* texture)
 {
     wchar currDirectory[MAX_PATH] = { 0 };
     GetCurrentDirectory(ArraySize_(currDirectory), currDirectory);
@@ -63,7 +80,7 @@ static void SavePNGScreenshot(HWND parentWindow, ID3D11Texture2D* texture)
     ofn.hwndOwner = parentWindow;
     ofn.lpstrFile = filePath;
     ofn.nMaxFile = ArraySize_(filePath);
-    ofn.lpstrFilter = L"All Files (*.*)\0*.*\0PNG Files (*.png)\0*.png\0";
+    ofn.lpstrFilter = L"All Files (*.*)\0*.*\0PNG Files (*.png)\0*.png\0EXR Files (*.exr)\0*.exr\0";
     ofn.nFilterIndex = 2;
     ofn.lpstrFileTitle = nullptr;
     ofn.nMaxFileTitle = 0;
@@ -75,23 +92,16 @@ static void SavePNGScreenshot(HWND parentWindow, ID3D11Texture2D* texture)
     SetCurrentDirectory(currDirectory);
 
     if(succeeded)
-    {
-        try
-        {
-            SaveTextureAsPNG(texture, filePath);
-        }
-        catch(Exception e)
-        {
-            std::wstring errorString = L"Error occured while saving screenshot as an EXR file:\n" + e.GetMessage();
-            MessageBox(parentWindow, errorString.c_str(), L"Error", MB_OK | MB_ICONERROR);
-        }
-    }
+        frameCapture.Capture(context, texture, filePath);
 }
 
 LowResRendering::LowResRendering() :  App(L"Low Resolution Rendering", MAKEINTRESOURCEW(IDI_DEFAULT)),
                                       camera(16.0f / 9.0f, Pi_4, NearClip, FarClip)
 {
     deviceManager.SetMinFeatureLevel(D3D_FEATURE_LEVEL_11_0);
+
+    // The scene model and its textures are created on loading threads
+    deviceManager.SetMultithreadedDevice(true);
     globalHelpText = "Low Resolution Rendering Sample\n\n"
                      "Demonstrates how to render half-resolution transparents using 4xMSAA "
                      "in order to maintain full-resolution depth testing and rasterization.\n\n"
@@ -127,12 +137,23 @@ void LowResRendering::Initialize()
     font.Initialize(L"Consolas", 18, SpriteFont::Regular, true, device);
     spriteRenderer.Initialize(device);
 
+    frameCapture.Initialize(device);
+
+    // The mesh renderer starts out with a separate empty model, since the loader fills in the scene
+    // models on its own thread. It gets handed the real one once Update() reports that the
+    // geometry is ready.
+    meshRenderer.Initialize(device, deviceManager.ImmediateContext(), &emptyModel);
+
     // Load the scenes
+    ModelImportOptions importOptions;
+    importOptions.ForceSRGB = true;
+    importOptions.UseCache = true;
+    importOptions.CompressVertices = CompressVertices;
+    importOptions.Force16BitIndices = Force16BitIndices;
+    importOptions.GenerateLODs = GenerateLODs;
     for(uint64 i = 0; i < 1; ++i)
-        sceneModels[i].CreateWithAssimp(device, ModelPaths[i].c_str(), true);
-
-    Model& currentModel = sceneModels[0];
-    meshRenderer.Initialize(device, deviceManager.ImmediateContext(), &currentModel);
+        modelLoaders[i].Start(device, &sceneModels[i], ModelPaths[i].c_str(), importOptions, DiffuseCompression,
+                              NormalMapCompression);
 
     skybox.Initialize(device);
 
@@ -456,6 +477,9 @@ void LowResRendering::Update(const Timer& timer)
     // Toggle VSYNC
     deviceManager.SetVSYNCEnabled(AppSettings::EnableVSync ? true : false);
 
+    if(modelLoaders[0].Update(deviceManager.ImmediateContext()))
+        meshRenderer.SetModel(&sceneModels[0]);
+
     meshRenderer.Update(camera);
 
     UpdateParticles(timer);
@@ -486,8 +510,27 @@ void LowResRendering::Render(const Timer& timer)
     }
 
     if(AppSettings::TakeScreenshot)
-        SavePNGScreenshot(window.GetHwnd(), deviceManager.BackBufferTexture());
+        SaveScreenshot(window.GetHwnd(), frameCapture, context, deviceManager.BackBufferTexture());
 
+    if(AppSettings::CaptureFrames)
+    {
+        if(numCapturedFrames == 0 && DirectoryExists(L"Captures") == false)
+            Win32Call(CreateDirectory(L"Captures", nullptr));
+
+        wstring filePath = MakeString(L"Captures\\Frame_%05llu.png", numCapturedFrames);
+        frameCapture.Capture(context, deviceManager.BackBufferTexture(), filePath.c_str());
+        ++numCapturedFrames;
+    }
+
+    try
+    {
+        frameCapture.Update(context);
+    }
+    catch(Exception e)
+    {
+        std::wstring errorString = L"Error occured while saving a screenshot:\n" + e.GetMessage();
+        MessageBox(window.GetHwnd(), errorString.c_str(), L"Error", MB_OK | MB_ICONERROR);
+    }
 
     ID3D11RenderTargetView* renderTargets[1] = { deviceManager.BackBuffer() };
     context->OMSetRenderTargets(1, renderTargets, NULL);
@@ -495,6 +538,9 @@ void LowResRendering::Render(const Timer& timer)
     SetViewport(context, deviceManager.BackBufferWidth(), deviceManager.BackBufferHeight());
 
     RenderHUD(timer);
+
+    if(firstFrameTime == 0.0f)
+        firstFrameTime = timer.ElapsedMillisecondsF();
 }
 
 void LowResRendering::RenderMainPass()
@@ -503,6 +549,10 @@ void LowResRendering::RenderMainPass()
 
     ID3D11DeviceContextPtr context = deviceManager.ImmediateContext();
 
+    // This binds its own depth target, so it needs to happen before the main targets are set
+    if(AppSettings::EnableSun && AppSettings::BakedSunShadows)
+        meshRenderer.UpdateBakedSunShadowMap(context);
+
     ID3D11RenderTargetView* renderTargets[1] = { nullptr };
     ID3D11DepthStencilView* ds = depthBuffer.DSView;
     context->OMSetRenderTargets(1, renderTargets, ds);
@@ -513,12 +563,15 @@ void LowResRendering::RenderMainPass()
     context->ClearRenderTargetView(colorTargetMSAA.RTView, clearColor);
     context->ClearDepthStencilView(ds, D3D11_CLEAR_DEPTH|D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-    meshRenderer.RenderDepth(context, camera, false, false);
-
+    // The depth bounds come from the scene bounds rather than the depth buffer, so they're ready
+    // before the prepass. This lets every view build its draw list up front, in parallel.
     meshRenderer.ReduceDepth(context, depthBuffer, camera);
+    meshRenderer.BuildDrawLists(camera);
+
+    meshRenderer.RenderDepthPrepass(context);
 
     if(AppSettings::EnableSun)
-        meshRenderer.RenderSunShadowMap(context, camera);
+        meshRenderer.RenderSunShadowMap(context);
 
     renderTargets[0] = colorTargetMSAA.RTView;
     context->OMSetRenderTargets(1, renderTargets, ds);
@@ -622,7 +675,7 @@ void LowResRendering::RenderParticles(const Timer& timer)
         context->VSSetShaderResources(0, 1, srvs);
 
         srvs[0] = smokeTexture;
-        srvs[1] = meshRenderer.sunVSM.SRView;
+        srvs[1] = meshRenderer.SunShadowMap();
         context->PSSetShaderResources(0, 2, srvs);
 
         D3D11_MAPPED_SUBRESOURCE mapped;
@@ -778,6 +831,126 @@ void LowResRendering::RenderHUD(const Timer& timer)
     wstring fpsText = MakeString(L"Frame Time: %.2fms (%u FPS)", 1000.0f / fps, fps);
     spriteRenderer.RenderText(font, fpsText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
 
+    const DrawStats& drawStats = meshRenderer.MainPassDrawStats();
+    transform._42 += 25.0f;
+    wstring drawText = MakeString(L"Main Pass Draws: %llu (%llu state changes)", drawStats.NumDraws,
+                                  drawStats.NumStateChanges());
+    spriteRenderer.RenderText(font, drawText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+    wstring buildText = L"Draw List Build Times:";
+    for(uint32 viewIdx = 0; viewIdx < meshRenderer.NumDrawViews(); ++viewIdx)
+        buildText += MakeString(L" %.3fms", meshRenderer.ViewBuildTime(viewIdx));
+    transform._42 += 25.0f;
+    spriteRenderer.RenderText(font, buildText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+    wstring triangleText = L"Triangles Per View:";
+    for(uint32 viewIdx = 0; viewIdx < meshRenderer.NumDrawViews(); ++viewIdx)
+        triangleText += MakeString(L" %llu", meshRenderer.ViewNumTriangles(viewIdx));
+    transform._42 += 25.0f;
+    spriteRenderer.RenderText(font, triangleText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+    if(AppSettings::EnableClusterCulling)
+    {
+        wstring meshletText = MakeString(L"Main Pass Meshlets: %u / %u", meshRenderer.NumMainViewVisibleMeshlets(),
+                                         meshRenderer.NumMainViewMeshlets());
+        transform._42 += 25.0f;
+        spriteRenderer.RenderText(font, meshletText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+    }
+
+    const AsyncModelLoader& modelLoader = modelLoaders[0];
+    wstring loadText = MakeString(L"First Frame: %.2fms", firstFrameTime);
+    if(modelLoader.GeometryLoaded())
+        loadText += MakeString(L", Geometry Loaded: %.2fms", modelLoader.GeometryLoadTime());
+    if(modelLoader.FullyLoaded())
+        loadText += MakeString(L", Fully Loaded: %.2fms", modelLoader.FullLoadTime());
+    else if(modelLoader.GeometryLoaded())
+        loadText += MakeString(L", Textures: %u / %u", modelLoader.NumTexturesLoaded(), modelLoader.NumTextures());
+    transform._42 += 25.0f;
+    spriteRenderer.RenderText(font, loadText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+    // The loader only hands the model over to the main thread once its geometry is done
+    if(modelLoader.GeometryLoaded())
+    {
+        const ModelImportStats& importStats = sceneModels[0].ImportStats();
+        wstring importText;
+        if(importStats.LoadedFromCache)
+            importText = MakeString(L"Model Import: %u meshes from the mesh cache in %.2fms", importStats.NumMeshes,
+                                    importStats.LoadTime);
+        else
+            importText = MakeString(L"Model Import: %u meshes in %.2fms (%.2fms processing), ACMR %.3f -> %.3f, "
+                                    L"ATVR %.3f -> %.3f", importStats.NumMeshes, importStats.LoadTime,
+                                    importStats.MeshProcessingTime, importStats.ImportCacheStats.ACMR(),
+                                    importStats.OptimizedCacheStats.ACMR(), importStats.ImportCacheStats.ATVR(),
+                                    importStats.OptimizedCacheStats.ATVR());
+        if(importStats.NumUncompressedMeshes > 0)
+            importText += MakeString(L", %u left uncompressed", importStats.NumUncompressedMeshes);
+        transform._42 += 25.0f;
+        spriteRenderer.RenderText(font, importText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+        if(importStats.CacheError.length() > 0)
+        {
+            wstring cacheErrorText = L"Discarded Mesh Cache Entry: " + importStats.CacheError;
+            transform._42 += 25.0f;
+            spriteRenderer.RenderText(font, cacheErrorText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+        }
+
+        if(importStats.SplitIndexBytesSaved > 0)
+        {
+            const double MB = 1024.0 * 1024.0;
+            wstring splitText = MakeString(L"16-bit Index Split: %.2fMB of indices saved, %.2fMB of vertices added",
+                                           importStats.SplitIndexBytesSaved / MB, importStats.SplitVertexBytesAdded / MB);
+            transform._42 += 25.0f;
+            spriteRenderer.RenderText(font, splitText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+        }
+
+        if(importStats.LODTriangles.size() > 0)
+        {
+            wstring lodText = L"LOD Triangles:";
+            for(uint64 lodIdx = 0; lodIdx < importStats.LODTriangles.size(); ++lodIdx)
+                lodText += MakeString(lodIdx > 0 ? L" / %llu" : L" %llu", importStats.LODTriangles[lodIdx]);
+            transform._42 += 25.0f;
+            spriteRenderer.RenderText(font, lodText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+        }
+    }
+
+    if(AppSettings::BakedSunShadows && meshRenderer.BakedShadowUpdateTime() > 0.0f)
+    {
+        wstring bakedText = MakeString(L"Baked Sun Shadows: %ls in %.2fms",
+                                       meshRenderer.BakedShadowsLoadedFromCache() ? L"loaded from cache" : L"baked",
+                                       meshRenderer.BakedShadowUpdateTime());
+        transform._42 += 25.0f;
+        spriteRenderer.RenderText(font, bakedText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+    }
+
+    const TextureCacheStats cacheStats = TextureCache::Global.Stats();
+    wstring cacheText = MakeString(L"Texture Cache: %llu textures (%.2fMB), %llu hits / %llu misses (%.2fMB saved)",
+                                   cacheStats.NumTextures, cacheStats.NumBytes / (1024.0 * 1024.0),
+                                   cacheStats.NumHits, cacheStats.NumMisses,
+                                   cacheStats.NumBytesSaved / (1024.0 * 1024.0));
+    transform._42 += 25.0f;
+    spriteRenderer.RenderText(font, cacheText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+
+    const TextureCompressionStats& compressionStats = cacheStats.Compression;
+    if(compressionStats.NumEncoded > 0 || compressionStats.NumLoadedFromCache > 0)
+    {
+        wstring compressionText = MakeString(L"Texture Compression: %llu encoded (%.2f MP/s, %.2fdB PSNR), "
+                                             L"%llu from DDS cache, %.2fMB saved",
+                                             compressionStats.NumEncoded, compressionStats.EncodeThroughput(),
+                                             compressionStats.PSNR(), compressionStats.NumLoadedFromCache,
+                                             compressionStats.BytesSaved() / (1024.0 * 1024.0));
+        transform._42 += 25.0f;
+        spriteRenderer.RenderText(font, compressionText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+    }
+
+    if(frameCapture.NumFramesWritten() > 0 || AppSettings::CaptureFrames)
+    {
+        wstring captureText = MakeString(L"Frames Captured: %llu, Encoding: %.2fms per frame (%.2f MP/s)",
+                                         frameCapture.NumFramesWritten(), frameCapture.AverageEncodeTime(),
+                                         frameCapture.EncodeThroughput());
+        transform._42 += 25.0f;
+        spriteRenderer.RenderText(font, captureText.c_str(), transform, XMFLOAT4(1, 1, 0, 1));
+    }
+
     Profiler::GlobalProfiler.EndFrame(spriteRenderer, font);
 
     spriteRenderer.End();
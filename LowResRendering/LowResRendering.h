@@ -17,6 +17,8 @@
 #include <Input.h>
 #include <Graphics/Camera.h>
 #include <Graphics/Model.h>
+#include <Graphics/AsyncModelLoader.h>
+#include <Graphics/FrameCapture.h>
 #include <Graphics/SpriteFont.h>
 #include <Graphics/SpriteRenderer.h>
 #include <Graphics/Skybox.h>
@@ -51,7 +53,13 @@ protected:
 
     // Model
     Model sceneModels[1];
+    AsyncModelLoader modelLoaders[1];
+    Model emptyModel;           // Rendered until the loader hands over the scene's geometry
     MeshRenderer meshRenderer;
+    float firstFrameTime = 0.0f;
+
+    FrameCapture frameCapture;
+    uint64 numCapturedFrames = 0;
 
     ID3D11RasterizerStatePtr msaaLowResRS[uint64(MSAAModes::NumValues)];
     PixelShaderPtr depthDownscalePS[uint64(MSAAModes::NumValues)];
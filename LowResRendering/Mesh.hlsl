@@ -16,6 +16,7 @@
 #include <SH.hlsl>
 #include "BRDF.hlsl"
 #include "AppSettings.hlsl"
+#include <VertexCompression.hlsl>
 
 //=================================================================================================
 // Constant buffers
@@ -27,6 +28,14 @@ cbuffer VSConstants : register(b0)
     float4x4 WorldViewProjection;
 }
 
+#if CompressedVertices_
+cbuffer MeshDecodeConstants : register(b2)
+{
+    float3 PositionScale;
+    float3 PositionBias;
+}
+#endif
+
 cbuffer PSConstants : register(b0)
 {
     float3 SunDirectionWS;
@@ -41,7 +50,7 @@ cbuffer PSConstants : register(b0)
 //=================================================================================================
 Texture2D AlbedoMap : register(t0);
 Texture2D NormalMap : register(t1);
-Texture2DArray SunShadowMap : register(t2);
+Texture2D SunShadowMap : register(t2);
 
 SamplerState AnisoSampler : register(s0);
 SamplerState EVSMSampler : register(s1);
@@ -50,6 +59,18 @@ SamplerState LinearSampler : register(s2);
 //=================================================================================================
 // Input/Output structs
 //=================================================================================================
+#if CompressedVertices_
+
+struct VSInput
+{
+    float4 PositionQ 		    : POSITION;
+    float2 NormalOct 		    : NORMAL;
+    float2 TexCoord 		    : TEXCOORD0;
+	uint2 TangentPacked 	    : TANGENT;
+};
+
+#else
+
 struct VSInput
 {
     float3 PositionOS 		    : POSITION;
@@ -59,6 +80,8 @@ struct VSInput
 	float3 BitangentOS		    : BITANGENT;
 };
 
+#endif
+
 struct VSOutput
 {
     float4 PositionCS 		    : SV_Position;
@@ -91,7 +114,18 @@ VSOutput VS(in VSInput input, in uint VertexID : SV_VertexID)
 {
     VSOutput output;
 
-    float3 positionOS = input.PositionOS;
+    #if CompressedVertices_
+        float3 positionOS = input.PositionQ.xyz * PositionScale + PositionBias;
+        float3 normalOS = DecodeOctahedral(input.NormalOct);
+        float bitangentSign = 1.0f;
+        float3 tangentOS = UnpackTangent(input.TangentPacked, bitangentSign);
+        float3 bitangentOS = cross(normalOS, tangentOS) * bitangentSign;
+    #else
+        float3 positionOS = input.PositionOS;
+        float3 normalOS = input.NormalOS;
+        float3 tangentOS = input.TangentOS;
+        float3 bitangentOS = input.BitangentOS;
+    #endif
 
     // Calc the world-space position
     output.PositionWS = mul(float4(positionOS, 1.0f), World).xyz;
@@ -102,11 +136,11 @@ VSOutput VS(in VSInput input, in uint VertexID : SV_VertexID)
 
 
 	// Rotate the normal into world space
-    output.NormalWS = normalize(mul(input.NormalOS, (float3x3)World));
+    output.NormalWS = normalize(mul(normalOS, (float3x3)World));
 
 	// Rotate the rest of the tangent frame into world space
-	output.TangentWS = normalize(mul(input.TangentOS, (float3x3)World));
-	output.BitangentWS = normalize(mul(input.BitangentOS, (float3x3)World));
+	output.TangentWS = normalize(mul(tangentOS, (float3x3)World));
+	output.BitangentWS = normalize(mul(bitangentOS, (float3x3)World));
 
     // Pass along the texture coordinates
     output.TexCoord = input.TexCoord;
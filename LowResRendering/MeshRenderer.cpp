@@ -14,11 +14,20 @@
 
 #include <Exceptions.h>
 #include <Utility.h>
+#include <Timer.h>
+#include <ThreadPool.h>
+#include <FileIO.h>
+#include <MurmurHash.h>
+#include <Serialization.h>
+#include <Graphics/MipGenerator.h>
+#include <Graphics/D3D11DrawBackend.h>
 #include <Graphics/ShaderCompilation.h>
+#include <Graphics/Profiler.h>
 #include <App.h>
 
 #include "AppSettings.h"
 #include "SharedConstants.h"
+#include "DepthReduction.h"
 
 // Constants
 static const float ShadowNearClip = 1.0f;
@@ -28,25 +37,113 @@ static const float OffsetScale = 0.0f;
 static const float LightBleedingReduction = 0.10f;
 static const float PositiveExponent = 40.0f;
 static const float NegativeExponent = 8.0f;
-static const uint32 ShadowMapSize = 1024;
+static const float MinLODDistance = 0.01f;
+static const uint32 MaxCascadeSize = 1024;
+static const uint32 MinCascadeSize = 128;
+static const uint32 ShadowAtlasPadding = 16;
+static const uint32 ShadowAtlasWidth = MaxCascadeSize * 2 + ShadowAtlasPadding;
+static const uint32 ShadowAtlasHeight = MaxCascadeSize + MaxCascadeSize / 2 + ShadowAtlasPadding;
+static const float ShadowTexelDensity = 1.0f;
 static const uint32 ShadowMSAASamples = 4;
 static const uint32 ShadowAnisotropy = 16;
 static const bool EnableShadowMips = true;
 
-MeshRenderer::MeshRenderer() : currFrame(0), sceneModel(nullptr)
+// The cascades are only ShadowAtlasPadding texels apart, so the mip chain stops at the level where
+// that gap is down to 2 texels. Any lower and the cascades would bleed into each other.
+static const uint32 NumShadowMips = 4;
+
+// The baked shadow map covers the whole scene with a single orthographic projection. Bump the
+// version whenever the bake changes, so that stale entries in the cache aren't used.
+static const uint32 BakedShadowMapSize = 1024;
+static const uint32 BakedShadowCacheVersion = 2;
+static const wchar* BakedShadowCacheDir = L"ShadowCache\\";
+
+// Transforms from [-1,1] post-projection space to [0,1] UV space
+static XMMATRIX TexScaleBias()
+{
+    XMMATRIX texScaleBias;
+    texScaleBias.r[0] = XMVectorSet(0.5f,  0.0f, 0.0f, 0.0f);
+    texScaleBias.r[1] = XMVectorSet(0.0f, -0.5f, 0.0f, 0.0f);
+    texScaleBias.r[2] = XMVectorSet(0.0f,  0.0f, 1.0f, 0.0f);
+    texScaleBias.r[3] = XMVectorSet(0.5f,  0.5f, 0.0f, 1.0f);
+    return texScaleBias;
+}
+
+// Extracts the frustum planes from a view * projection matrix, with the normals pointing inwards.
+// The 4 side planes come first, followed by the near and far planes. The planes are normalized
+// so that they can be used for sphere tests.
+static void ExtractFrustumPlanes(const Float4x4& viewProjection, XMVECTOR planes[6])
+{
+    XMMATRIX columns = XMMatrixTranspose(viewProjection.ToSIMD());
+    planes[0] = XMVectorAdd(columns.r[3], columns.r[0]);
+    planes[1] = XMVectorSubtract(columns.r[3], columns.r[0]);
+    planes[2] = XMVectorAdd(columns.r[3], columns.r[1]);
+    planes[3] = XMVectorSubtract(columns.r[3], columns.r[1]);
+    planes[4] = columns.r[2];
+    planes[5] = XMVectorSubtract(columns.r[3], columns.r[2]);
+
+    for(uint32 i = 0; i < 6; ++i)
+        planes[i] = XMPlaneNormalize(planes[i]);
+}
+
+// Returns false if the box is completely outside of any of the planes
+static bool IsVisible(const BoundingBox& bounds, const XMVECTOR* planes, uint32 numPlanes)
+{
+    XMVECTOR center = XMVectorSetW(XMLoadFloat3(&bounds.Center), 1.0f);
+    XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+
+    for(uint32 i = 0; i < numPlanes; ++i)
+    {
+        const float distance = XMVectorGetX(XMVector4Dot(planes[i], center));
+        const float radius = XMVectorGetX(XMVector3Dot(XMVectorAbs(planes[i]), extents));
+        if(distance + radius < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+// Returns false if the sphere is completely outside of any of the planes
+static bool IsVisible(const Float3& center, float radius, const XMVECTOR* planes, uint32 numPlanes)
+{
+    XMVECTOR centerVec = XMVectorSet(center.x, center.y, center.z, 1.0f);
+    for(uint32 i = 0; i < numPlanes; ++i)
+    {
+        if(XMVectorGetX(XMVector4Dot(planes[i], centerVec)) + radius < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+MeshRenderer::MeshRenderer() : currFrame(0), sceneModel(nullptr), screenHeight(1), bakedShadowUpdateTime(0.0f),
+                               bakedShadowsFromCache(false)
 {
+    for(uint32 i = 0; i < NumCascades; ++i)
+    {
+        desiredCascadeSizes[i] = 0;
+        cascadeSizes[i] = 0;
+    }
 }
 
 void MeshRenderer::LoadShaders()
 {
     // Load the mesh shaders
-    meshDepthVS = CompileVSFromFile(device, L"DepthOnly.hlsl", "VS", "vs_5_0");
-    meshVS = CompileVSFromFile(device, L"Mesh.hlsl", "VS", "vs_5_0");
+    CompileOptions opts;
+    opts.Add("CompressedVertices_", 0);
+    meshDepthVS = CompileVSFromFile(device, L"DepthOnly.hlsl", "VS", "vs_5_0", opts);
+    meshVS = CompileVSFromFile(device, L"Mesh.hlsl", "VS", "vs_5_0", opts);
+
+    opts.Reset();
+    opts.Add("CompressedVertices_", 1);
+    meshDepthCompressedVS = CompileVSFromFile(device, L"DepthOnly.hlsl", "VS", "vs_5_0", opts);
+    meshCompressedVS = CompileVSFromFile(device, L"Mesh.hlsl", "VS", "vs_5_0", opts);
+
     meshPS = CompilePSFromFile(device, L"Mesh.hlsl", "PS", "ps_5_0");
 
     fullScreenVS = CompileVSFromFile(device, L"EVSMConvert.hlsl", "FullScreenVS");
 
-    CompileOptions opts;
+    opts.Reset();
     opts.Add("MSAASamples_", ShadowMSAASamples);
     evsmConvertPS = CompilePSFromFile(device, L"EVSMConvert.hlsl", "ConvertToEVSM", "ps_5_0", opts);
 
@@ -75,16 +172,82 @@ void MeshRenderer::LoadShaders()
 
 void MeshRenderer::CreateShadowMaps()
 {
-    // Create the shadow map as a texture atlas
-    sunShadowDepthMap.Initialize(device, ShadowMapSize, ShadowMapSize, DXGI_FORMAT_D24_UNORM_S8_UINT, true,
+    // The depth map and temporary blur target are re-used for every cascade, so they only need
+    // to be as big as the largest cascade
+    sunShadowDepthMap.Initialize(device, MaxCascadeSize, MaxCascadeSize, DXGI_FORMAT_D24_UNORM_S8_UINT, true,
                                  ShadowMSAASamples, 0, 1);
 
+    // Create the EVSM map as a texture atlas, with a variable-sized region for each cascade
     DXGI_FORMAT smFmt = DXGI_FORMAT_R32G32B32A32_FLOAT;
-    uint32 numMips = EnableShadowMips ? 0 : 1;
-    sunVSM.Initialize(device, ShadowMapSize, ShadowMapSize, smFmt, numMips, 1, 0,
-                                 EnableShadowMips, false, NumCascades, false);
+    StaticAssert_((1 << NumShadowMips) <= ShadowAtlasPadding);
+    uint32 numMips = EnableShadowMips ? NumShadowMips : 1;
+    sunVSM.Initialize(device, ShadowAtlasWidth, ShadowAtlasHeight, smFmt, numMips, 1, 0,
+                                 EnableShadowMips, false, 1, false);
+
+    tempVSM.Initialize(device, MaxCascadeSize, MaxCascadeSize, smFmt, 1, 1, 0, false, false, 1, false);
+
+    shadowAtlas.Initialize(ShadowAtlasWidth, ShadowAtlasHeight, ShadowAtlasPadding);
+
+    uint32 initialSizes[NumCascades];
+    for(uint32 i = 0; i < NumCascades; ++i)
+        initialSizes[i] = MaxCascadeSize;
+    PackShadowAtlas(initialSizes);
+}
+
+// Rounds a cascade size up to a multiple of the texel size of the smallest shadow mip. Since the
+// padding is also a multiple of it, every region starts on a texel boundary of each mip, and none
+// of the lower-mip texels end up straddling a cascade and the padding next to it.
+static uint32 AlignCascadeSize(uint32 size)
+{
+    const uint32 alignment = 1 << (NumShadowMips - 1);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// Assigns each cascade a region of the shadow atlas. The atlas is only re-packed when the
+// requested cascade resolutions change.
+void MeshRenderer::PackShadowAtlas(const uint32 desiredSizes[NumCascades])
+{
+    bool sizesChanged = false;
+    for(uint32 i = 0; i < NumCascades; ++i)
+        sizesChanged |= desiredSizes[i] != desiredCascadeSizes[i];
+
+    if(sizesChanged == false)
+        return;
+
+    uint32 sizes[NumCascades];
+    for(uint32 i = 0; i < NumCascades; ++i)
+    {
+        desiredCascadeSizes[i] = desiredSizes[i];
+        sizes[i] = AlignCascadeSize(Clamp(desiredSizes[i], MinCascadeSize, MaxCascadeSize));
+    }
+
+    while(shadowAtlas.Repack(sizes, sizes, NumCascades, cascadeRects) == false)
+    {
+        // Everything didn't fit, so halve the resolution of the largest cascade (preferring
+        // the farthest one) and try again
+        uint32 largestIdx = 0;
+        for(uint32 i = 1; i < NumCascades; ++i)
+            if(sizes[i] >= sizes[largestIdx])
+                largestIdx = i;
+
+        if(sizes[largestIdx] <= MinCascadeSize)
+            throw Exception(L"Failed to fit the shadow cascades into the shadow atlas");
+
+        sizes[largestIdx] = AlignCascadeSize(sizes[largestIdx] / 2);
+    }
+
+    const float atlasWidth = float(sunVSM.Width);
+    const float atlasHeight = float(sunVSM.Height);
+    for(uint32 i = 0; i < NumCascades; ++i)
+    {
+        const AtlasRect& rect = cascadeRects[i];
+        cascadeSizes[i] = sizes[i];
+        shadowConstants.Data.CascadeAtlasScaleOffsets[i] = Float4(rect.Width / atlasWidth, rect.Height / atlasHeight,
+                                                                  rect.X / atlasWidth, rect.Y / atlasHeight);
+    }
 
-    tempVSM.Initialize(device, ShadowMapSize, ShadowMapSize, smFmt, 1, 1, 0, false, false, 1, false);
+    shadowConstants.Data.ShadowAtlasTexelSize = Float2(1.0f / atlasWidth, 1.0f / atlasHeight);
+    shadowConstants.Data.ShadowAtlasMaxMip = float(sunVSM.NumMipLevels - 1);
 }
 
 // Loads resources
@@ -98,6 +261,7 @@ void MeshRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
     samplerStates.Initialize(device);
 
     meshVSConstants.Initialize(device);
+    meshDecodeConstants.Initialize(device);
     meshPSConstants.Initialize(device);
     shadowConstants.Initialize(device);
     evsmConstants.Initialize(device);
@@ -122,6 +286,28 @@ void MeshRenderer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
     SetModel(model);
 }
 
+// Combines a hash of everything in the mesh that affects what gets rendered into the shadow map
+// with the hash of the meshes that came before it. D3D11 buffers are limited to less than 2GB, so
+// the sizes fit in the int that GenerateHash takes.
+static Hash HashMeshGeometry(const Mesh& mesh, const Hash& prevHash)
+{
+    const Hash vertexHash = GenerateHash(mesh.Vertices(), int(mesh.VertexDataSize()));
+    const Hash indexHash = GenerateHash(mesh.Indices(), int(mesh.IndexDataSize()));
+    const Hash partHash = GenerateHash(mesh.MeshParts().data(), int(mesh.MeshParts().size() * sizeof(MeshPart)));
+    const Hash lodHash = GenerateHash(mesh.LODs().data(), int(mesh.LODs().size() * sizeof(MeshLOD)));
+
+    // Compressed positions depend on the scale and bias, and on the layout of the vertex
+    const Float3& scale = mesh.PositionScale();
+    const Float3& bias = mesh.PositionBias();
+    float decodeParams[8] = { scale.x, scale.y, scale.z, bias.x, bias.y, bias.z,
+                              float(mesh.VertexStride()), mesh.HasCompressedVertices() ? 1.0f : 0.0f };
+    const Hash decodeHash = GenerateHash(decodeParams, sizeof(decodeParams));
+
+    uint64 key[12] = { prevHash.A, prevHash.B, vertexHash.A, vertexHash.B, indexHash.A, indexHash.B,
+                       partHash.A, partHash.B, lodHash.A, lodHash.B, decodeHash.A, decodeHash.B };
+    return GenerateHash(key, sizeof(key));
+}
+
 void MeshRenderer::SetModel(const Model* model)
 {
     Assert_(model != nullptr);
@@ -129,19 +315,85 @@ void MeshRenderer::SetModel(const Model* model)
 
     meshInputLayouts.clear();
     meshDepthInputLayouts.clear();
+    drawItems.clear();
+
+    // The baked shadows belong to the old scene
+    bakedShadows = BakedEVSM();
+    bakedShadowMap = nullptr;
+    sceneGeometryHash = Hash();
 
     for(uint64 i = 0; i < sceneModel->Meshes().size(); ++i)
     {
         // Generate input layouts for the scene meshes
         const Mesh& mesh = sceneModel->Meshes()[i];
+        sceneGeometryHash = HashMeshGeometry(mesh, sceneGeometryHash);
+        VertexShaderPtr vs = mesh.HasCompressedVertices() ? meshCompressedVS : meshVS;
+        VertexShaderPtr depthVS = mesh.HasCompressedVertices() ? meshDepthCompressedVS : meshDepthVS;
+
         ID3D11InputLayoutPtr inputLayout;
         DXCall(device->CreateInputLayout(mesh.InputElements(), mesh.NumInputElements(),
-               meshVS->ByteCode->GetBufferPointer(), meshVS->ByteCode->GetBufferSize(), &inputLayout));
+               vs->ByteCode->GetBufferPointer(), vs->ByteCode->GetBufferSize(), &inputLayout));
         meshInputLayouts.push_back(inputLayout);
 
         DXCall(device->CreateInputLayout(mesh.InputElements(), mesh.NumInputElements(),
-               meshDepthVS->ByteCode->GetBufferPointer(), meshDepthVS->ByteCode->GetBufferSize(), &inputLayout));
+               depthVS->ByteCode->GetBufferPointer(), depthVS->ByteCode->GetBufferSize(), &inputLayout));
         meshDepthInputLayouts.push_back(inputLayout);
+
+        for(uint64 partIdx = 0; partIdx < mesh.MeshParts().size(); ++partIdx)
+        {
+            const MeshPart& part = mesh.MeshParts()[partIdx];
+
+            // Some models don't fill out the vertex range, so fall back to the whole mesh
+            uint32 vertexStart = part.VertexStart;
+            uint32 vertexCount = part.VertexCount;
+            if(vertexCount == 0)
+            {
+                vertexStart = 0;
+                vertexCount = mesh.NumVertices();
+            }
+
+            Float3 minPosition;
+            Float3 maxPosition;
+            mesh.ComputeBounds(vertexStart, vertexCount, minPosition, maxPosition);
+
+            DrawItem item;
+            item.MeshIdx = uint32(i);
+            item.PartIdx = uint32(partIdx);
+            const Float3 center = (minPosition + maxPosition) * 0.5f;
+            const Float3 extents = (maxPosition - minPosition) * 0.5f;
+            item.Bounds.Center = XMFLOAT3(center.x, center.y, center.z);
+            item.Bounds.Extents = XMFLOAT3(extents.x, extents.y, extents.z);
+            drawItems.push_back(item);
+        }
+    }
+
+    // Each view gets a dynamic index buffer for the meshlets that pass cluster culling, which
+    // needs to be big enough for the case where every meshlet is visible
+    uint64 numMeshletIndices = 0;
+    for(uint64 i = 0; i < sceneModel->Meshes().size(); ++i)
+    {
+        const Mesh& mesh = sceneModel->Meshes()[i];
+        for(uint64 meshletIdx = 0; meshletIdx < mesh.Meshlets().size(); ++meshletIdx)
+            numMeshletIndices += mesh.Meshlets()[meshletIdx].IndexCount;
+    }
+
+    for(uint32 viewIdx = 0; viewIdx < NumViews; ++viewIdx)
+    {
+        ViewDrawData& view = views[viewIdx];
+        view.ClusterIndices.clear();
+        view.ClusterIndices.reserve(numMeshletIndices);
+        view.ClusterIndexBuffer = nullptr;
+        if(numMeshletIndices == 0)
+            continue;
+
+        D3D11_BUFFER_DESC bufferDesc;
+        bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+        bufferDesc.ByteWidth = uint32(numMeshletIndices * sizeof(uint32));
+        bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        bufferDesc.MiscFlags = 0;
+        bufferDesc.StructureByteStride = 0;
+        DXCall(device->CreateBuffer(&bufferDesc, nullptr, &view.ClusterIndexBuffer));
     }
 }
 
@@ -151,6 +403,8 @@ void MeshRenderer::Update(const Camera& camera)
 
 void MeshRenderer::OnResize(uint32 width, uint32 height)
 {
+    screenHeight = height;
+
     depthReductionTargets.clear();
 
     uint32 w = width;
@@ -283,21 +537,32 @@ void MeshRenderer::ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx
     context->IASetIndexBuffer(NULL, DXGI_FORMAT_R32_UINT, 0);
     context->IASetInputLayout(NULL);
 
-    SetViewport(context, sunVSM.Width, sunVSM.Height);
+    // Restrict rendering to the cascade's region of the atlas
+    const AtlasRect& rect = cascadeRects[cascadeIdx];
+    D3D11_VIEWPORT atlasViewport;
+    atlasViewport.TopLeftX = float(rect.X);
+    atlasViewport.TopLeftY = float(rect.Y);
+    atlasViewport.Width = float(rect.Width);
+    atlasViewport.Height = float(rect.Height);
+    atlasViewport.MinDepth = 0.0f;
+    atlasViewport.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &atlasViewport);
 
     evsmConstants.Data.PositiveExponent = PositiveExponent;
     evsmConstants.Data.NegativeExponent = NegativeExponent;
     evsmConstants.Data.CascadeScale = shadowConstants.Data.CascadeScales[cascadeIdx].To3D();
     evsmConstants.Data.FilterSize = 1.0f;
-    evsmConstants.Data.ShadowMapSize.x = float(sunVSM.Width);
-    evsmConstants.Data.ShadowMapSize.y = float(sunVSM.Height);
+    evsmConstants.Data.ShadowMapSize.x = float(rect.Width);
+    evsmConstants.Data.ShadowMapSize.y = float(rect.Height);
+    evsmConstants.Data.AtlasOffset.x = float(rect.X);
+    evsmConstants.Data.AtlasOffset.y = float(rect.Y);
     evsmConstants.ApplyChanges(context);
     evsmConstants.SetPS(context, 0);
 
     context->VSSetShader(fullScreenVS, NULL, 0);
     context->PSSetShader(evsmConvertPS, NULL, 0);
 
-    ID3D11RenderTargetView* rtvs[1] = { sunVSM.RTVArraySlices[cascadeIdx] };
+    ID3D11RenderTargetView* rtvs[1] = { sunVSM.RTView };
     context->OMSetRenderTargets(1, rtvs, NULL);
 
     ID3D11ShaderResourceView* srvs[1] = { sunShadowDepthMap.SRView };
@@ -308,8 +573,11 @@ void MeshRenderer::ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx
     srvs[0] = NULL;
     context->PSSetShaderResources(0, 1, srvs);
 
-    const float FilterSizeU = std::max(FilterSize * cascadeScale.x, 1.0f);
-    const float FilterSizeV = std::max(FilterSize * cascadeScale.y, 1.0f);
+    // The filter width is specified in texels of the first cascade, so account for both
+    // the difference in world-space coverage and the difference in resolution
+    const float resolutionScale = float(cascadeSizes[cascadeIdx]) / float(cascadeSizes[0]);
+    const float FilterSizeU = std::max(FilterSize * cascadeScale.x * resolutionScale, 1.0f);
+    const float FilterSizeV = std::max(FilterSize * cascadeScale.y * resolutionScale, 1.0f);
 
     if(FilterSizeU > 1.0f || FilterSizeV > 1.0f)
     {
@@ -321,8 +589,9 @@ void MeshRenderer::ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx
 
         rtvs[0] = tempVSM.RTView;
         context->OMSetRenderTargets(1, rtvs, NULL);
+        SetViewport(context, rect.Width, rect.Height);
 
-        srvs[0] = sunVSM.SRVArraySlices[cascadeIdx];
+        srvs[0] = sunVSM.SRView;
         context->PSSetShaderResources(0, 1, srvs);
 
         context->PSSetShader(evsmBlurH, NULL, 0);
@@ -338,8 +607,9 @@ void MeshRenderer::ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx
 
         uint32 sampleRadiusV = static_cast<uint32>((FilterSizeV / 2) + 0.499f);
 
-        rtvs[0] = sunVSM.RTVArraySlices[cascadeIdx];
+        rtvs[0] = sunVSM.RTView;
         context->OMSetRenderTargets(1, rtvs, NULL);
+        context->RSSetViewports(1, &atlasViewport);
 
         srvs[0] = tempVSM.SRView;
         context->PSSetShaderResources(0, 1, srvs);
@@ -356,6 +626,228 @@ void MeshRenderer::ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx
         context->GenerateMips(sunVSM.SRView);
 }
 
+// Builds the draw lists for every view. Each view is culled and recorded as an independent
+// job on the thread pool, so that only the final submission happens on the immediate context.
+void MeshRenderer::BuildDrawLists(const Camera& camera)
+{
+    CPUProfileBlock profileBlock(L"Build Draw Lists");
+
+    views[DepthPrepassView].View = camera.ViewMatrix();
+    views[DepthPrepassView].ViewProjection = camera.ViewProjectionMatrix();
+    views[DepthPrepassView].Position = camera.Position();
+    views[MainView].View = camera.ViewMatrix();
+    views[MainView].ViewProjection = camera.ViewProjectionMatrix();
+    views[MainView].Position = camera.Position();
+
+    // The prepass and main pass need to pick the same LODs, or the depth won't match
+    const float cameraLODScale = camera.ProjectionMatrix()._22 * screenHeight * 0.5f;
+    views[DepthPrepassView].LODScale = cameraLODScale;
+    views[DepthPrepassView].Orthographic = false;
+    views[MainView].LODScale = cameraLODScale;
+    views[MainView].Orthographic = false;
+
+    uint32 numViews = CascadeView0;
+    if(AppSettings::EnableSun && UsingBakedShadows())
+    {
+        SetupBakedShadowConstants(camera);
+    }
+    else if(AppSettings::EnableSun)
+    {
+        SetupShadowCascades(camera);
+        numViews = NumViews;
+    }
+
+    for(uint32 viewIdx = numViews; viewIdx < NumViews; ++viewIdx)
+    {
+        views[viewIdx].List.Reset();
+        views[viewIdx].BuildTime = 0.0f;
+        views[viewIdx].NumTriangles = 0;
+        views[viewIdx].NumMeshlets = 0;
+        views[viewIdx].NumVisibleMeshlets = 0;
+    }
+
+    ParallelFor(numViews, 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        for(uint64 viewIdx = start; viewIdx < end; ++viewIdx)
+            BuildDrawList(uint32(viewIdx));
+    });
+}
+
+// Culls the mesh parts against the view frustum, and records a sorted packet for each one that's visible
+void MeshRenderer::BuildDrawList(uint32 viewIdx)
+{
+    Timer timer;
+
+    ViewDrawData& view = views[viewIdx];
+    view.List.Reset();
+    view.ClusterIndices.clear();
+    view.NumTriangles = 0;
+    view.NumMeshlets = 0;
+    view.NumVisibleMeshlets = 0;
+
+    // Shadow casters in front of the cascade's near plane still need to be rendered (they're
+    // pancaked onto it with depth clipping disabled), so only test the side planes for cascades
+    XMVECTOR frustumPlanes[6];
+    ExtractFrustumPlanes(view.ViewProjection, frustumPlanes);
+    const uint32 numPlanes = viewIdx >= CascadeView0 ? 4 : 6;
+
+    const XMMATRIX viewProjection = view.ViewProjection.ToSIMD();
+    const bool depthOnly = viewIdx != MainView;
+
+    // Meshlets are culled individually against the frustum, and by their normal cones for the
+    // camera views. Shadow casters are rendered without backface culling, so the cascades can't
+    // use the cones.
+    const bool clusterCulling = AppSettings::EnableClusterCulling && view.ClusterIndexBuffer != nullptr;
+    const bool coneCulling = viewIdx == DepthPrepassView || viewIdx == MainView;
+
+    // Parts use the coarsest LOD whose error projects to fewer pixels than the threshold. The
+    // cascades get a larger threshold, since the filtered shadows hide most of the difference.
+    const bool useLODs = AppSettings::EnableLODs;
+    float lodThreshold = AppSettings::LODErrorThreshold;
+    if(viewIdx >= CascadeView0)
+        lodThreshold *= AppSettings::ShadowLODBias;
+
+    // Compressed meshes need their decode constants, which only need to be added once per mesh
+    const uint32 NoConstants = uint32(-1);
+    std::vector<uint32> meshConstantOffsets(sceneModel->Meshes().size(), NoConstants);
+
+    for(uint64 itemIdx = 0; itemIdx < drawItems.size(); ++itemIdx)
+    {
+        const DrawItem& item = drawItems[itemIdx];
+        if(IsVisible(item.Bounds, frustumPlanes, numPlanes) == false)
+            continue;
+
+        const Mesh& mesh = sceneModel->Meshes()[item.MeshIdx];
+        const MeshPart& part = mesh.MeshParts()[item.PartIdx];
+
+        // Sort front-to-back within a batch, using the post-projection depth of the bounds center
+        XMVECTOR centerCS = XMVector3TransformCoord(XMLoadFloat3(&item.Bounds.Center), viewProjection);
+        const uint32 depth = uint32(Saturate(XMVectorGetZ(centerCS)) * 0xFFFFFF);
+
+        DrawPacket packet;
+        packet.VertexBuffer = mesh.VertexBuffer();
+        packet.VertexStride = mesh.VertexStride();
+        packet.IndexBuffer = mesh.IndexBuffer();
+        packet.IndexSize = mesh.IndexSize();
+        packet.IndexStart = part.IndexStart;
+        packet.IndexCount = part.IndexCount;
+        packet.BaseVertex = int32(part.BaseVertex);
+
+        uint32 lodIdx = 0;
+        if(useLODs && part.LODCount > 0)
+        {
+            // Use the closest point of the bounds, so that the error is never underestimated
+            float pixelsPerUnit = view.LODScale;
+            if(view.Orthographic == false)
+            {
+                const float radius = Float3::Length(Float3(item.Bounds.Extents.x, item.Bounds.Extents.y, item.Bounds.Extents.z));
+                const Float3 center = Float3(item.Bounds.Center.x, item.Bounds.Center.y, item.Bounds.Center.z);
+                const float distance = Float3::Length(center - view.Position) - radius;
+                pixelsPerUnit /= std::max(distance, MinLODDistance);
+            }
+
+            while(lodIdx < part.LODCount && mesh.LODs()[part.LODStart + lodIdx].Error * pixelsPerUnit <= lodThreshold)
+                ++lodIdx;
+        }
+
+        if(lodIdx > 0)
+        {
+            // The meshlets only cover the full-detail triangles, so LODs skip cluster culling
+            const MeshLOD& lod = mesh.LODs()[part.LODStart + lodIdx - 1];
+            packet.IndexStart = lod.IndexStart;
+            packet.IndexCount = lod.IndexCount;
+        }
+        else if(clusterCulling && part.MeshletCount > 0)
+        {
+            // Append the indices of the visible meshlets to the view's compacted index list
+            const uint32 clusterIndexStart = uint32(view.ClusterIndices.size());
+            const uint8* meshIndices = mesh.Indices();
+            const bool indices32 = mesh.IndexBufferType() == IndexType::Index32Bit;
+
+            for(uint32 meshletIdx = part.MeshletStart; meshletIdx < part.MeshletStart + part.MeshletCount; ++meshletIdx)
+            {
+                const Meshlet& meshlet = mesh.Meshlets()[meshletIdx];
+                ++view.NumMeshlets;
+
+                if(IsVisible(meshlet.Center, meshlet.Radius, frustumPlanes, numPlanes) == false)
+                    continue;
+
+                if(coneCulling && IsMeshletBackFacing(meshlet, view.Position))
+                    continue;
+
+                ++view.NumVisibleMeshlets;
+
+                const uint32 indexEnd = meshlet.IndexStart + meshlet.IndexCount;
+                if(indices32)
+                {
+                    const uint32* src = reinterpret_cast<const uint32*>(meshIndices);
+                    view.ClusterIndices.insert(view.ClusterIndices.end(), src + meshlet.IndexStart, src + indexEnd);
+                }
+                else
+                {
+                    const uint16* src = reinterpret_cast<const uint16*>(meshIndices);
+                    view.ClusterIndices.insert(view.ClusterIndices.end(), src + meshlet.IndexStart, src + indexEnd);
+                }
+            }
+
+            const uint32 clusterIndexCount = uint32(view.ClusterIndices.size()) - clusterIndexStart;
+            if(clusterIndexCount == 0)
+                continue;
+
+            packet.IndexBuffer = view.ClusterIndexBuffer.GetInterfacePtr();
+            packet.IndexSize = sizeof(uint32);
+            packet.IndexStart = clusterIndexStart;
+            packet.IndexCount = clusterIndexCount;
+        }
+
+        const bool compressed = mesh.HasCompressedVertices();
+        const uint32 shaderID = compressed ? 1 : 0;
+        if(compressed)
+        {
+            if(meshConstantOffsets[item.MeshIdx] == NoConstants)
+            {
+                MeshDecodeConstants decodeConstants;
+                decodeConstants.PositionScale = mesh.PositionScale();
+                decodeConstants.PositionBias = mesh.PositionBias();
+                meshConstantOffsets[item.MeshIdx] = view.List.AddConstants(&decodeConstants, sizeof(decodeConstants));
+            }
+
+            packet.ConstantsOffset = meshConstantOffsets[item.MeshIdx];
+            packet.ConstantsSize = sizeof(MeshDecodeConstants);
+        }
+
+        if(depthOnly)
+        {
+            // Materials don't matter for depth-only rendering, so sort by mesh only
+            packet.SortKey = MakeDrawSortKey(shaderID, item.MeshIdx, 0, depth);
+            packet.VS = compressed ? meshDepthCompressedVS : meshDepthVS;
+            packet.PS = nullptr;
+            packet.InputLayout = meshDepthInputLayouts[item.MeshIdx].GetInterfacePtr();
+        }
+        else
+        {
+            const MeshMaterial& material = sceneModel->Materials()[part.MaterialIdx];
+
+            packet.SortKey = MakeDrawSortKey(shaderID, item.MeshIdx, part.MaterialIdx, depth);
+            packet.VS = compressed ? meshCompressedVS : meshVS;
+            packet.PS = meshPS;
+            packet.InputLayout = meshInputLayouts[item.MeshIdx].GetInterfacePtr();
+            packet.PSSRVs[0] = material.DiffuseMap.GetInterfacePtr();
+            packet.PSSRVs[1] = material.NormalMap.GetInterfacePtr();
+            packet.PSSRVs[2] = SunShadowMap();
+            packet.NumPSSRVs = 3;
+        }
+
+        view.List.AddPacket(packet);
+        view.NumTriangles += packet.IndexCount / 3;
+    }
+
+    view.List.Sort();
+
+    timer.Update();
+    view.BuildTime = timer.ElapsedMillisecondsF();
+}
+
 // Renders all meshes in the model, with shadows
 void MeshRenderer::RenderMainPass(ID3D11DeviceContext* context, const Camera& camera)
 {
@@ -378,8 +870,8 @@ void MeshRenderer::RenderMainPass(ID3D11DeviceContext* context, const Camera& ca
 
     // Set constant buffers
     meshVSConstants.Data.World = Float4x4();
-    meshVSConstants.Data.View = Float4x4::Transpose(camera.ViewMatrix());
-    meshVSConstants.Data.WorldViewProjection = Float4x4::Transpose(camera.ViewProjectionMatrix());
+    meshVSConstants.Data.View = Float4x4::Transpose(views[MainView].View);
+    meshVSConstants.Data.WorldViewProjection = Float4x4::Transpose(views[MainView].ViewProjection);
     meshVSConstants.ApplyChanges(context);
     meshVSConstants.SetVS(context, 0);
 
@@ -401,50 +893,26 @@ void MeshRenderer::RenderMainPass(ID3D11DeviceContext* context, const Camera& ca
     context->DSSetShader(nullptr, nullptr, 0);
     context->HSSetShader(nullptr, nullptr, 0);
     context->GSSetShader(nullptr, nullptr, 0);
-    context->VSSetShader(meshVS, nullptr, 0);
-    context->PSSetShader(meshPS, nullptr, 0);
-
-    // Draw all meshes
-    for(uint64 meshIdx = 0; meshIdx < sceneModel->Meshes().size(); ++meshIdx)
-    {
-        const Mesh& mesh = sceneModel->Meshes()[meshIdx];
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        // Set the vertices and indices
-        ID3D11Buffer* vertexBuffers[1] = { mesh.VertexBuffer() };
-        UINT vertexStrides[1] = { mesh.VertexStride() };
-        UINT offsets[1] = { 0 };
-        context->IASetVertexBuffers(0, 1, vertexBuffers, vertexStrides, offsets);
-        context->IASetIndexBuffer(mesh.IndexBuffer(), mesh.IndexBufferFormat(), 0);
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    UploadClusterIndices(context, MainView);
 
-        // Set the input layout
-        context->IASetInputLayout(meshInputLayouts[meshIdx]);
-
-        // Draw all parts
-        for(uint64 partIdx = 0; partIdx < mesh.MeshParts().size(); ++partIdx)
-        {
-            const MeshPart& part = mesh.MeshParts()[partIdx];
-            const MeshMaterial& material = sceneModel->Materials()[part.MaterialIdx];
-
-            // Set the textures
-            ID3D11ShaderResourceView* psTextures[] =
-            {
-                material.DiffuseMap,
-                material.NormalMap,
-                sunVSM.SRView,
-            };
-
-            context->PSSetShaderResources(0, ArraySize_(psTextures), psTextures);
-            context->DrawIndexed(part.IndexCount, part.IndexStart, 0);
-        }
-    }
+    D3D11DrawBackend backend(context, meshDecodeConstants.Buffer, 2);
+    views[MainView].List.Submit(backend);
+    mainPassDrawStats = backend.Stats;
 
     ID3D11ShaderResourceView* nullSRVs[8] = { NULL };
     context->PSSetShaderResources(0, 8, nullSRVs);
 }
 
-// Renders all meshes using depth-only rendering
-void MeshRenderer::RenderDepth(ID3D11DeviceContext* context, const Camera& camera, bool noZClip, bool flippedZRange)
+// Renders the depth prepass for the main camera
+void MeshRenderer::RenderDepthPrepass(ID3D11DeviceContext* context)
+{
+    RenderDepth(context, DepthPrepassView, false, false);
+}
+
+// Renders all meshes in a view's draw list using depth-only rendering
+void MeshRenderer::RenderDepth(ID3D11DeviceContext* context, uint32 viewIdx, bool noZClip, bool flippedZRange)
 {
     PIXEvent event(L"Mesh Depth Rendering");
 
@@ -461,47 +929,41 @@ void MeshRenderer::RenderDepth(ID3D11DeviceContext* context, const Camera& camer
 
     // Set constant buffers
     meshVSConstants.Data.World = Float4x4();
-    meshVSConstants.Data.View = Float4x4::Transpose(camera.ViewMatrix());
-    meshVSConstants.Data.WorldViewProjection = Float4x4::Transpose(camera.ViewProjectionMatrix());
+    meshVSConstants.Data.View = Float4x4::Transpose(views[viewIdx].View);
+    meshVSConstants.Data.WorldViewProjection = Float4x4::Transpose(views[viewIdx].ViewProjection);
     meshVSConstants.ApplyChanges(context);
     meshVSConstants.SetVS(context, 0);
 
     // Set shaders
-    context->VSSetShader(meshDepthVS , nullptr, 0);
-    context->PSSetShader(nullptr, nullptr, 0);
     context->GSSetShader(nullptr, nullptr, 0);
     context->DSSetShader(nullptr, nullptr, 0);
     context->HSSetShader(nullptr, nullptr, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    for(uint32 meshIdx = 0; meshIdx < sceneModel->Meshes().size(); ++meshIdx)
-    {
-        const Mesh& mesh = sceneModel->Meshes()[meshIdx];
+    UploadClusterIndices(context, viewIdx);
 
-        // Set the vertices and indices
-        ID3D11Buffer* vertexBuffers[1] = { mesh.VertexBuffer() };
-        UINT vertexStrides[1] = { mesh.VertexStride() };
-        UINT offsets[1] = { 0 };
-        context->IASetVertexBuffers(0, 1, vertexBuffers, vertexStrides, offsets);
-        context->IASetIndexBuffer(mesh.IndexBuffer(), mesh.IndexBufferFormat(), 0);
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    D3D11DrawBackend backend(context, meshDecodeConstants.Buffer, 2);
+    views[viewIdx].List.Submit(backend);
+}
 
-        // Set the input layout
-        context->IASetInputLayout(meshDepthInputLayouts[meshIdx]);
+// Copies the view's compacted meshlet indices into its dynamic index buffer
+void MeshRenderer::UploadClusterIndices(ID3D11DeviceContext* context, uint32 viewIdx)
+{
+    const ViewDrawData& view = views[viewIdx];
+    if(view.ClusterIndices.empty())
+        return;
 
-        // Draw all parts
-        for(uint64 partIdx = 0; partIdx < mesh.MeshParts().size(); ++partIdx)
-        {
-            const MeshPart& part = mesh.MeshParts()[partIdx];
-            context->DrawIndexed(part.IndexCount, part.IndexStart, 0);
-        }
-    }
+    Assert_(view.ClusterIndexBuffer != nullptr);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DXCall(context->Map(view.ClusterIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    memcpy(mapped.pData, view.ClusterIndices.data(), view.ClusterIndices.size() * sizeof(uint32));
+    context->Unmap(view.ClusterIndexBuffer, 0);
 }
 
-// Renders meshes using cascaded shadow mapping
-void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera& camera)
+// Fits the shadow cascades to the view frustum, and sets up the view for each cascade
+void MeshRenderer::SetupShadowCascades(const Camera& camera)
 {
-    PIXEvent event(L"Sun Shadow Map Rendering");
-
     const float MinDistance = reductionDepth.x;
     const float MaxDistance = reductionDepth.y;
 
@@ -535,21 +997,20 @@ void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera
     Float4x4 c0Matrix;
 
     const Float3 lightDir = AppSettings::SunDirection;
+    const float clipDist = camera.FarClip() - camera.NearClip();
 
-    // Render the meshes to each cascade
-    for(uint32 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
-    {
-        PIXEvent cascadeEvent((L"Rendering Shadow Map Cascade " + ToString(cascadeIdx)).c_str());
+    // Pick the up vector to use for the light camera
+    Float3 upDir = camera.Right();
 
-        // Set the viewport
-        SetViewport(context, ShadowMapSize, ShadowMapSize);
-
-        // Set the shadow map as the depth target
-        ID3D11DepthStencilView* dsv = sunShadowDepthMap.DSView;
-        ID3D11RenderTargetView* nullRenderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = { NULL };
-        context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, nullRenderTargets, dsv);
-        context->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH|D3D11_CLEAR_STENCIL, 1.0f, 0);
+    // Fit a bounding box to each cascade's slice of the view frustum, so that we can pick
+    // the shadow map resolution for each cascade before we allocate space in the atlas
+    Float3 frustumCenters[NumCascades];
+    Float3 minCascadeExtents[NumCascades];
+    Float3 maxCascadeExtents[NumCascades];
+    uint32 desiredSizes[NumCascades];
 
+    for(uint32 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
         // Get the 8 points of the view frustum in world space
         XMVECTOR frustumCornersWS[8] =
         {
@@ -588,9 +1049,6 @@ void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera
         frustumCenterVec = XMVectorScale(frustumCenterVec, 1.0f / 8.0f);
         Float3 frustumCenter = frustumCenterVec;
 
-        // Pick the up vector to use for the light camera
-        Float3 upDir = camera.Right();
-
         Float3 minExtents;
         Float3 maxExtents;
 
@@ -614,8 +1072,37 @@ void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera
             maxExtents = maxes;
         }
 
+        frustumCenters[cascadeIdx] = frustumCenter;
+        minCascadeExtents[cascadeIdx] = minExtents;
+        maxCascadeExtents[cascadeIdx] = maxExtents;
+
+        // Pick a resolution that roughly matches the size of a screen pixel at the near edge of
+        // the slice, which is where the cascade has the highest screen-space texel density
+        const float sliceNearZ = camera.NearClip() + prevSplitDist * clipDist;
+        const float pixelSizeWS = 2.0f * sliceNearZ / (camera.ProjectionMatrix()._22 * screenHeight);
+        const float cascadeSizeWS = std::max(maxExtents.x - minExtents.x, maxExtents.y - minExtents.y);
+        const float desiredTexels = ShadowTexelDensity * cascadeSizeWS / std::max(pixelSizeWS, 0.0001f);
+
+        uint32 cascadeSize = MinCascadeSize;
+        while(cascadeSize < desiredTexels && cascadeSize < MaxCascadeSize)
+            cascadeSize *= 2;
+        desiredSizes[cascadeIdx] = cascadeSize;
+    }
+
+    PackShadowAtlas(desiredSizes);
+
+    // Set up an orthographic camera for each cascade
+    for(uint32 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
+        const uint32 cascadeSize = cascadeSizes[cascadeIdx];
+
+        float splitDist = CascadeSplits[cascadeIdx];
+        Float3 frustumCenter = frustumCenters[cascadeIdx];
+        Float3 minExtents = minCascadeExtents[cascadeIdx];
+        Float3 maxExtents = maxCascadeExtents[cascadeIdx];
+
         // Adjust the min/max to accommodate the filtering size
-        float scale = (ShadowMapSize + FilterSize) / static_cast<float>(ShadowMapSize);
+        float scale = (cascadeSize + FilterSize) / static_cast<float>(cascadeSize);
         minExtents.x *= scale;
         minExtents.y *= scale;
         maxExtents.x *= scale;
@@ -631,21 +1118,17 @@ void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera
             maxExtents.y, 0.0f, cascadeExtents.z);
         shadowCamera.SetLookAt(shadowCameraPos, frustumCenter, upDir);
 
-        // Draw the mesh with depth only, using the new shadow camera
-        RenderDepth(context, shadowCamera, true, false);
+        views[CascadeView0 + cascadeIdx].View = shadowCamera.ViewMatrix();
+        views[CascadeView0 + cascadeIdx].ViewProjection = shadowCamera.ViewProjectionMatrix();
+        views[CascadeView0 + cascadeIdx].LODScale = shadowCamera.ProjectionMatrix()._22 * cascadeSize * 0.5f;
+        views[CascadeView0 + cascadeIdx].Orthographic = true;
 
         // Apply the scale/offset matrix, which transforms from [-1,1]
         // post-projection space to [0,1] UV space
-        XMMATRIX texScaleBias;
-        texScaleBias.r[0] = XMVectorSet(0.5f,  0.0f, 0.0f, 0.0f);
-        texScaleBias.r[1] = XMVectorSet(0.0f, -0.5f, 0.0f, 0.0f);
-        texScaleBias.r[2] = XMVectorSet(0.0f,  0.0f, 1.0f, 0.0f);
-        texScaleBias.r[3] = XMVectorSet(0.5f,  0.5f, 0.0f, 1.0f);
         XMMATRIX shadowMatrix = shadowCamera.ViewProjectionMatrix().ToSIMD();
-        shadowMatrix = XMMatrixMultiply(shadowMatrix, texScaleBias);
+        shadowMatrix = XMMatrixMultiply(shadowMatrix, TexScaleBias());
 
         // Store the split distance in terms of view space depth
-        const float clipDist = camera.FarClip() - camera.NearClip();
         shadowConstants.Data.CascadeSplits[cascadeIdx] = camera.NearClip() + splitDist * clipDist;
 
         if(cascadeIdx == 0)
@@ -673,7 +1156,266 @@ void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context, const Camera
             shadowConstants.Data.CascadeOffsets[cascadeIdx] = Float4(-cascadeCorner, 0.0f);
             shadowConstants.Data.CascadeScales[cascadeIdx] = Float4(cascadeScale, 1.0f);
         }
+    }
+}
+
+// Renders meshes using cascaded shadow mapping
+void MeshRenderer::RenderSunShadowMap(ID3D11DeviceContext* context)
+{
+    // The baked map doesn't need anything rendered per-frame
+    if(UsingBakedShadows())
+        return;
+
+    PIXEvent event(L"Sun Shadow Map Rendering");
+
+    // Render the meshes to each cascade
+    for(uint32 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
+        PIXEvent cascadeEvent((L"Rendering Shadow Map Cascade " + ToString(cascadeIdx)).c_str());
+
+        const uint32 cascadeSize = cascadeSizes[cascadeIdx];
+
+        // Set the viewport
+        SetViewport(context, cascadeSize, cascadeSize);
+
+        // Set the shadow map as the depth target
+        ID3D11DepthStencilView* dsv = sunShadowDepthMap.DSView;
+        ID3D11RenderTargetView* nullRenderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = { NULL };
+        context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, nullRenderTargets, dsv);
+        context->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH|D3D11_CLEAR_STENCIL, 1.0f, 0);
+
+        // Draw the mesh with depth only, using the cascade's draw list
+        RenderDepth(context, CascadeView0 + cascadeIdx, true, false);
 
         ConvertToEVSM(context, cascadeIdx, shadowConstants.Data.CascadeScales[cascadeIdx].To3D());
     }
 }
+
+bool MeshRenderer::UsingBakedShadows() const
+{
+    return AppSettings::BakedSunShadows && bakedShadowMap != nullptr;
+}
+
+ID3D11ShaderResourceView* MeshRenderer::SunShadowMap() const
+{
+    return UsingBakedShadows() ? bakedShadowMap.GetInterfacePtr() : sunVSM.SRView.GetInterfacePtr();
+}
+
+// The bake only depends on the scene geometry, which is identified by the hash of its mesh data
+// and the bounds of its parts, and on the sun direction and the bake settings
+std::wstring MeshRenderer::BakedShadowCacheName(const Float3& lightDir) const
+{
+    std::vector<float> cacheKey;
+    cacheKey.reserve(drawItems.size() * 6 + 8);
+    for(uint64 i = 0; i < drawItems.size(); ++i)
+    {
+        const BoundingBox& bounds = drawItems[i].Bounds;
+        cacheKey.push_back(bounds.Center.x);
+        cacheKey.push_back(bounds.Center.y);
+        cacheKey.push_back(bounds.Center.z);
+        cacheKey.push_back(bounds.Extents.x);
+        cacheKey.push_back(bounds.Extents.y);
+        cacheKey.push_back(bounds.Extents.z);
+    }
+
+    cacheKey.push_back(lightDir.x);
+    cacheKey.push_back(lightDir.y);
+    cacheKey.push_back(lightDir.z);
+    cacheKey.push_back(float(BakedShadowMapSize));
+    cacheKey.push_back(PositiveExponent);
+    cacheKey.push_back(NegativeExponent);
+    cacheKey.push_back(FilterSize);
+
+    Hash settingsHash = GenerateHash(cacheKey.data(), int(cacheKey.size() * sizeof(float)), BakedShadowCacheVersion);
+
+    uint64 hashKey[4] = { sceneGeometryHash.A, sceneGeometryHash.B, settingsHash.A, settingsHash.B };
+    Hash cacheHash = GenerateHash(hashKey, sizeof(hashKey), BakedShadowCacheVersion);
+    return std::wstring(BakedShadowCacheDir) + cacheHash.ToString() + L".evsm";
+}
+
+// Makes sure that the baked shadow map matches the current scene and sun direction, by loading it
+// from the cache or baking it again. This stalls for the readback and the CPU conversion, so it
+// should only happen when the scene is loaded or the sun moves.
+void MeshRenderer::UpdateBakedSunShadowMap(ID3D11DeviceContext* context)
+{
+    const Float3 lightDir = AppSettings::SunDirection;
+    if(drawItems.empty() || (bakedShadowMap != nullptr && bakedShadows.LightDirection == lightDir))
+        return;
+
+    Timer timer;
+
+    const std::wstring cacheName = BakedShadowCacheName(lightDir);
+    bool loadedFromCache = false;
+    if(FileExists(cacheName.c_str()))
+    {
+        try
+        {
+            FileReadSerializer serializer(cacheName.c_str());
+            SerializeItem(serializer, bakedShadows);
+
+            loadedFromCache = bakedShadows.Moments.Width == BakedShadowMapSize
+                              && bakedShadows.Moments.Height == BakedShadowMapSize
+                              && bakedShadows.Moments.Texels.size() == bakedShadows.Moments.MipOffset(bakedShadows.Moments.NumMips)
+                              && bakedShadows.Regions.size() == 1
+                              && bakedShadows.LightDirection == lightDir;
+        }
+        catch(const Exception&)
+        {
+            // A truncated or corrupt entry just gets baked again
+        }
+
+        if(loadedFromCache == false)
+            DeleteFile(cacheName.c_str());
+    }
+
+    if(loadedFromCache == false)
+    {
+        BakeSunShadowMap(context, lightDir);
+
+        if(DirectoryExists(BakedShadowCacheDir) == false)
+            Win32Call(CreateDirectory(BakedShadowCacheDir, nullptr));
+
+        // Write to a temporary file first, so that an interrupted write can't leave behind
+        // a truncated cache entry
+        const std::wstring tempName = cacheName + L".tmp";
+        {
+            FileWriteSerializer serializer(tempName.c_str());
+            SerializeItem(serializer, bakedShadows);
+        }
+        Win32Call(MoveFileEx(tempName.c_str(), cacheName.c_str(), MOVEFILE_REPLACE_EXISTING));
+    }
+
+    bakedShadowMap = CreateSRVFromTextureData(device, bakedShadows.Moments, false, DXGI_FORMAT_R32G32B32A32_FLOAT);
+
+    timer.Update();
+    bakedShadowUpdateTime = timer.ElapsedMillisecondsF();
+    bakedShadowsFromCache = loadedFromCache;
+}
+
+// Renders the whole scene into a single orthographic depth map, then reads it back and converts
+// and filters it into EVSM moments on the CPU
+void MeshRenderer::BakeSunShadowMap(ID3D11DeviceContext* context, const Float3& lightDir)
+{
+    PIXEvent event(L"Sun Shadow Map Baking");
+
+    BoundingBox sceneBounds = drawItems[0].Bounds;
+    for(uint64 i = 1; i < drawItems.size(); ++i)
+        BoundingBox::CreateMerged(sceneBounds, sceneBounds, drawItems[i].Bounds);
+
+    const Float3 sceneCenter = Float3(sceneBounds.Center.x, sceneBounds.Center.y, sceneBounds.Center.z);
+    const Float3 upDir = std::abs(lightDir.y) < 0.99f ? Float3(0.0f, 1.0f, 0.0f) : Float3(1.0f, 0.0f, 0.0f);
+
+    // Fit the projection to the scene bounds in light space
+    XMFLOAT3 sceneCorners[BoundingBox::CORNER_COUNT];
+    sceneBounds.GetCorners(sceneCorners);
+
+    Float3 lookAt = sceneCenter - lightDir;
+    XMMATRIX lightView = XMMatrixLookAtLH(sceneCenter.ToSIMD(), lookAt.ToSIMD(), upDir.ToSIMD());
+    XMVECTOR mins = XMVectorSet(REAL_MAX, REAL_MAX, REAL_MAX, REAL_MAX);
+    XMVECTOR maxes = XMVectorSet(-REAL_MAX, -REAL_MAX, -REAL_MAX, -REAL_MAX);
+    for(uint32 i = 0; i < BoundingBox::CORNER_COUNT; ++i)
+    {
+        XMVECTOR corner = XMVector3TransformCoord(XMLoadFloat3(&sceneCorners[i]), lightView);
+        mins = XMVectorMin(mins, corner);
+        maxes = XMVectorMax(maxes, corner);
+    }
+
+    Float3 minExtents = mins;
+    Float3 maxExtents = maxes;
+
+    // Leave room for the filter kernel at the edges
+    const float scale = (BakedShadowMapSize + FilterSize) / static_cast<float>(BakedShadowMapSize);
+    minExtents.x *= scale;
+    minExtents.y *= scale;
+    maxExtents.x *= scale;
+    maxExtents.y *= scale;
+
+    const Float3 bakeExtents = maxExtents - minExtents;
+    const Float3 shadowCameraPos = sceneCenter + lightDir * -minExtents.z;
+    OrthographicCamera shadowCamera(minExtents.x, minExtents.y, maxExtents.x, maxExtents.y, 0.0f, bakeExtents.z);
+    shadowCamera.SetLookAt(shadowCameraPos, sceneCenter, upDir);
+
+    // Borrow the first cascade's view for the draw list, since the cascades aren't rendered
+    // while the baked map is in use
+    ViewDrawData& view = views[CascadeView0];
+    view.View = shadowCamera.ViewMatrix();
+    view.ViewProjection = shadowCamera.ViewProjectionMatrix();
+    view.Position = shadowCameraPos;
+    view.LODScale = shadowCamera.ProjectionMatrix()._22 * BakedShadowMapSize * 0.5f;
+    view.Orthographic = true;
+    BuildDrawList(CascadeView0);
+
+    DepthStencilBuffer depthMap;
+    depthMap.Initialize(device, BakedShadowMapSize, BakedShadowMapSize, DXGI_FORMAT_D32_FLOAT, true);
+
+    SetViewport(context, BakedShadowMapSize, BakedShadowMapSize);
+    ID3D11RenderTargetView* nullRenderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = { NULL };
+    context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, nullRenderTargets, depthMap.DSView);
+    context->ClearDepthStencilView(depthMap.DSView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+    RenderDepth(context, CascadeView0, true, false);
+
+    context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, nullRenderTargets, nullptr);
+    view.List.Reset();
+
+    TextureData<Float4> readbackData;
+    GetTextureData(device, depthMap.SRView, readbackData);
+
+    TextureData<float> depthData;
+    depthData.Init(BakedShadowMapSize, BakedShadowMapSize, 1);
+    for(uint64 i = 0; i < depthData.Texels.size(); ++i)
+        depthData.Texels[i] = readbackData.Texels[i].x;
+
+    // Tighten the depth range to what the casters actually cover, which gets more precision out
+    // of the exponential warp. Texels that nothing was rendered to stay at 1.0.
+    const Float2 depthRange = ReduceDepthCPU(depthData, shadowCamera.ProjectionMatrix(), 0.0f, bakeExtents.z);
+    if(depthRange.y > depthRange.x)
+    {
+        const float rangeScale = 1.0f / (depthRange.y - depthRange.x);
+        for(uint64 i = 0; i < depthData.Texels.size(); ++i)
+            depthData.Texels[i] = Saturate((depthData.Texels[i] - depthRange.x) * rangeScale);
+
+        shadowCamera.SetFarClip(depthRange.y * bakeExtents.z);
+        shadowCamera.SetNearClip(depthRange.x * bakeExtents.z);
+    }
+
+    EVSMRegion region;
+    region.Rect.Width = BakedShadowMapSize;
+    region.Rect.Height = BakedShadowMapSize;
+
+    bakedShadows.Moments.Init(BakedShadowMapSize, BakedShadowMapSize, 1);
+    bakedShadows.Regions.assign(1, region);
+    bakedShadows.CascadeScales.assign(1, Float4(1.0f, 1.0f, 1.0f, 1.0f));
+    bakedShadows.PositiveExponent = PositiveExponent;
+    bakedShadows.NegativeExponent = NegativeExponent;
+    bakedShadows.ShadowMatrix = XMMatrixMultiply(shadowCamera.ViewProjectionMatrix().ToSIMD(), TexScaleBias());
+    bakedShadows.LightDirection = lightDir;
+
+    ConvertToEVSMCPU(depthData.Texels.data(), 1, Float3(1.0f, 1.0f, 1.0f), PositiveExponent, NegativeExponent,
+                     bakedShadows.Moments, region);
+    BlurEVSMCPU(bakedShadows.Moments, region, Float2(FilterSize, FilterSize));
+
+    // Unlike the atlas there's nothing next to the map that could bleed in, so it gets a full mip chain
+    GenerateMips(bakedShadows.Moments);
+}
+
+// Points every cascade at the baked map, so that the shader doesn't need a separate path for it
+void MeshRenderer::SetupBakedShadowConstants(const Camera& camera)
+{
+    shadowConstants.Data.ShadowMatrix = Float4x4::Transpose(bakedShadows.ShadowMatrix);
+    for(uint32 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
+        shadowConstants.Data.CascadeSplits[cascadeIdx] = camera.FarClip();
+        shadowConstants.Data.CascadeOffsets[cascadeIdx] = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+        shadowConstants.Data.CascadeScales[cascadeIdx] = Float4(1.0f, 1.0f, 1.0f, 1.0f);
+        shadowConstants.Data.CascadeAtlasScaleOffsets[cascadeIdx] = Float4(1.0f, 1.0f, 0.0f, 0.0f);
+
+        // PackShadowAtlas only writes the atlas constants when the cascade sizes change, so
+        // make sure that it runs again when switching back to the cascades
+        desiredCascadeSizes[cascadeIdx] = 0;
+    }
+
+    const TextureData<Float4>& moments = bakedShadows.Moments;
+    shadowConstants.Data.ShadowAtlasTexelSize = Float2(1.0f / moments.Width, 1.0f / moments.Height);
+    shadowConstants.Data.ShadowAtlasMaxMip = float(moments.NumMips - 1);
+}
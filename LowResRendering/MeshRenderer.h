@@ -12,14 +12,19 @@
 
 #include <PCH.h>
 
+#include <MurmurHash.h>
 #include <Graphics/Model.h>
 #include <Graphics/GraphicsTypes.h>
 #include <Graphics/DeviceStates.h>
 #include <Graphics/Camera.h>
 #include <Graphics/SH.h>
 #include <Graphics/ShaderCompilation.h>
+#include <Graphics/AtlasAllocator.h>
+#include <Graphics/Textures.h>
+#include <Graphics/DrawList.h>
 
 #include "AppSettings.h"
+#include "EVSM.h"
 
 using namespace SampleFramework11;
 
@@ -32,6 +37,12 @@ protected:
     static const uint32 NumCascades = 4;
     static const uint32 ReadbackLatency = 1;
 
+    // Views that get their own draw list
+    static const uint32 DepthPrepassView = 0;
+    static const uint32 MainView = 1;
+    static const uint32 CascadeView0 = 2;
+    static const uint32 NumViews = CascadeView0 + NumCascades;
+
 public:
 
     MeshRenderer();
@@ -39,7 +50,9 @@ public:
     void Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const Model* sceneModel);
     void SetModel(const Model* model);
 
-    void RenderDepth(ID3D11DeviceContext* context, const Camera& camera, bool noZClip, bool flippedZRange);
+    void BuildDrawLists(const Camera& camera);
+
+    void RenderDepthPrepass(ID3D11DeviceContext* context);
     void RenderMainPass(ID3D11DeviceContext* context, const Camera& camera);
 
     void Update(const Camera& camera);
@@ -49,14 +62,43 @@ public:
     void ReduceDepth(ID3D11DeviceContext* context, DepthStencilBuffer& depthTarget,
                      const Camera& camera);
 
-    void RenderSunShadowMap(ID3D11DeviceContext* context, const Camera& camera);
+    void RenderSunShadowMap(ID3D11DeviceContext* context);
+    void UpdateBakedSunShadowMap(ID3D11DeviceContext* context);
+
+    // The EVSM map that the main pass samples the sun shadows from
+    ID3D11ShaderResourceView* SunShadowMap() const;
+
+    const AtlasAllocator& ShadowAtlas() const { return shadowAtlas; }
+    const DrawStats& MainPassDrawStats() const { return mainPassDrawStats; }
+
+    // CPU time spent culling and building each view's draw list, in milliseconds
+    float ViewBuildTime(uint32 viewIdx) const { return views[viewIdx].BuildTime; }
+    uint64 ViewNumDraws(uint32 viewIdx) const { return views[viewIdx].List.NumPackets(); }
+    uint64 ViewNumTriangles(uint32 viewIdx) const { return views[viewIdx].NumTriangles; }
+    uint32 NumDrawViews() const { return NumViews; }
 
+    // Meshlets tested and drawn for the main view during the last BuildDrawLists
+    uint32 NumMainViewMeshlets() const { return views[MainView].NumMeshlets; }
+    uint32 NumMainViewVisibleMeshlets() const { return views[MainView].NumVisibleMeshlets; }
+
+    // How long the last UpdateBakedSunShadowMap took to load or bake the map, in milliseconds
+    float BakedShadowUpdateTime() const { return bakedShadowUpdateTime; }
+    bool BakedShadowsLoadedFromCache() const { return bakedShadowsFromCache; }
 
 protected:
 
     void LoadShaders();
     void CreateShadowMaps();
+    void PackShadowAtlas(const uint32 desiredSizes[NumCascades]);
     void ConvertToEVSM(ID3D11DeviceContext* context, uint32 cascadeIdx, Float3 cascadeScale);
+    void SetupShadowCascades(const Camera& camera);
+    void SetupBakedShadowConstants(const Camera& camera);
+    void BakeSunShadowMap(ID3D11DeviceContext* context, const Float3& lightDir);
+    std::wstring BakedShadowCacheName(const Float3& lightDir) const;
+    bool UsingBakedShadows() const;
+    void BuildDrawList(uint32 viewIdx);
+    void RenderDepth(ID3D11DeviceContext* context, uint32 viewIdx, bool noZClip, bool flippedZRange);
+    void UploadClusterIndices(ID3D11DeviceContext* context, uint32 viewIdx);
 
     ID3D11DevicePtr device;
 
@@ -70,15 +112,71 @@ protected:
     DepthStencilBuffer sunShadowDepthMap;
     RenderTarget2D tempVSM;
 
+    AtlasAllocator shadowAtlas;
+    uint32 desiredCascadeSizes[NumCascades];
+    uint32 cascadeSizes[NumCascades];
+    AtlasRect cascadeRects[NumCascades];
+    uint32 screenHeight;
+
+    // Scene-wide EVSM map for the sun, baked on the CPU and cached on disk. It's used instead of
+    // the cascades when AppSettings::BakedSunShadows is enabled.
+    BakedEVSM bakedShadows;
+    ID3D11ShaderResourceViewPtr bakedShadowMap;
+
+    // Hash of the scene's vertices, indices and mesh parts, which identifies it in the bake cache
+    Hash sceneGeometryHash;
+
+    float bakedShadowUpdateTime;
+    bool bakedShadowsFromCache;
+
     ID3D11RasterizerStatePtr noZClipRSState;
     ID3D11SamplerStatePtr evsmSampler;
 
     std::vector<ID3D11InputLayoutPtr> meshInputLayouts;
     VertexShaderPtr meshVS;
+    VertexShaderPtr meshCompressedVS;
     PixelShaderPtr meshPS;
 
     std::vector<ID3D11InputLayoutPtr> meshDepthInputLayouts;
     VertexShaderPtr meshDepthVS;
+    VertexShaderPtr meshDepthCompressedVS;
+
+    // A mesh part, with its bounds for frustum culling
+    struct DrawItem
+    {
+        uint32 MeshIdx;
+        uint32 PartIdx;
+        BoundingBox Bounds;
+    };
+
+    struct ViewDrawData
+    {
+        Float4x4 View;
+        Float4x4 ViewProjection;
+        Float3 Position;
+        DrawList List;
+        float BuildTime;
+        uint64 NumTriangles;
+
+        // Converts an object-space distance to pixels for picking LODs. Perspective views also
+        // divide by the distance to the camera.
+        float LODScale;
+        bool Orthographic;
+
+        // Indices of the meshlets that survived cluster culling, which are copied into
+        // ClusterIndexBuffer before the list is submitted
+        std::vector<uint32> ClusterIndices;
+        ID3D11BufferPtr ClusterIndexBuffer;
+        uint32 NumMeshlets;
+        uint32 NumVisibleMeshlets;
+
+        ViewDrawData() : BuildTime(0.0f), NumTriangles(0), LODScale(1.0f), Orthographic(false),
+                         NumMeshlets(0), NumVisibleMeshlets(0) {}
+    };
+
+    std::vector<DrawItem> drawItems;
+    ViewDrawData views[NumViews];
+    DrawStats mainPassDrawStats;
 
     VertexShaderPtr fullScreenVS;
     PixelShaderPtr evsmConvertPS;
@@ -101,6 +199,13 @@ protected:
         Float4Align Float4x4 WorldViewProjection;
     };
 
+    // Per-mesh constants for decoding compressed vertices, supplied through the draw lists
+    struct MeshDecodeConstants
+    {
+        Float4Align Float3 PositionScale;
+        Float4Align Float3 PositionBias;
+    };
+
     struct MeshPSConstants
     {
         Float4Align Float3 SunDirectionWS;
@@ -117,6 +222,7 @@ protected:
         float NegativeExponent;
         float FilterSize;
         Float2 ShadowMapSize;
+        Float2 AtlasOffset;
     };
 
     struct ReductionConstants
@@ -130,6 +236,7 @@ protected:
 
     ConstantBuffer<MeshVSConstants> meshVSConstants;
     ConstantBuffer<MeshPSConstants> meshPSConstants;
+    ConstantBuffer<MeshDecodeConstants> meshDecodeConstants;
     ConstantBuffer<EVSMConstants> evsmConstants;
     ConstantBuffer<ReductionConstants> reductionConstants;
 
@@ -142,10 +249,13 @@ public:
 
         Float4Align Float4 CascadeOffsets[NumCascades];
         Float4Align Float4 CascadeScales[NumCascades];
+        Float4Align Float4 CascadeAtlasScaleOffsets[NumCascades];
 
         float PositiveExponent;
         float NegativeExponent;
         float LightBleedingReduction;
+        Float4Align Float2 ShadowAtlasTexelSize;
+        float ShadowAtlasMaxMip;
     };
 
     ConstantBuffer<ShadowConstants> shadowConstants;
@@ -32,7 +32,7 @@ cbuffer ParticleConstants : register(b0)
 
 StructuredBuffer<ParticleData> ParticleRenderBuffer : register(t0);
 Texture2D<float4> ParticleTexture : register(t0);
-Texture2DArray SunShadowMap : register(t1);
+Texture2D SunShadowMap : register(t1);
 SamplerState LinearSampler : register(s0);
 SamplerState EVSMSampler : register(s1);
 
@@ -21,9 +21,12 @@ cbuffer ShadowConstants : register(b1)
     float4 CascadeSplits;
     float4 CascadeOffsets[NumCascades];
     float4 CascadeScales[NumCascades];
+    float4 CascadeAtlasScaleOffsets[NumCascades];
     float PositiveExponent;
     float NegativeExponent;
     float LightBleedingReduction;
+    float2 ShadowAtlasTexelSize;
+    float ShadowAtlasMaxMip;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -31,13 +34,13 @@ cbuffer ShadowConstants : register(b1)
 //-------------------------------------------------------------------------------------------------
 float SampleShadowMapEVSM(in float3 shadowPos, in float3 shadowPosDX,
                           in float3 shadowPosDY, in uint cascadeIdx,
-                          in Texture2DArray sunShadowMap, in SamplerState evsmSampler)
+                          in Texture2D sunShadowMap, in SamplerState evsmSampler)
 {
     float2 exponents = GetEVSMExponents(PositiveExponent, NegativeExponent,
                                         CascadeScales[cascadeIdx].xyz);
     float2 warpedDepth = WarpDepth(shadowPos.z, exponents);
 
-    float4 occluder = sunShadowMap.SampleGrad(evsmSampler, float3(shadowPos.xy, cascadeIdx),
+    float4 occluder = sunShadowMap.SampleGrad(evsmSampler, shadowPos.xy,
                                             shadowPosDX.xy, shadowPosDY.xy);
 
     // Derivative of warping at depth
@@ -57,7 +60,7 @@ float SampleShadowMapEVSM(in float3 shadowPos, in float3 shadowPosDX,
 //-------------------------------------------------------------------------------------------------
 float3 SampleShadowCascade(in float3 shadowPosition, in float3 shadowPosDX,
                            in float3 shadowPosDY, in uint cascadeIdx,
-                           in Texture2DArray sunShadowMap, in SamplerState evsmSampler)
+                           in Texture2D sunShadowMap, in SamplerState evsmSampler)
 {
     shadowPosition += CascadeOffsets[cascadeIdx].xyz;
     shadowPosition *= CascadeScales[cascadeIdx].xyz;
@@ -65,6 +68,24 @@ float3 SampleShadowCascade(in float3 shadowPosition, in float3 shadowPosDX,
     shadowPosDX *= CascadeScales[cascadeIdx].xyz;
     shadowPosDY *= CascadeScales[cascadeIdx].xyz;
 
+    // Remap to the cascade's region of the atlas
+    float4 atlasScaleOffset = CascadeAtlasScaleOffsets[cascadeIdx];
+    shadowPosDX.xy *= atlasScaleOffset.xy;
+    shadowPosDY.xy *= atlasScaleOffset.xy;
+
+    // Clamp so that filtering doesn't pull in texels from the padding or the neighboring regions.
+    // The texels get bigger on the lower mips, so the clamp moves inwards with the mip level. The
+    // isotropic LOD is never lower than what the anisotropic filter picks, so it's conservative.
+    float2 atlasSize = 1.0f / ShadowAtlasTexelSize;
+    float2 texelDX = shadowPosDX.xy * atlasSize;
+    float2 texelDY = shadowPosDY.xy * atlasSize;
+    float lod = 0.5f * log2(max(dot(texelDX, texelDX), dot(texelDY, texelDY)));
+    float mipTexelScale = exp2(clamp(ceil(lod), 0.0f, ShadowAtlasMaxMip));
+    float2 halfTexel = ShadowAtlasTexelSize * 0.5f * mipTexelScale;
+    float2 atlasMin = atlasScaleOffset.zw + halfTexel;
+    float2 atlasMax = atlasScaleOffset.zw + atlasScaleOffset.xy - halfTexel;
+    shadowPosition.xy = clamp(shadowPosition.xy * atlasScaleOffset.xy + atlasScaleOffset.zw, atlasMin, atlasMax);
+
     float3 cascadeColor = 1.0f;
 
     float shadow = SampleShadowMapEVSM(shadowPosition, shadowPosDX, shadowPosDY, cascadeIdx, sunShadowMap, evsmSampler);
@@ -76,7 +97,7 @@ float3 SampleShadowCascade(in float3 shadowPosition, in float3 shadowPosDX,
 // Computes the sun visibility term by performing the shadow test
 //--------------------------------------------------------------------------------------
 float3 SunShadowVisibility(in float3 positionWS, in float depthVS,
-                           in Texture2DArray sunShadowMap, in SamplerState evsmSampler)
+                           in Texture2D sunShadowMap, in SamplerState evsmSampler)
 {
     float3 shadowVisibility = 1.0f;
     uint cascadeIdx = 0;
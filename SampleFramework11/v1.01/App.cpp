@@ -13,10 +13,12 @@
 #include "Exceptions.h"
 #include "Graphics\\Profiler.h"
 #include "Graphics\\Spectrum.h"
+#include "Graphics\\Textures.h"
 #include "SF11_Math.h"
 #include "FileIO.h"
 #include "Settings.h"
 #include "TwHelper.h"
+#include "ThreadPool.h"
 
 // AppSettings framework
 namespace AppSettings
@@ -78,6 +80,8 @@ int32 App::Run()
 
         Profiler::GlobalProfiler.Initialize(deviceManager.Device(), deviceManager.ImmediateContext());
 
+        ThreadPool::GlobalPool.Initialize();
+
         window.RegisterMessageCallback(WM_SIZE, OnWindowResized, this);
 
         // Initialize AntTweakBar
@@ -144,6 +148,10 @@ int32 App::Run()
 
     ShutdownShaders();
 
+    TextureCache::Global.Clear();
+
+    ThreadPool::GlobalPool.Shutdown();
+
     TwCall(TwTerminate());
 
     if(createConsole)
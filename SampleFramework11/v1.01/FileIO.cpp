@@ -225,4 +225,37 @@ uint64 File::Size() const
     return fileSize.QuadPart;
 }
 
-}
\ No newline at end of file
+// == MappedFile ==================================================================================
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::MappedFile(const wchar* filePath)
+{
+    Open(filePath);
+}
+
+void MappedFile::Open(const wchar* filePath)
+{
+    Assert_(file.Data() == nullptr);
+    Assert_(FileExists(filePath));
+
+    if(file.Open(filePath))
+        return;
+
+    // Empty files can't be mapped, but there's nothing to read from them anyway
+    const DWORD errorCode = GetLastError();
+    if(errorCode == ERROR_HANDLE_EOF)
+        return;
+
+    const std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+    throw Win32Exception(errorCode, errPrefix.c_str());
+}
+
+void MappedFile::Close()
+{
+    file.Close();
+}
+
+}
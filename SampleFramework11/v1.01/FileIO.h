@@ -13,6 +13,7 @@
 
 #include "Exceptions.h"
 #include "Utility.h"
+#include "Graphics\\DDSParser.h"
 
 namespace SampleFramework11
 {
@@ -78,6 +79,34 @@ template<typename T> void File::Write(const T& data) const
     Write(sizeof(T), &data);
 }
 
+// Read-only memory mapping of an entire file. The contents stay valid until the file is closed.
+// This wraps DDS::MappedFile with the framework's error handling: failures throw, and empty files
+// can be opened (with a null Data() and a Size() of 0).
+class MappedFile
+{
+
+private:
+
+    DDS::MappedFile file;
+
+public:
+
+    // Lifetime
+    MappedFile();
+    explicit MappedFile(const wchar* filePath);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Explicit Open and close
+    void Open(const wchar* filePath);
+    void Close();
+
+    // Accessors
+    const uint8* Data() const { return file.Data(); }
+    uint64 Size() const { return file.Size(); }
+};
+
 // Templated helper functions
 
 // Reads a POD type from a file
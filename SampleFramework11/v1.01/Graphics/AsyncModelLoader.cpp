@@ -0,0 +1,229 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "AsyncModelLoader.h"
+
+#include "..\\Assert.h"
+#include "..\\Utility.h"
+#include "..\\ThreadPool.h"
+#include "Textures.h"
+
+namespace SampleFramework11
+{
+
+AsyncModelLoader::AsyncModelLoader() : model(nullptr), diffuseCompression(TextureCompression::None),
+                                       normalMapCompression(TextureCompression::None), geometryReady(false),
+                                       loadingDone(false), failed(false), geometryLoaded(false), fullyLoaded(false),
+                                       geometryLoadTime(0.0f), fullLoadTime(0.0f), numTexturesLoaded(0)
+{
+}
+
+AsyncModelLoader::~AsyncModelLoader()
+{
+    if(loadThread.joinable())
+        loadThread.join();
+}
+
+void AsyncModelLoader::Start(ID3D11Device* device_, Model* model_, const wchar* fileName_,
+                             const ModelImportOptions& importOptions_, TextureCompression diffuseCompression_,
+                             TextureCompression normalMapCompression_)
+{
+    Assert_(model_ != nullptr);
+    Assert_(loadThread.joinable() == false);
+
+    device = device_;
+    model = model_;
+    fileName = fileName_;
+    importOptions = importOptions_;
+    importOptions.LoadTextures = false;
+    diffuseCompression = diffuseCompression_;
+    normalMapCompression = normalMapCompression_;
+
+    loadTimer = Timer();
+    loadThread = std::thread(&AsyncModelLoader::LoadThread, this);
+}
+
+void AsyncModelLoader::AddTextureJob(const std::wstring& filePath, bool forceSRGB, TextureCompression compression,
+                                     uint32 materialIdx, bool normalMap)
+{
+    uint64 jobIdx = 0;
+    while(jobIdx < textureJobs.size() && (textureJobs[jobIdx].FilePath != filePath
+                                          || textureJobs[jobIdx].ForceSRGB != forceSRGB
+                                          || textureJobs[jobIdx].Compression != compression))
+        ++jobIdx;
+
+    if(jobIdx == textureJobs.size())
+    {
+        TextureJob job;
+        job.FilePath = filePath;
+        job.ForceSRGB = forceSRGB;
+        job.Compression = compression;
+        textureJobs.push_back(job);
+    }
+
+    if(normalMap)
+        textureJobs[jobIdx].NormalMaterials.push_back(materialIdx);
+    else
+        textureJobs[jobIdx].DiffuseMaterials.push_back(materialIdx);
+}
+
+void AsyncModelLoader::SetError(const Exception& exception)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(failed == false)
+    {
+        failed = true;
+        error = exception;
+    }
+}
+
+void AsyncModelLoader::LoadThread()
+{
+    // WIC needs COM to be initialized on every thread that decodes images
+    const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    try
+    {
+        model->CreateWithAssimp(device, fileName.c_str(), importOptions);
+
+        // Gather up the textures before the model is handed over, since the main thread owns it after
+        // that. Materials that share a texture only load it once, and like LoadMaterialResources, only
+        // the diffuse maps use ForceSRGB.
+        const std::vector<MeshMaterial>& materials = model->Materials();
+        for(uint64 i = 0; i < materials.size(); ++i)
+        {
+            std::wstring path;
+            if(Model::DiffuseMapPath(materials[i], model->FileDirectory(), path))
+                AddTextureJob(path, importOptions.ForceSRGB, diffuseCompression, uint32(i), false);
+            if(Model::NormalMapPath(materials[i], model->FileDirectory(), path))
+                AddTextureJob(path, false, normalMapCompression, uint32(i), true);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            geometryReady = true;
+        }
+
+        // Leave a hardware thread for the main thread, since it keeps rendering during the load
+        texturePool.Initialize(std::max<uint32>(std::thread::hardware_concurrency(), 2) - 1);
+
+        // Each texture gets its own deferred context for generating mips, which is turned into a
+        // command list that the main thread executes before swapping the texture in
+        texturePool.ParallelFor(textureJobs.size(), 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            const HRESULT threadComResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+            for(uint64 jobIdx = start; jobIdx < end; ++jobIdx)
+            {
+                try
+                {
+                    const TextureJob& job = textureJobs[jobIdx];
+
+                    ID3D11DeviceContextPtr deferredContext;
+                    DXCall(device->CreateDeferredContext(0, &deferredContext));
+
+                    LoadedTexture texture;
+                    texture.JobIdx = uint32(jobIdx);
+                    texture.SRV = LoadTexture(device, deferredContext, job.FilePath.c_str(), job.ForceSRGB,
+                                              job.Compression);
+                    DXCall(deferredContext->FinishCommandList(FALSE, &texture.CommandList));
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    loadedTextures.push_back(texture);
+                }
+                catch(Exception exception)
+                {
+                    SetError(exception);
+                }
+            }
+
+            if(SUCCEEDED(threadComResult))
+                CoUninitialize();
+        });
+    }
+    catch(Exception exception)
+    {
+        SetError(exception);
+    }
+
+    texturePool.Shutdown();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loadingDone = true;
+    }
+
+    if(SUCCEEDED(comResult))
+        CoUninitialize();
+}
+
+bool AsyncModelLoader::Update(ID3D11DeviceContext* context)
+{
+    if(model == nullptr || fullyLoaded)
+        return false;
+
+    std::vector<LoadedTexture> textures;
+    bool geometryReadyNow = false;
+    bool loadingDoneNow = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(failed)
+            throw error;
+
+        textures.swap(loadedTextures);
+        geometryReadyNow = geometryReady;
+        loadingDoneNow = loadingDone;
+    }
+
+    bool modelChanged = false;
+    if(geometryReadyNow && geometryLoaded == false)
+    {
+        loadTimer.Update();
+        geometryLoaded = true;
+        geometryLoadTime = loadTimer.ElapsedMillisecondsF();
+        modelChanged = true;
+    }
+
+    for(uint64 i = 0; i < textures.size(); ++i)
+    {
+        const LoadedTexture& texture = textures[i];
+        if(texture.CommandList != nullptr)
+            context->ExecuteCommandList(texture.CommandList, TRUE);
+
+        std::vector<MeshMaterial>& materials = model->Materials();
+        const TextureJob& job = textureJobs[texture.JobIdx];
+        for(uint64 j = 0; j < job.DiffuseMaterials.size(); ++j)
+            materials[job.DiffuseMaterials[j]].DiffuseMap = texture.SRV;
+        for(uint64 j = 0; j < job.NormalMaterials.size(); ++j)
+            materials[job.NormalMaterials[j]].NormalMap = texture.SRV;
+
+        ++numTexturesLoaded;
+    }
+
+    // Every texture is pushed before loadingDone gets set, so they've all been swapped in by now
+    if(loadingDoneNow)
+    {
+        loadThread.join();
+
+        loadTimer.Update();
+        fullyLoaded = true;
+        fullLoadTime = loadTimer.ElapsedMillisecondsF();
+
+        // Every material has its final textures now, so anything that's only referenced by the
+        // cache belonged to a model that was replaced or released in the meantime
+        TextureCache::Global.Trim();
+    }
+
+    return modelChanged;
+}
+
+}
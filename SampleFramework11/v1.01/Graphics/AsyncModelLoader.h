@@ -0,0 +1,121 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\InterfacePointers.h"
+#include "..\\Exceptions.h"
+#include "..\\Timer.h"
+#include "..\\ThreadPool.h"
+#include "Model.h"
+#include "Textures.h"
+
+namespace SampleFramework11
+{
+
+// Loads a Model in the background, so that the app can start rendering right away. The model is
+// imported on a loading thread with every material using the default textures, and is handed over
+// once its vertex and index buffers have been created. After that the material textures are
+// decoded and created on the loader's own thread pool, and each one is swapped in as soon as it's
+// done. Encoding a texture can take seconds, and the global pool only runs one loop at a time, so
+// using it would leave the main thread's ParallelFor calls running serially for the whole load.
+//
+// Update() needs to be called from the main thread every frame, since that's where the model is
+// handed over, where the command lists that generate texture mips are executed, and where errors
+// from the loading threads get re-thrown. The main thread can't touch the model until Update() has
+// reported that its geometry is loaded. The device needs to be created without
+// D3D11_CREATE_DEVICE_SINGLETHREADED (see DeviceManager::SetMultithreadedDevice).
+class AsyncModelLoader
+{
+
+public:
+
+    AsyncModelLoader();
+    ~AsyncModelLoader();
+
+    // Takes the same import settings as Model::CreateWithAssimp (LoadTextures is ignored, since the
+    // textures are always loaded afterwards), along with the block compression to apply to the
+    // diffuse and normal maps (see LoadTexture)
+    void Start(ID3D11Device* device, Model* model, const wchar* fileName,
+               const ModelImportOptions& importOptions = ModelImportOptions(),
+               TextureCompression diffuseCompression = TextureCompression::None,
+               TextureCompression normalMapCompression = TextureCompression::None);
+
+    // Returns true on the call where the model's meshes became available
+    bool Update(ID3D11DeviceContext* context);
+
+    bool GeometryLoaded() const { return geometryLoaded; }
+    bool FullyLoaded() const { return fullyLoaded; }
+
+    // Time from Start() until Update() picked up the geometry and the last texture, in milliseconds
+    float GeometryLoadTime() const { return geometryLoadTime; }
+    float FullLoadTime() const { return fullLoadTime; }
+
+    uint32 NumTexturesLoaded() const { return numTexturesLoaded; }
+    uint32 NumTextures() const { return geometryLoaded ? uint32(textureJobs.size()) : 0; }
+
+protected:
+
+    // A texture file, along with the materials that use it
+    struct TextureJob
+    {
+        std::wstring FilePath;
+        bool ForceSRGB;
+        TextureCompression Compression;
+        std::vector<uint32> DiffuseMaterials;
+        std::vector<uint32> NormalMaterials;
+    };
+
+    struct LoadedTexture
+    {
+        uint32 JobIdx;
+        ID3D11ShaderResourceViewPtr SRV;
+        ID3D11CommandListPtr CommandList;
+    };
+
+    void LoadThread();
+    void AddTextureJob(const std::wstring& filePath, bool forceSRGB, TextureCompression compression,
+                       uint32 materialIdx, bool normalMap);
+    void SetError(const Exception& exception);
+
+    std::thread loadThread;
+    ID3D11DevicePtr device;
+    Model* model;
+
+    std::wstring fileName;
+    ModelImportOptions importOptions;
+    TextureCompression diffuseCompression;
+    TextureCompression normalMapCompression;
+
+    // Only written by the loading thread before the geometry is handed over
+    std::vector<TextureJob> textureJobs;
+
+    // Only used by the loading thread, and shut down once the textures are done
+    ThreadPool texturePool;
+
+    // Shared with the loading threads
+    std::mutex mutex;
+    std::vector<LoadedTexture> loadedTextures;
+    bool geometryReady;
+    bool loadingDone;
+    bool failed;
+    Exception error;
+
+    // Only used on the main thread
+    Timer loadTimer;
+    bool geometryLoaded;
+    bool fullyLoaded;
+    float geometryLoadTime;
+    float fullLoadTime;
+    uint32 numTexturesLoaded;
+};
+
+}
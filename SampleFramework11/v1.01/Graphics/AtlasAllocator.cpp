@@ -0,0 +1,237 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "AtlasAllocator.h"
+
+#include <assert.h>
+#include <algorithm>
+
+namespace SampleFramework11
+{
+
+AtlasAllocator::AtlasAllocator() : width(0), height(0), padding(0)
+{
+}
+
+void AtlasAllocator::Initialize(uint32_t width_, uint32_t height_, uint32_t padding_)
+{
+    assert(width_ > 0 && height_ > 0);
+    width = width_;
+    height = height_;
+    padding = padding_;
+
+    Reset();
+}
+
+void AtlasAllocator::Reset()
+{
+    // Padding is added to the right and bottom of every rectangle, so we let the skyline
+    // extend past the edge of the atlas by that amount to avoid wasting space on the borders
+    skyline.clear();
+    SkylineNode node = { 0, 0, width + padding };
+    skyline.push_back(node);
+
+    stats = AtlasStats();
+}
+
+// Checks if a rectangle fits with its left edge placed at the given skyline node, and returns
+// the lowest Y coordinate that it can be placed at
+bool AtlasAllocator::FitsAt(uint64_t nodeIdx, uint32_t rectWidth, uint32_t rectHeight, uint32_t& y) const
+{
+    const uint32_t x = skyline[nodeIdx].X;
+    if(x + rectWidth > width + padding)
+        return false;
+
+    y = skyline[nodeIdx].Y;
+    uint32_t widthLeft = rectWidth;
+    uint64_t i = nodeIdx;
+    while(widthLeft > 0)
+    {
+        assert(i < skyline.size());
+        y = std::max(y, skyline[i].Y);
+        if(y + rectHeight > height + padding)
+            return false;
+
+        if(skyline[i].Width >= widthLeft)
+            break;
+
+        widthLeft -= skyline[i].Width;
+        ++i;
+    }
+
+    return true;
+}
+
+void AtlasAllocator::AddSkylineLevel(uint64_t nodeIdx, uint32_t x, uint32_t y, uint32_t rectWidth, uint32_t rectHeight)
+{
+    SkylineNode newNode = { x, y + rectHeight, rectWidth };
+    skyline.insert(skyline.begin() + nodeIdx, newNode);
+
+    // Shrink or remove the nodes that are now covered by the new level
+    for(uint64_t i = nodeIdx + 1; i < skyline.size();)
+    {
+        const SkylineNode& prev = skyline[i - 1];
+        SkylineNode& node = skyline[i];
+        const uint32_t prevEnd = prev.X + prev.Width;
+        if(node.X >= prevEnd)
+            break;
+
+        const uint32_t shrink = prevEnd - node.X;
+        if(node.Width <= shrink)
+        {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+
+        node.X += shrink;
+        node.Width -= shrink;
+        break;
+    }
+
+    // Merge neighboring nodes at the same height
+    for(uint64_t i = 0; i + 1 < skyline.size();)
+    {
+        if(skyline[i].Y == skyline[i + 1].Y)
+        {
+            skyline[i].Width += skyline[i + 1].Width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+}
+
+bool AtlasAllocator::Allocate(uint32_t rectWidth, uint32_t rectHeight, AtlasRect& rect)
+{
+    assert(width > 0 && height > 0);
+
+    const uint32_t paddedWidth = rectWidth + padding;
+    const uint32_t paddedHeight = rectHeight + padding;
+
+    // Bottom-left heuristic: pick the position with the lowest top edge, and break ties
+    // by picking the narrowest skyline segment
+    uint64_t bestIdx = uint64_t(-1);
+    uint32_t bestTop = UINT32_MAX;
+    uint32_t bestSegmentWidth = UINT32_MAX;
+    uint32_t bestY = 0;
+
+    for(uint64_t i = 0; i < skyline.size(); ++i)
+    {
+        uint32_t y = 0;
+        if(FitsAt(i, paddedWidth, paddedHeight, y) == false)
+            continue;
+
+        const uint32_t top = y + paddedHeight;
+        if(top < bestTop || (top == bestTop && skyline[i].Width < bestSegmentWidth))
+        {
+            bestIdx = i;
+            bestTop = top;
+            bestSegmentWidth = skyline[i].Width;
+            bestY = y;
+        }
+    }
+
+    if(bestIdx == uint64_t(-1))
+    {
+        ++stats.NumFailedAllocations;
+        return false;
+    }
+
+    const uint32_t x = skyline[bestIdx].X;
+    AddSkylineLevel(bestIdx, x, bestY, paddedWidth, paddedHeight);
+
+    rect.X = x;
+    rect.Y = bestY;
+    rect.Width = rectWidth;
+    rect.Height = rectHeight;
+
+    ++stats.NumAllocations;
+    stats.AllocatedArea += uint64_t(rectWidth) * rectHeight;
+    UpdateStats();
+
+    return true;
+}
+
+bool AtlasAllocator::Repack(const uint32_t* widths, const uint32_t* heights, uint32_t count, AtlasRect* rects)
+{
+    Reset();
+
+    // Sorting by decreasing height (then width) gives a much tighter skyline
+    std::vector<uint32_t> order(count);
+    for(uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        if(heights[a] != heights[b])
+            return heights[a] > heights[b];
+        return widths[a] > widths[b];
+    });
+
+    bool success = true;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t idx = order[i];
+        if(Allocate(widths[idx], heights[idx], rects[idx]) == false)
+        {
+            rects[idx] = AtlasRect();
+            success = false;
+        }
+    }
+
+    #ifndef NDEBUG
+        // Every rectangle needs to be inside the atlas, and at least the padding away from the others
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            const AtlasRect& a = rects[i];
+            if(a.Width == 0 || a.Height == 0)
+                continue;
+
+            assert(a.X + a.Width <= width && a.Y + a.Height <= height);
+            for(uint32_t j = i + 1; j < count; ++j)
+            {
+                const AtlasRect& b = rects[j];
+                if(b.Width == 0 || b.Height == 0)
+                    continue;
+
+                const bool separateX = a.X + a.Width + padding <= b.X || b.X + b.Width + padding <= a.X;
+                const bool separateY = a.Y + a.Height + padding <= b.Y || b.Y + b.Height + padding <= a.Y;
+                assert(separateX || separateY);
+            }
+        }
+    #endif
+
+    return success;
+}
+
+void AtlasAllocator::UpdateStats()
+{
+    stats.SkylineArea = 0;
+    for(uint64_t i = 0; i < skyline.size(); ++i)
+    {
+        const SkylineNode& node = skyline[i];
+        if(node.X >= width)
+            continue;
+
+        const uint32_t nodeWidth = std::min(node.Width, width - node.X);
+        const uint32_t nodeHeight = std::min(node.Y, height);
+        stats.SkylineArea += uint64_t(nodeWidth) * nodeHeight;
+    }
+
+    const uint64_t totalArea = uint64_t(width) * height;
+    stats.Occupancy = float(double(stats.AllocatedArea) / double(totalArea));
+    if(stats.SkylineArea > 0)
+        stats.Fragmentation = float(1.0 - double(stats.AllocatedArea) / double(stats.SkylineArea));
+    else
+        stats.Fragmentation = 0.0f;
+}
+
+}
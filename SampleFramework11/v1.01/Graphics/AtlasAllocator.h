@@ -0,0 +1,88 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// This header is platform-neutral, and doesn't include PCH.h, so that the allocator can be tested
+// on its own (see Tests/AtlasAllocatorTests.cpp)
+
+#include <stdint.h>
+#include <vector>
+
+namespace SampleFramework11
+{
+
+struct AtlasRect
+{
+    uint32_t X = 0;
+    uint32_t Y = 0;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+
+    bool operator==(const AtlasRect& other) const
+    {
+        return X == other.X && Y == other.Y && Width == other.Width && Height == other.Height;
+    }
+};
+
+struct AtlasStats
+{
+    uint32_t NumAllocations = 0;
+    uint32_t NumFailedAllocations = 0;
+    uint64_t AllocatedArea = 0;       // Sum of the areas of all live allocations
+    uint64_t SkylineArea = 0;         // Area covered by the skyline, including holes trapped beneath it
+    float Occupancy = 0.0f;         // AllocatedArea / total atlas area
+    float Fragmentation = 0.0f;     // Fraction of the skyline area that's wasted
+};
+
+// Packs rectangles into a fixed-size 2D atlas using the "skyline bottom-left" heuristic.
+// Individual allocations can't be freed, instead the atlas is cleared and re-packed
+// whenever the set of rectangles changes.
+class AtlasAllocator
+{
+
+public:
+
+    AtlasAllocator();
+
+    void Initialize(uint32_t width, uint32_t height, uint32_t padding = 0);
+    void Reset();
+
+    bool Allocate(uint32_t width, uint32_t height, AtlasRect& rect);
+
+    // Clears the atlas and allocates all rectangles, largest first. Results are returned
+    // in the same order as the inputs. Returns false if any of the rectangles didn't fit.
+    bool Repack(const uint32_t* widths, const uint32_t* heights, uint32_t count, AtlasRect* rects);
+
+    uint32_t Width() const { return width; }
+    uint32_t Height() const { return height; }
+    const AtlasStats& Stats() const { return stats; }
+
+protected:
+
+    struct SkylineNode
+    {
+        uint32_t X;
+        uint32_t Y;
+        uint32_t Width;
+    };
+
+    bool FitsAt(uint64_t nodeIdx, uint32_t rectWidth, uint32_t rectHeight, uint32_t& y) const;
+    void AddSkylineLevel(uint64_t nodeIdx, uint32_t x, uint32_t y, uint32_t rectWidth, uint32_t rectHeight);
+    void UpdateStats();
+
+    std::vector<SkylineNode> skyline;
+    AtlasStats stats;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t padding;
+};
+
+}
@@ -0,0 +1,1124 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "BCDecoder.h"
+#include "PixelConversion.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define BC_SSE2_ 1
+#else
+    #define BC_SSE2_ 0
+#endif
+
+namespace SampleFramework11
+{
+
+namespace BC
+{
+
+// == Helpers =====================================================================================
+
+// Blocks are little-endian, which is also what every platform that we build for is
+static uint16_t LoadUInt16(const uint8_t* data)
+{
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t LoadUInt32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t LoadUInt64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+static int32_t SignExtend(uint32_t value, uint32_t numBits)
+{
+    const uint32_t shift = 32 - numBits;
+    return int32_t(value << shift) >> shift;
+}
+
+// Reads the bits of a 128-bit block in order, starting from the lowest bit
+struct BitReader
+{
+    uint64_t Low;
+    uint64_t High;
+    uint32_t Position;
+
+    BitReader(const uint8_t* block) : Low(LoadUInt64(block)), High(LoadUInt64(block + 8)), Position(0)
+    {
+    }
+
+    uint32_t Read(uint32_t numBits)
+    {
+        if(numBits == 0)
+            return 0;
+
+        uint64_t value = 0;
+        if(Position >= 64)
+            value = High >> (Position - 64);
+        else if(Position + numBits <= 64)
+            value = Low >> Position;
+        else
+            value = (Low >> Position) | (High << (64 - Position));
+
+        Position += numBits;
+        return uint32_t(value & ((uint64_t(1) << numBits) - 1));
+    }
+
+    // For reading all of the indices at once, which never take up more than 63 bits
+    uint64_t Read64(uint32_t numBits)
+    {
+        const uint32_t numLowBits = std::min<uint32_t>(numBits, 32);
+        const uint64_t low = Read(numLowBits);
+        return low | (uint64_t(Read(numBits - numLowBits)) << 32);
+    }
+};
+
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits = sign;
+    if(exponent == 0x1F)
+    {
+        // Infinity or NaN
+        bits |= 0x7F800000 | (mantissa << 13);
+    }
+    else if(exponent != 0)
+    {
+        bits |= ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if(mantissa != 0)
+    {
+        // Denormalized, which needs to be renormalized for 32-bit floats
+        exponent = 113;
+        while((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits |= (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Converts 4 halves at a time. The exponent and mantissa are shifted into place and scaled by
+// 2^112 to re-bias the exponent, which also takes care of denormals.
+static void HalfToFloat4(const uint16_t* halves, float* floats)
+{
+    #if BC_SSE2_
+        const __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(halves)),
+                                             _mm_setzero_si128());
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+        const __m128i expMantissa = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+        const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(expMantissa), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+
+        // Infinity and NaN keep their mantissa, and get the maximum exponent
+        const __m128i infNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x0F7FE000));
+        const __m128i infNaNBits = _mm_or_si128(expMantissa, _mm_set1_epi32(0x7F800000));
+        __m128i bits = _mm_or_si128(_mm_andnot_si128(infNaN, _mm_castps_si128(scaled)),
+                                    _mm_and_si128(infNaN, infNaNBits));
+        bits = _mm_or_si128(bits, sign);
+        _mm_storeu_ps(floats, _mm_castsi128_ps(bits));
+    #else
+        for(uint32_t i = 0; i < 4; ++i)
+            floats[i] = HalfToFloat(halves[i]);
+    #endif
+}
+
+// == BC1-BC5 =====================================================================================
+
+// Builds the 4 RGBA colors of a BC1 color block. When transparency isn't allowed (BC2 and BC3),
+// the block always uses 4-color mode.
+static void BC1Palette(const uint8_t* block, bool allowTransparency, uint32_t* palette)
+{
+    const uint32_t c0 = LoadUInt16(block);
+    const uint32_t c1 = LoadUInt16(block + 2);
+
+    const uint32_t r0 = ((c0 >> 11) << 3) | (c0 >> 13);
+    const uint32_t g0 = (((c0 >> 5) & 0x3F) << 2) | ((c0 >> 9) & 0x3);
+    const uint32_t b0 = ((c0 & 0x1F) << 3) | ((c0 >> 2) & 0x7);
+    const uint32_t r1 = ((c1 >> 11) << 3) | (c1 >> 13);
+    const uint32_t g1 = (((c1 >> 5) & 0x3F) << 2) | ((c1 >> 9) & 0x3);
+    const uint32_t b1 = ((c1 & 0x1F) << 3) | ((c1 >> 2) & 0x7);
+
+    const bool fourColors = c0 > c1 || allowTransparency == false;
+
+    #if BC_SSE2_
+        const __m128i endpoints = _mm_setr_epi16(short(r0), short(g0), short(b0), 255,
+                                                 short(r1), short(g1), short(b1), 255);
+        const __m128i swapped = _mm_shuffle_epi32(endpoints, _MM_SHUFFLE(1, 0, 3, 2));
+
+        __m128i interpolated;
+        if(fourColors)
+        {
+            // (2 * c0 + c1) / 3 and (c0 + 2 * c1) / 3, dividing by multiplying with 65536 / 3
+            interpolated = _mm_add_epi16(_mm_add_epi16(endpoints, endpoints), swapped);
+            interpolated = _mm_mulhi_epu16(interpolated, _mm_set1_epi16(21846));
+        }
+        else
+        {
+            // (c0 + c1) / 2, followed by transparent black
+            interpolated = _mm_srli_epi16(_mm_add_epi16(endpoints, swapped), 1);
+            interpolated = _mm_and_si128(interpolated, _mm_setr_epi32(-1, -1, 0, 0));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(palette), _mm_packus_epi16(endpoints, interpolated));
+    #else
+        palette[0] = PackRGBA(r0, g0, b0, 255);
+        palette[1] = PackRGBA(r1, g1, b1, 255);
+        if(fourColors)
+        {
+            palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+            palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+        }
+        else
+        {
+            palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+            palette[3] = 0;
+        }
+    #endif
+}
+
+static void DecodeBC1Colors(const uint8_t* block, bool allowTransparency, uint32_t* texels)
+{
+    uint32_t palette[4];
+    BC1Palette(block, allowTransparency, palette);
+
+    const uint32_t indices = LoadUInt32(block + 4);
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = palette[(indices >> (i * 2)) & 0x3];
+}
+
+// Builds the 8 values of a BC4 block, rounding the interpolated values to nearest
+static void BC4PaletteU(const uint8_t* block, uint8_t* palette)
+{
+    const uint32_t r0 = block[0];
+    const uint32_t r1 = block[1];
+
+    #if BC_SSE2_
+        const __m128i v0 = _mm_set1_epi16(short(r0));
+        const __m128i v1 = _mm_set1_epi16(short(r1));
+
+        __m128i values;
+        if(r0 > r1)
+        {
+            // Dividing by 7 is done by multiplying with 65536 / 7
+            const __m128i weights0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+            const __m128i weights1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+            values = _mm_add_epi16(_mm_mullo_epi16(weights0, v0), _mm_mullo_epi16(weights1, v1));
+            values = _mm_mulhi_epu16(_mm_add_epi16(values, _mm_set1_epi16(3)), _mm_set1_epi16(9363));
+        }
+        else
+        {
+            // Same for 5, with the last two values being 0 and 255
+            const __m128i weights0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+            const __m128i weights1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+            values = _mm_add_epi16(_mm_mullo_epi16(weights0, v0), _mm_mullo_epi16(weights1, v1));
+            values = _mm_mulhi_epu16(_mm_add_epi16(values, _mm_set1_epi16(2)), _mm_set1_epi16(13108));
+            values = _mm_or_si128(values, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+        }
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(palette), _mm_packus_epi16(values, values));
+    #else
+        palette[0] = uint8_t(r0);
+        palette[1] = uint8_t(r1);
+        if(r0 > r1)
+        {
+            for(uint32_t i = 1; i < 7; ++i)
+                palette[i + 1] = uint8_t(((7 - i) * r0 + i * r1 + 3) / 7);
+        }
+        else
+        {
+            for(uint32_t i = 1; i < 5; ++i)
+                palette[i + 1] = uint8_t(((5 - i) * r0 + i * r1 + 2) / 5);
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    #endif
+}
+
+static void BC4PaletteS(const uint8_t* block, float* palette)
+{
+    // -128 and -127 both map to -1
+    const int32_t r0 = std::max<int32_t>(int8_t(block[0]), -127);
+    const int32_t r1 = std::max<int32_t>(int8_t(block[1]), -127);
+    const float f0 = r0 / 127.0f;
+    const float f1 = r1 / 127.0f;
+
+    palette[0] = f0;
+    palette[1] = f1;
+    if(r0 > r1)
+    {
+        for(uint32_t i = 1; i < 7; ++i)
+            palette[i + 1] = (f0 * (7 - i) + f1 * i) / 7.0f;
+    }
+    else
+    {
+        for(uint32_t i = 1; i < 5; ++i)
+            palette[i + 1] = (f0 * (5 - i) + f1 * i) / 5.0f;
+        palette[6] = -1.0f;
+        palette[7] = 1.0f;
+    }
+}
+
+static void DecodeBC4Channel(const uint8_t* block, uint8_t* texels)
+{
+    uint8_t palette[8];
+    BC4PaletteU(block, palette);
+
+    const uint64_t indices = LoadUInt64(block) >> 16;
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = palette[(indices >> (i * 3)) & 0x7];
+}
+
+static void DecodeBC4Channel(const uint8_t* block, float* texels)
+{
+    float palette[8];
+    BC4PaletteS(block, palette);
+
+    const uint64_t indices = LoadUInt64(block) >> 16;
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = palette[(indices >> (i * 3)) & 0x7];
+}
+
+void DecodeBC1(const uint8_t* block, uint32_t* texels)
+{
+    DecodeBC1Colors(block, true, texels);
+}
+
+void DecodeBC2(const uint8_t* block, uint32_t* texels)
+{
+    DecodeBC1Colors(block + 8, false, texels);
+
+    const uint64_t alpha = LoadUInt64(block);
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = (texels[i] & 0x00FFFFFF) | (uint32_t((alpha >> (i * 4)) & 0xF) * 17) << 24;
+}
+
+void DecodeBC3(const uint8_t* block, uint32_t* texels)
+{
+    DecodeBC1Colors(block + 8, false, texels);
+
+    uint8_t alpha[16];
+    DecodeBC4Channel(block, alpha);
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = (texels[i] & 0x00FFFFFF) | (uint32_t(alpha[i]) << 24);
+}
+
+void DecodeBC4U(const uint8_t* block, uint32_t* texels)
+{
+    uint8_t red[16];
+    DecodeBC4Channel(block, red);
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = PackRGBA(red[i], 0, 0, 255);
+}
+
+void DecodeBC4S(const uint8_t* block, float* texels)
+{
+    float red[16];
+    DecodeBC4Channel(block, red);
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        texels[i * 4 + 0] = red[i];
+        texels[i * 4 + 1] = 0.0f;
+        texels[i * 4 + 2] = 0.0f;
+        texels[i * 4 + 3] = 1.0f;
+    }
+}
+
+void DecodeBC5U(const uint8_t* block, uint32_t* texels)
+{
+    uint8_t red[16];
+    uint8_t green[16];
+    DecodeBC4Channel(block, red);
+    DecodeBC4Channel(block + 8, green);
+    for(uint32_t i = 0; i < 16; ++i)
+        texels[i] = PackRGBA(red[i], green[i], 0, 255);
+}
+
+void DecodeBC5S(const uint8_t* block, float* texels)
+{
+    float red[16];
+    float green[16];
+    DecodeBC4Channel(block, red);
+    DecodeBC4Channel(block + 8, green);
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        texels[i * 4 + 0] = red[i];
+        texels[i * 4 + 1] = green[i];
+        texels[i * 4 + 2] = 0.0f;
+        texels[i * 4 + 3] = 1.0f;
+    }
+}
+
+// == BC6H and BC7 tables =========================================================================
+
+static const uint32_t Weights2[4] = { 0, 21, 43, 64 };
+static const uint32_t Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint32_t Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static const uint32_t* InterpolationWeights(uint32_t indexBits)
+{
+    return indexBits == 2 ? Weights2 : (indexBits == 3 ? Weights3 : Weights4);
+}
+
+// Bit i is the subset of texel i. BC6H uses the first 32.
+static const uint16_t Partitions2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// 2 bits per texel, with texel 0 in the lowest bits
+static const uint32_t Partitions3[64] =
+{
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+// The anchor texel of each subset after the first, whose index is stored with one less bit
+static const uint8_t Anchors2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static const uint8_t Anchors3Second[64] =
+{
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+static const uint8_t Anchors3Third[64] =
+{
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+static uint32_t Subset(uint32_t numSubsets, uint32_t partition, uint32_t texelIdx)
+{
+    if(numSubsets == 2)
+        return (Partitions2[partition] >> texelIdx) & 0x1;
+    else if(numSubsets == 3)
+        return (Partitions3[partition] >> (texelIdx * 2)) & 0x3;
+    return 0;
+}
+
+// Returns a mask with a bit set for each anchor texel
+static uint32_t AnchorMask(uint32_t numSubsets, uint32_t partition)
+{
+    if(numSubsets == 2)
+        return 1 | (1 << Anchors2[partition]);
+    else if(numSubsets == 3)
+        return 1 | (1 << Anchors3Second[partition]) | (1 << Anchors3Third[partition]);
+    return 1;
+}
+
+// Unpacks 16 indices that were read in one go, where the anchor texels have one less bit
+static void UnpackIndices(uint64_t bits, uint32_t numBits, uint32_t anchorMask, uint32_t* indices)
+{
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        const uint32_t texelBits = numBits - ((anchorMask >> i) & 1);
+        indices[i] = uint32_t(bits & ((1 << texelBits) - 1));
+        bits >>= texelBits;
+    }
+}
+
+static uint32_t NumIndexBits(uint32_t numBits, uint32_t anchorMask)
+{
+    uint32_t numAnchors = 0;
+    for(; anchorMask != 0; anchorMask &= anchorMask - 1)
+        ++numAnchors;
+    return numBits * 16 - numAnchors;
+}
+
+// == BC7 =========================================================================================
+
+struct BC7Mode
+{
+    uint32_t NumSubsets;
+    uint32_t PartitionBits;
+    uint32_t RotationBits;
+    uint32_t IndexSelectionBits;
+    uint32_t ColorBits;
+    uint32_t AlphaBits;
+    uint32_t EndpointPBits;
+    uint32_t SharedPBits;
+    uint32_t IndexBits;
+    uint32_t IndexBits2;
+};
+
+static const BC7Mode BC7Modes[8] =
+{
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+    { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+    { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+// Interpolates between two RGBA endpoints for every index, two palette entries at a time
+static void BC7Palette(const uint8_t* e0, const uint8_t* e1, uint32_t indexBits, uint32_t* palette)
+{
+    const uint32_t* weights = InterpolationWeights(indexBits);
+    const uint32_t numEntries = 1 << indexBits;
+
+    #if BC_SSE2_
+        const __m128i v0 = _mm_setr_epi16(e0[0], e0[1], e0[2], e0[3], e0[0], e0[1], e0[2], e0[3]);
+        const __m128i v1 = _mm_setr_epi16(e1[0], e1[1], e1[2], e1[3], e1[0], e1[1], e1[2], e1[3]);
+        for(uint32_t i = 0; i < numEntries; i += 2)
+        {
+            const short w0 = short(weights[i]);
+            const short w1 = short(weights[i + 1]);
+            const __m128i w = _mm_setr_epi16(w0, w0, w0, w0, w1, w1, w1, w1);
+            const __m128i invW = _mm_sub_epi16(_mm_set1_epi16(64), w);
+            __m128i result = _mm_add_epi16(_mm_mullo_epi16(v0, invW), _mm_mullo_epi16(v1, w));
+            result = _mm_srli_epi16(_mm_add_epi16(result, _mm_set1_epi16(32)), 6);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(palette + i), _mm_packus_epi16(result, result));
+        }
+    #else
+        for(uint32_t i = 0; i < numEntries; ++i)
+        {
+            const uint32_t w = weights[i];
+            uint32_t channels[4];
+            for(uint32_t c = 0; c < 4; ++c)
+                channels[c] = ((64 - w) * e0[c] + w * e1[c] + 32) >> 6;
+            palette[i] = PackRGBA(channels[0], channels[1], channels[2], channels[3]);
+        }
+    #endif
+}
+
+void DecodeBC7(const uint8_t* block, uint32_t* texels)
+{
+    BitReader bits(block);
+
+    uint32_t modeIdx = 0;
+    while(modeIdx < 8 && bits.Read(1) == 0)
+        ++modeIdx;
+
+    // Reserved modes decode to 0 in every channel
+    if(modeIdx == 8)
+    {
+        memset(texels, 0, sizeof(uint32_t) * 16);
+        return;
+    }
+
+    const BC7Mode& mode = BC7Modes[modeIdx];
+    const uint32_t partition = bits.Read(mode.PartitionBits);
+    const uint32_t rotation = bits.Read(mode.RotationBits);
+    const uint32_t indexSelection = bits.Read(mode.IndexSelectionBits);
+
+    // [subset * 2 + endpoint][channel]
+    uint8_t endpoints[6][4];
+    const uint32_t numEndpoints = mode.NumSubsets * 2;
+    for(uint32_t c = 0; c < 3; ++c)
+        for(uint32_t e = 0; e < numEndpoints; ++e)
+            endpoints[e][c] = uint8_t(bits.Read(mode.ColorBits));
+
+    for(uint32_t e = 0; e < numEndpoints; ++e)
+        endpoints[e][3] = uint8_t(bits.Read(mode.AlphaBits));
+
+    uint32_t colorBits = mode.ColorBits;
+    uint32_t alphaBits = mode.AlphaBits;
+    if(mode.EndpointPBits || mode.SharedPBits)
+    {
+        for(uint32_t e = 0; e < numEndpoints; ++e)
+        {
+            // A shared P-bit is stored once per subset, so the second endpoint takes it from the
+            // low bit of the first one
+            uint32_t p = 0;
+            if(mode.EndpointPBits || (e & 1) == 0)
+                p = bits.Read(1);
+            else
+                p = endpoints[e - 1][0] & 1;
+
+            for(uint32_t c = 0; c < 4; ++c)
+                endpoints[e][c] = uint8_t((endpoints[e][c] << 1) | p);
+        }
+
+        ++colorBits;
+        if(alphaBits > 0)
+            ++alphaBits;
+    }
+
+    // Expand to 8 bits by replicating the high bits into the low bits
+    for(uint32_t e = 0; e < numEndpoints; ++e)
+    {
+        for(uint32_t c = 0; c < 3; ++c)
+        {
+            const uint32_t v = uint32_t(endpoints[e][c]) << (8 - colorBits);
+            endpoints[e][c] = uint8_t(v | (v >> colorBits));
+        }
+
+        if(alphaBits > 0)
+        {
+            const uint32_t v = uint32_t(endpoints[e][3]) << (8 - alphaBits);
+            endpoints[e][3] = uint8_t(v | (v >> alphaBits));
+        }
+        else
+            endpoints[e][3] = 255;
+    }
+
+    const uint32_t anchorMask = AnchorMask(mode.NumSubsets, partition);
+    uint32_t indices[16];
+    UnpackIndices(bits.Read64(NumIndexBits(mode.IndexBits, anchorMask)), mode.IndexBits, anchorMask, indices);
+
+    uint32_t palette[3][16];
+    if(mode.IndexBits2 == 0)
+    {
+        for(uint32_t s = 0; s < mode.NumSubsets; ++s)
+            BC7Palette(endpoints[s * 2], endpoints[s * 2 + 1], mode.IndexBits, palette[s]);
+
+        for(uint32_t i = 0; i < 16; ++i)
+            texels[i] = palette[Subset(mode.NumSubsets, partition, i)][indices[i]];
+    }
+    else
+    {
+        // Modes 4 and 5 have a second set of indices, and the index selection bit picks which set
+        // is used for color and which is used for alpha
+        uint32_t indices2[16];
+        UnpackIndices(bits.Read64(NumIndexBits(mode.IndexBits2, 1)), mode.IndexBits2, 1, indices2);
+
+        const uint32_t* colorIndices = indexSelection ? indices2 : indices;
+        const uint32_t* alphaIndices = indexSelection ? indices : indices2;
+        const uint32_t colorIndexBits = indexSelection ? mode.IndexBits2 : mode.IndexBits;
+        const uint32_t alphaIndexBits = indexSelection ? mode.IndexBits : mode.IndexBits2;
+
+        BC7Palette(endpoints[0], endpoints[1], colorIndexBits, palette[0]);
+        BC7Palette(endpoints[0], endpoints[1], alphaIndexBits, palette[1]);
+
+        for(uint32_t i = 0; i < 16; ++i)
+            texels[i] = (palette[0][colorIndices[i]] & 0x00FFFFFF) | (palette[1][alphaIndices[i]] & 0xFF000000);
+    }
+
+    // Rotation swaps alpha with one of the color channels
+    if(rotation != 0)
+    {
+        const uint32_t shift = (rotation - 1) * 8;
+        for(uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t texel = texels[i];
+            const uint32_t alpha = texel >> 24;
+            const uint32_t other = (texel >> shift) & 0xFF;
+            texels[i] = (texel & ~((0xFFu << shift) | 0xFF000000u)) | (alpha << shift) | (other << 24);
+        }
+    }
+}
+
+// == BC6H ========================================================================================
+
+enum BC6HField
+{
+    RW, RX, RY, RZ,
+    GW, GX, GY, GZ,
+    BW, BX, BY, BZ,
+    D,
+    NumBC6HFields
+};
+
+// A run of bits that gets written to a field, starting at FirstBit
+struct BC6HSegment
+{
+    uint8_t Field;
+    uint8_t FirstBit;
+    uint8_t NumBits;
+};
+
+struct BC6HMode
+{
+    uint32_t ModeBits;
+    bool Transformed;
+    uint32_t EndpointBits;
+    uint32_t DeltaBits[3];
+    BC6HSegment Segments[28];
+};
+
+// The header layouts from the BC6H format documentation, in the order that the bits are stored.
+// The first 10 modes have 2 subsets and the rest have 1.
+static const BC6HMode BC6HModes[14] =
+{
+    { 0x00, true, 10, { 5, 5, 5 },
+        { { GY, 4, 1 }, { BY, 4, 1 }, { BZ, 4, 1 }, { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 5 },
+          { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 },
+          { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 }, { D, 0, 5 } } },
+    { 0x01, true, 7, { 6, 6, 6 },
+        { { GY, 5, 1 }, { GZ, 4, 1 }, { GZ, 5, 1 }, { RW, 0, 7 }, { BZ, 0, 1 }, { BZ, 1, 1 }, { BY, 4, 1 },
+          { GW, 0, 7 }, { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 7 }, { BZ, 3, 1 }, { BZ, 5, 1 },
+          { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 },
+          { RY, 0, 6 }, { RZ, 0, 6 }, { D, 0, 5 } } },
+    { 0x02, true, 11, { 5, 4, 4 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 5 }, { RW, 10, 1 }, { GY, 0, 4 }, { GX, 0, 4 },
+          { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 }, { BZ, 1, 1 }, { BY, 0, 4 },
+          { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 }, { D, 0, 5 } } },
+    { 0x06, true, 11, { 4, 5, 4 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { GZ, 4, 1 }, { GY, 0, 4 },
+          { GX, 0, 5 }, { GW, 10, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 }, { BZ, 1, 1 }, { BY, 0, 4 },
+          { RY, 0, 4 }, { BZ, 0, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 }, { GY, 4, 1 }, { BZ, 3, 1 }, { D, 0, 5 } } },
+    { 0x0A, true, 11, { 4, 4, 5 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { BY, 4, 1 }, { GY, 0, 4 },
+          { GX, 0, 4 }, { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BW, 10, 1 }, { BY, 0, 4 },
+          { RY, 0, 4 }, { BZ, 1, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 }, { BZ, 4, 1 }, { BZ, 3, 1 }, { D, 0, 5 } } },
+    { 0x0E, true, 9, { 5, 5, 5 },
+        { { RW, 0, 9 }, { BY, 4, 1 }, { GW, 0, 9 }, { GY, 4, 1 }, { BW, 0, 9 }, { BZ, 4, 1 }, { RX, 0, 5 },
+          { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 },
+          { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 }, { D, 0, 5 } } },
+    { 0x12, true, 8, { 6, 5, 5 },
+        { { RW, 0, 8 }, { GZ, 4, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+          { BZ, 3, 1 }, { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 },
+          { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 6 }, { RZ, 0, 6 }, { D, 0, 5 } } },
+    { 0x16, true, 8, { 5, 6, 5 },
+        { { RW, 0, 8 }, { BZ, 0, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { GY, 5, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+          { GZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 },
+          { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 },
+          { D, 0, 5 } } },
+    { 0x1A, true, 8, { 5, 5, 6 },
+        { { RW, 0, 8 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BY, 5, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+          { BZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 },
+          { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 },
+          { D, 0, 5 } } },
+    { 0x1E, false, 6, { 6, 6, 6 },
+        { { RW, 0, 6 }, { GZ, 4, 1 }, { BZ, 0, 1 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 6 }, { GY, 5, 1 },
+          { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 6 }, { GZ, 5, 1 }, { BZ, 3, 1 }, { BZ, 5, 1 },
+          { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 },
+          { RY, 0, 6 }, { RZ, 0, 6 }, { D, 0, 5 } } },
+    { 0x03, false, 10, { 10, 10, 10 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 10 }, { GX, 0, 10 }, { BX, 0, 10 } } },
+    { 0x07, true, 11, { 9, 9, 9 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 9 }, { RW, 10, 1 }, { GX, 0, 9 }, { GW, 10, 1 },
+          { BX, 0, 9 }, { BW, 10, 1 } } },
+    { 0x0B, true, 12, { 8, 8, 8 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 8 }, { RW, 11, 1 }, { RW, 10, 1 }, { GX, 0, 8 },
+          { GW, 11, 1 }, { GW, 10, 1 }, { BX, 0, 8 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+    { 0x0F, true, 16, { 4, 4, 4 },
+        { { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 15, 1 }, { RW, 14, 1 }, { RW, 13, 1 },
+          { RW, 12, 1 }, { RW, 11, 1 }, { RW, 10, 1 }, { GX, 0, 4 }, { GW, 15, 1 }, { GW, 14, 1 }, { GW, 13, 1 },
+          { GW, 12, 1 }, { GW, 11, 1 }, { GW, 10, 1 }, { BX, 0, 4 }, { BW, 15, 1 }, { BW, 14, 1 }, { BW, 13, 1 },
+          { BW, 12, 1 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+};
+
+static int32_t BC6HUnquantize(int32_t value, uint32_t numBits, bool isSigned)
+{
+    if(isSigned)
+    {
+        if(numBits >= 16)
+            return value;
+
+        const bool negative = value < 0;
+        if(negative)
+            value = -value;
+
+        int32_t result = 0;
+        if(value == 0)
+            result = 0;
+        else if(value >= (1 << (numBits - 1)) - 1)
+            result = 0x7FFF;
+        else
+            result = ((value << 15) + 0x4000) >> (numBits - 1);
+
+        return negative ? -result : result;
+    }
+    else
+    {
+        if(numBits >= 15)
+            return value;
+        else if(value == 0)
+            return 0;
+        else if(value == (1 << numBits) - 1)
+            return 0xFFFF;
+        return ((value << 16) + 0x8000) >> numBits;
+    }
+}
+
+// Scales an interpolated value down to the range of a half, and returns its bits
+static uint16_t BC6HFinishUnquantize(int32_t value, bool isSigned)
+{
+    if(isSigned)
+    {
+        if(value < 0)
+            return uint16_t(0x8000 | ((-value * 31) >> 5));
+        return uint16_t((value * 31) >> 5);
+    }
+
+    return uint16_t((value * 31) >> 6);
+}
+
+void DecodeBC6H(const uint8_t* block, float* texels, bool isSigned)
+{
+    BitReader bits(block);
+
+    uint32_t modeBits = bits.Read(2);
+    if(modeBits > 1)
+        modeBits |= bits.Read(3) << 2;
+
+    uint32_t modeIdx = 0;
+    while(modeIdx < 14 && BC6HModes[modeIdx].ModeBits != modeBits)
+        ++modeIdx;
+
+    // Reserved modes decode to black
+    if(modeIdx == 14)
+    {
+        for(uint32_t i = 0; i < 16; ++i)
+        {
+            texels[i * 4 + 0] = 0.0f;
+            texels[i * 4 + 1] = 0.0f;
+            texels[i * 4 + 2] = 0.0f;
+            texels[i * 4 + 3] = 1.0f;
+        }
+        return;
+    }
+
+    const BC6HMode& mode = BC6HModes[modeIdx];
+
+    uint32_t fields[NumBC6HFields] = { };
+    for(uint32_t i = 0; i < 28 && mode.Segments[i].NumBits > 0; ++i)
+    {
+        const BC6HSegment& segment = mode.Segments[i];
+        fields[segment.Field] |= bits.Read(segment.NumBits) << segment.FirstBit;
+    }
+
+    const uint32_t numSubsets = modeIdx < 10 ? 2 : 1;
+    const uint32_t numEndpoints = numSubsets * 2;
+    const uint32_t partition = fields[D];
+
+    // [subset * 2 + endpoint][channel]. The first endpoint is W, and the rest are X, Y and Z.
+    int32_t endpoints[4][3];
+    for(uint32_t c = 0; c < 3; ++c)
+    {
+        const uint32_t endpointMask = (1 << mode.EndpointBits) - 1;
+
+        const uint32_t w = fields[c * 4];
+        endpoints[0][c] = isSigned ? SignExtend(w, mode.EndpointBits) : int32_t(w);
+
+        for(uint32_t e = 1; e < numEndpoints; ++e)
+        {
+            const uint32_t value = fields[c * 4 + e];
+            if(mode.Transformed)
+            {
+                // The other endpoints are stored as signed deltas from the first one
+                uint32_t absolute = uint32_t(endpoints[0][c] + SignExtend(value, mode.DeltaBits[c])) & endpointMask;
+                endpoints[e][c] = isSigned ? SignExtend(absolute, mode.EndpointBits) : int32_t(absolute);
+            }
+            else
+                endpoints[e][c] = isSigned ? SignExtend(value, mode.EndpointBits) : int32_t(value);
+        }
+
+        for(uint32_t e = 0; e < numEndpoints; ++e)
+            endpoints[e][c] = BC6HUnquantize(endpoints[e][c], mode.EndpointBits, isSigned);
+    }
+
+    const uint32_t indexBits = numSubsets == 2 ? 3 : 4;
+    const uint32_t numIndices = 1 << indexBits;
+    const uint32_t* weights = InterpolationWeights(indexBits);
+
+    // Both subsets together never have more than 16 palette entries
+    uint16_t halfPalette[16][4];
+    for(uint32_t s = 0; s < numSubsets; ++s)
+    {
+        for(uint32_t i = 0; i < numIndices; ++i)
+        {
+            const int32_t w = int32_t(weights[i]);
+            uint16_t* entry = halfPalette[s * numIndices + i];
+            for(uint32_t c = 0; c < 3; ++c)
+            {
+                const int32_t value = (endpoints[s * 2][c] * (64 - w) + endpoints[s * 2 + 1][c] * w + 32) >> 6;
+                entry[c] = BC6HFinishUnquantize(value, isSigned);
+            }
+            entry[3] = 0x3C00;
+        }
+    }
+
+    float palette[16][4];
+    for(uint32_t i = 0; i < 16; ++i)
+        HalfToFloat4(halfPalette[i], palette[i]);
+
+    const uint32_t anchorMask = AnchorMask(numSubsets, partition);
+    uint32_t indices[16];
+    UnpackIndices(bits.Read64(NumIndexBits(indexBits, anchorMask)), indexBits, anchorMask, indices);
+
+    for(uint32_t i = 0; i < 16; ++i)
+        memcpy(texels + i * 4, palette[Subset(numSubsets, partition, i) * numIndices + indices[i]], sizeof(float) * 4);
+}
+
+// == Surfaces ====================================================================================
+
+OutputType GetOutputType(DXGI_FORMAT format)
+{
+    switch(format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8_UNORM:
+        return OutputType::RGBA8;
+
+    case DXGI_FORMAT_BC4_SNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        return OutputType::Float;
+
+    default:
+        return OutputType::None;
+    }
+}
+
+bool IsBlockCompressed(DXGI_FORMAT format)
+{
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM)
+        || (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+bool IsSRGB(DXGI_FORMAT format)
+{
+    switch(format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static void DecodeBlock(DXGI_FORMAT format, const uint8_t* block, void* texels)
+{
+    uint32_t* rgba = reinterpret_cast<uint32_t*>(texels);
+    float* floats = reinterpret_cast<float*>(texels);
+
+    switch(format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        DecodeBC1(block, rgba);
+        break;
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+        DecodeBC2(block, rgba);
+        break;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+        DecodeBC3(block, rgba);
+        break;
+    case DXGI_FORMAT_BC4_UNORM:
+        DecodeBC4U(block, rgba);
+        break;
+    case DXGI_FORMAT_BC4_SNORM:
+        DecodeBC4S(block, floats);
+        break;
+    case DXGI_FORMAT_BC5_UNORM:
+        DecodeBC5U(block, rgba);
+        break;
+    case DXGI_FORMAT_BC5_SNORM:
+        DecodeBC5S(block, floats);
+        break;
+    case DXGI_FORMAT_BC6H_UF16:
+        DecodeBC6H(block, floats, false);
+        break;
+    case DXGI_FORMAT_BC6H_SF16:
+        DecodeBC6H(block, floats, true);
+        break;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        DecodeBC7(block, rgba);
+        break;
+    default:
+        break;
+    }
+}
+
+static void DecodeUncompressedRow(DXGI_FORMAT format, const uint8_t* src, uint32_t width, void* dst)
+{
+    uint32_t* rgba = reinterpret_cast<uint32_t*>(dst);
+
+    switch(format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        memcpy(dst, src, width * 4);
+        break;
+
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    {
+        const bool hasAlpha = format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        for(uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* texel = src + x * 4;
+            rgba[x] = PackRGBA(texel[2], texel[1], texel[0], hasAlpha ? texel[3] : 255);
+        }
+        break;
+    }
+
+    case DXGI_FORMAT_R8G8_UNORM:
+        for(uint32_t x = 0; x < width; ++x)
+            rgba[x] = PackRGBA(src[x * 2], src[x * 2 + 1], 0, 255);
+        break;
+
+    case DXGI_FORMAT_R8_UNORM:
+        for(uint32_t x = 0; x < width; ++x)
+            rgba[x] = PackRGBA(src[x], 0, 0, 255);
+        break;
+
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        PixelConversion::HalfToFloat(reinterpret_cast<const uint16_t*>(src), reinterpret_cast<float*>(dst), width * 4);
+        break;
+
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        PixelConversion::UNorm16ToFloat(reinterpret_cast<const uint16_t*>(src), reinterpret_cast<float*>(dst), width * 4);
+        break;
+
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    {
+        // Only RGB gets written, so alpha is filled in first
+        float* floats = reinterpret_cast<float*>(dst);
+        for(uint32_t x = 0; x < width; ++x)
+            floats[x * 4 + 3] = 1.0f;
+
+        const uint32_t* packed = reinterpret_cast<const uint32_t*>(src);
+        if(format == DXGI_FORMAT_R11G11B10_FLOAT)
+            PixelConversion::R11G11B10ToFloat(packed, floats, 4, width);
+        else
+            PixelConversion::R9G9B9E5ToFloat(packed, floats, 4, width);
+        break;
+    }
+
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        memcpy(dst, src, width * 16);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void DecodeRows(DXGI_FORMAT format, const uint8_t* src, size_t srcRowPitch, uint32_t width, uint32_t height,
+                void* dst, size_t dstRowPitch)
+{
+    const OutputType outputType = GetOutputType(format);
+    if(outputType == OutputType::None)
+        return;
+
+    uint8_t* dstBytes = reinterpret_cast<uint8_t*>(dst);
+
+    if(IsBlockCompressed(format) == false)
+    {
+        for(uint32_t y = 0; y < height; ++y)
+            DecodeUncompressedRow(format, src + y * srcRowPitch, width, dstBytes + y * dstRowPitch);
+        return;
+    }
+
+    const size_t blockSize = (format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB
+                              || format == DXGI_FORMAT_BC4_UNORM || format == DXGI_FORMAT_BC4_SNORM) ? 8 : 16;
+    const size_t texelSize = outputType == OutputType::Float ? 16 : 4;
+    const uint32_t numBlocksX = (width + 3) / 4;
+    const uint32_t numBlocksY = (height + 3) / 4;
+
+    // Big enough for 16 float RGBA texels
+    float blockTexels[64];
+
+    for(uint32_t blockY = 0; blockY < numBlocksY; ++blockY)
+    {
+        const uint8_t* blockRow = src + blockY * srcRowPitch;
+        const uint32_t numRows = std::min<uint32_t>(height - blockY * 4, 4);
+
+        for(uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+        {
+            DecodeBlock(format, blockRow + blockX * blockSize, blockTexels);
+
+            // Blocks on the right and bottom edges can hang off the surface
+            const uint32_t numColumns = std::min<uint32_t>(width - blockX * 4, 4);
+            const uint8_t* blockBytes = reinterpret_cast<const uint8_t*>(blockTexels);
+            for(uint32_t row = 0; row < numRows; ++row)
+            {
+                uint8_t* dstRow = dstBytes + (blockY * 4 + row) * dstRowPitch + blockX * 4 * texelSize;
+                memcpy(dstRow, blockBytes + row * 4 * texelSize, numColumns * texelSize);
+            }
+        }
+    }
+}
+
+}
+
+}
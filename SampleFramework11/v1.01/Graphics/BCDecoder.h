@@ -0,0 +1,62 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// CPU decoders for the block-compressed formats (BC1 through BC7), plus a handful of common
+// uncompressed formats, so that texture data can be read without going through a D3D device.
+// Like DDSParser.h this is platform-neutral and doesn't include PCH.h. SSE2 is used for building
+// the block palettes when it's available, and the uncompressed float and packed HDR formats are
+// converted with PixelConversion.
+
+#include "DDSParser.h"
+
+namespace SampleFramework11
+{
+
+namespace BC
+{
+
+// What DecodeRows() writes for a format: 8-bit RGBA (R in the lowest byte), or 32-bit float RGBA.
+// The 8-bit formats are returned as-is, without converting sRGB to linear.
+enum class OutputType
+{
+    None = 0,
+    RGBA8,
+    Float,
+};
+
+OutputType GetOutputType(DXGI_FORMAT format);
+
+bool IsBlockCompressed(DXGI_FORMAT format);
+bool IsSRGB(DXGI_FORMAT format);
+
+// Decodes a width x height region of a surface. src points at the top-left block (or texel, for
+// uncompressed formats) and srcRowPitch is the distance between rows of blocks (or texels). dst
+// receives height rows of width texels, in the format given by GetOutputType().
+void DecodeRows(DXGI_FORMAT format, const uint8_t* src, size_t srcRowPitch, uint32_t width, uint32_t height,
+                void* dst, size_t dstRowPitch);
+
+// Single 4x4 block decoders. The 8-bit ones write 16 RGBA texels, the float ones write 64 floats.
+// BC4 and BC5 write their channels to R and RG, with B = 0 and A = 1.
+void DecodeBC1(const uint8_t* block, uint32_t* texels);
+void DecodeBC2(const uint8_t* block, uint32_t* texels);
+void DecodeBC3(const uint8_t* block, uint32_t* texels);
+void DecodeBC4U(const uint8_t* block, uint32_t* texels);
+void DecodeBC4S(const uint8_t* block, float* texels);
+void DecodeBC5U(const uint8_t* block, uint32_t* texels);
+void DecodeBC5S(const uint8_t* block, float* texels);
+void DecodeBC6H(const uint8_t* block, float* texels, bool isSigned);
+void DecodeBC7(const uint8_t* block, uint32_t* texels);
+
+float HalfToFloat(uint16_t half);
+
+}
+
+}
@@ -0,0 +1,901 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "BCEncoder.h"
+
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define BC_SSE2_ 1
+#else
+    #define BC_SSE2_ 0
+#endif
+
+namespace SampleFramework11
+{
+
+namespace BC
+{
+
+// == Helpers =====================================================================================
+
+// Blocks are little-endian, which is also what every platform that we build for is
+static void StoreUInt16(uint8_t* data, uint16_t value)
+{
+    memcpy(data, &value, sizeof(value));
+}
+
+static void StoreUInt32(uint8_t* data, uint32_t value)
+{
+    memcpy(data, &value, sizeof(value));
+}
+
+static void StoreUInt64(uint8_t* data, uint64_t value)
+{
+    memcpy(data, &value, sizeof(value));
+}
+
+static uint32_t Channel(uint32_t texel, uint32_t channel)
+{
+    return (texel >> (channel * 8)) & 0xFF;
+}
+
+static float Clamp(float value, float minValue, float maxValue)
+{
+    return std::min(std::max(value, minValue), maxValue);
+}
+
+// Writes the bits of a 128-bit block in order, starting from the lowest bit
+struct BitWriter
+{
+    uint64_t Low;
+    uint64_t High;
+    uint32_t Position;
+
+    BitWriter() : Low(0), High(0), Position(0)
+    {
+    }
+
+    void Write(uint32_t value, uint32_t numBits)
+    {
+        const uint64_t bits = value;
+        if(Position >= 64)
+            High |= bits << (Position - 64);
+        else
+        {
+            Low |= bits << Position;
+            if(Position + numBits > 64)
+                High |= bits >> (64 - Position);
+        }
+
+        Position += numBits;
+    }
+
+    void Store(uint8_t* block) const
+    {
+        StoreUInt64(block, Low);
+        StoreUInt64(block + 8, High);
+    }
+};
+
+const uint32_t AllTexels = 0xFFFF;
+
+// The texels of a block as floats, with one array per channel so that 4 texels can be compared
+// against a palette entry at once
+struct BlockTexels
+{
+    float Channels[4][16];
+};
+
+static void LoadBlockTexels(const uint32_t* texels, BlockTexels& block)
+{
+    for(uint32_t c = 0; c < 4; ++c)
+        for(uint32_t i = 0; i < 16; ++i)
+            block.Channels[c][i] = float(Channel(texels[i], c));
+}
+
+// Picks the closest palette entry for each texel, comparing the first NumChannels channels, and
+// returns the squared error summed over the texels in mask. Ties go to the lower index. The
+// palette and the texels only hold whole numbers, so the sums are exact and both paths agree.
+template<uint32_t NumChannels>
+static float FitIndices(const BlockTexels& block, const float (*palette)[4], uint32_t numEntries, uint32_t mask,
+                        uint8_t* indices)
+{
+    #if BC_SSE2_
+        const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+        __m128 totalError = _mm_setzero_ps();
+        for(uint32_t group = 0; group < 4; ++group)
+        {
+            __m128 texels[NumChannels];
+            for(uint32_t c = 0; c < NumChannels; ++c)
+                texels[c] = _mm_loadu_ps(&block.Channels[c][group * 4]);
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128 bestIndex = _mm_setzero_ps();
+            for(uint32_t e = 0; e < numEntries; ++e)
+            {
+                __m128 error = _mm_setzero_ps();
+                for(uint32_t c = 0; c < NumChannels; ++c)
+                {
+                    const __m128 diff = _mm_sub_ps(texels[c], _mm_set1_ps(palette[e][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+                }
+
+                const __m128 closer = _mm_cmplt_ps(error, bestError);
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps(float(e))), _mm_andnot_ps(closer, bestIndex));
+            }
+
+            const __m128i lanes = _mm_and_si128(_mm_set1_epi32(int32_t((mask >> (group * 4)) & 0xF)), laneBits);
+            const __m128 laneMask = _mm_castsi128_ps(_mm_cmpeq_epi32(lanes, laneBits));
+            totalError = _mm_add_ps(totalError, _mm_and_ps(bestError, laneMask));
+
+            const __m128i packed = _mm_cvttps_epi32(bestIndex);
+            int32_t groupIndices[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(groupIndices), packed);
+            for(uint32_t i = 0; i < 4; ++i)
+                indices[group * 4 + i] = uint8_t(groupIndices[i]);
+        }
+
+        float errors[4];
+        _mm_storeu_ps(errors, totalError);
+        return (errors[0] + errors[1]) + (errors[2] + errors[3]);
+    #else
+        float totalError = 0.0f;
+        for(uint32_t i = 0; i < 16; ++i)
+        {
+            float bestError = FLT_MAX;
+            uint32_t bestIndex = 0;
+            for(uint32_t e = 0; e < numEntries; ++e)
+            {
+                float error = 0.0f;
+                for(uint32_t c = 0; c < NumChannels; ++c)
+                {
+                    const float diff = block.Channels[c][i] - palette[e][c];
+                    error += diff * diff;
+                }
+
+                if(error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = e;
+                }
+            }
+
+            indices[i] = uint8_t(bestIndex);
+            if(mask & (1 << i))
+                totalError += bestError;
+        }
+
+        return totalError;
+    #endif
+}
+
+// Finds the texels at either end of the principal axis of the texels in mask, which is found
+// from their covariance with a few rounds of power iteration
+template<uint32_t NumChannels>
+static void PrincipalEndpoints(const BlockTexels& block, uint32_t mask, float endpoints[2][4])
+{
+    float mean[NumChannels] = { };
+    float numTexels = 0.0f;
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        if(mask & (1 << i))
+        {
+            for(uint32_t c = 0; c < NumChannels; ++c)
+                mean[c] += block.Channels[c][i];
+            numTexels += 1.0f;
+        }
+    }
+
+    for(uint32_t c = 0; c < NumChannels; ++c)
+        mean[c] /= numTexels;
+
+    float covariance[NumChannels][NumChannels] = { };
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        if((mask & (1 << i)) == 0)
+            continue;
+
+        float diff[NumChannels];
+        for(uint32_t c = 0; c < NumChannels; ++c)
+            diff[c] = block.Channels[c][i] - mean[c];
+
+        for(uint32_t row = 0; row < NumChannels; ++row)
+            for(uint32_t col = row; col < NumChannels; ++col)
+                covariance[row][col] += diff[row] * diff[col];
+    }
+
+    for(uint32_t row = 1; row < NumChannels; ++row)
+        for(uint32_t col = 0; col < row; ++col)
+            covariance[row][col] = covariance[col][row];
+
+    // Starting from the row with the largest variance keeps the first guess from being orthogonal
+    // to the principal axis. Only the direction matters, so the axis is scaled by its largest
+    // component rather than normalized.
+    uint32_t startRow = 0;
+    for(uint32_t c = 1; c < NumChannels; ++c)
+        if(covariance[c][c] > covariance[startRow][startRow])
+            startRow = c;
+
+    float axis[NumChannels];
+    for(uint32_t c = 0; c < NumChannels; ++c)
+        axis[c] = covariance[startRow][c];
+
+    for(uint32_t iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[NumChannels] = { };
+        float maxComponent = 0.0f;
+        for(uint32_t row = 0; row < NumChannels; ++row)
+        {
+            for(uint32_t col = 0; col < NumChannels; ++col)
+                next[row] += covariance[row][col] * axis[col];
+            maxComponent = std::max(maxComponent, fabsf(next[row]));
+        }
+
+        if(maxComponent == 0.0f)
+            break;
+
+        for(uint32_t c = 0; c < NumChannels; ++c)
+            axis[c] = next[c] / maxComponent;
+    }
+
+    float minProjection = FLT_MAX;
+    float maxProjection = -FLT_MAX;
+    uint32_t minTexel = 0;
+    uint32_t maxTexel = 0;
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        if((mask & (1 << i)) == 0)
+            continue;
+
+        float projection = 0.0f;
+        for(uint32_t c = 0; c < NumChannels; ++c)
+            projection += (block.Channels[c][i] - mean[c]) * axis[c];
+
+        if(projection < minProjection)
+        {
+            minProjection = projection;
+            minTexel = i;
+        }
+
+        if(projection > maxProjection)
+        {
+            maxProjection = projection;
+            maxTexel = i;
+        }
+    }
+
+    for(uint32_t c = 0; c < 4; ++c)
+    {
+        endpoints[0][c] = block.Channels[c][minTexel];
+        endpoints[1][c] = block.Channels[c][maxTexel];
+    }
+}
+
+// Solves for the pair of endpoints that best fits the texels in mask in the least-squares sense,
+// given how far along from the first endpoint to the second each index is. Returns false when the
+// texels all use the same weight, since the endpoints can't be solved for.
+template<uint32_t NumChannels>
+static bool FitEndpoints(const BlockTexels& block, uint32_t mask, const uint8_t* indices, const float* weights,
+                         float endpoints[2][4])
+{
+    float a = 0.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    float sums0[NumChannels] = { };
+    float sums1[NumChannels] = { };
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        if((mask & (1 << i)) == 0)
+            continue;
+
+        const float w = weights[indices[i]];
+        const float invW = 1.0f - w;
+        a += invW * invW;
+        b += invW * w;
+        c += w * w;
+        for(uint32_t ch = 0; ch < NumChannels; ++ch)
+        {
+            sums0[ch] += invW * block.Channels[ch][i];
+            sums1[ch] += w * block.Channels[ch][i];
+        }
+    }
+
+    const float determinant = a * c - b * b;
+    if(fabsf(determinant) < 1e-6f)
+        return false;
+
+    const float invDeterminant = 1.0f / determinant;
+    for(uint32_t ch = 0; ch < NumChannels; ++ch)
+    {
+        endpoints[0][ch] = Clamp((c * sums0[ch] - b * sums1[ch]) * invDeterminant, 0.0f, 255.0f);
+        endpoints[1][ch] = Clamp((a * sums1[ch] - b * sums0[ch]) * invDeterminant, 0.0f, 255.0f);
+    }
+
+    return true;
+}
+
+// == BC1 =========================================================================================
+
+static uint32_t Expand5(uint32_t value)
+{
+    return (value << 3) | (value >> 2);
+}
+
+static uint32_t Expand6(uint32_t value)
+{
+    return (value << 2) | (value >> 4);
+}
+
+static uint32_t Quantize(float value, uint32_t maxValue)
+{
+    return uint32_t(Clamp(value * (maxValue / 255.0f) + 0.5f, 0.0f, float(maxValue)));
+}
+
+static uint16_t PackRGB565(const float* color)
+{
+    return uint16_t((Quantize(color[0], 31) << 11) | (Quantize(color[1], 63) << 5) | Quantize(color[2], 31));
+}
+
+// Builds the palette exactly the way the decoder does, including its rounding, so that the
+// indices are picked against the colors that will actually come out
+static void BC1Palette(uint16_t c0, uint16_t c1, float (*palette)[4])
+{
+    const uint32_t e0[3] = { Expand5(c0 >> 11), Expand6((c0 >> 5) & 0x3F), Expand5(c0 & 0x1F) };
+    const uint32_t e1[3] = { Expand5(c1 >> 11), Expand6((c1 >> 5) & 0x3F), Expand5(c1 & 0x1F) };
+    for(uint32_t c = 0; c < 3; ++c)
+    {
+        palette[0][c] = float(e0[c]);
+        palette[1][c] = float(e1[c]);
+        if(c0 > c1)
+        {
+            palette[2][c] = float((2 * e0[c] + e1[c]) / 3);
+            palette[3][c] = float((e0[c] + 2 * e1[c]) / 3);
+        }
+        else
+        {
+            palette[2][c] = float((e0[c] + e1[c]) / 2);
+            palette[3][c] = 0.0f;
+        }
+    }
+}
+
+// For every 8-bit value, the pair of 5-bit (or 6-bit) endpoints whose 2:1 blend comes the closest
+// to it, so that blocks of a single color can be matched more closely than by rounding the color
+struct BC1SingleColorTables
+{
+    uint8_t Match5[256][2];
+    uint8_t Match6[256][2];
+
+    BC1SingleColorTables()
+    {
+        Build(5, Match5);
+        Build(6, Match6);
+    }
+
+    static void Build(uint32_t numBits, uint8_t (*match)[2])
+    {
+        const uint32_t numValues = 1 << numBits;
+        for(uint32_t value = 0; value < 256; ++value)
+        {
+            uint32_t bestError = 256;
+            for(uint32_t e0 = 0; e0 < numValues; ++e0)
+            {
+                for(uint32_t e1 = 0; e1 < numValues; ++e1)
+                {
+                    const uint32_t x0 = numBits == 5 ? Expand5(e0) : Expand6(e0);
+                    const uint32_t x1 = numBits == 5 ? Expand5(e1) : Expand6(e1);
+                    const uint32_t blended = (2 * x0 + x1) / 3;
+                    const uint32_t error = blended > value ? blended - value : value - blended;
+                    if(error < bestError)
+                    {
+                        bestError = error;
+                        match[value][0] = uint8_t(e0);
+                        match[value][1] = uint8_t(e1);
+                    }
+                }
+            }
+        }
+    }
+};
+
+static const BC1SingleColorTables SingleColorTables;
+
+struct BC1Candidate
+{
+    uint16_t Color0;
+    uint16_t Color1;
+    uint8_t Indices[16];
+    float Error;
+};
+
+// Quantizes a pair of endpoints, orders them for the right mode, and picks the indices. Opaque
+// blocks use 4-color mode, and blocks with transparent texels (the ones that aren't in
+// opaqueMask) use 3-color mode.
+static void EvaluateBC1(const BlockTexels& block, uint32_t opaqueMask, const float endpoints[2][4],
+                        BC1Candidate& candidate)
+{
+    const bool transparent = opaqueMask != AllTexels;
+    uint16_t c0 = PackRGB565(endpoints[0]);
+    uint16_t c1 = PackRGB565(endpoints[1]);
+    if((transparent == false && c0 < c1) || (transparent && c0 > c1))
+        std::swap(c0, c1);
+
+    float palette[4][4];
+    BC1Palette(c0, c1, palette);
+
+    // Index 3 is transparent black when c0 <= c1, so only opaque blocks with c0 > c1 can use it
+    const uint32_t numEntries = c0 > c1 ? 4 : 3;
+
+    candidate.Color0 = c0;
+    candidate.Color1 = c1;
+    candidate.Error = FitIndices<3>(block, palette, numEntries, opaqueMask, candidate.Indices);
+}
+
+void EncodeBC1(const uint32_t* texels, uint8_t* block)
+{
+    uint32_t opaqueMask = 0;
+    for(uint32_t i = 0; i < 16; ++i)
+        if(Channel(texels[i], 3) >= 128)
+            opaqueMask |= 1 << i;
+
+    if(opaqueMask == 0)
+    {
+        // Both endpoints at 0 selects 3-color mode, and index 3 is transparent black
+        StoreUInt32(block, 0);
+        StoreUInt32(block + 4, 0xFFFFFFFF);
+        return;
+    }
+
+    BC1Candidate best;
+
+    bool singleColor = opaqueMask == AllTexels;
+    for(uint32_t i = 1; i < 16 && singleColor; ++i)
+        singleColor = ((texels[i] ^ texels[0]) & 0xFFFFFF) == 0;
+
+    if(singleColor)
+    {
+        const uint32_t r = Channel(texels[0], 0);
+        const uint32_t g = Channel(texels[0], 1);
+        const uint32_t b = Channel(texels[0], 2);
+        best.Color0 = uint16_t((SingleColorTables.Match5[r][0] << 11) | (SingleColorTables.Match6[g][0] << 5)
+                               | SingleColorTables.Match5[b][0]);
+        best.Color1 = uint16_t((SingleColorTables.Match5[r][1] << 11) | (SingleColorTables.Match6[g][1] << 5)
+                               | SingleColorTables.Match5[b][1]);
+
+        // Index 2 is the 2:1 blend. Swapping the endpoints to get into 4-color mode turns it into
+        // index 3, and if they're equal every index gives the same color.
+        uint8_t index = 2;
+        if(best.Color0 < best.Color1)
+        {
+            std::swap(best.Color0, best.Color1);
+            index = 3;
+        }
+        else if(best.Color0 == best.Color1)
+            index = 0;
+
+        memset(best.Indices, index, sizeof(best.Indices));
+    }
+    else
+    {
+        BlockTexels blockTexels;
+        LoadBlockTexels(texels, blockTexels);
+
+        float endpoints[2][4];
+        PrincipalEndpoints<3>(blockTexels, opaqueMask, endpoints);
+        EvaluateBC1(blockTexels, opaqueMask, endpoints, best);
+
+        // Refit the endpoints to the indices that were picked, for as long as it keeps helping
+        const bool transparent = opaqueMask != AllTexels;
+        const float weights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        const float weights3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+        for(uint32_t iteration = 0; iteration < 2; ++iteration)
+        {
+            const float* weights = best.Color0 > best.Color1 ? weights4 : weights3;
+            if(FitEndpoints<3>(blockTexels, opaqueMask, best.Indices, weights, endpoints) == false)
+                break;
+
+            BC1Candidate candidate;
+            EvaluateBC1(blockTexels, opaqueMask, endpoints, candidate);
+            if(candidate.Error >= best.Error)
+                break;
+
+            best = candidate;
+        }
+
+        if(transparent)
+        {
+            for(uint32_t i = 0; i < 16; ++i)
+                if((opaqueMask & (1 << i)) == 0)
+                    best.Indices[i] = 3;
+        }
+    }
+
+    uint32_t indices = 0;
+    for(uint32_t i = 0; i < 16; ++i)
+        indices |= uint32_t(best.Indices[i]) << (i * 2);
+
+    StoreUInt16(block, best.Color0);
+    StoreUInt16(block + 2, best.Color1);
+    StoreUInt32(block + 4, indices);
+}
+
+// == BC4 and BC5 =================================================================================
+
+// Same values and rounding as the decoder's palette
+static void BC4Palette(uint32_t r0, uint32_t r1, uint8_t* palette)
+{
+    palette[0] = uint8_t(r0);
+    palette[1] = uint8_t(r1);
+    if(r0 > r1)
+    {
+        for(uint32_t i = 1; i < 7; ++i)
+            palette[i + 1] = uint8_t(((7 - i) * r0 + i * r1 + 3) / 7);
+    }
+    else
+    {
+        for(uint32_t i = 1; i < 5; ++i)
+            palette[i + 1] = uint8_t(((5 - i) * r0 + i * r1 + 2) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Picks the closest of the 8 palette values for each of the 16 values, and returns the summed
+// squared error. Ties go to the lower index. SSE2 handles all 16 values at once.
+static uint32_t FitBC4Indices(const uint8_t* values, const uint8_t* palette, uint8_t* indices)
+{
+    #if BC_SSE2_
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        __m128i bestError = _mm_set1_epi8(-1);
+        __m128i bestIndex = _mm_setzero_si128();
+        for(uint32_t e = 0; e < 8; ++e)
+        {
+            const __m128i p = _mm_set1_epi8(char(palette[e]));
+            const __m128i error = _mm_or_si128(_mm_subs_epu8(v, p), _mm_subs_epu8(p, v));
+            const __m128i minError = _mm_min_epu8(error, bestError);
+            const __m128i notCloser = _mm_cmpeq_epi8(minError, bestError);
+            bestIndex = _mm_or_si128(_mm_and_si128(notCloser, bestIndex),
+                                     _mm_andnot_si128(notCloser, _mm_set1_epi8(char(e))));
+            bestError = minError;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+
+        const __m128i low = _mm_unpacklo_epi8(bestError, _mm_setzero_si128());
+        const __m128i high = _mm_unpackhi_epi8(bestError, _mm_setzero_si128());
+        __m128i sums = _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high));
+        sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+        sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+        return uint32_t(_mm_cvtsi128_si32(sums));
+    #else
+        uint32_t totalError = 0;
+        for(uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t bestError = 256;
+            uint32_t bestIndex = 0;
+            for(uint32_t e = 0; e < 8; ++e)
+            {
+                const uint32_t error = values[i] > palette[e] ? values[i] - palette[e] : palette[e] - values[i];
+                if(error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = e;
+                }
+            }
+
+            indices[i] = uint8_t(bestIndex);
+            totalError += bestError * bestError;
+        }
+
+        return totalError;
+    #endif
+}
+
+// Tries endpoints just inside the range of the values in 8-value mode, and the range of the
+// values besides 0 and 255 in 6-value mode (which has exact 0 and 255 entries)
+static void EncodeBC4Channel(const uint8_t* values, uint8_t* block)
+{
+    uint32_t minValue = 255;
+    uint32_t maxValue = 0;
+    uint32_t minInner = 255;
+    uint32_t maxInner = 0;
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        minValue = std::min<uint32_t>(minValue, values[i]);
+        maxValue = std::max<uint32_t>(maxValue, values[i]);
+        if(values[i] != 0 && values[i] != 255)
+        {
+            minInner = std::min<uint32_t>(minInner, values[i]);
+            maxInner = std::max<uint32_t>(maxInner, values[i]);
+        }
+    }
+
+    uint32_t bestR0 = minValue;
+    uint32_t bestR1 = minValue;
+    uint8_t bestIndices[16] = { };
+    if(minValue != maxValue)
+    {
+        uint32_t bestError = UINT32_MAX;
+        uint8_t palette[8];
+        uint8_t indices[16];
+
+        const uint32_t SearchRange = 3;
+        for(uint32_t hi = maxValue; hi + SearchRange >= maxValue && hi > minValue; --hi)
+        {
+            for(uint32_t lo = minValue; lo <= minValue + SearchRange && lo < hi; ++lo)
+            {
+                BC4Palette(hi, lo, palette);
+                const uint32_t error = FitBC4Indices(values, palette, indices);
+                if(error < bestError)
+                {
+                    bestError = error;
+                    bestR0 = hi;
+                    bestR1 = lo;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+        }
+
+        if(minValue == 0 || maxValue == 255)
+        {
+            if(minInner > maxInner)
+                minInner = maxInner = 0;
+
+            BC4Palette(minInner, maxInner, palette);
+            const uint32_t error = FitBC4Indices(values, palette, indices);
+            if(error < bestError)
+            {
+                bestR0 = minInner;
+                bestR1 = maxInner;
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+    }
+
+    uint64_t bits = uint64_t(bestR0) | (uint64_t(bestR1) << 8);
+    for(uint32_t i = 0; i < 16; ++i)
+        bits |= uint64_t(bestIndices[i]) << (16 + i * 3);
+    StoreUInt64(block, bits);
+}
+
+static void EncodeBC4Channel(const uint32_t* texels, uint32_t channel, uint8_t* block)
+{
+    uint8_t values[16];
+    for(uint32_t i = 0; i < 16; ++i)
+        values[i] = uint8_t(Channel(texels[i], channel));
+    EncodeBC4Channel(values, block);
+}
+
+void EncodeBC4U(const uint32_t* texels, uint8_t* block)
+{
+    EncodeBC4Channel(texels, 0, block);
+}
+
+void EncodeBC5U(const uint32_t* texels, uint8_t* block)
+{
+    EncodeBC4Channel(texels, 0, block);
+    EncodeBC4Channel(texels, 1, block + 8);
+}
+
+// == BC7 =========================================================================================
+
+static const uint32_t BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Mode 6 endpoints are 7 bits per channel, plus a P-bit per endpoint that's shared by all 4
+// channels and becomes the lowest of their 8 bits
+struct BC7Candidate
+{
+    uint32_t Endpoints[2][4];
+    uint32_t PBits[2];
+    uint8_t Indices[16];
+    float Error;
+};
+
+static uint32_t QuantizeBC7(float value, uint32_t pBit)
+{
+    return uint32_t(Clamp((value - pBit) * 0.5f + 0.5f, 0.0f, 127.0f));
+}
+
+// Picks the P-bit that puts an endpoint closest to where it should be
+static uint32_t BestPBit(const float* endpoint)
+{
+    float errors[2] = { 0.0f, 0.0f };
+    for(uint32_t p = 0; p < 2; ++p)
+    {
+        for(uint32_t c = 0; c < 4; ++c)
+        {
+            const float diff = float((QuantizeBC7(endpoint[c], p) << 1) | p) - endpoint[c];
+            errors[p] += diff * diff;
+        }
+    }
+
+    return errors[1] < errors[0] ? 1 : 0;
+}
+
+static void EvaluateBC7(const BlockTexels& block, const float endpoints[2][4], uint32_t p0, uint32_t p1,
+                        BC7Candidate& candidate)
+{
+    candidate.PBits[0] = p0;
+    candidate.PBits[1] = p1;
+
+    uint32_t expanded[2][4];
+    for(uint32_t e = 0; e < 2; ++e)
+    {
+        for(uint32_t c = 0; c < 4; ++c)
+        {
+            candidate.Endpoints[e][c] = QuantizeBC7(endpoints[e][c], candidate.PBits[e]);
+            expanded[e][c] = (candidate.Endpoints[e][c] << 1) | candidate.PBits[e];
+        }
+    }
+
+    float palette[16][4];
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        const uint32_t w = BC7Weights[i];
+        for(uint32_t c = 0; c < 4; ++c)
+            palette[i][c] = float(((64 - w) * expanded[0][c] + w * expanded[1][c] + 32) >> 6);
+    }
+
+    candidate.Error = FitIndices<4>(block, palette, 16, AllTexels, candidate.Indices);
+}
+
+void EncodeBC7(const uint32_t* texels, uint8_t* block)
+{
+    BlockTexels blockTexels;
+    LoadBlockTexels(texels, blockTexels);
+
+    float endpoints[2][4];
+    PrincipalEndpoints<4>(blockTexels, AllTexels, endpoints);
+
+    // Every combination of P-bits gets tried for the first guess, and the refits use whichever
+    // P-bits suit their endpoints best
+    BC7Candidate best;
+    best.Error = FLT_MAX;
+    for(uint32_t pBits = 0; pBits < 4; ++pBits)
+    {
+        BC7Candidate candidate;
+        EvaluateBC7(blockTexels, endpoints, pBits & 1, pBits >> 1, candidate);
+        if(candidate.Error < best.Error)
+            best = candidate;
+    }
+
+    float weights[16];
+    for(uint32_t i = 0; i < 16; ++i)
+        weights[i] = BC7Weights[i] / 64.0f;
+
+    for(uint32_t iteration = 0; iteration < 2 && best.Error > 0.0f; ++iteration)
+    {
+        if(FitEndpoints<4>(blockTexels, AllTexels, best.Indices, weights, endpoints) == false)
+            break;
+
+        BC7Candidate candidate;
+        EvaluateBC7(blockTexels, endpoints, BestPBit(endpoints[0]), BestPBit(endpoints[1]), candidate);
+        if(candidate.Error >= best.Error)
+            break;
+
+        best = candidate;
+    }
+
+    // The highest bit of the first texel's index is implied to be 0, so the endpoints get swapped
+    // if it isn't. The weights are symmetric, so flipping the indices gives the same colors.
+    if(best.Indices[0] >= 8)
+    {
+        for(uint32_t c = 0; c < 4; ++c)
+            std::swap(best.Endpoints[0][c], best.Endpoints[1][c]);
+        std::swap(best.PBits[0], best.PBits[1]);
+        for(uint32_t i = 0; i < 16; ++i)
+            best.Indices[i] = uint8_t(15 - best.Indices[i]);
+    }
+
+    // Mode 6 is 6 zero bits followed by a one
+    BitWriter bits;
+    bits.Write(1 << 6, 7);
+    for(uint32_t c = 0; c < 4; ++c)
+    {
+        bits.Write(best.Endpoints[0][c], 7);
+        bits.Write(best.Endpoints[1][c], 7);
+    }
+
+    bits.Write(best.PBits[0], 1);
+    bits.Write(best.PBits[1], 1);
+
+    bits.Write(best.Indices[0], 3);
+    for(uint32_t i = 1; i < 16; ++i)
+        bits.Write(best.Indices[i], 4);
+
+    bits.Store(block);
+}
+
+// == Surfaces ====================================================================================
+
+bool CanEncode(DXGI_FORMAT format)
+{
+    switch(format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static void EncodeBlock(DXGI_FORMAT format, const uint32_t* texels, uint8_t* block)
+{
+    switch(format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        EncodeBC1(texels, block);
+        break;
+    case DXGI_FORMAT_BC4_UNORM:
+        EncodeBC4U(texels, block);
+        break;
+    case DXGI_FORMAT_BC5_UNORM:
+        EncodeBC5U(texels, block);
+        break;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        EncodeBC7(texels, block);
+        break;
+    default:
+        break;
+    }
+}
+
+void EncodeRows(DXGI_FORMAT format, const void* src, size_t srcRowPitch, uint32_t width, uint32_t height,
+                uint8_t* dst, size_t dstRowPitch)
+{
+    if(CanEncode(format) == false || width == 0 || height == 0)
+        return;
+
+    const uint8_t* srcBytes = reinterpret_cast<const uint8_t*>(src);
+    const size_t blockSize = (format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB
+                              || format == DXGI_FORMAT_BC4_UNORM) ? 8 : 16;
+    const uint32_t numBlocksX = (width + 3) / 4;
+    const uint32_t numBlocksY = (height + 3) / 4;
+
+    uint32_t blockTexels[16];
+    for(uint32_t blockY = 0; blockY < numBlocksY; ++blockY)
+    {
+        uint8_t* blockRow = dst + blockY * dstRowPitch;
+        for(uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+        {
+            for(uint32_t row = 0; row < 4; ++row)
+            {
+                const uint32_t y = std::min(blockY * 4 + row, height - 1);
+                const uint8_t* srcRow = srcBytes + y * srcRowPitch;
+                for(uint32_t column = 0; column < 4; ++column)
+                {
+                    const uint32_t x = std::min(blockX * 4 + column, width - 1);
+                    memcpy(&blockTexels[row * 4 + column], srcRow + x * 4, sizeof(uint32_t));
+                }
+            }
+
+            EncodeBlock(format, blockTexels, blockRow + blockX * blockSize);
+        }
+    }
+}
+
+}
+
+}
@@ -0,0 +1,52 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// CPU encoders for BC1, BC4, BC5 and BC7, which cover 8-bit color, masks and normal maps. Like
+// BCDecoder.h this is platform-neutral and doesn't include PCH.h.
+//
+// Endpoints start out at the ends of the block's principal axis and are then refined with a
+// least-squares fit to the chosen indices, keeping whichever candidate decodes with the lowest
+// squared error. SSE2 is used for picking the indices and measuring the error of each candidate
+// when it's available. BC7 blocks only use mode 6 (a single subset with RGBA endpoints and 4-bit
+// indices), which is much faster to search than the full set of modes, at the cost of some
+// quality on blocks that contain several unrelated colors.
+
+#include "DDSParser.h"
+
+namespace SampleFramework11
+{
+
+namespace BC
+{
+
+// Returns true for the formats that EncodeRows() can write: BC1_UNORM, BC4_UNORM, BC5_UNORM and
+// BC7_UNORM, along with their sRGB versions
+bool CanEncode(DXGI_FORMAT format);
+
+// Encodes a width x height region of 8-bit RGBA texels (R in the lowest byte), which is the
+// reverse of DecodeRows(). src has srcRowPitch bytes between rows of texels, and dst receives
+// rows of blocks with dstRowPitch bytes between them. Blocks that hang off the right and bottom
+// edges are padded by repeating the last column and row. sRGB formats are encoded as-is, without
+// converting to linear first.
+void EncodeRows(DXGI_FORMAT format, const void* src, size_t srcRowPitch, uint32_t width, uint32_t height,
+                uint8_t* dst, size_t dstRowPitch);
+
+// Single 4x4 block encoders, which take 16 RGBA texels. BC1 switches to its 3-color mode for
+// blocks with alpha below 128, so that those texels decode as transparent black. BC4 encodes R,
+// and BC5 encodes R and G.
+void EncodeBC1(const uint32_t* texels, uint8_t* block);
+void EncodeBC4U(const uint32_t* texels, uint8_t* block);
+void EncodeBC5U(const uint32_t* texels, uint8_t* block);
+void EncodeBC7(const uint32_t* texels, uint8_t* block);
+
+}
+
+}
@@ -0,0 +1,82 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "D3D11DrawBackend.h"
+
+#include "..\\Assert.h"
+#include "..\\Exceptions.h"
+
+namespace SampleFramework11
+{
+
+D3D11DrawBackend::D3D11DrawBackend(ID3D11DeviceContext* context_, ID3D11Buffer* constantBuffer_,
+                                   uint32 constantBufferSlot_) : context(context_),
+                                                                 constantBuffer(constantBuffer_),
+                                                                 constantBufferSlot(constantBufferSlot_)
+{
+    Assert_(context != nullptr);
+}
+
+void D3D11DrawBackend::SetShaders(DrawHandle vs, DrawHandle ps)
+{
+    context->VSSetShader(static_cast<ID3D11VertexShader*>(vs), nullptr, 0);
+    context->PSSetShader(static_cast<ID3D11PixelShader*>(ps), nullptr, 0);
+}
+
+void D3D11DrawBackend::SetInputLayout(DrawHandle inputLayout)
+{
+    context->IASetInputLayout(static_cast<ID3D11InputLayout*>(inputLayout));
+}
+
+void D3D11DrawBackend::SetVertexBuffer(DrawHandle vertexBuffer, uint32 stride)
+{
+    ID3D11Buffer* vertexBuffers[1] = { static_cast<ID3D11Buffer*>(vertexBuffer) };
+    UINT vertexStrides[1] = { stride };
+    UINT offsets[1] = { 0 };
+    context->IASetVertexBuffers(0, 1, vertexBuffers, vertexStrides, offsets);
+}
+
+void D3D11DrawBackend::SetIndexBuffer(DrawHandle indexBuffer, uint32 indexSize)
+{
+    Assert_(indexSize == 2 || indexSize == 4);
+    const DXGI_FORMAT format = indexSize == 4 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    context->IASetIndexBuffer(static_cast<ID3D11Buffer*>(indexBuffer), format, 0);
+}
+
+void D3D11DrawBackend::SetPSShaderResources(const DrawHandle* srvs, uint32 numSRVs)
+{
+    Assert_(numSRVs <= MaxDrawSRVs);
+
+    ID3D11ShaderResourceView* d3dSRVs[MaxDrawSRVs] = { nullptr };
+    for(uint32 i = 0; i < numSRVs; ++i)
+        d3dSRVs[i] = static_cast<ID3D11ShaderResourceView*>(srvs[i]);
+    context->PSSetShaderResources(0, numSRVs, d3dSRVs);
+}
+
+void D3D11DrawBackend::SetConstants(const void* data, uint32 size)
+{
+    Assert_(constantBuffer != nullptr);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DXCall(context->Map(constantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    memcpy(mapped.pData, data, size);
+    context->Unmap(constantBuffer, 0);
+
+    ID3D11Buffer* buffers[1] = { constantBuffer };
+    context->VSSetConstantBuffers(constantBufferSlot, 1, buffers);
+}
+
+void D3D11DrawBackend::DrawIndexed(uint32 indexCount, uint32 indexStart, int32 baseVertex)
+{
+    context->DrawIndexed(indexCount, indexStart, baseVertex);
+}
+
+}
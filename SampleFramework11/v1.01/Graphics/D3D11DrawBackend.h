@@ -0,0 +1,44 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "DrawList.h"
+
+namespace SampleFramework11
+{
+
+// Issues the draws on a D3D11 context. The packets' handles are the ID3D11 interfaces for
+// each object. Per-draw constants are written to constantBuffer, which is bound to the given
+// VS slot.
+class D3D11DrawBackend : public DrawBackend
+{
+
+public:
+
+    D3D11DrawBackend(ID3D11DeviceContext* context, ID3D11Buffer* constantBuffer = nullptr, uint32 constantBufferSlot = 0);
+
+    virtual void SetShaders(DrawHandle vs, DrawHandle ps) override;
+    virtual void SetInputLayout(DrawHandle inputLayout) override;
+    virtual void SetVertexBuffer(DrawHandle vertexBuffer, uint32 stride) override;
+    virtual void SetIndexBuffer(DrawHandle indexBuffer, uint32 indexSize) override;
+    virtual void SetPSShaderResources(const DrawHandle* srvs, uint32 numSRVs) override;
+    virtual void SetConstants(const void* data, uint32 size) override;
+    virtual void DrawIndexed(uint32 indexCount, uint32 indexStart, int32 baseVertex) override;
+
+protected:
+
+    ID3D11DeviceContext* context;
+    ID3D11Buffer* constantBuffer;
+    uint32 constantBufferSlot;
+};
+
+}
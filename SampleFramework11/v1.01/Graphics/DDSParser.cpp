@@ -0,0 +1,867 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "DDSParser.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace SampleFramework11
+{
+
+namespace DDS
+{
+
+size_t BitsPerPixel(DXGI_FORMAT fmt)
+{
+    switch(fmt)
+    {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return 128;
+
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return 96;
+
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+    case DXGI_FORMAT_R32G8X24_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+    case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+    case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+    case DXGI_FORMAT_Y416:
+    case DXGI_FORMAT_Y210:
+    case DXGI_FORMAT_Y216:
+        return 64;
+
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R24G8_TYPELESS:
+    case DXGI_FORMAT_D24_UNORM_S8_UINT:
+    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+    case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_R8G8_B8G8_UNORM:
+    case DXGI_FORMAT_G8R8_G8B8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_AYUV:
+    case DXGI_FORMAT_Y410:
+    case DXGI_FORMAT_YUY2:
+        return 32;
+
+    case DXGI_FORMAT_P010:
+    case DXGI_FORMAT_P016:
+        return 24;
+
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_A8P8:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return 16;
+
+    case DXGI_FORMAT_NV12:
+    case DXGI_FORMAT_420_OPAQUE:
+    case DXGI_FORMAT_NV11:
+        return 12;
+
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+    case DXGI_FORMAT_AI44:
+    case DXGI_FORMAT_IA44:
+    case DXGI_FORMAT_P8:
+        return 8;
+
+    case DXGI_FORMAT_R1_UNORM:
+        return 1;
+
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return 4;
+
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 8;
+
+    default:
+        return 0;
+    }
+}
+
+void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt, size_t* outNumBytes,
+                    size_t* outRowBytes, size_t* outNumRows)
+{
+    size_t numBytes = 0;
+    size_t rowBytes = 0;
+    size_t numRows = 0;
+
+    bool bc = false;
+    bool packed = false;
+    bool planar = false;
+    size_t bpe = 0;
+    switch(fmt)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        bc = true;
+        bpe = 8;
+        break;
+
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        bc = true;
+        bpe = 16;
+        break;
+
+    case DXGI_FORMAT_R8G8_B8G8_UNORM:
+    case DXGI_FORMAT_G8R8_G8B8_UNORM:
+    case DXGI_FORMAT_YUY2:
+        packed = true;
+        bpe = 4;
+        break;
+
+    case DXGI_FORMAT_Y210:
+    case DXGI_FORMAT_Y216:
+        packed = true;
+        bpe = 8;
+        break;
+
+    case DXGI_FORMAT_NV12:
+    case DXGI_FORMAT_420_OPAQUE:
+        planar = true;
+        bpe = 2;
+        break;
+
+    case DXGI_FORMAT_P010:
+    case DXGI_FORMAT_P016:
+        planar = true;
+        bpe = 4;
+        break;
+
+    default:
+        break;
+    }
+
+    if(bc)
+    {
+        size_t numBlocksWide = 0;
+        if(width > 0)
+            numBlocksWide = std::max<size_t>(1, (width + 3) / 4);
+        size_t numBlocksHigh = 0;
+        if(height > 0)
+            numBlocksHigh = std::max<size_t>(1, (height + 3) / 4);
+        rowBytes = numBlocksWide * bpe;
+        numRows = numBlocksHigh;
+        numBytes = rowBytes * numBlocksHigh;
+    }
+    else if(packed)
+    {
+        rowBytes = ((width + 1) >> 1) * bpe;
+        numRows = height;
+        numBytes = rowBytes * height;
+    }
+    else if(fmt == DXGI_FORMAT_NV11)
+    {
+        rowBytes = ((width + 3) >> 2) * 4;
+        numRows = height * 2; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+        numBytes = rowBytes * numRows;
+    }
+    else if(planar)
+    {
+        rowBytes = ((width + 1) >> 1) * bpe;
+        numBytes = (rowBytes * height) + ((rowBytes * height + 1) >> 1);
+        numRows = height + ((height + 1) >> 1);
+    }
+    else
+    {
+        size_t bpp = BitsPerPixel(fmt);
+        rowBytes = (width * bpp + 7) / 8; // round up to nearest byte
+        numRows = height;
+        numBytes = rowBytes * height;
+    }
+
+    if(outNumBytes)
+        *outNumBytes = numBytes;
+    if(outRowBytes)
+        *outRowBytes = rowBytes;
+    if(outNumRows)
+        *outNumRows = numRows;
+}
+
+#define ISBITMASK(r, g, b, a) (ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a)
+
+DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf)
+{
+    if(ddpf.flags & PixelFormatRGB)
+    {
+        // Note that sRGB formats are written using the "DX10" extended header
+
+        switch(ddpf.RGBBitCount)
+        {
+        case 32:
+            if(ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+            if(ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+
+            if(ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+
+            // No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
+
+            // Note that many common DDS reader/writers (including D3DX) swap the
+            // the RED/BLUE masks for 10:10:10:2 formats. We assumme
+            // below that the 'backwards' header mask is being used since it is most
+            // likely written by D3DX. The more robust solution is to use the 'DX10'
+            // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+            // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+            if(ISBITMASK(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+                return DXGI_FORMAT_R10G10B10A2_UNORM;
+
+            // No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+            if(ISBITMASK(0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+                return DXGI_FORMAT_R16G16_UNORM;
+
+            if(ISBITMASK(0xffffffff, 0x00000000, 0x00000000, 0x00000000))
+            {
+                // Only 32-bit color channel format in D3D9 was R32F
+                return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
+            }
+            break;
+
+        case 24:
+            // No 24bpp DXGI formats aka D3DFMT_R8G8B8
+            break;
+
+        case 16:
+            if(ISBITMASK(0x7c00, 0x03e0, 0x001f, 0x8000))
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            if(ISBITMASK(0xf800, 0x07e0, 0x001f, 0x0000))
+                return DXGI_FORMAT_B5G6R5_UNORM;
+
+            // No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
+
+            if(ISBITMASK(0x0f00, 0x00f0, 0x000f, 0xf000))
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+
+            // No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
+
+            // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+            break;
+        }
+    }
+    else if(ddpf.flags & PixelFormatLuminance)
+    {
+        if(8 == ddpf.RGBBitCount)
+        {
+            if(ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x00000000))
+                return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
+
+            // No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
+        }
+
+        if(16 == ddpf.RGBBitCount)
+        {
+            if(ISBITMASK(0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
+                return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
+            if(ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
+                return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
+        }
+    }
+    else if(ddpf.flags & PixelFormatAlpha)
+    {
+        if(8 == ddpf.RGBBitCount)
+            return DXGI_FORMAT_A8_UNORM;
+    }
+    else if(ddpf.flags & PixelFormatFourCC)
+    {
+        if(DDS_MAKEFOURCC('D', 'X', 'T', '1') == ddpf.fourCC)
+            return DXGI_FORMAT_BC1_UNORM;
+        if(DDS_MAKEFOURCC('D', 'X', 'T', '3') == ddpf.fourCC)
+            return DXGI_FORMAT_BC2_UNORM;
+        if(DDS_MAKEFOURCC('D', 'X', 'T', '5') == ddpf.fourCC)
+            return DXGI_FORMAT_BC3_UNORM;
+
+        // While pre-mulitplied alpha isn't directly supported by the DXGI formats,
+        // they are basically the same as these BC formats so they can be mapped
+        if(DDS_MAKEFOURCC('D', 'X', 'T', '2') == ddpf.fourCC)
+            return DXGI_FORMAT_BC2_UNORM;
+        if(DDS_MAKEFOURCC('D', 'X', 'T', '4') == ddpf.fourCC)
+            return DXGI_FORMAT_BC3_UNORM;
+
+        if(DDS_MAKEFOURCC('A', 'T', 'I', '1') == ddpf.fourCC)
+            return DXGI_FORMAT_BC4_UNORM;
+        if(DDS_MAKEFOURCC('B', 'C', '4', 'U') == ddpf.fourCC)
+            return DXGI_FORMAT_BC4_UNORM;
+        if(DDS_MAKEFOURCC('B', 'C', '4', 'S') == ddpf.fourCC)
+            return DXGI_FORMAT_BC4_SNORM;
+
+        if(DDS_MAKEFOURCC('A', 'T', 'I', '2') == ddpf.fourCC)
+            return DXGI_FORMAT_BC5_UNORM;
+        if(DDS_MAKEFOURCC('B', 'C', '5', 'U') == ddpf.fourCC)
+            return DXGI_FORMAT_BC5_UNORM;
+        if(DDS_MAKEFOURCC('B', 'C', '5', 'S') == ddpf.fourCC)
+            return DXGI_FORMAT_BC5_SNORM;
+
+        // BC6H and BC7 are written using the "DX10" extended header
+
+        if(DDS_MAKEFOURCC('R', 'G', 'B', 'G') == ddpf.fourCC)
+            return DXGI_FORMAT_R8G8_B8G8_UNORM;
+        if(DDS_MAKEFOURCC('G', 'R', 'G', 'B') == ddpf.fourCC)
+            return DXGI_FORMAT_G8R8_G8B8_UNORM;
+
+        if(DDS_MAKEFOURCC('Y', 'U', 'Y', '2') == ddpf.fourCC)
+            return DXGI_FORMAT_YUY2;
+
+        // Check for D3DFORMAT enums being set here
+        switch(ddpf.fourCC)
+        {
+        case 36: // D3DFMT_A16B16G16R16
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+
+        case 110: // D3DFMT_Q16W16V16U16
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+
+        case 111: // D3DFMT_R16F
+            return DXGI_FORMAT_R16_FLOAT;
+
+        case 112: // D3DFMT_G16R16F
+            return DXGI_FORMAT_R16G16_FLOAT;
+
+        case 113: // D3DFMT_A16B16G16R16F
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+        case 114: // D3DFMT_R32F
+            return DXGI_FORMAT_R32_FLOAT;
+
+        case 115: // D3DFMT_G32R32F
+            return DXGI_FORMAT_R32G32_FLOAT;
+
+        case 116: // D3DFMT_A32B32G32R32F
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+#undef ISBITMASK
+
+Result Parse(const uint8_t* ddsData, size_t ddsDataSize, Texture& texture)
+{
+    texture = Texture();
+
+    if(ddsData == nullptr || ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        return Result::InvalidFile;
+
+    // DDS files always start with the same magic number ("DDS ")
+    if(*reinterpret_cast<const uint32_t*>(ddsData) != Magic)
+        return Result::InvalidFile;
+
+    const DDS_HEADER* header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+    if(header->size != sizeof(DDS_HEADER) || header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+        return Result::InvalidFile;
+
+    // Check for DX10 extension
+    const DDS_HEADER_DXT10* d3d10ext = nullptr;
+    if((header->ddspf.flags & PixelFormatFourCC) && (DDS_MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+    {
+        // Must be long enough for both headers and magic value
+        if(ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)))
+            return Result::InvalidFile;
+
+        d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(ddsData + sizeof(uint32_t) + sizeof(DDS_HEADER));
+    }
+
+    const size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER) + (d3d10ext ? sizeof(DDS_HEADER_DXT10) : 0);
+
+    uint32_t width = header->width;
+    uint32_t height = header->height;
+    uint32_t depth = header->depth;
+    uint32_t arraySize = 1;
+    uint32_t resDim = ResourceDimensionUnknown;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    bool isCubeMap = false;
+
+    uint32_t mipCount = header->mipMapCount;
+    if(mipCount == 0)
+        mipCount = 1;
+
+    if(d3d10ext != nullptr)
+    {
+        arraySize = d3d10ext->arraySize;
+        if(arraySize == 0)
+            return Result::InvalidData;
+
+        switch(d3d10ext->dxgiFormat)
+        {
+        case DXGI_FORMAT_AI44:
+        case DXGI_FORMAT_IA44:
+        case DXGI_FORMAT_P8:
+        case DXGI_FORMAT_A8P8:
+            return Result::NotSupported;
+
+        default:
+            if(BitsPerPixel(d3d10ext->dxgiFormat) == 0)
+                return Result::NotSupported;
+        }
+
+        format = d3d10ext->dxgiFormat;
+
+        switch(d3d10ext->resourceDimension)
+        {
+        case ResourceDimensionTexture1D:
+            // D3DX writes 1D textures with a fixed Height of 1
+            if((header->flags & HeaderFlagsHeight) && height != 1)
+                return Result::InvalidData;
+            height = depth = 1;
+            break;
+
+        case ResourceDimensionTexture2D:
+            if(d3d10ext->miscFlag & MiscFlagTextureCube)
+            {
+                arraySize *= 6;
+                isCubeMap = true;
+            }
+            depth = 1;
+            break;
+
+        case ResourceDimensionTexture3D:
+            if(!(header->flags & HeaderFlagsVolume))
+                return Result::InvalidData;
+            if(arraySize > 1)
+                return Result::NotSupported;
+            break;
+
+        default:
+            return Result::NotSupported;
+        }
+
+        resDim = d3d10ext->resourceDimension;
+    }
+    else
+    {
+        format = GetDXGIFormat(header->ddspf);
+        if(format == DXGI_FORMAT_UNKNOWN)
+            return Result::NotSupported;
+
+        if(header->flags & HeaderFlagsVolume)
+        {
+            resDim = ResourceDimensionTexture3D;
+        }
+        else
+        {
+            if(header->caps2 & CubeMap)
+            {
+                // We require all six faces to be defined
+                if((header->caps2 & CubeMapAllFaces) != CubeMapAllFaces)
+                    return Result::NotSupported;
+
+                arraySize = 6;
+                isCubeMap = true;
+            }
+
+            depth = 1;
+            resDim = ResourceDimensionTexture2D;
+
+            // Note there's no way for a legacy Direct3D 9 DDS to express a '1D' texture
+        }
+    }
+
+    if(width == 0 || height == 0 || depth == 0)
+        return Result::InvalidData;
+
+    texture.Header = header;
+    texture.HeaderDXT10 = d3d10ext;
+    texture.BitData = ddsData + offset;
+    texture.BitSize = ddsDataSize - offset;
+    texture.ResourceDimension = resDim;
+    texture.Format = format;
+    texture.Width = width;
+    texture.Height = height;
+    texture.Depth = depth;
+    texture.MipCount = mipCount;
+    texture.ArraySize = arraySize;
+    texture.IsCubeMap = isCubeMap;
+
+    return Result::Ok;
+}
+
+Result GetSubresources(const Texture& texture, size_t maxSize, Subresource* subresources,
+                       size_t& outWidth, size_t& outHeight, size_t& outDepth, size_t& skipMip)
+{
+    skipMip = 0;
+    outWidth = 0;
+    outHeight = 0;
+    outDepth = 0;
+
+    if(texture.BitData == nullptr || subresources == nullptr)
+        return Result::InvalidData;
+
+    const uint8_t* srcBits = texture.BitData;
+    const uint8_t* endBits = texture.BitData + texture.BitSize;
+    const size_t mipCount = texture.MipCount;
+
+    size_t index = 0;
+    for(size_t arrayIdx = 0; arrayIdx < texture.ArraySize; ++arrayIdx)
+    {
+        size_t w = texture.Width;
+        size_t h = texture.Height;
+        size_t d = texture.Depth;
+        for(size_t mipIdx = 0; mipIdx < mipCount; ++mipIdx)
+        {
+            size_t numBytes = 0;
+            size_t rowBytes = 0;
+            GetSurfaceInfo(w, h, texture.Format, &numBytes, &rowBytes, nullptr);
+
+            // Check against the remaining size rather than computing the end pointer, so that a
+            // bogus header can't overflow it
+            if(numBytes * d > size_t(endBits - srcBits))
+                return Result::EndOfFile;
+
+            if(mipCount <= 1 || maxSize == 0 || (w <= maxSize && h <= maxSize && d <= maxSize))
+            {
+                if(outWidth == 0)
+                {
+                    outWidth = w;
+                    outHeight = h;
+                    outDepth = d;
+                }
+
+                Subresource& subresource = subresources[index++];
+                subresource.Data = srcBits;
+                subresource.RowPitch = rowBytes;
+                subresource.SlicePitch = numBytes;
+                subresource.Width = uint32_t(w);
+                subresource.Height = uint32_t(h);
+                subresource.Depth = uint32_t(d);
+            }
+            else if(arrayIdx == 0)
+            {
+                // Count number of skipped mipmaps (first item only)
+                ++skipMip;
+            }
+
+            srcBits += numBytes * d;
+
+            w = std::max<size_t>(w >> 1, 1);
+            h = std::max<size_t>(h >> 1, 1);
+            d = std::max<size_t>(d >> 1, 1);
+        }
+    }
+
+    return index > 0 ? Result::Ok : Result::InvalidData;
+}
+
+uint32_t GetAlphaMode(const DDS_HEADER* header)
+{
+    // Values from DDS_ALPHA_MODE
+    const uint32_t AlphaModeUnknown = 0;
+    const uint32_t AlphaModePremultiplied = 2;
+    const uint32_t AlphaModeCustom = 4;
+
+    if(header->ddspf.flags & PixelFormatFourCC)
+    {
+        if(DDS_MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)
+        {
+            const DDS_HEADER_DXT10* d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(header + 1);
+            const uint32_t mode = d3d10ext->miscFlags2 & MiscFlags2AlphaModeMask;
+            if(mode <= AlphaModeCustom)
+                return mode;
+        }
+        else if((DDS_MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC) ||
+                (DDS_MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC))
+        {
+            return AlphaModePremultiplied;
+        }
+    }
+
+    return AlphaModeUnknown;
+}
+
+// == Writing =====================================================================================
+
+void MakeHeaders(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t arraySize,
+                 bool isCubeMap, DDS_HEADER& header, DDS_HEADER_DXT10& headerDXT10)
+{
+    memset(&header, 0, sizeof(header));
+    memset(&headerDXT10, 0, sizeof(headerDXT10));
+
+    size_t numBytes = 0;
+    size_t rowBytes = 0;
+    size_t numRows = 0;
+    GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, &numRows);
+
+    header.size = sizeof(DDS_HEADER);
+    header.flags = HeaderFlagsCaps | HeaderFlagsHeight | HeaderFlagsWidth | HeaderFlagsPixelFormat
+                 | HeaderFlagsMipCount | HeaderFlagsLinearSize;
+    header.height = height;
+    header.width = width;
+    header.pitchOrLinearSize = uint32_t(numBytes);
+    header.depth = 1;
+    header.mipMapCount = mipCount;
+    header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+    header.ddspf.flags = PixelFormatFourCC;
+    header.ddspf.fourCC = DDS_MAKEFOURCC('D', 'X', '1', '0');
+    header.caps = CapsTexture | (mipCount > 1 ? (CapsComplex | CapsMipMap) : 0);
+    if(isCubeMap)
+    {
+        header.caps |= CapsComplex;
+        header.caps2 = CubeMap | CubeMapAllFaces;
+    }
+
+    headerDXT10.dxgiFormat = format;
+    headerDXT10.resourceDimension = ResourceDimensionTexture2D;
+    headerDXT10.miscFlag = isCubeMap ? MiscFlagTextureCube : 0;
+    headerDXT10.arraySize = isCubeMap ? arraySize / 6 : arraySize;
+}
+
+// == MappedFile ==================================================================================
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() : data(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+}
+
+bool MappedFile::Open(const char* filePath)
+{
+    Close();
+    fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    return MapOpenedFile();
+}
+
+bool MappedFile::Open(const wchar_t* filePath)
+{
+    Close();
+    fileHandle = CreateFileW(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    return MapOpenedFile();
+}
+
+bool MappedFile::MapOpenedFile()
+{
+    if(fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize = { };
+    if(GetFileSizeEx(fileHandle, &fileSize) == FALSE)
+    {
+        Close();
+        return false;
+    }
+
+    // An empty file can't be mapped
+    if(fileSize.QuadPart == 0 || uint64_t(fileSize.QuadPart) > uint64_t(SIZE_MAX))
+    {
+        SetLastError(fileSize.QuadPart == 0 ? ERROR_HANDLE_EOF : ERROR_FILE_TOO_LARGE);
+        Close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mappingHandle == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    data = reinterpret_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    size = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    // Preserve the error from whatever failed, since the cleanup calls can overwrite it
+    const DWORD lastError = GetLastError();
+
+    if(data != nullptr)
+        UnmapViewOfFile(data);
+    if(mappingHandle != nullptr)
+        CloseHandle(mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+
+    SetLastError(lastError);
+}
+
+#else
+
+MappedFile::MappedFile() : data(nullptr), size(0), fileDescriptor(-1)
+{
+}
+
+bool MappedFile::Open(const char* filePath)
+{
+    Close();
+    fileDescriptor = open(filePath, O_RDONLY);
+    if(fileDescriptor < 0)
+        return false;
+
+    struct stat fileStats;
+    if(fstat(fileDescriptor, &fileStats) != 0 || fileStats.st_size <= 0)
+    {
+        Close();
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, size_t(fileStats.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if(mapping == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+
+    // Textures are read front to back when they're uploaded
+    madvise(mapping, size_t(fileStats.st_size), MADV_SEQUENTIAL);
+
+    data = reinterpret_cast<const uint8_t*>(mapping);
+    size = size_t(fileStats.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(data != nullptr)
+        munmap(const_cast<uint8_t*>(data), size);
+    if(fileDescriptor >= 0)
+        close(fileDescriptor);
+
+    data = nullptr;
+    size = 0;
+    fileDescriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+}
+
+}
@@ -0,0 +1,353 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// This header is platform-neutral, and doesn't include PCH.h. It only needs the standard headers,
+// plus DXGI_FORMAT, which is declared below on platforms that don't have dxgiformat.h. The DDS
+// header layout and the surface size logic were split out of DDSTextureLoader (from DirectXTK).
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+    #include <dxgiformat.h>
+#else
+
+// Same values as dxgiformat.h
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN                     = 0,
+    DXGI_FORMAT_R32G32B32A32_TYPELESS       = 1,
+    DXGI_FORMAT_R32G32B32A32_FLOAT          = 2,
+    DXGI_FORMAT_R32G32B32A32_UINT           = 3,
+    DXGI_FORMAT_R32G32B32A32_SINT           = 4,
+    DXGI_FORMAT_R32G32B32_TYPELESS          = 5,
+    DXGI_FORMAT_R32G32B32_FLOAT             = 6,
+    DXGI_FORMAT_R32G32B32_UINT              = 7,
+    DXGI_FORMAT_R32G32B32_SINT              = 8,
+    DXGI_FORMAT_R16G16B16A16_TYPELESS       = 9,
+    DXGI_FORMAT_R16G16B16A16_FLOAT          = 10,
+    DXGI_FORMAT_R16G16B16A16_UNORM          = 11,
+    DXGI_FORMAT_R16G16B16A16_UINT           = 12,
+    DXGI_FORMAT_R16G16B16A16_SNORM          = 13,
+    DXGI_FORMAT_R16G16B16A16_SINT           = 14,
+    DXGI_FORMAT_R32G32_TYPELESS             = 15,
+    DXGI_FORMAT_R32G32_FLOAT                = 16,
+    DXGI_FORMAT_R32G32_UINT                 = 17,
+    DXGI_FORMAT_R32G32_SINT                 = 18,
+    DXGI_FORMAT_R32G8X24_TYPELESS           = 19,
+    DXGI_FORMAT_D32_FLOAT_S8X24_UINT        = 20,
+    DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS    = 21,
+    DXGI_FORMAT_X32_TYPELESS_G8X24_UINT     = 22,
+    DXGI_FORMAT_R10G10B10A2_TYPELESS        = 23,
+    DXGI_FORMAT_R10G10B10A2_UNORM           = 24,
+    DXGI_FORMAT_R10G10B10A2_UINT            = 25,
+    DXGI_FORMAT_R11G11B10_FLOAT             = 26,
+    DXGI_FORMAT_R8G8B8A8_TYPELESS           = 27,
+    DXGI_FORMAT_R8G8B8A8_UNORM              = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB         = 29,
+    DXGI_FORMAT_R8G8B8A8_UINT               = 30,
+    DXGI_FORMAT_R8G8B8A8_SNORM              = 31,
+    DXGI_FORMAT_R8G8B8A8_SINT               = 32,
+    DXGI_FORMAT_R16G16_TYPELESS             = 33,
+    DXGI_FORMAT_R16G16_FLOAT                = 34,
+    DXGI_FORMAT_R16G16_UNORM                = 35,
+    DXGI_FORMAT_R16G16_UINT                 = 36,
+    DXGI_FORMAT_R16G16_SNORM                = 37,
+    DXGI_FORMAT_R16G16_SINT                 = 38,
+    DXGI_FORMAT_R32_TYPELESS                = 39,
+    DXGI_FORMAT_D32_FLOAT                   = 40,
+    DXGI_FORMAT_R32_FLOAT                   = 41,
+    DXGI_FORMAT_R32_UINT                    = 42,
+    DXGI_FORMAT_R32_SINT                    = 43,
+    DXGI_FORMAT_R24G8_TYPELESS              = 44,
+    DXGI_FORMAT_D24_UNORM_S8_UINT           = 45,
+    DXGI_FORMAT_R24_UNORM_X8_TYPELESS       = 46,
+    DXGI_FORMAT_X24_TYPELESS_G8_UINT        = 47,
+    DXGI_FORMAT_R8G8_TYPELESS               = 48,
+    DXGI_FORMAT_R8G8_UNORM                  = 49,
+    DXGI_FORMAT_R8G8_UINT                   = 50,
+    DXGI_FORMAT_R8G8_SNORM                  = 51,
+    DXGI_FORMAT_R8G8_SINT                   = 52,
+    DXGI_FORMAT_R16_TYPELESS                = 53,
+    DXGI_FORMAT_R16_FLOAT                   = 54,
+    DXGI_FORMAT_D16_UNORM                   = 55,
+    DXGI_FORMAT_R16_UNORM                   = 56,
+    DXGI_FORMAT_R16_UINT                    = 57,
+    DXGI_FORMAT_R16_SNORM                   = 58,
+    DXGI_FORMAT_R16_SINT                    = 59,
+    DXGI_FORMAT_R8_TYPELESS                 = 60,
+    DXGI_FORMAT_R8_UNORM                    = 61,
+    DXGI_FORMAT_R8_UINT                     = 62,
+    DXGI_FORMAT_R8_SNORM                    = 63,
+    DXGI_FORMAT_R8_SINT                     = 64,
+    DXGI_FORMAT_A8_UNORM                    = 65,
+    DXGI_FORMAT_R1_UNORM                    = 66,
+    DXGI_FORMAT_R9G9B9E5_SHAREDEXP          = 67,
+    DXGI_FORMAT_R8G8_B8G8_UNORM             = 68,
+    DXGI_FORMAT_G8R8_G8B8_UNORM             = 69,
+    DXGI_FORMAT_BC1_TYPELESS                = 70,
+    DXGI_FORMAT_BC1_UNORM                   = 71,
+    DXGI_FORMAT_BC1_UNORM_SRGB              = 72,
+    DXGI_FORMAT_BC2_TYPELESS                = 73,
+    DXGI_FORMAT_BC2_UNORM                   = 74,
+    DXGI_FORMAT_BC2_UNORM_SRGB              = 75,
+    DXGI_FORMAT_BC3_TYPELESS                = 76,
+    DXGI_FORMAT_BC3_UNORM                   = 77,
+    DXGI_FORMAT_BC3_UNORM_SRGB              = 78,
+    DXGI_FORMAT_BC4_TYPELESS                = 79,
+    DXGI_FORMAT_BC4_UNORM                   = 80,
+    DXGI_FORMAT_BC4_SNORM                   = 81,
+    DXGI_FORMAT_BC5_TYPELESS                = 82,
+    DXGI_FORMAT_BC5_UNORM                   = 83,
+    DXGI_FORMAT_BC5_SNORM                   = 84,
+    DXGI_FORMAT_B5G6R5_UNORM                = 85,
+    DXGI_FORMAT_B5G5R5A1_UNORM              = 86,
+    DXGI_FORMAT_B8G8R8A8_UNORM              = 87,
+    DXGI_FORMAT_B8G8R8X8_UNORM              = 88,
+    DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM  = 89,
+    DXGI_FORMAT_B8G8R8A8_TYPELESS           = 90,
+    DXGI_FORMAT_B8G8R8A8_UNORM_SRGB         = 91,
+    DXGI_FORMAT_B8G8R8X8_TYPELESS           = 92,
+    DXGI_FORMAT_B8G8R8X8_UNORM_SRGB         = 93,
+    DXGI_FORMAT_BC6H_TYPELESS               = 94,
+    DXGI_FORMAT_BC6H_UF16                   = 95,
+    DXGI_FORMAT_BC6H_SF16                   = 96,
+    DXGI_FORMAT_BC7_TYPELESS                = 97,
+    DXGI_FORMAT_BC7_UNORM                   = 98,
+    DXGI_FORMAT_BC7_UNORM_SRGB              = 99,
+    DXGI_FORMAT_AYUV                        = 100,
+    DXGI_FORMAT_Y410                        = 101,
+    DXGI_FORMAT_Y416                        = 102,
+    DXGI_FORMAT_NV12                        = 103,
+    DXGI_FORMAT_P010                        = 104,
+    DXGI_FORMAT_P016                        = 105,
+    DXGI_FORMAT_420_OPAQUE                  = 106,
+    DXGI_FORMAT_YUY2                        = 107,
+    DXGI_FORMAT_Y210                        = 108,
+    DXGI_FORMAT_Y216                        = 109,
+    DXGI_FORMAT_NV11                        = 110,
+    DXGI_FORMAT_AI44                        = 111,
+    DXGI_FORMAT_IA44                        = 112,
+    DXGI_FORMAT_P8                          = 113,
+    DXGI_FORMAT_A8P8                        = 114,
+    DXGI_FORMAT_B4G4R4A4_UNORM              = 115,
+    DXGI_FORMAT_FORCE_UINT                  = 0xffffffff
+};
+
+#endif
+
+namespace SampleFramework11
+{
+
+namespace DDS
+{
+
+// == File layout =================================================================================
+
+#define DDS_MAKEFOURCC(ch0, ch1, ch2, ch3) (uint32_t(uint8_t(ch0)) | (uint32_t(uint8_t(ch1)) << 8) |     \
+                                           (uint32_t(uint8_t(ch2)) << 16) | (uint32_t(uint8_t(ch3)) << 24))
+
+const uint32_t Magic = 0x20534444; // "DDS "
+
+// DDS_PIXELFORMAT flags
+const uint32_t PixelFormatFourCC = 0x00000004;
+const uint32_t PixelFormatRGB = 0x00000040;
+const uint32_t PixelFormatLuminance = 0x00020000;
+const uint32_t PixelFormatAlpha = 0x00000002;
+
+// DDS_HEADER flags
+const uint32_t HeaderFlagsCaps = 0x00000001;
+const uint32_t HeaderFlagsHeight = 0x00000002;
+const uint32_t HeaderFlagsWidth = 0x00000004;
+const uint32_t HeaderFlagsPixelFormat = 0x00001000;
+const uint32_t HeaderFlagsMipCount = 0x00020000;
+const uint32_t HeaderFlagsLinearSize = 0x00080000;
+const uint32_t HeaderFlagsVolume = 0x00800000;
+
+// DDS_HEADER caps
+const uint32_t CapsComplex = 0x00000008;
+const uint32_t CapsTexture = 0x00001000;
+const uint32_t CapsMipMap = 0x00400000;
+
+// DDS_HEADER caps2
+const uint32_t CubeMap = 0x00000200;
+const uint32_t CubeMapAllFaces = 0x0000FE00;
+
+// DDS_HEADER_DXT10 fields, which use the same values as D3D11_RESOURCE_DIMENSION and
+// D3D11_RESOURCE_MISC_TEXTURECUBE
+const uint32_t ResourceDimensionUnknown = 0;
+const uint32_t ResourceDimensionTexture1D = 2;
+const uint32_t ResourceDimensionTexture2D = 3;
+const uint32_t ResourceDimensionTexture3D = 4;
+const uint32_t MiscFlagTextureCube = 0x4;
+const uint32_t MiscFlags2AlphaModeMask = 0x7;
+
+#pragma pack(push, 1)
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t RGBBitCount;
+    uint32_t RBitMask;
+    uint32_t GBitMask;
+    uint32_t BBitMask;
+    uint32_t ABitMask;
+};
+
+struct DDS_HEADER
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth; // only if HeaderFlagsVolume is set in flags
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+#pragma pack(pop)
+
+// == Parsing =====================================================================================
+
+enum class Result
+{
+    Ok = 0,
+    InvalidFile,        // Too small, or the magic number or header sizes are wrong
+    InvalidData,        // The header describes a texture that doesn't make sense
+    NotSupported,       // Valid, but not a format or texture type that can be loaded
+    EndOfFile,          // The file is too small for the surfaces that the header describes
+};
+
+// Everything needed to create a texture from a DDS file. BitData points into the data that was
+// passed to Parse(), so it's only valid for as long as that is.
+struct Texture
+{
+    const DDS_HEADER* Header = nullptr;
+    const DDS_HEADER_DXT10* HeaderDXT10 = nullptr;
+    const uint8_t* BitData = nullptr;
+    size_t BitSize = 0;
+
+    uint32_t ResourceDimension = ResourceDimensionUnknown;
+    DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t Depth = 0;
+    uint32_t MipCount = 0;
+    uint32_t ArraySize = 0;     // Includes the 6 faces of cube maps
+    bool IsCubeMap = false;
+};
+
+// A mip level of an array slice. Data points directly into the file data.
+struct Subresource
+{
+    const uint8_t* Data = nullptr;
+    size_t RowPitch = 0;
+    size_t SlicePitch = 0;      // Size of one depth slice
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t Depth = 0;
+};
+
+// Returns 0 for formats that can't be stored in a DDS file
+size_t BitsPerPixel(DXGI_FORMAT fmt);
+
+void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt, size_t* outNumBytes,
+                    size_t* outRowBytes, size_t* outNumRows);
+
+// Maps the legacy (non-DX10) pixel format description to a DXGI format
+DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+
+// Validates the headers and works out the texture's dimensions and format, without copying anything
+Result Parse(const uint8_t* ddsData, size_t ddsDataSize, Texture& texture);
+
+// Fills out MipCount * ArraySize subresources, in the order that D3D11 expects for initial data.
+// Mips that are larger than maxSize in any dimension are skipped (maxSize == 0 means no limit).
+// The size of the first mip that wasn't skipped and the number of skipped mips are returned through
+// the remaining parameters, and the number of subresources that were filled out is
+// (MipCount - skipMip) * ArraySize.
+Result GetSubresources(const Texture& texture, size_t maxSize, Subresource* subresources,
+                       size_t& outWidth, size_t& outHeight, size_t& outDepth, size_t& skipMip);
+
+// Returns the DDS_ALPHA_MODE stored in the DX10 header, or the premultiplied mode for DXT2/DXT4
+uint32_t GetAlphaMode(const DDS_HEADER* header);
+
+// == Writing =====================================================================================
+
+// Fills out the headers for a 2D texture, using the DX10 extension so that any format can be
+// stored. A file is Magic, followed by the two headers and then the surfaces in the same order
+// that GetSubresources() returns them. arraySize includes the 6 faces of cube maps, like it does
+// in Texture.
+void MakeHeaders(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t arraySize,
+                 bool isCubeMap, DDS_HEADER& header, DDS_HEADER_DXT10& headerDXT10);
+
+// == MappedFile ==================================================================================
+
+// A read-only memory mapping of a whole file, so that it can be parsed without first being copied
+// into a heap allocation. Uses CreateFileMapping on Windows, and mmap everywhere else.
+class MappedFile
+{
+
+public:
+
+    MappedFile();
+    ~MappedFile();
+
+    // Returns false on failure, in which case GetLastError()/errno has the reason
+    bool Open(const char* filePath);
+    #if defined(_WIN32)
+        bool Open(const wchar_t* filePath);
+    #endif
+
+    void Close();
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+
+    // Not copyable
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+    const uint8_t* data;
+    size_t size;
+
+    #if defined(_WIN32)
+        bool MapOpenedFile();
+
+        void* fileHandle;
+        void* mappingHandle;
+    #else
+        int fileDescriptor;
+    #endif
+};
+
+}
+
+}
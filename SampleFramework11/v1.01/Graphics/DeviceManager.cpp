@@ -35,7 +35,8 @@ DeviceManager::DeviceManager()  :  backBufferFormat(DXGI_FORMAT_R8G8B8A8_UNORM_S
                                    featureLevel(D3D_FEATURE_LEVEL_11_0),
                                    minFeatureLevel(D3D_FEATURE_LEVEL_10_0),
                                    vsync(true),
-                                   numVSYNCIntervals(1)
+                                   numVSYNCIntervals(1),
+                                   multithreadedDevice(false)
 {
     refreshRate.Numerator = 60;
     refreshRate.Denominator = 1;
@@ -104,7 +105,7 @@ void DeviceManager::Initialize(HWND outputWindow)
     desc.OutputWindow = outputWindow;
     desc.Windowed = !fullScreen;
 
-    uint32 flags = D3D11_CREATE_DEVICE_SINGLETHREADED;
+    uint32 flags = multithreadedDevice ? 0 : D3D11_CREATE_DEVICE_SINGLETHREADED;
     #if UseDebugDevice_
         flags |= D3D11_CREATE_DEVICE_DEBUG;
     #endif
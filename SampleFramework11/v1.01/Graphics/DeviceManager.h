@@ -46,6 +46,7 @@ public:
     bool                        FullScreen() const   { return fullScreen; };
     bool                        VSYNCEnabled() const    { return vsync; };
     uint32                      NumVSYNCIntervals() const   { return numVSYNCIntervals; };
+    bool                        MultithreadedDevice() const     { return multithreadedDevice; };
 
 
     // Setters
@@ -59,6 +60,9 @@ public:
     void SetMinFeatureLevel(D3D_FEATURE_LEVEL level)    { minFeatureLevel = level; };
     void SetNumVSYNCIntervals(uint32 intervals)     { numVSYNCIntervals = intervals; };
 
+    // Needs to be enabled before Initialize() for resources to be created from other threads
+    void SetMultithreadedDevice(bool enabled)       { multithreadedDevice = enabled; };
+
 protected:
 
     void CheckForSuitableOutput();
@@ -84,6 +88,7 @@ protected:
     bool                        vsync;
     DXGI_RATIONAL               refreshRate;
     uint32                      numVSYNCIntervals;
+    bool                        multithreadedDevice;
 
     D3D_FEATURE_LEVEL           featureLevel;
     D3D_FEATURE_LEVEL           minFeatureLevel;
@@ -0,0 +1,166 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "DrawList.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+namespace SampleFramework11
+{
+
+// == DrawList ====================================================================================
+
+void DrawList::Reset()
+{
+    packets.clear();
+    sortedEntries.clear();
+    constantData.clear();
+}
+
+void DrawList::AddPacket(const DrawPacket& packet)
+{
+    assert(packet.NumPSSRVs <= MaxDrawSRVs);
+
+    SortEntry entry;
+    entry.Key = packet.SortKey;
+    entry.PacketIdx = uint32_t(packets.size());
+    sortedEntries.push_back(entry);
+
+    packets.push_back(packet);
+}
+
+uint32_t DrawList::AddConstants(const void* data, uint32_t size)
+{
+    // Keep each block 16-byte aligned, like a constant buffer
+    const uint32_t offset = uint32_t(constantData.size());
+    constantData.resize(offset + ((size + 15) & ~15));
+    memcpy(&constantData[offset], data, size);
+    return offset;
+}
+
+void DrawList::Sort()
+{
+    const uint64_t numEntries = sortedEntries.size();
+    if(numEntries <= 1)
+        return;
+
+    // LSD radix sort with 8-bit digits. All 8 histograms are built in a single pass.
+    const uint32_t NumPasses = 8;
+    uint32_t histograms[NumPasses][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for(uint64_t i = 0; i < numEntries; ++i)
+    {
+        const uint64_t key = sortedEntries[i].Key;
+        for(uint32_t pass = 0; pass < NumPasses; ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xFF];
+    }
+
+    tempEntries.resize(numEntries);
+    SortEntry* src = sortedEntries.data();
+    SortEntry* dst = tempEntries.data();
+
+    for(uint32_t pass = 0; pass < NumPasses; ++pass)
+    {
+        uint32_t* histogram = histograms[pass];
+        const uint32_t shift = pass * 8;
+
+        // Skip the pass if every key has the same value for this digit, which is common
+        // since most views only use a few of the key's fields
+        if(histogram[(src[0].Key >> shift) & 0xFF] == numEntries)
+            continue;
+
+        uint32_t offset = 0;
+        for(uint32_t digit = 0; digit < 256; ++digit)
+        {
+            const uint32_t count = histogram[digit];
+            histogram[digit] = offset;
+            offset += count;
+        }
+
+        for(uint64_t i = 0; i < numEntries; ++i)
+        {
+            const uint32_t digit = (src[i].Key >> shift) & 0xFF;
+            dst[histogram[digit]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if(src != sortedEntries.data())
+        sortedEntries.swap(tempEntries);
+}
+
+void DrawList::Submit(DrawBackend& backend) const
+{
+    DrawStats& stats = backend.Stats;
+
+    const DrawPacket* prev = nullptr;
+    for(uint64_t i = 0; i < sortedEntries.size(); ++i)
+    {
+        const DrawPacket& packet = packets[sortedEntries[i].PacketIdx];
+
+        if(prev == nullptr || packet.VS != prev->VS || packet.PS != prev->PS)
+        {
+            backend.SetShaders(packet.VS, packet.PS);
+            ++stats.NumShaderChanges;
+        }
+
+        if(prev == nullptr || packet.InputLayout != prev->InputLayout)
+        {
+            backend.SetInputLayout(packet.InputLayout);
+            ++stats.NumInputLayoutChanges;
+        }
+
+        if(prev == nullptr || packet.VertexBuffer != prev->VertexBuffer || packet.VertexStride != prev->VertexStride)
+        {
+            backend.SetVertexBuffer(packet.VertexBuffer, packet.VertexStride);
+            ++stats.NumVertexBufferChanges;
+        }
+
+        if(prev == nullptr || packet.IndexBuffer != prev->IndexBuffer || packet.IndexSize != prev->IndexSize)
+        {
+            backend.SetIndexBuffer(packet.IndexBuffer, packet.IndexSize);
+            ++stats.NumIndexBufferChanges;
+        }
+
+        if(packet.NumPSSRVs > 0)
+        {
+            bool srvsChanged = prev == nullptr || packet.NumPSSRVs != prev->NumPSSRVs;
+            for(uint32_t srvIdx = 0; srvIdx < packet.NumPSSRVs && srvsChanged == false; ++srvIdx)
+                srvsChanged = packet.PSSRVs[srvIdx] != prev->PSSRVs[srvIdx];
+
+            if(srvsChanged)
+            {
+                backend.SetPSShaderResources(packet.PSSRVs, packet.NumPSSRVs);
+                ++stats.NumSRVChanges;
+            }
+        }
+
+        if(packet.ConstantsSize > 0)
+        {
+            if(prev == nullptr || packet.ConstantsOffset != prev->ConstantsOffset || packet.ConstantsSize != prev->ConstantsSize)
+            {
+                backend.SetConstants(&constantData[packet.ConstantsOffset], packet.ConstantsSize);
+                ++stats.NumConstantUpdates;
+            }
+        }
+
+        backend.DrawIndexed(packet.IndexCount, packet.IndexStart, packet.BaseVertex);
+        ++stats.NumDraws;
+
+        prev = &packet;
+    }
+}
+
+}
@@ -0,0 +1,160 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// This header is platform-neutral, and doesn't include PCH.h. The packets only store opaque handles
+// for the backend's objects, so that lists can be built, sorted and submitted to NullDrawBackend
+// without a graphics API. D3D11DrawBackend.h has the backend that issues the draws on a device.
+
+#include <stdint.h>
+#include <vector>
+
+namespace SampleFramework11
+{
+
+// Pointer to a backend object (shader, input layout, buffer or SRV), which the list only compares
+typedef void* DrawHandle;
+
+static const uint32_t MaxDrawSRVs = 4;
+
+// Everything needed to issue a single indexed draw
+struct DrawPacket
+{
+    uint64_t SortKey;
+
+    DrawHandle VS;
+    DrawHandle PS;
+    DrawHandle InputLayout;
+    DrawHandle VertexBuffer;
+    DrawHandle IndexBuffer;
+    uint32_t VertexStride;
+    uint32_t IndexSize;         // 2 or 4 bytes
+
+    DrawHandle PSSRVs[MaxDrawSRVs];
+    uint32_t NumPSSRVs;
+
+    // Optional per-draw constants, stored in the draw list
+    uint32_t ConstantsOffset;
+    uint32_t ConstantsSize;
+
+    uint32_t IndexStart;
+    uint32_t IndexCount;
+    int32_t BaseVertex;
+
+    DrawPacket() : SortKey(0), VS(nullptr), PS(nullptr), InputLayout(nullptr), VertexBuffer(nullptr),
+                   IndexBuffer(nullptr), VertexStride(0), IndexSize(2), NumPSSRVs(0),
+                   ConstantsOffset(0), ConstantsSize(0), IndexStart(0), IndexCount(0), BaseVertex(0)
+    {
+        for(uint32_t i = 0; i < MaxDrawSRVs; ++i)
+            PSSRVs[i] = nullptr;
+    }
+};
+
+// Sort key layout, from most to least significant:
+//   [63:56] shader ID      - shader changes are the most expensive
+//   [55:40] mesh ID        - vertex buffer, index buffer and input layout
+//   [39:24] material ID    - pixel shader SRVs
+//   [23:0]  depth          - front-to-back order within a batch
+inline uint64_t MakeDrawSortKey(uint32_t shaderID, uint32_t meshID, uint32_t materialID, uint32_t depth = 0)
+{
+    return (uint64_t(shaderID & 0xFF) << 56) | (uint64_t(meshID & 0xFFFF) << 40) |
+           (uint64_t(materialID & 0xFFFF) << 24) | uint64_t(depth & 0xFFFFFF);
+}
+
+struct DrawStats
+{
+    uint64_t NumDraws = 0;
+    uint64_t NumShaderChanges = 0;
+    uint64_t NumInputLayoutChanges = 0;
+    uint64_t NumVertexBufferChanges = 0;
+    uint64_t NumIndexBufferChanges = 0;
+    uint64_t NumSRVChanges = 0;
+    uint64_t NumConstantUpdates = 0;
+
+    uint64_t NumStateChanges() const
+    {
+        return NumShaderChanges + NumInputLayoutChanges + NumVertexBufferChanges +
+               NumIndexBufferChanges + NumSRVChanges + NumConstantUpdates;
+    }
+};
+
+// Receives the state changes and draws from a DrawList. Redundant state changes are
+// filtered out before they reach the backend, and counted in Stats.
+class DrawBackend
+{
+
+public:
+
+    DrawStats Stats;
+
+    virtual ~DrawBackend() {}
+
+    virtual void SetShaders(DrawHandle vs, DrawHandle ps) = 0;
+    virtual void SetInputLayout(DrawHandle inputLayout) = 0;
+    virtual void SetVertexBuffer(DrawHandle vertexBuffer, uint32_t stride) = 0;
+    virtual void SetIndexBuffer(DrawHandle indexBuffer, uint32_t indexSize) = 0;
+    virtual void SetPSShaderResources(const DrawHandle* srvs, uint32_t numSRVs) = 0;
+    virtual void SetConstants(const void* data, uint32_t size) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t indexStart, int32_t baseVertex) = 0;
+};
+
+// Doesn't touch the GPU at all, only counts state changes and draws. Useful for measuring
+// how well a draw list batches without needing a device.
+class NullDrawBackend : public DrawBackend
+{
+
+public:
+
+    virtual void SetShaders(DrawHandle vs, DrawHandle ps) override {}
+    virtual void SetInputLayout(DrawHandle inputLayout) override {}
+    virtual void SetVertexBuffer(DrawHandle vertexBuffer, uint32_t stride) override {}
+    virtual void SetIndexBuffer(DrawHandle indexBuffer, uint32_t indexSize) override {}
+    virtual void SetPSShaderResources(const DrawHandle* srvs, uint32_t numSRVs) override {}
+    virtual void SetConstants(const void* data, uint32_t size) override {}
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t indexStart, int32_t baseVertex) override {}
+};
+
+// A list of draw packets for a single view. Packets are submitted in the order that they
+// were added, unless Sort() is called first.
+class DrawList
+{
+
+public:
+
+    void Reset();
+
+    void AddPacket(const DrawPacket& packet);
+
+    // Copies per-draw constant data into the list, and returns the offset to store in the packet
+    uint32_t AddConstants(const void* data, uint32_t size);
+
+    // Radix sort by SortKey. The sort is stable, so packets with equal keys keep their order.
+    void Sort();
+
+    void Submit(DrawBackend& backend) const;
+
+    uint64_t NumPackets() const { return packets.size(); }
+    const DrawPacket& Packet(uint64_t idx) const { return packets[sortedEntries[idx].PacketIdx]; }
+
+protected:
+
+    struct SortEntry
+    {
+        uint64_t Key;
+        uint32_t PacketIdx;
+    };
+
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry> sortedEntries;
+    std::vector<SortEntry> tempEntries;
+    std::vector<uint8_t> constantData;
+};
+
+}
@@ -121,6 +121,45 @@ inline float FilterSinc1D(float x)
     return s;
 }
 
+inline float FilterLanczos1D(float x, float numLobes)
+{
+    x = std::abs(x);
+    if(x >= 1.0f)
+        return 0.0f;
+
+    // Rescale from [-1, 1] range to [-numLobes, numLobes]
+    return FilterSinc1D(x * numLobes) * FilterSinc1D(x);
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+inline float BesselI0(float x)
+{
+    const float halfX = x * 0.5f;
+    float sum = 1.0f;
+    float term = 1.0f;
+    for(uint32 k = 1; k < 32 && term > sum * 1e-8f; ++k)
+    {
+        term *= halfX / k;
+        term *= halfX / k;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// Sinc windowed by a Kaiser window, where alpha controls the trade-off between the width of the
+// main lobe and the height of the side lobes
+inline float FilterKaiser1D(float x, float numLobes, float alpha)
+{
+    x = std::abs(x);
+    if(x >= 1.0f)
+        return 0.0f;
+
+    // Rescale from [-1, 1] range to [-numLobes, numLobes]
+    const float window = BesselI0(alpha * std::sqrt(1.0f - x * x)) / BesselI0(alpha);
+    return FilterSinc1D(x * numLobes) * window;
+}
+
 inline float BlackmanHarris(float x)
 {
     const float a0 = 0.35875f;
@@ -0,0 +1,357 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "FrameCapture.h"
+
+#include "..\\Assert.h"
+#include "..\\Utility.h"
+#include "..\\FileIO.h"
+#include "..\\Timer.h"
+#include "..\\TinyEXR.h"
+#include "PixelConversion.h"
+
+namespace SampleFramework11
+{
+
+FrameCapture::FrameCapture() : queueHead(0), queueTail(0), quit(false), numFramesWritten(0), numPixelsWritten(0),
+                               encodeMicroseconds(0)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    Shutdown();
+}
+
+void FrameCapture::Initialize(ID3D11Device* device_, uint32 numStagingTextures)
+{
+    Assert_(numStagingTextures > 0);
+    Assert_(encodeThread.joinable() == false);
+
+    device = device_;
+    stagingTextures.resize(numStagingTextures);
+    nextStaging = 0;
+
+    quit = false;
+    encodeThread = std::thread(&FrameCapture::EncodeThread, this);
+}
+
+void FrameCapture::Shutdown()
+{
+    if(encodeThread.joinable() == false)
+        return;
+
+    // Copies that are still in flight get waited on and queued up, then the encoding thread
+    // empties the queue before quitting
+    ID3D11DeviceContextPtr context;
+    device->GetImmediateContext(&context);
+    for(uint64 i = 0; i < stagingTextures.size(); ++i)
+    {
+        StagingTexture& staging = stagingTextures[(nextStaging + i) % stagingTextures.size()];
+        if(staging.InFlight)
+            Readback(context, staging);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        quit = true;
+    }
+    wakeCondition.notify_one();
+    encodeThread.join();
+
+    stagingTextures.clear();
+    device = nullptr;
+}
+
+void FrameCapture::Capture(ID3D11DeviceContext* context, ID3D11Texture2D* texture, const wchar* filePath)
+{
+    Assert_(encodeThread.joinable());
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    if(desc.SampleDesc.Count > 1)
+        throw Exception(L"MSAA textures need to be resolved before they can be captured");
+
+    // The ring is full, so the oldest copy has to finish before its staging texture can be reused
+    StagingTexture& staging = stagingTextures[nextStaging];
+    if(staging.InFlight)
+        Readback(context, staging);
+
+    if(staging.Texture == nullptr || staging.Desc.Width != desc.Width || staging.Desc.Height != desc.Height
+       || staging.Desc.Format != desc.Format)
+    {
+        staging.Desc = desc;
+        staging.Desc.MipLevels = 1;
+        staging.Desc.ArraySize = 1;
+        staging.Desc.Usage = D3D11_USAGE_STAGING;
+        staging.Desc.BindFlags = 0;
+        staging.Desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        staging.Desc.MiscFlags = 0;
+
+        staging.Texture = nullptr;
+        DXCall(device->CreateTexture2D(&staging.Desc, nullptr, &staging.Texture));
+
+        if(staging.CopyDone == nullptr)
+        {
+            D3D11_QUERY_DESC queryDesc = { D3D11_QUERY_EVENT, 0 };
+            DXCall(device->CreateQuery(&queryDesc, &staging.CopyDone));
+        }
+    }
+
+    context->CopySubresourceRegion(staging.Texture, 0, 0, 0, 0, texture, 0, nullptr);
+    context->End(staging.CopyDone);
+
+    staging.FilePath = filePath;
+    staging.InFlight = true;
+    nextStaging = (nextStaging + 1) % uint32(stagingTextures.size());
+}
+
+void FrameCapture::Update(ID3D11DeviceContext* context)
+{
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if(failed)
+        {
+            failed = false;
+            throw error;
+        }
+    }
+
+    // Copies finish in the order they were issued, so this stops at the first one that isn't done
+    for(uint64 i = 0; i < stagingTextures.size(); ++i)
+    {
+        StagingTexture& staging = stagingTextures[(nextStaging + i) % stagingTextures.size()];
+        if(staging.InFlight == false)
+            continue;
+
+        if(context->GetData(staging.CopyDone, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            break;
+
+        Readback(context, staging);
+    }
+}
+
+float FrameCapture::AverageEncodeTime() const
+{
+    const uint64 numFrames = numFramesWritten;
+    return numFrames > 0 ? float(encodeMicroseconds / 1000.0 / numFrames) : 0.0f;
+}
+
+float FrameCapture::EncodeThroughput() const
+{
+    const uint64 microseconds = encodeMicroseconds;
+    return microseconds > 0 ? float(double(numPixelsWritten) / microseconds) : 0.0f;
+}
+
+// Maps a staging texture (waiting on the copy if it hasn't finished) and queues up its texels
+void FrameCapture::Readback(ID3D11DeviceContext* context, StagingTexture& staging)
+{
+    Assert_(staging.InFlight);
+    staging.InFlight = false;
+
+    // Wait for the encoding thread to make room. Jobs are filled in place, so that their texel
+    // buffers get reused from one capture to the next.
+    const uint32 tail = queueTail.load(std::memory_order_relaxed);
+    while(tail - queueHead.load(std::memory_order_acquire) == QueueSize)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    CaptureJob& job = queue[tail % QueueSize];
+    job.FilePath = staging.FilePath;
+    job.Width = staging.Desc.Width;
+    job.Height = staging.Desc.Height;
+    job.Format = staging.Desc.Format;
+    job.RowPitch = uint32(BitsPerPixel(job.Format) * job.Width / 8);
+    job.Texels.resize(uint64(job.RowPitch) * job.Height);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DXCall(context->Map(staging.Texture, 0, D3D11_MAP_READ, 0, &mapped));
+    const uint8* src = reinterpret_cast<const uint8*>(mapped.pData);
+    for(uint32 y = 0; y < job.Height; ++y)
+        memcpy(&job.Texels[uint64(y) * job.RowPitch], src + uint64(y) * mapped.RowPitch, job.RowPitch);
+    context->Unmap(staging.Texture, 0);
+
+    queueTail.store(tail + 1, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void FrameCapture::EncodeThread()
+{
+    // WIC needs COM to be initialized on every thread that encodes images
+    const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    while(true)
+    {
+        const uint32 head = queueHead.load(std::memory_order_relaxed);
+
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&]()
+            {
+                return queueTail.load(std::memory_order_acquire) != head || quit;
+            });
+        }
+
+        // Everything queued before quit was set gets written out first
+        if(queueTail.load(std::memory_order_acquire) == head)
+            break;
+
+        const CaptureJob& job = queue[head % QueueSize];
+        try
+        {
+            Timer timer;
+            Encode(job);
+            timer.Update();
+
+            encodeMicroseconds += uint64(timer.ElapsedMicroseconds());
+            numPixelsWritten += uint64(job.Width) * job.Height;
+            ++numFramesWritten;
+        }
+        catch(Exception exception)
+        {
+            SetError(exception);
+        }
+
+        // The job's slot can be refilled once it's been written
+        queueHead.store(head + 1, std::memory_order_release);
+    }
+
+    if(SUCCEEDED(comResult))
+        CoUninitialize();
+}
+
+// Converts the texels of a job to float RGBA in floatTexels, returning false for formats that
+// PixelConversion doesn't handle. 8-bit UNORM texels are converted as-is, while sRGB ones are
+// converted to linear.
+bool FrameCapture::ConvertToFloat(const CaptureJob& job)
+{
+    std::vector<float>& floats = floatTexels;
+    const uint64 numTexels = uint64(job.Width) * job.Height;
+    floats.resize(numTexels * 4);
+    const uint8* texels = job.Texels.data();
+
+    switch(job.Format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        memcpy(floats.data(), texels, numTexels * 4 * sizeof(float));
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        PixelConversion::HalfToFloat(reinterpret_cast<const uint16*>(texels), floats.data(), size_t(numTexels * 4));
+        return true;
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        for(uint64 i = 0; i < numTexels; ++i)
+            floats[i * 4 + 3] = 1.0f;
+        PixelConversion::R11G11B10ToFloat(reinterpret_cast<const uint32*>(texels), floats.data(), 4, size_t(numTexels));
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        PixelConversion::UNorm8ToFloat(texels, floats.data(), size_t(numTexels * 4));
+        break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        PixelConversion::SRGBA8ToFloat(reinterpret_cast<const uint32*>(texels), floats.data(), size_t(numTexels));
+        break;
+    default:
+        return false;
+    }
+
+    if(job.Format == DXGI_FORMAT_B8G8R8A8_UNORM || job.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+    {
+        for(uint64 i = 0; i < numTexels; ++i)
+            std::swap(floats[i * 4 + 0], floats[i * 4 + 2]);
+    }
+
+    return true;
+}
+
+void FrameCapture::Encode(const CaptureJob& job)
+{
+    Image image;
+    image.width = job.Width;
+    image.height = job.Height;
+    image.format = job.Format;
+    image.rowPitch = job.RowPitch;
+    image.slicePitch = uint64(job.RowPitch) * job.Height;
+    image.pixels = const_cast<uint8*>(job.Texels.data());
+
+    const std::wstring extension = GetFileExtension(job.FilePath.c_str());
+    if(extension != L"exr" && extension != L"EXR")
+    {
+        // Float formats hold linear values, which are encoded as 8-bit sRGB for the PNG
+        if(job.Format == DXGI_FORMAT_R16G16B16A16_FLOAT || job.Format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+        {
+            ConvertToFloat(job);
+            srgbTexels.resize(uint64(job.Width) * job.Height);
+            PixelConversion::FloatToSRGBA8(floatTexels.data(), srgbTexels.data(), srgbTexels.size());
+
+            image.format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+            image.rowPitch = job.Width * sizeof(uint32);
+            image.slicePitch = image.rowPitch * job.Height;
+            image.pixels = reinterpret_cast<uint8*>(srgbTexels.data());
+        }
+
+        DXCall(SaveToWICFile(image, WIC_FLAGS_NONE, GetWICCodec(WIC_CODEC_PNG), job.FilePath.c_str()));
+        return;
+    }
+
+    // EXR files are written from half or float RGBA, so anything else gets converted to float
+    ScratchImage converted;
+    int pixelType = 2;
+    if(job.Format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+    {
+        pixelType = 1;
+    }
+    else if(job.Format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        if(ConvertToFloat(job))
+        {
+            image.pixels = reinterpret_cast<uint8*>(floatTexels.data());
+        }
+        else
+        {
+            DXCall(Convert(image, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, 0.5f, converted));
+            image = *converted.GetImage(0, 0, 0);
+        }
+    }
+
+    const uint64 valueSize = pixelType == 1 ? sizeof(uint16) : sizeof(float);
+    const void* channels[3] = { image.pixels + valueSize * 2, image.pixels + valueSize, image.pixels };
+    const char* channelNames[3] = { "B", "G", "R" };
+
+    EXRStridedImage exrImage;
+    exrImage.num_channels = 3;
+    exrImage.channel_names = channelNames;
+    exrImage.channels = channels;
+    exrImage.pixel_stride = 4;
+    exrImage.pixel_type = pixelType;
+    exrImage.width = job.Width;
+    exrImage.height = job.Height;
+
+    const std::string filePathAnsi = WStringToAnsi(job.FilePath.c_str());
+    const char* errorString = nullptr;
+    if(SaveStridedEXR(&exrImage, filePathAnsi.c_str(), &errorString) != 0)
+        throw Exception(L"Failed to save " + job.FilePath + L": " + AnsiToWString(errorString));
+}
+
+void FrameCapture::SetError(const Exception& exception)
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if(failed == false)
+    {
+        failed = true;
+        error = exception;
+    }
+}
+
+}
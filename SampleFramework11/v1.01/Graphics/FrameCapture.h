@@ -0,0 +1,112 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\InterfacePointers.h"
+#include "..\\Exceptions.h"
+
+namespace SampleFramework11
+{
+
+// Saves copies of a texture (usually the back buffer) to PNG or EXR files without stalling the
+// frame. Capture() copies the texture into one of a ring of staging textures, Update() maps each
+// copy once the GPU has finished it (usually a couple of frames later) and passes the texels to an
+// encoding thread through a lock-free queue, and the encoding thread writes the files.
+//
+// Update() needs to be called from the main thread every frame, and it's where errors from the
+// encoding thread get re-thrown. Frames are never dropped: if every staging texture is still in
+// flight Capture() waits for the oldest one, and if the encoding thread falls behind Update()
+// waits for room in the queue, so capturing every frame runs at the speed of the encoder.
+class FrameCapture
+{
+
+public:
+
+    FrameCapture();
+    ~FrameCapture();
+
+    void Initialize(ID3D11Device* device, uint32 numStagingTextures = 3);
+
+    // Writes out everything that's been captured and stops the encoding thread
+    void Shutdown();
+
+    // Queues up a copy of the top mip of a non-MSAA texture. Paths ending in ".exr" are saved as
+    // half-precision EXR files, and everything else is saved as PNG, with float formats encoded
+    // as 8-bit sRGB.
+    void Capture(ID3D11DeviceContext* context, ID3D11Texture2D* texture, const wchar* filePath);
+
+    void Update(ID3D11DeviceContext* context);
+
+    // Counts every file the encoding thread has written, along with how long it spent encoding
+    uint64 NumFramesWritten() const { return numFramesWritten; }
+    float AverageEncodeTime() const;    // In milliseconds
+    float EncodeThroughput() const;     // In megapixels per second
+
+protected:
+
+    struct CaptureJob
+    {
+        std::wstring FilePath;
+        std::vector<uint8> Texels;
+        uint32 Width = 0;
+        uint32 Height = 0;
+        uint32 RowPitch = 0;
+        DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+    };
+
+    struct StagingTexture
+    {
+        ID3D11Texture2DPtr Texture;
+        ID3D11QueryPtr CopyDone;
+        D3D11_TEXTURE2D_DESC Desc;
+        std::wstring FilePath;
+        bool InFlight = false;
+    };
+
+    void Readback(ID3D11DeviceContext* context, StagingTexture& staging);
+    void EncodeThread();
+    void Encode(const CaptureJob& job);
+    bool ConvertToFloat(const CaptureJob& job);
+    void SetError(const Exception& exception);
+
+    ID3D11DevicePtr device;
+
+    // Ring of staging textures, where nextStaging is the oldest one that's still in flight
+    std::vector<StagingTexture> stagingTextures;
+    uint32 nextStaging = 0;
+
+    // Single-producer/single-consumer ring of jobs. Only the main thread advances queueTail, and
+    // only the encoding thread advances queueHead. The mutex is only used for putting the
+    // encoding thread to sleep when the queue is empty.
+    static const uint32 QueueSize = 8;
+    CaptureJob queue[QueueSize];
+    std::atomic<uint32> queueHead;
+    std::atomic<uint32> queueTail;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> quit;
+    std::thread encodeThread;
+
+    // Scratch memory for converting texels, which only the encoding thread uses
+    std::vector<float> floatTexels;
+    std::vector<uint32> srgbTexels;
+
+    std::mutex errorMutex;
+    bool failed = false;
+    Exception error;
+
+    std::atomic<uint64> numFramesWritten;
+    std::atomic<uint64> numPixelsWritten;
+    std::atomic<uint64> encodeMicroseconds;
+};
+
+}
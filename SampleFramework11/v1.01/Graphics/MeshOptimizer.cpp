@@ -0,0 +1,786 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "MeshOptimizer.h"
+
+#include "..\\Assert.h"
+#include "..\\SF11_Math.h"
+
+namespace SampleFramework11
+{
+
+static const uint32 InvalidVertex = uint32(-1);
+
+// The cache simulations all use timestamps: a vertex is in the FIFO if fewer than cacheSize
+// vertices have been added since it was added. Starting the clock at cacheSize + 1 means that
+// a zero timestamp is always a miss.
+static bool CacheMiss(std::vector<uint32>& timestamps, uint32& time, uint32 vertex, uint32 cacheSize)
+{
+    if(time - timestamps[vertex] <= cacheSize)
+        return false;
+
+    timestamps[vertex] = time++;
+    return true;
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint64 numIndices, uint32 numVertices, uint32 cacheSize)
+{
+    Assert_(numIndices % 3 == 0);
+    Assert_(cacheSize > 0);
+
+    VertexCacheStats stats;
+    stats.NumTriangles = numIndices / 3;
+
+    std::vector<uint32> timestamps(numVertices, 0);
+    std::vector<bool> referenced(numVertices, false);
+    uint32 time = cacheSize + 1;
+
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        const uint32 vertex = indices[i];
+        Assert_(vertex < numVertices);
+
+        if(referenced[vertex] == false)
+        {
+            referenced[vertex] = true;
+            ++stats.NumVertices;
+        }
+
+        if(CacheMiss(timestamps, time, vertex, cacheSize))
+            ++stats.NumCacheMisses;
+    }
+
+    return stats;
+}
+
+void OptimizeVertexCache(uint32* indices, uint64 numIndices, uint32 numVertices, uint32 cacheSize,
+                         std::vector<uint32>* clusters)
+{
+    Assert_(numIndices % 3 == 0);
+    Assert_(cacheSize > 0);
+
+    if(clusters != nullptr)
+        clusters->clear();
+
+    const uint32 numTriangles = uint32(numIndices / 3);
+    if(numTriangles == 0)
+        return;
+
+    // Build the vertex -> triangle adjacency, and count the remaining triangles for each vertex
+    std::vector<uint32> liveTriangles(numVertices, 0);
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        Assert_(indices[i] < numVertices);
+        ++liveTriangles[indices[i]];
+    }
+
+    std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+    for(uint32 v = 0; v < numVertices; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+    std::vector<uint32> adjacency(numIndices);
+    {
+        std::vector<uint32> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(uint64 i = 0; i < numIndices; ++i)
+            adjacency[fillOffsets[indices[i]]++] = uint32(i / 3);
+    }
+
+    std::vector<uint32> timestamps(numVertices, 0);
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<uint32> deadEndStack;
+    deadEndStack.reserve(numIndices);
+    std::vector<uint32> candidates;
+    std::vector<uint32> output;
+    output.reserve(numIndices);
+
+    uint32 time = cacheSize + 1;
+    uint32 cursor = 0;
+    uint32 fanVertex = 0;
+    bool newCluster = true;
+
+    while(fanVertex != InvalidVertex)
+    {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for(uint32 i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; ++i)
+        {
+            const uint32 tri = adjacency[i];
+            if(emitted[tri])
+                continue;
+
+            if(newCluster && clusters != nullptr)
+                clusters->push_back(uint32(output.size() / 3));
+            newCluster = false;
+
+            for(uint32 k = 0; k < 3; ++k)
+            {
+                const uint32 vertex = indices[tri * 3 + k];
+                output.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                CacheMiss(timestamps, time, vertex, cacheSize);
+            }
+
+            emitted[tri] = true;
+        }
+
+        // Pick the next fanning vertex from the 1-ring. Prefer vertices that will still be in
+        // the cache after their remaining triangles are emitted, and then the oldest of those.
+        uint32 nextVertex = InvalidVertex;
+        int64 bestPriority = -1;
+        for(uint64 i = 0; i < candidates.size(); ++i)
+        {
+            const uint32 vertex = candidates[i];
+            if(liveTriangles[vertex] == 0)
+                continue;
+
+            int64 priority = 0;
+            const uint32 age = time - timestamps[vertex];
+            if(age + 2 * liveTriangles[vertex] <= cacheSize)
+                priority = age;
+
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                nextVertex = vertex;
+            }
+        }
+
+        if(nextVertex == InvalidVertex)
+        {
+            // Dead end: fall back to recently-used vertices, and then to the input order
+            newCluster = true;
+
+            while(deadEndStack.empty() == false && nextVertex == InvalidVertex)
+            {
+                const uint32 vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+                if(liveTriangles[vertex] > 0)
+                    nextVertex = vertex;
+            }
+
+            while(nextVertex == InvalidVertex && cursor < numVertices)
+            {
+                if(liveTriangles[cursor] > 0)
+                    nextVertex = cursor;
+                ++cursor;
+            }
+        }
+
+        fanVertex = nextVertex;
+    }
+
+    Assert_(output.size() == numIndices);
+    memcpy(indices, output.data(), numIndices * sizeof(uint32));
+}
+
+void OptimizeOverdraw(uint32* indices, uint64 numIndices, const uint8* positions, uint32 positionStride,
+                      uint32 numVertices, const std::vector<uint32>& hardClusters, uint32 cacheSize, float threshold)
+{
+    Assert_(numIndices % 3 == 0);
+
+    const uint32 numTriangles = uint32(numIndices / 3);
+    if(numTriangles == 0 || hardClusters.size() <= 1)
+        return;
+
+    // Split the clusters further wherever the cache efficiency is already close to the overall
+    // efficiency, so that the sort has more freedom. The cache is flushed at every boundary,
+    // since the clusters can end up in any order.
+    const float maxClusterACMR = AnalyzeVertexCache(indices, numIndices, numVertices, cacheSize).ACMR() * threshold;
+
+    std::vector<uint32> clusters;
+    std::vector<uint32> timestamps(numVertices, 0);
+    uint32 time = cacheSize + 1;
+
+    for(uint64 hardIdx = 0; hardIdx < hardClusters.size(); ++hardIdx)
+    {
+        const uint32 start = hardClusters[hardIdx];
+        const uint32 end = hardIdx + 1 < hardClusters.size() ? hardClusters[hardIdx + 1] : numTriangles;
+
+        clusters.push_back(start);
+        time += cacheSize + 1;
+
+        uint32 clusterStart = start;
+        uint32 clusterMisses = 0;
+        for(uint32 tri = start; tri < end; ++tri)
+        {
+            for(uint32 k = 0; k < 3; ++k)
+                if(CacheMiss(timestamps, time, indices[tri * 3 + k], cacheSize))
+                    ++clusterMisses;
+
+            const uint32 clusterTriangles = tri - clusterStart + 1;
+            if(tri + 1 < end && float(clusterMisses) / clusterTriangles <= maxClusterACMR)
+            {
+                clusters.push_back(tri + 1);
+                clusterStart = tri + 1;
+                clusterMisses = 0;
+                time += cacheSize + 1;
+            }
+        }
+    }
+
+    // Compute an area-weighted centroid and normal for each cluster, and for the whole mesh
+    struct Cluster
+    {
+        uint32 Start;
+        uint32 End;
+        float SortKey;
+    };
+
+    std::vector<Cluster> sortedClusters(clusters.size());
+    std::vector<Float3> clusterCentroids(clusters.size());
+    std::vector<Float3> clusterNormals(clusters.size());
+    Float3 meshCentroid;
+    float meshArea = 0.0f;
+
+    for(uint64 clusterIdx = 0; clusterIdx < clusters.size(); ++clusterIdx)
+    {
+        Cluster& cluster = sortedClusters[clusterIdx];
+        cluster.Start = clusters[clusterIdx];
+        cluster.End = clusterIdx + 1 < clusters.size() ? clusters[clusterIdx + 1] : numTriangles;
+        cluster.SortKey = 0.0f;
+
+        Float3 centroid;
+        Float3 normal;
+        float area = 0.0f;
+        for(uint32 tri = cluster.Start; tri < cluster.End; ++tri)
+        {
+            const Float3& p0 = *reinterpret_cast<const Float3*>(positions + uint64(indices[tri * 3 + 0]) * positionStride);
+            const Float3& p1 = *reinterpret_cast<const Float3*>(positions + uint64(indices[tri * 3 + 1]) * positionStride);
+            const Float3& p2 = *reinterpret_cast<const Float3*>(positions + uint64(indices[tri * 3 + 2]) * positionStride);
+
+            const Float3 triNormal = Float3::Cross(p1 - p0, p2 - p0);
+            const float triArea = Float3::Length(triNormal);
+            centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+            normal += triNormal;
+            area += triArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        clusterCentroids[clusterIdx] = area > 0.0f ? centroid / area : centroid;
+        clusterNormals[clusterIdx] = normal;
+    }
+
+    if(meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters that face away from the center of the mesh are likely to occlude the others
+    for(uint64 clusterIdx = 0; clusterIdx < clusters.size(); ++clusterIdx)
+    {
+        const Float3& normal = clusterNormals[clusterIdx];
+        if(Float3::Length(normal) > 0.0f)
+            sortedClusters[clusterIdx].SortKey = Float3::Dot(clusterCentroids[clusterIdx] - meshCentroid,
+                                                             Float3::Normalize(normal));
+    }
+
+    std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b)
+    {
+        return a.SortKey > b.SortKey;
+    });
+
+    std::vector<uint32> output;
+    output.reserve(numIndices);
+    for(uint64 clusterIdx = 0; clusterIdx < sortedClusters.size(); ++clusterIdx)
+    {
+        const Cluster& cluster = sortedClusters[clusterIdx];
+        output.insert(output.end(), indices + cluster.Start * 3, indices + cluster.End * 3);
+    }
+
+    Assert_(output.size() == numIndices);
+    memcpy(indices, output.data(), numIndices * sizeof(uint32));
+}
+
+uint32 OptimizeVertexFetch(uint8* vertices, uint32 vertexStride, uint32 numVertices, uint32* indices, uint64 numIndices)
+{
+    std::vector<uint32> remap(numVertices, InvalidVertex);
+    uint32 numNewVertices = 0;
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        uint32& newIdx = remap[indices[i]];
+        if(newIdx == InvalidVertex)
+            newIdx = numNewVertices++;
+        indices[i] = newIdx;
+    }
+
+    std::vector<uint8> newVertices(uint64(numNewVertices) * vertexStride);
+    for(uint32 v = 0; v < numVertices; ++v)
+    {
+        if(remap[v] != InvalidVertex)
+            memcpy(&newVertices[uint64(remap[v]) * vertexStride], vertices + uint64(v) * vertexStride, vertexStride);
+    }
+
+    if(newVertices.size() > 0)
+        memcpy(vertices, newVertices.data(), newVertices.size());
+
+    return numNewVertices;
+}
+
+// Computes the bounding sphere and normal cone for a meshlet. The cone test is the one from
+// meshoptimizer (Kapoulkine), which folds the bounding sphere into the cutoff.
+static void ComputeMeshletBounds(const uint32* indices, const uint8* positions, uint32 positionStride,
+                                 Meshlet& meshlet)
+{
+    auto position = [&](uint32 vertex) -> const Float3&
+    {
+        return *reinterpret_cast<const Float3*>(positions + uint64(vertex) * positionStride);
+    };
+
+    Float3 minPosition = Float3(FloatMax, FloatMax, FloatMax);
+    Float3 maxPosition = Float3(-FloatMax, -FloatMax, -FloatMax);
+    Float3 normalSum;
+    std::vector<Float3> normals;
+    normals.reserve(meshlet.IndexCount / 3);
+
+    for(uint32 i = meshlet.IndexStart; i < meshlet.IndexStart + meshlet.IndexCount; i += 3)
+    {
+        const Float3& p0 = position(indices[i + 0]);
+        const Float3& p1 = position(indices[i + 1]);
+        const Float3& p2 = position(indices[i + 2]);
+
+        const Float3* triPositions[3] = { &p0, &p1, &p2 };
+        for(uint32 j = 0; j < 3; ++j)
+        {
+            const Float3& p = *triPositions[j];
+            minPosition = Float3(std::min(minPosition.x, p.x), std::min(minPosition.y, p.y), std::min(minPosition.z, p.z));
+            maxPosition = Float3(std::max(maxPosition.x, p.x), std::max(maxPosition.y, p.y), std::max(maxPosition.z, p.z));
+        }
+
+        // Clockwise winding, so this is the outward-facing normal
+        const Float3 normal = Float3::Cross(p1 - p0, p2 - p0);
+        const float area = Float3::Length(normal);
+        if(area > 0.0f)
+        {
+            normals.push_back(normal / area);
+            normalSum += normal / area;
+        }
+    }
+
+    meshlet.Center = (minPosition + maxPosition) * 0.5f;
+    meshlet.Radius = 0.0f;
+    for(uint32 i = meshlet.IndexStart; i < meshlet.IndexStart + meshlet.IndexCount; ++i)
+        meshlet.Radius = std::max(meshlet.Radius, Float3::Length(position(indices[i]) - meshlet.Center));
+
+    // Fall back to a cone that never culls if the normals don't agree well enough
+    meshlet.ConeAxis = Float3(0.0f, 0.0f, 1.0f);
+    meshlet.ConeCutoff = 1.0f;
+
+    const float axisLength = Float3::Length(normalSum);
+    if(normals.empty() || axisLength <= 0.0f)
+        return;
+
+    const Float3 axis = normalSum / axisLength;
+    float minDot = 1.0f;
+    for(uint64 i = 0; i < normals.size(); ++i)
+        minDot = std::min(minDot, Float3::Dot(axis, normals[i]));
+
+    if(minDot <= 0.1f)
+        return;
+
+    meshlet.ConeAxis = axis;
+    meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(const uint32* indices, uint32 indexStart, uint32 indexCount, const uint8* positions,
+                   uint32 positionStride, uint32 numVertices, std::vector<Meshlet>& meshlets,
+                   uint32 maxVertices, uint32 maxTriangles)
+{
+    Assert_(indexCount % 3 == 0);
+    Assert_(maxVertices >= 3);
+    Assert_(maxTriangles > 0);
+
+    // Marks the vertices that are already in the current meshlet
+    std::vector<uint32> vertexMeshlet(numVertices, InvalidVertex);
+
+    Meshlet meshlet;
+    meshlet.IndexStart = indexStart;
+    meshlet.IndexCount = 0;
+    uint32 numMeshletVertices = 0;
+    uint32 meshletIdx = uint32(meshlets.size());
+
+    const uint32 indexEnd = indexStart + indexCount;
+    for(uint32 i = indexStart; i < indexEnd; i += 3)
+    {
+        uint32 numNewVertices = 0;
+        for(uint32 j = 0; j < 3; ++j)
+        {
+            const uint32 vertex = indices[i + j];
+            Assert_(vertex < numVertices);
+            if(vertexMeshlet[vertex] != meshletIdx)
+                ++numNewVertices;
+        }
+
+        // Start a new meshlet if this triangle doesn't fit
+        if(meshlet.IndexCount / 3 == maxTriangles || numMeshletVertices + numNewVertices > maxVertices)
+        {
+            ComputeMeshletBounds(indices, positions, positionStride, meshlet);
+            meshlets.push_back(meshlet);
+
+            meshlet.IndexStart = i;
+            meshlet.IndexCount = 0;
+            numMeshletVertices = 0;
+            meshletIdx = uint32(meshlets.size());
+        }
+
+        for(uint32 j = 0; j < 3; ++j)
+        {
+            const uint32 vertex = indices[i + j];
+            if(vertexMeshlet[vertex] != meshletIdx)
+            {
+                vertexMeshlet[vertex] = meshletIdx;
+                ++numMeshletVertices;
+            }
+        }
+
+        meshlet.IndexCount += 3;
+    }
+
+    if(meshlet.IndexCount > 0)
+    {
+        ComputeMeshletBounds(indices, positions, positionStride, meshlet);
+        meshlets.push_back(meshlet);
+    }
+}
+
+// Plane quadric for the squared distance to a set of planes, weighted by the area of the triangles
+// that the planes came from
+struct Quadric
+{
+    double A00, A11, A22, A01, A02, A12;
+    double B0, B1, B2;
+    double C;
+    double Weight;
+
+    Quadric() : A00(0.0), A11(0.0), A22(0.0), A01(0.0), A02(0.0), A12(0.0), B0(0.0), B1(0.0), B2(0.0),
+                C(0.0), Weight(0.0)
+    {
+    }
+
+    Quadric(const Float3& n, float d, float weight)
+    {
+        A00 = n.x * n.x * weight;
+        A11 = n.y * n.y * weight;
+        A22 = n.z * n.z * weight;
+        A01 = n.x * n.y * weight;
+        A02 = n.x * n.z * weight;
+        A12 = n.y * n.z * weight;
+        B0 = n.x * d * weight;
+        B1 = n.y * d * weight;
+        B2 = n.z * d * weight;
+        C = double(d) * d * weight;
+        Weight = weight;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        A00 += q.A00;
+        A11 += q.A11;
+        A22 += q.A22;
+        A01 += q.A01;
+        A02 += q.A02;
+        A12 += q.A12;
+        B0 += q.B0;
+        B1 += q.B1;
+        B2 += q.B2;
+        C += q.C;
+        Weight += q.Weight;
+        return *this;
+    }
+
+    // Area-weighted average of the squared distances from p to the planes
+    double Evaluate(const Float3& p) const
+    {
+        const double x = p.x;
+        const double y = p.y;
+        const double z = p.z;
+        const double error = A00 * x * x + A11 * y * y + A22 * z * z + 2.0 * (A01 * x * y + A02 * x * z + A12 * y * z)
+                           + 2.0 * (B0 * x + B1 * y + B2 * z) + C;
+        return Weight > 0.0 ? std::max(error, 0.0) / Weight : 0.0;
+    }
+};
+
+uint64 SimplifyMesh(const uint32* indices, uint64 numIndices, const uint8* positions, uint32 positionStride,
+                    uint32 numVertices, const SimplifyAttribute* attributes, uint32 numAttributes,
+                    uint64 targetIndexCount, float maxError, uint32* dstIndices, float* resultError)
+{
+    Assert_(numIndices % 3 == 0);
+
+    if(dstIndices != indices)
+        memcpy(dstIndices, indices, numIndices * sizeof(uint32));
+
+    if(resultError != nullptr)
+        *resultError = 0.0f;
+
+    if(numIndices <= targetIndexCount || numVertices == 0)
+        return numIndices;
+
+    // Work with positions scaled to the size of the mesh, so that the errors and attribute weights
+    // don't depend on the units that the mesh was authored in
+    Float3 minPosition = Float3(FloatMax, FloatMax, FloatMax);
+    Float3 maxPosition = Float3(-FloatMax, -FloatMax, -FloatMax);
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        Assert_(indices[i] < numVertices);
+        const Float3& p = *reinterpret_cast<const Float3*>(positions + uint64(indices[i]) * positionStride);
+        minPosition = Float3(std::min(minPosition.x, p.x), std::min(minPosition.y, p.y), std::min(minPosition.z, p.z));
+        maxPosition = Float3(std::max(maxPosition.x, p.x), std::max(maxPosition.y, p.y), std::max(maxPosition.z, p.z));
+    }
+
+    const Float3 size = maxPosition - minPosition;
+    const float extent = std::max(std::max(size.x, size.y), size.z);
+    if(extent <= 0.0f)
+        return numIndices;
+
+    const float invExtent = 1.0f / extent;
+    std::vector<Float3> scaledPositions(numVertices);
+    for(uint32 v = 0; v < numVertices; ++v)
+    {
+        const Float3& p = *reinterpret_cast<const Float3*>(positions + uint64(v) * positionStride);
+        scaledPositions[v] = (p - minPosition) * invExtent;
+    }
+
+    // Lock the vertices of every half-edge that doesn't have a twin going the other way
+    std::vector<uint64> halfEdges(numIndices);
+    for(uint64 i = 0; i < numIndices; i += 3)
+    {
+        for(uint64 k = 0; k < 3; ++k)
+        {
+            const uint32 a = indices[i + k];
+            const uint32 b = indices[i + (k + 1) % 3];
+            halfEdges[i + k] = (uint64(a) << 32) | b;
+        }
+    }
+    std::sort(halfEdges.begin(), halfEdges.end());
+
+    std::vector<bool> locked(numVertices, false);
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        const uint32 a = uint32(halfEdges[i] >> 32);
+        const uint32 b = uint32(halfEdges[i] & 0xFFFFFFFF);
+        const uint64 twin = (uint64(b) << 32) | a;
+        if(std::binary_search(halfEdges.begin(), halfEdges.end(), twin) == false)
+        {
+            locked[a] = true;
+            locked[b] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(numVertices);
+    for(uint64 i = 0; i < numIndices; i += 3)
+    {
+        const Float3& p0 = scaledPositions[indices[i + 0]];
+        const Float3& p1 = scaledPositions[indices[i + 1]];
+        const Float3& p2 = scaledPositions[indices[i + 2]];
+
+        Float3 normal = Float3::Cross(p1 - p0, p2 - p0);
+        const float length = Float3::Length(normal);
+        if(length <= 0.0f)
+            continue;
+
+        normal /= length;
+        const Quadric quadric(normal, -Float3::Dot(normal, p0), length * 0.5f);
+        for(uint64 k = 0; k < 3; ++k)
+            quadrics[indices[i + k]] += quadric;
+    }
+
+    auto attributeError = [&](uint32 a, uint32 b) -> double
+    {
+        double error = 0.0;
+        for(uint32 attrIdx = 0; attrIdx < numAttributes; ++attrIdx)
+        {
+            const SimplifyAttribute& attribute = attributes[attrIdx];
+            const float* va = reinterpret_cast<const float*>(attribute.Data + uint64(a) * attribute.Stride);
+            const float* vb = reinterpret_cast<const float*>(attribute.Data + uint64(b) * attribute.Stride);
+            for(uint32 c = 0; c < attribute.NumComponents; ++c)
+            {
+                const double diff = double(va[c]) - vb[c];
+                error += diff * diff * attribute.Weight;
+            }
+        }
+
+        return error;
+    };
+
+    auto collapseCost = [&](uint32 from, uint32 to) -> float
+    {
+        Quadric quadric = quadrics[from];
+        quadric += quadrics[to];
+        return float(quadric.Evaluate(scaledPositions[to]) + attributeError(from, to));
+    };
+
+    struct Collapse
+    {
+        float Cost;
+        uint32 From;
+        uint32 To;
+    };
+
+    const double scaledMaxError = double(maxError) * invExtent;
+    const double maxCost = scaledMaxError * scaledMaxError;
+    double maxCollapseCost = 0.0;
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32> adjacencyOffsets(numVertices + 1);
+    std::vector<uint32> adjacencyCounts(numVertices);
+    std::vector<uint32> adjacentTriangles;
+    std::vector<uint32> remap(numVertices);
+    std::vector<bool> touched(numVertices);
+
+    uint64 indexCount = numIndices;
+    while(indexCount > targetIndexCount)
+    {
+        // Find the triangles around each vertex
+        std::fill(adjacencyCounts.begin(), adjacencyCounts.end(), 0);
+        for(uint64 i = 0; i < indexCount; ++i)
+            ++adjacencyCounts[dstIndices[i]];
+
+        adjacencyOffsets[0] = 0;
+        for(uint32 v = 0; v < numVertices; ++v)
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + adjacencyCounts[v];
+
+        adjacentTriangles.resize(indexCount);
+        std::fill(adjacencyCounts.begin(), adjacencyCounts.end(), 0);
+        for(uint64 i = 0; i < indexCount; ++i)
+        {
+            const uint32 v = dstIndices[i];
+            adjacentTriangles[adjacencyOffsets[v] + adjacencyCounts[v]++] = uint32(i / 3);
+        }
+
+        // Every interior edge shows up once in each direction, so only look at one of them and
+        // consider collapsing either way
+        collapses.clear();
+        for(uint64 i = 0; i < indexCount; i += 3)
+        {
+            for(uint64 k = 0; k < 3; ++k)
+            {
+                const uint32 a = dstIndices[i + k];
+                const uint32 b = dstIndices[i + (k + 1) % 3];
+                if(a > b)
+                    continue;
+
+                if(locked[a] == false)
+                {
+                    Collapse collapse = { collapseCost(a, b), a, b };
+                    collapses.push_back(collapse);
+                }
+
+                if(locked[b] == false)
+                {
+                    Collapse collapse = { collapseCost(b, a), b, a };
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        if(collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+        {
+            return a.Cost < b.Cost;
+        });
+
+        for(uint32 v = 0; v < numVertices; ++v)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+
+        // Apply the cheapest collapses that don't overlap. A vertex can only be involved in one
+        // collapse per pass, so that the flip test below is done against up-to-date positions.
+        const uint64 trianglesToRemove = (indexCount - targetIndexCount + 2) / 3;
+        uint64 numRemoved = 0;
+        uint64 numCollapses = 0;
+        for(uint64 collapseIdx = 0; collapseIdx < collapses.size() && numRemoved < trianglesToRemove; ++collapseIdx)
+        {
+            const Collapse& collapse = collapses[collapseIdx];
+            if(collapse.Cost > maxCost)
+                break;
+
+            if(touched[collapse.From] || touched[collapse.To])
+                continue;
+
+            // Don't let any of the remaining triangles flip over, or rotate far enough that a
+            // few more collapses could flip them
+            bool flips = false;
+            uint32 numCollapsed = 0;
+            for(uint32 adjIdx = adjacencyOffsets[collapse.From]; adjIdx < adjacencyOffsets[collapse.From + 1]; ++adjIdx)
+            {
+                const uint32* tri = &dstIndices[adjacentTriangles[adjIdx] * 3];
+                if(tri[0] == collapse.To || tri[1] == collapse.To || tri[2] == collapse.To)
+                {
+                    ++numCollapsed;
+                    continue;
+                }
+
+                Float3 oldPositions[3];
+                Float3 newPositions[3];
+                for(uint32 k = 0; k < 3; ++k)
+                {
+                    oldPositions[k] = scaledPositions[tri[k]];
+                    newPositions[k] = scaledPositions[tri[k] == collapse.From ? collapse.To : tri[k]];
+                }
+
+                const Float3 oldNormal = Float3::Cross(oldPositions[1] - oldPositions[0], oldPositions[2] - oldPositions[0]);
+                const Float3 newNormal = Float3::Cross(newPositions[1] - newPositions[0], newPositions[2] - newPositions[0]);
+                if(Float3::Dot(oldNormal, newNormal) <= 0.25f * Float3::Length(oldNormal) * Float3::Length(newNormal))
+                {
+                    flips = true;
+                    break;
+                }
+            }
+
+            if(flips)
+                continue;
+
+            for(uint32 adjIdx = adjacencyOffsets[collapse.From]; adjIdx < adjacencyOffsets[collapse.From + 1]; ++adjIdx)
+            {
+                const uint32* tri = &dstIndices[adjacentTriangles[adjIdx] * 3];
+                for(uint32 k = 0; k < 3; ++k)
+                    touched[tri[k]] = true;
+            }
+
+            remap[collapse.From] = collapse.To;
+            quadrics[collapse.To] += quadrics[collapse.From];
+            maxCollapseCost = std::max(maxCollapseCost, double(collapse.Cost));
+            numRemoved += numCollapsed;
+            ++numCollapses;
+        }
+
+        if(numCollapses == 0)
+            break;
+
+        // Remap the indices and drop the triangles that collapsed down to an edge
+        uint64 newIndexCount = 0;
+        for(uint64 i = 0; i < indexCount; i += 3)
+        {
+            const uint32 a = remap[dstIndices[i + 0]];
+            const uint32 b = remap[dstIndices[i + 1]];
+            const uint32 c = remap[dstIndices[i + 2]];
+            if(a == b || b == c || a == c)
+                continue;
+
+            dstIndices[newIndexCount + 0] = a;
+            dstIndices[newIndexCount + 1] = b;
+            dstIndices[newIndexCount + 2] = c;
+            newIndexCount += 3;
+        }
+
+        indexCount = newIndexCount;
+    }
+
+    if(resultError != nullptr)
+        *resultError = float(std::sqrt(maxCollapseCost)) * extent;
+
+    return indexCount;
+}
+
+}
@@ -0,0 +1,121 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\SF11_Math.h"
+
+namespace SampleFramework11
+{
+
+static const uint32 DefaultVertexCacheSize = 16;
+static const float DefaultOverdrawThreshold = 1.05f;
+static const uint32 MaxMeshletVertices = 64;
+static const uint32 MaxMeshletTriangles = 124;
+
+// Results from simulating a FIFO post-transform vertex cache
+struct VertexCacheStats
+{
+    uint64 NumTriangles = 0;
+    uint64 NumVertices = 0;
+    uint64 NumCacheMisses = 0;
+
+    // Average cache miss ratio, the number of vertices transformed per triangle. 0.5 is the best
+    // possible for a large regular grid, and 3.0 is the worst.
+    float ACMR() const { return NumTriangles > 0 ? float(double(NumCacheMisses) / NumTriangles) : 0.0f; }
+
+    // Average transform to vertex ratio. 1.0 means every vertex is only transformed once.
+    float ATVR() const { return NumVertices > 0 ? float(double(NumCacheMisses) / NumVertices) : 0.0f; }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& other)
+    {
+        NumTriangles += other.NumTriangles;
+        NumVertices += other.NumVertices;
+        NumCacheMisses += other.NumCacheMisses;
+        return *this;
+    }
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint64 numIndices, uint32 numVertices,
+                                    uint32 cacheSize = DefaultVertexCacheSize);
+
+// Reorders triangles for the post-transform vertex cache using Tipsify (Sander et al. 2007).
+// If clusters is non-null, it receives the first triangle of each cluster that starts at a
+// dead end, which can be re-ordered freely without hurting cache efficiency much.
+void OptimizeVertexCache(uint32* indices, uint64 numIndices, uint32 numVertices,
+                         uint32 cacheSize = DefaultVertexCacheSize, std::vector<uint32>* clusters = nullptr);
+
+// Sorts the clusters from OptimizeVertexCache so that outward-facing clusters are drawn first,
+// which reduces overdraw from most view directions. Clusters are split further wherever the
+// local ACMR is within threshold of the overall ACMR.
+void OptimizeOverdraw(uint32* indices, uint64 numIndices, const uint8* positions, uint32 positionStride,
+                      uint32 numVertices, const std::vector<uint32>& clusters,
+                      uint32 cacheSize = DefaultVertexCacheSize, float threshold = DefaultOverdrawThreshold);
+
+// Reorders vertices in the order that the indices first reference them, and remaps the indices.
+// Unreferenced vertices are removed, and the new vertex count is returned.
+uint32 OptimizeVertexFetch(uint8* vertices, uint32 vertexStride, uint32 numVertices,
+                           uint32* indices, uint64 numIndices);
+
+// A small cluster of neighboring triangles that can be culled on its own
+struct Meshlet
+{
+    uint32 IndexStart;
+    uint32 IndexCount;
+
+    // Bounding sphere
+    Float3 Center;
+    float Radius;
+
+    // Cone containing all of the triangle normals. ConeCutoff is the sine of the cone's half
+    // angle, or 1 if the normals are spread out too far for the cone to be useful.
+    Float3 ConeAxis;
+    float ConeCutoff;
+};
+
+// Splits the triangles in [indexStart, indexStart + indexCount) into meshlets of consecutive
+// triangles, and appends them to meshlets. The triangles should already be ordered for the vertex
+// cache, so that neighboring triangles are close together in the index buffer.
+void BuildMeshlets(const uint32* indices, uint32 indexStart, uint32 indexCount, const uint8* positions,
+                   uint32 positionStride, uint32 numVertices, std::vector<Meshlet>& meshlets,
+                   uint32 maxVertices = MaxMeshletVertices, uint32 maxTriangles = MaxMeshletTriangles);
+
+// A per-vertex attribute that SimplifyMesh tries to preserve, stored as NumComponents floats
+struct SimplifyAttribute
+{
+    const uint8* Data;
+    uint32 Stride;
+    uint32 NumComponents;
+    float Weight;
+};
+
+// Reduces the triangle count with edge collapses ranked by quadric error (Garland and Heckbert 1997).
+// Every collapse moves a vertex onto one of its neighbors, so the result references a subset of
+// the original vertices and can share their vertex buffer. The cost of a collapse also includes the
+// weighted difference in attributes between the two vertices. Vertices on open edges are locked,
+// which keeps mesh borders intact along with UV and normal seams, since the split vertices along a
+// seam show up as open edges. Stops once the index count reaches targetIndexCount or every remaining
+// collapse has an error above maxError. dstIndices needs room for numIndices indices, and the new
+// index count is returned. resultError receives the largest error of any collapse, in the same
+// units as the positions.
+uint64 SimplifyMesh(const uint32* indices, uint64 numIndices, const uint8* positions, uint32 positionStride,
+                    uint32 numVertices, const SimplifyAttribute* attributes, uint32 numAttributes,
+                    uint64 targetIndexCount, float maxError, uint32* dstIndices, float* resultError = nullptr);
+
+// Returns true if every triangle in the meshlet faces away from a viewer at viewPosition,
+// assuming clockwise front faces
+inline bool IsMeshletBackFacing(const Meshlet& meshlet, const Float3& viewPosition)
+{
+    const Float3 toCenter = meshlet.Center - viewPosition;
+    return Float3::Dot(toCenter, meshlet.ConeAxis) >= meshlet.ConeCutoff * Float3::Length(toCenter) + meshlet.Radius;
+}
+
+}
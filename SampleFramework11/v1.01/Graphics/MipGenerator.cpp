@@ -0,0 +1,510 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "MipGenerator.h"
+
+#include "..\\Assert.h"
+#include "..\\ThreadPool.h"
+#include "..\\SF11_Math.h"
+#include "Filtering.h"
+#include "PixelConversion.h"
+
+namespace SampleFramework11
+{
+
+// Number of rows processed per ParallelFor work item
+static const uint64 RowsPerWorkItem = 4;
+
+static const float NumSincLobes = 3.0f;
+static const float KaiserAlpha = 4.0f;
+
+// Resampling weights for one dimension of a mip level. Destination texel i is the sum of
+// Weights[i * NumTaps + t] * source texel Indices[i * NumTaps + t], and unused taps have a weight of 0.
+struct FilterKernel
+{
+    uint32 NumTaps = 0;
+    std::vector<uint32> Indices;
+    std::vector<float> Weights;
+};
+
+struct FilterTap
+{
+    uint32 Index;
+    float Weight;
+};
+
+static void BuildKernel(MipFilter filter, uint32 srcSize, uint32 dstSize, FilterKernel& kernel)
+{
+    Assert_(dstSize > 0 && srcSize >= dstSize);
+
+    // The filter's radius is measured in destination texels, and then scaled to the source
+    const float scale = float(srcSize) / float(dstSize);
+    const float radius = (filter == MipFilter::Box ? 0.5f : NumSincLobes) * scale;
+
+    std::vector<std::vector<FilterTap>> taps(dstSize);
+    uint32 numTaps = 1;
+    for(uint32 dstIdx = 0; dstIdx < dstSize; ++dstIdx)
+    {
+        const float center = (dstIdx + 0.5f) * scale;
+        const int64 first = int64(std::floor(center - radius));
+        const int64 last = int64(std::ceil(center + radius));
+
+        std::vector<FilterTap>& dstTaps = taps[dstIdx];
+        float weightSum = 0.0f;
+        for(int64 srcIdx = first; srcIdx < last; ++srcIdx)
+        {
+            float weight = 0.0f;
+            if(filter == MipFilter::Box)
+            {
+                // How much of the source texel falls inside the destination texel
+                const float overlapStart = std::max(float(srcIdx), center - radius);
+                const float overlapEnd = std::min(float(srcIdx + 1), center + radius);
+                weight = std::max(overlapEnd - overlapStart, 0.0f);
+            }
+            else
+            {
+                const float x = (srcIdx + 0.5f - center) / radius;
+                if(filter == MipFilter::Kaiser)
+                    weight = FilterKaiser1D(x, NumSincLobes, KaiserAlpha);
+                else
+                    weight = FilterLanczos1D(x, NumSincLobes);
+            }
+
+            if(weight == 0.0f)
+                continue;
+
+            // Texels past the edge are clamped, which folds their weight into the edge texel
+            const uint32 clampedIdx = uint32(Clamp<int64>(srcIdx, 0, srcSize - 1));
+            uint64 tapIdx = 0;
+            while(tapIdx < dstTaps.size() && dstTaps[tapIdx].Index != clampedIdx)
+                ++tapIdx;
+
+            if(tapIdx == dstTaps.size())
+            {
+                FilterTap tap = { clampedIdx, 0.0f };
+                dstTaps.push_back(tap);
+            }
+
+            dstTaps[tapIdx].Weight += weight;
+            weightSum += weight;
+        }
+
+        Assert_(dstTaps.size() > 0 && weightSum != 0.0f);
+        for(uint64 tapIdx = 0; tapIdx < dstTaps.size(); ++tapIdx)
+            dstTaps[tapIdx].Weight /= weightSum;
+
+        numTaps = std::max(numTaps, uint32(dstTaps.size()));
+    }
+
+    kernel.NumTaps = numTaps;
+    kernel.Indices.assign(dstSize * numTaps, 0);
+    kernel.Weights.assign(dstSize * numTaps, 0.0f);
+    for(uint32 dstIdx = 0; dstIdx < dstSize; ++dstIdx)
+    {
+        for(uint64 tapIdx = 0; tapIdx < taps[dstIdx].size(); ++tapIdx)
+        {
+            kernel.Indices[dstIdx * numTaps + tapIdx] = taps[dstIdx][tapIdx].Index;
+            kernel.Weights[dstIdx * numTaps + tapIdx] = taps[dstIdx][tapIdx].Weight;
+        }
+    }
+}
+
+// Filters every slice of a level down to the next one, first horizontally into temp and then
+// vertically into dst. The vertical pass accumulates whole rows at a time, so that it streams
+// through memory instead of striding down columns. loadRow(row, scratch) returns a pointer to a
+// row of linear source texels, which it can either point into the previous level or convert into
+// scratch (which has room for srcWidth texels).
+template<typename TLoadRow> static void DownsampleLevel(TLoadRow loadRow, uint32 srcWidth, uint32 srcHeight,
+                                                        uint32 numSlices, XMFLOAT4A* dst, uint32 dstWidth,
+                                                        uint32 dstHeight, MipFilter filter,
+                                                        std::vector<XMFLOAT4A>& temp)
+{
+    FilterKernel kernelX;
+    FilterKernel kernelY;
+    BuildKernel(filter, srcWidth, dstWidth, kernelX);
+    BuildKernel(filter, srcHeight, dstHeight, kernelY);
+
+    temp.resize(uint64(dstWidth) * srcHeight * numSlices);
+    XMFLOAT4A* tempData = temp.data();
+
+    std::vector<std::vector<XMFLOAT4A>> rowScratch(NumWorkerThreads());
+
+    ParallelFor(uint64(srcHeight) * numSlices, RowsPerWorkItem, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        std::vector<XMFLOAT4A>& scratch = rowScratch[threadIdx];
+        scratch.resize(srcWidth);
+
+        const uint32 numTaps = kernelX.NumTaps;
+        for(uint64 row = startRow; row < endRow; ++row)
+        {
+            const XMFLOAT4A* srcRow = loadRow(row, scratch.data());
+            XMFLOAT4A* tempRow = tempData + row * dstWidth;
+            for(uint32 x = 0; x < dstWidth; ++x)
+            {
+                const uint32* indices = &kernelX.Indices[x * numTaps];
+                const float* weights = &kernelX.Weights[x * numTaps];
+
+                XMVECTOR sum = XMVectorZero();
+                for(uint32 t = 0; t < numTaps; ++t)
+                    sum = XMVectorMultiplyAdd(XMLoadFloat4A(&srcRow[indices[t]]), XMVectorReplicate(weights[t]), sum);
+
+                XMStoreFloat4A(&tempRow[x], sum);
+            }
+        }
+    });
+
+    ParallelFor(uint64(dstHeight) * numSlices, RowsPerWorkItem, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        const uint32 numTaps = kernelY.NumTaps;
+        for(uint64 row = startRow; row < endRow; ++row)
+        {
+            const uint64 slice = row / dstHeight;
+            const uint32 y = uint32(row % dstHeight);
+            const XMFLOAT4A* tempSlice = tempData + slice * srcHeight * dstWidth;
+            XMFLOAT4A* dstRow = dst + row * dstWidth;
+
+            for(uint32 t = 0; t < numTaps; ++t)
+            {
+                const float weight = kernelY.Weights[y * numTaps + t];
+                if(t > 0 && weight == 0.0f)
+                    continue;
+
+                const XMFLOAT4A* tempRow = tempSlice + uint64(kernelY.Indices[y * numTaps + t]) * dstWidth;
+                const XMVECTOR weightVec = XMVectorReplicate(weight);
+                if(t == 0)
+                {
+                    for(uint32 x = 0; x < dstWidth; ++x)
+                        XMStoreFloat4A(&dstRow[x], XMVectorMultiply(XMLoadFloat4A(&tempRow[x]), weightVec));
+                }
+                else
+                {
+                    for(uint32 x = 0; x < dstWidth; ++x)
+                    {
+                        const XMVECTOR sum = XMVectorMultiplyAdd(XMLoadFloat4A(&tempRow[x]), weightVec,
+                                                                 XMLoadFloat4A(&dstRow[x]));
+                        XMStoreFloat4A(&dstRow[x], sum);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// == Cube Map Edges ==============================================================================
+
+// Same face conventions as MapXYSToDirection and SampleCubemap. u and v are in [-1, 1], with v
+// pointing up.
+static Float3 FaceUVToDirection(uint32 face, float u, float v)
+{
+    switch(face)
+    {
+        case 0: return Float3(1.0f, v, -u);
+        case 1: return Float3(-1.0f, v, u);
+        case 2: return Float3(u, 1.0f, -v);
+        case 3: return Float3(u, -1.0f, v);
+        case 4: return Float3(u, v, 1.0f);
+        default: return Float3(-u, v, -1.0f);
+    }
+}
+
+static void DirectionToFaceUV(Float3 dir, uint32& face, float& u, float& v)
+{
+    const float absX = std::abs(dir.x);
+    const float absY = std::abs(dir.y);
+    const float absZ = std::abs(dir.z);
+    if(absX >= absY && absX >= absZ)
+    {
+        face = dir.x > 0.0f ? 0 : 1;
+        u = (dir.x > 0.0f ? -dir.z : dir.z) / absX;
+        v = dir.y / absX;
+    }
+    else if(absY >= absZ)
+    {
+        face = dir.y > 0.0f ? 2 : 3;
+        u = dir.x / absY;
+        v = (dir.y > 0.0f ? -dir.z : dir.z) / absY;
+    }
+    else
+    {
+        face = dir.z > 0.0f ? 4 : 5;
+        u = (dir.z > 0.0f ? dir.x : -dir.x) / absZ;
+        v = dir.y / absZ;
+    }
+}
+
+// Finds the texel on the face across one edge of the given texel, by stepping just past the edge
+// and mapping the direction back onto the cube
+static uint64 AdjacentFaceTexel(uint32 face, uint32 x, uint32 y, int32 stepX, int32 stepY, uint32 size)
+{
+    const float Epsilon = 0.001f;
+    float u = ((x + 0.5f) / size) * 2.0f - 1.0f;
+    float v = -(((y + 0.5f) / size) * 2.0f - 1.0f);
+    if(stepX != 0)
+        u = stepX * (1.0f + Epsilon);
+    if(stepY != 0)
+        v = -stepY * (1.0f + Epsilon);
+
+    uint32 adjacentFace = 0;
+    DirectionToFaceUV(FaceUVToDirection(face, u, v), adjacentFace, u, v);
+    Assert_(adjacentFace != face);
+
+    const uint32 adjacentX = std::min(uint32(std::max((u * 0.5f + 0.5f) * size, 0.0f)), size - 1);
+    const uint32 adjacentY = std::min(uint32(std::max((-v * 0.5f + 0.5f) * size, 0.0f)), size - 1);
+    return (uint64(adjacentFace) * size + adjacentY) * size + adjacentX;
+}
+
+// Averages every texel along the edges of each face with its neighbours on the adjacent faces.
+// Texels along an edge end up matching the texel across from them, and the three texels that
+// meet at a corner all end up with the same value.
+static void FixupCubeMapEdges(XMFLOAT4A* texels, uint32 size, uint32 numSlices, std::vector<XMFLOAT4A>& temp)
+{
+    Assert_(numSlices % 6 == 0);
+    if(size < 2)
+        return;
+
+    // Gather the border texels of each face in the same order, with the neighbours looked up once
+    std::vector<uint32> borderX;
+    std::vector<uint32> borderY;
+    for(uint32 y = 0; y < size; ++y)
+    {
+        for(uint32 x = 0; x < size; ++x)
+        {
+            if(x == 0 || y == 0 || x == size - 1 || y == size - 1)
+            {
+                borderX.push_back(x);
+                borderY.push_back(y);
+            }
+        }
+    }
+
+    const uint64 numBorderTexels = borderX.size();
+    const uint64 faceSize = uint64(size) * size;
+    const uint64 MaxNeighbors = 2;
+    std::vector<uint64> neighbors(numBorderTexels * 6 * MaxNeighbors);
+    std::vector<uint32> numNeighbors(numBorderTexels * 6, 0);
+    for(uint32 face = 0; face < 6; ++face)
+    {
+        for(uint64 i = 0; i < numBorderTexels; ++i)
+        {
+            const uint32 x = borderX[i];
+            const uint32 y = borderY[i];
+            const uint64 entry = face * numBorderTexels + i;
+            uint64* entryNeighbors = &neighbors[entry * MaxNeighbors];
+            if(x == 0 || x == size - 1)
+                entryNeighbors[numNeighbors[entry]++] = AdjacentFaceTexel(face, x, y, x == 0 ? -1 : 1, 0, size);
+            if(y == 0 || y == size - 1)
+                entryNeighbors[numNeighbors[entry]++] = AdjacentFaceTexel(face, x, y, 0, y == 0 ? -1 : 1, size);
+        }
+    }
+
+    const uint64 numCubes = numSlices / 6;
+    temp.resize(numBorderTexels * numSlices);
+    for(uint64 cube = 0; cube < numCubes; ++cube)
+    {
+        XMFLOAT4A* cubeTexels = texels + cube * 6 * faceSize;
+        XMFLOAT4A* results = &temp[cube * 6 * numBorderTexels];
+
+        for(uint32 face = 0; face < 6; ++face)
+        {
+            for(uint64 i = 0; i < numBorderTexels; ++i)
+            {
+                const uint64 entry = face * numBorderTexels + i;
+                const uint64 texelIdx = face * faceSize + borderY[i] * size + borderX[i];
+
+                XMVECTOR sum = XMLoadFloat4A(&cubeTexels[texelIdx]);
+                for(uint32 n = 0; n < numNeighbors[entry]; ++n)
+                    sum += XMLoadFloat4A(&cubeTexels[neighbors[entry * MaxNeighbors + n]]);
+
+                sum *= 1.0f / (numNeighbors[entry] + 1);
+
+                XMStoreFloat4A(&results[entry], sum);
+            }
+        }
+
+        for(uint32 face = 0; face < 6; ++face)
+        {
+            for(uint64 i = 0; i < numBorderTexels; ++i)
+            {
+                const uint64 entry = face * numBorderTexels + i;
+                cubeTexels[face * faceSize + borderY[i] * size + borderX[i]] = results[entry];
+            }
+        }
+    }
+}
+
+// == Texel Conversion ============================================================================
+
+static float SRGBToLinear(float srgb)
+{
+    return srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSRGB(float linear)
+{
+    linear = std::max(linear, 0.0f);
+    return linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+// Loads texels as linear floats. Half and float texels with srgb set hold sRGB values in floating
+// point, which go through the exact curve.
+static void LoadLinearTexels(const UByte4N* src, bool srgb, XMFLOAT4A* dst, uint64 numTexels)
+{
+    if(srgb)
+        PixelConversion::SRGBA8ToFloat(&src[0].Bits, &dst[0].x, size_t(numTexels));
+    else
+        PixelConversion::UNorm8ToFloat(reinterpret_cast<const uint8*>(src), &dst[0].x, size_t(numTexels * 4));
+}
+
+static void LoadLinearTexels(const Half4* src, bool srgb, XMFLOAT4A* dst, uint64 numTexels)
+{
+    PixelConversion::HalfToFloat(&src[0].x, &dst[0].x, size_t(numTexels * 4));
+    for(uint64 i = 0; i < numTexels && srgb; ++i)
+        dst[i] = XMFLOAT4A(SRGBToLinear(dst[i].x), SRGBToLinear(dst[i].y), SRGBToLinear(dst[i].z), dst[i].w);
+}
+
+static void LoadLinearTexels(const Float4* src, bool srgb, XMFLOAT4A* dst, uint64 numTexels)
+{
+    memcpy(dst, src, numTexels * sizeof(Float4));
+    for(uint64 i = 0; i < numTexels && srgb; ++i)
+        dst[i] = XMFLOAT4A(SRGBToLinear(dst[i].x), SRGBToLinear(dst[i].y), SRGBToLinear(dst[i].z), dst[i].w);
+}
+
+static void StoreFloatTexels(const XMFLOAT4A* src, Half4* dst, uint64 numTexels)
+{
+    PixelConversion::FloatToHalf(&src[0].x, &dst[0].x, size_t(numTexels * 4));
+}
+
+static void StoreFloatTexels(const XMFLOAT4A* src, Float4* dst, uint64 numTexels)
+{
+    memcpy(dst, src, numTexels * sizeof(Float4));
+}
+
+// Stores linear float texels, converting them back to sRGB if needed
+template<typename T> static void StoreTexels(const XMFLOAT4A* src, bool srgb, T* dst, uint64 numTexels)
+{
+    if(srgb == false)
+    {
+        StoreFloatTexels(src, dst, numTexels);
+        return;
+    }
+
+    // The source texels get filtered again for the next level, so they're converted a chunk at a time
+    const uint64 ChunkSize = 256;
+    XMFLOAT4A srgbTexels[ChunkSize];
+    for(uint64 start = 0; start < numTexels; start += ChunkSize)
+    {
+        const uint64 count = std::min(numTexels - start, ChunkSize);
+        for(uint64 i = 0; i < count; ++i)
+        {
+            const XMFLOAT4A& texel = src[start + i];
+            srgbTexels[i] = XMFLOAT4A(LinearToSRGB(texel.x), LinearToSRGB(texel.y), LinearToSRGB(texel.z), texel.w);
+        }
+
+        StoreFloatTexels(srgbTexels, dst + start, count);
+    }
+}
+
+static void StoreTexels(const XMFLOAT4A* src, bool srgb, UByte4N* dst, uint64 numTexels)
+{
+    if(srgb)
+        PixelConversion::FloatToSRGBA8(&src[0].x, &dst[0].Bits, size_t(numTexels));
+    else
+        PixelConversion::FloatToUNorm8(&src[0].x, reinterpret_cast<uint8*>(dst), size_t(numTexels * 4));
+}
+
+// == Mip Generation ==============================================================================
+
+template<typename T> static void GenerateMips(TextureData<T>& texData, MipFilter filter, bool srgb, bool cubeMap,
+                                              uint32 numMips)
+{
+    Assert_(texData.Width > 0 && texData.Height > 0 && texData.NumSlices > 0);
+    Assert_(uint64(filter) < uint64(MipFilter::NumValues));
+    Assert_(cubeMap == false || (texData.NumSlices % 6 == 0 && texData.Width == texData.Height));
+    Assert_(texData.Texels.size() >= uint64(texData.Width) * texData.Height * texData.NumSlices);
+
+    uint32 maxMips = 1;
+    while((std::max(texData.Width, texData.Height) >> maxMips) > 0)
+        ++maxMips;
+    numMips = numMips == 0 ? maxMips : std::min(numMips, maxMips);
+
+    // The top mip stays where it is, since the mips are stored after it
+    texData.NumMips = numMips;
+    texData.Texels.resize(texData.MipOffset(numMips));
+
+    const uint32 numSlices = texData.NumSlices;
+    const uint32 width = texData.Width;
+    const T* topMip = texData.Texels.data();
+    std::vector<XMFLOAT4A> srcLevel;
+    std::vector<XMFLOAT4A> dstLevel;
+    std::vector<XMFLOAT4A> temp;
+
+    // The top mip is converted to linear floats a row at a time as it's filtered, and the levels
+    // after that are filtered from the float copy of the previous level
+    auto loadTopMipRow = [&](uint64 row, XMFLOAT4A* scratch) -> const XMFLOAT4A*
+    {
+        LoadLinearTexels(topMip + row * width, srgb, scratch, width);
+        return scratch;
+    };
+
+    for(uint32 mipLevel = 1; mipLevel < numMips; ++mipLevel)
+    {
+        const uint32 srcWidth = texData.MipWidth(mipLevel - 1);
+        const uint32 srcHeight = texData.MipHeight(mipLevel - 1);
+        const uint32 dstWidth = texData.MipWidth(mipLevel);
+        const uint32 dstHeight = texData.MipHeight(mipLevel);
+
+        dstLevel.resize(uint64(dstWidth) * dstHeight * numSlices);
+        if(mipLevel == 1)
+        {
+            DownsampleLevel(loadTopMipRow, srcWidth, srcHeight, numSlices, dstLevel.data(), dstWidth, dstHeight,
+                            filter, temp);
+        }
+        else
+        {
+            const XMFLOAT4A* srcTexels = srcLevel.data();
+            auto loadLevelRow = [=](uint64 row, XMFLOAT4A* scratch) -> const XMFLOAT4A*
+            {
+                return srcTexels + row * srcWidth;
+            };
+
+            DownsampleLevel(loadLevelRow, srcWidth, srcHeight, numSlices, dstLevel.data(), dstWidth, dstHeight,
+                            filter, temp);
+        }
+
+        if(cubeMap)
+            FixupCubeMapEdges(dstLevel.data(), dstWidth, numSlices, temp);
+
+        T* dstTexels = &texData.Texels[texData.MipOffset(mipLevel)];
+        ParallelFor(dstLevel.size(), dstWidth * RowsPerWorkItem, [&](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            StoreTexels(&dstLevel[start], srgb, dstTexels + start, end - start);
+        });
+
+        srcLevel.swap(dstLevel);
+    }
+}
+
+void GenerateMips(TextureData<UByte4N>& texData, MipFilter filter, bool srgb, bool cubeMap, uint32 numMips)
+{
+    GenerateMips<UByte4N>(texData, filter, srgb, cubeMap, numMips);
+}
+
+void GenerateMips(TextureData<Half4>& texData, MipFilter filter, bool srgb, bool cubeMap, uint32 numMips)
+{
+    GenerateMips<Half4>(texData, filter, srgb, cubeMap, numMips);
+}
+
+void GenerateMips(TextureData<Float4>& texData, MipFilter filter, bool srgb, bool cubeMap, uint32 numMips)
+{
+    GenerateMips<Float4>(texData, filter, srgb, cubeMap, numMips);
+}
+
+}
@@ -0,0 +1,48 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "Textures.h"
+
+namespace SampleFramework11
+{
+
+enum class MipFilter
+{
+    Box,        // Averages the texels covered by each destination texel
+    Kaiser,     // Kaiser-windowed sinc, 3 lobes with alpha = 4
+    Lanczos,    // Lanczos, 3 lobes
+
+    NumValues
+};
+
+// Generates mip levels on the CPU from the top mip of every array slice, replacing any mips that
+// the data already had. numMips == 0 generates the full chain down to 1x1. The result can be
+// uploaded in one go with CreateSRVFromTextureData.
+//
+// Each level is filtered from the one above it, separably and in floating point. With srgb set
+// the RGB channels are converted to linear before filtering and back to sRGB afterwards, which is
+// only useful for data that's uploaded to an sRGB format (GetTextureData already returns linear
+// values). With cubeMap set the slices are treated as groups of 6 faces, and the texels along
+// the edges of each face are averaged with the matching texels on the adjacent faces, so that
+// bilinear filtering doesn't show seams on the lower mips. The sinc filters can ring around sharp
+// edges, and 8-bit results are clamped to [0, 1] while float results are not.
+void GenerateMips(TextureData<UByte4N>& texData, MipFilter filter = MipFilter::Box, bool srgb = false,
+                  bool cubeMap = false, uint32 numMips = 0);
+
+void GenerateMips(TextureData<Half4>& texData, MipFilter filter = MipFilter::Box, bool srgb = false,
+                  bool cubeMap = false, uint32 numMips = 0);
+
+void GenerateMips(TextureData<Float4>& texData, MipFilter filter = MipFilter::Box, bool srgb = false,
+                  bool cubeMap = false, uint32 numMips = 0);
+
+}
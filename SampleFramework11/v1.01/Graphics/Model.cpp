@@ -17,7 +17,11 @@
 #include "GraphicsTypes.h"
 #include "..\\Serialization.h"
 #include "..\\FileIO.h"
+#include "..\\MurmurHash.h"
+#include "..\\Timer.h"
+#include "..\\ThreadPool.h"
 #include "Textures.h"
+#include "VertexCompression.h"
 
 using std::string;
 using std::wstring;
@@ -99,8 +103,6 @@ void Mesh::InitFromSDKMesh(ID3D11Device* device, SDKMesh& sdkMesh, uint32 meshId
     if(generateTangents)
         GenerateTangentFrame();
 
-    CreateVertexAndIndexBuffers(device);
-
     const uint32 numSubsets = sdkMesh.GetNumSubsets(meshIdx);
     meshParts.resize(numSubsets);
     for(uint32 i = 0; i < numSubsets; ++i)
@@ -113,9 +115,45 @@ void Mesh::InitFromSDKMesh(ID3D11Device* device, SDKMesh& sdkMesh, uint32 meshId
         part.VertexCount = static_cast<uint32>(subset.VertexCount);
         part.MaterialIdx = subset.MaterialID;
     }
+
+    OptimizeIndices();
+
+    CreateVertexAndIndexBuffers(device);
 }
 
-void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
+// An attribute stream from an aiMesh, and where it goes in the interleaved vertex
+struct AssimpVertexStream
+{
+    const aiVector3D* Data;
+    uint32 Offset;
+    uint32 NumComponents;
+    bool Negate;
+};
+
+// Copies a single attribute stream into the interleaved vertices
+template<uint32 NumComponents, bool Negate> static void CopyVertexStream(const aiVector3D* src, uint64 numVertices,
+                                                                         uint8* dst, uint64 dstStride)
+{
+    const float sign = Negate ? -1.0f : 1.0f;
+    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+    {
+        float* dstElem = reinterpret_cast<float*>(dst + vtxIdx * dstStride);
+        dstElem[0] = src[vtxIdx].x * sign;
+        dstElem[1] = src[vtxIdx].y * sign;
+        if(NumComponents == 3)
+            dstElem[2] = src[vtxIdx].z * sign;
+    }
+}
+
+void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh, const ModelImportOptions& options)
+{
+    InitFromAssimpMeshData(assimpMesh, options);
+    CreateVertexAndIndexBuffers(device);
+}
+
+// Does all of the CPU-side work for InitFromAssimpMesh. Doesn't touch the device, so it's safe to
+// run for multiple meshes at once.
+void Mesh::InitFromAssimpMeshData(const aiMesh& assimpMesh, const ModelImportOptions& options)
 {
     numVertices = assimpMesh.mNumVertices;
     numIndices = assimpMesh.mNumFaces * 3;
@@ -134,7 +172,8 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
     elemDesc.InputSlot = 0;
     elemDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
     elemDesc.InstanceDataStepRate = 0;
-    std::vector<const aiVector3D*> vertexData;
+    std::vector<AssimpVertexStream> streams;
+    AssimpVertexStream stream;
 
     if(assimpMesh.HasPositions())
     {
@@ -143,8 +182,12 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
         elemDesc.SemanticName = "POSITION";
         elemDesc.SemanticIndex = 0;
         inputElements.push_back(elemDesc);
+        stream.Data = assimpMesh.mVertices;
+        stream.Offset = currOffset;
+        stream.NumComponents = 3;
+        stream.Negate = false;
+        streams.push_back(stream);
         currOffset += 12;
-        vertexData.push_back(assimpMesh.mVertices);
     }
 
     if(assimpMesh.HasNormals())
@@ -154,8 +197,12 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
         elemDesc.SemanticName = "NORMAL";
         elemDesc.SemanticIndex = 0;
         inputElements.push_back(elemDesc);
+        stream.Data = assimpMesh.mNormals;
+        stream.Offset = currOffset;
+        stream.NumComponents = 3;
+        stream.Negate = false;
+        streams.push_back(stream);
         currOffset += 12;
-        vertexData.push_back(assimpMesh.mNormals);
     }
 
     for(uint32 i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; ++i)
@@ -167,8 +214,12 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
             elemDesc.SemanticName = "TEXCOORD";
             elemDesc.SemanticIndex = i;
             inputElements.push_back(elemDesc);
+            stream.Data = assimpMesh.mTextureCoords[i];
+            stream.Offset = currOffset;
+            stream.NumComponents = 2;
+            stream.Negate = false;
+            streams.push_back(stream);
             currOffset += 8;
-            vertexData.push_back(assimpMesh.mTextureCoords[i]);
         }
     }
 
@@ -179,36 +230,41 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
         elemDesc.SemanticName = "TANGENT";
         elemDesc.SemanticIndex = 0;
         inputElements.push_back(elemDesc);
+        stream.Data = assimpMesh.mTangents;
+        stream.Offset = currOffset;
+        stream.NumComponents = 3;
+        stream.Negate = false;
+        streams.push_back(stream);
         currOffset += 12;
-        vertexData.push_back(assimpMesh.mTangents);
 
         elemDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
         elemDesc.AlignedByteOffset = currOffset;
         elemDesc.SemanticName = "BITANGENT";
         elemDesc.SemanticIndex = 0;
         inputElements.push_back(elemDesc);
+        stream.Data = assimpMesh.mBitangents;
+        stream.Offset = currOffset;
+        stream.NumComponents = 3;
+        // Flip the bitangents to match the left-handed conversion
+        stream.Negate = true;
+        streams.push_back(stream);
         currOffset += 12;
-        vertexData.push_back(assimpMesh.mBitangents);
     }
 
     vertexStride = currOffset;
 
-    // Copy and interleave the vertex data
+    // Copy and interleave the vertex data, one stream at a time
     vertices.resize(vertexStride * numVertices, 0);
-    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+    for(uint64 streamIdx = 0; streamIdx < streams.size(); ++streamIdx)
     {
-        uint8* vtxStart = &vertices[vtxIdx * vertexStride];
-        for(uint64 elemIdx = 0; elemIdx < inputElements.size(); ++elemIdx)
-        {
-            uint64 offset = inputElements[elemIdx].AlignedByteOffset;
-            uint64 elemSize = elemIdx == inputElements.size() - 1 ? vertexStride - offset :
-                                                                    inputElements[elemIdx + 1].AlignedByteOffset - offset;
-            uint8* elemStart = vtxStart + inputElements[elemIdx].AlignedByteOffset;
-            memcpy(elemStart, vertexData[elemIdx] + vtxIdx, elemSize);
-
-            if(vertexData[elemIdx] == assimpMesh.mBitangents)
-                *reinterpret_cast<Float3*>(elemStart) *= -1.0f;
-        }
+        const AssimpVertexStream& stream = streams[streamIdx];
+        uint8* dst = vertices.data() + stream.Offset;
+        if(stream.NumComponents == 2)
+            CopyVertexStream<2, false>(stream.Data, numVertices, dst, vertexStride);
+        else if(stream.Negate)
+            CopyVertexStream<3, true>(stream.Data, numVertices, dst, vertexStride);
+        else
+            CopyVertexStream<3, false>(stream.Data, numVertices, dst, vertexStride);
     }
 
     // Copy the index data
@@ -228,8 +284,6 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
         }
     }
 
-    CreateVertexAndIndexBuffers(device);
-
     const uint32 numSubsets = 1;
     meshParts.resize(numSubsets);
     for(uint32 i = 0; i < numSubsets; ++i)
@@ -241,6 +295,14 @@ void Mesh::InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh)
         part.VertexCount = numVertices;
         part.MaterialIdx = assimpMesh.mMaterialIndex;
     }
+
+    OptimizeIndices(options.Force16BitIndices);
+
+    if(options.GenerateLODs)
+        GenerateLODs();
+
+    if(options.CompressVertices)
+        CompressVertices(compressionFailureReason);
 }
 
 // Initializes the mesh as a box
@@ -631,6 +693,119 @@ void Mesh::InitCornea(ID3D11Device* device, uint32 materialIdx)
 }
 
 
+// Number of triangles or vertices processed by each tangent generation task
+static const uint64 TangentGrainSize = 16 * 1024;
+
+// Computes the tangent frame for each vertex. The following code is based on
+// "Computing Tangent Space Basis Vectors for an Arbitrary Mesh", by Eric Lengyel
+// http://www.terathon.com/code/tangent.html
+//
+// The per-triangle directions are computed in parallel over the triangles, and then gathered in
+// parallel over the vertices using a vertex -> triangle adjacency list in CSR form. Every vertex
+// only writes to itself, and it sums its triangles in index buffer order, so the results are
+// identical to a serial loop.
+template<typename TIndex> static void GenerateTangents(const TIndex* indices, uint32 numIndices, uint32 numVertices,
+                                                       const uint8* vtxData, uint32 vtxStride, uint32 posOffset,
+                                                       uint32 nmlOffset, uint32 tcOffset, Vertex* newVertices)
+{
+    const uint32 numTriangles = numIndices / 3;
+    const uint32 numTriIndices = numTriangles * 3;
+
+    std::vector<Float3> triTangents(numTriangles);
+    std::vector<Float3> triBitangents(numTriangles);
+
+    ParallelFor(numTriangles, TangentGrainSize, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        for(uint64 triIdx = start; triIdx < end; ++triIdx)
+        {
+            const uint8* vtx1 = vtxData + uint64(indices[triIdx * 3 + 0]) * vtxStride;
+            const uint8* vtx2 = vtxData + uint64(indices[triIdx * 3 + 1]) * vtxStride;
+            const uint8* vtx3 = vtxData + uint64(indices[triIdx * 3 + 2]) * vtxStride;
+
+            const Float3& v1 = *reinterpret_cast<const Float3*>(vtx1 + posOffset);
+            const Float3& v2 = *reinterpret_cast<const Float3*>(vtx2 + posOffset);
+            const Float3& v3 = *reinterpret_cast<const Float3*>(vtx3 + posOffset);
+
+            const Float2& w1 = *reinterpret_cast<const Float2*>(vtx1 + tcOffset);
+            const Float2& w2 = *reinterpret_cast<const Float2*>(vtx2 + tcOffset);
+            const Float2& w3 = *reinterpret_cast<const Float2*>(vtx3 + tcOffset);
+
+            float x1 = v2.x - v1.x;
+            float x2 = v3.x - v1.x;
+            float y1 = v2.y - v1.y;
+            float y2 = v3.y - v1.y;
+            float z1 = v2.z - v1.z;
+            float z2 = v3.z - v1.z;
+
+            float s1 = w2.x - w1.x;
+            float s2 = w3.x - w1.x;
+            float t1 = w2.y - w1.y;
+            float t2 = w3.y - w1.y;
+
+            float r = 1.0f / (s1 * t2 - s2 * t1);
+            triTangents[triIdx] = Float3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+            triBitangents[triIdx] = Float3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+        }
+    });
+
+    // Build the adjacency list with a counting sort. It's a single linear pass over the indices,
+    // and filling it serially keeps each vertex's triangles in index buffer order.
+    std::vector<uint32> adjacencyOffsets(uint64(numVertices) + 1, 0);
+    for(uint32 i = 0; i < numTriIndices; ++i)
+        ++adjacencyOffsets[uint64(indices[i]) + 1];
+    for(uint32 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+        adjacencyOffsets[vtxIdx + 1] += adjacencyOffsets[vtxIdx];
+
+    std::vector<uint32> adjacentTriangles(numTriIndices);
+    std::vector<uint32> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for(uint32 i = 0; i < numTriIndices; ++i)
+        adjacentTriangles[fillOffsets[indices[i]]++] = i / 3;
+    fillOffsets = std::vector<uint32>();
+
+    ParallelFor(numVertices, TangentGrainSize, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        for(uint64 vtxIdx = start; vtxIdx < end; ++vtxIdx)
+        {
+            Float3 t;
+            Float3 b;
+            for(uint32 adjIdx = adjacencyOffsets[vtxIdx]; adjIdx < adjacencyOffsets[vtxIdx + 1]; ++adjIdx)
+            {
+                const uint32 triIdx = adjacentTriangles[adjIdx];
+                t += triTangents[triIdx];
+                b += triBitangents[triIdx];
+            }
+
+            const uint8* vtx = vtxData + vtxIdx * vtxStride;
+            Vertex& newVertex = newVertices[vtxIdx];
+            newVertex.Position = *reinterpret_cast<const Float3*>(vtx + posOffset);
+            newVertex.Normal = *reinterpret_cast<const Float3*>(vtx + nmlOffset);
+            newVertex.TexCoord = *reinterpret_cast<const Float2*>(vtx + tcOffset);
+
+            const Float3& n = newVertex.Normal;
+
+            // Gram-Schmidt orthogonalize
+            Float3 tangent = (t - n * Float3::Dot(n, t));
+            const bool validTangent = tangent.Length() > 0.00001f;
+            bool zeroTangent = false;
+            if(validTangent == false && n.Length() > 0.00001f)
+            {
+                tangent = Float3::Perpendicular(n);
+                zeroTangent = true;
+            }
+
+            float sign = 1.0f;
+            if(!zeroTangent)
+                sign = (Float3::Dot(Float3::Cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+
+            // Store the tangent + bitangent
+            newVertex.Tangent = Float3::Normalize(tangent);
+
+            newVertex.Bitangent = Float3::Normalize(Float3::Cross(n, tangent));
+            newVertex.Bitangent *= sign;
+        }
+    });
+}
+
 void Mesh::GenerateTangentFrame()
 {
     // Make sure that we have a position + texture coordinate + normal
@@ -652,107 +827,22 @@ void Mesh::GenerateTangentFrame()
     if(posOffset == 0xFFFFFFFF || nmlOffset == 0xFFFFFFFF || tcOffset == 0xFFFFFFFF)
         throw Exception(L"Can't generate a tangent frame, mesh doesn't have positions, normals, and texcoords");
 
-    // Clone the mesh
-    std::vector<Vertex> newVertices(numVertices);
-
-    const uint8* vtxData = vertices.data();
-    for(uint32 i = 0; i < numVertices; ++i)
-    {
-        newVertices[i].Position = *reinterpret_cast<const Float3*>(vtxData + posOffset);
-        newVertices[i].Normal = *reinterpret_cast<const Float3*>(vtxData + nmlOffset);
-        newVertices[i].TexCoord = *reinterpret_cast<const Float2*>(vtxData + tcOffset);
-        vtxData += vertexStride;
-    }
-
-    // Compute the tangent frame for each vertex. The following code is based on
-    // "Computing Tangent Space Basis Vectors for an Arbitrary Mesh", by Eric Lengyel
-    // http://www.terathon.com/code/tangent.html
-
-    // Make temporary arrays for the tangent and the bitangent
-    std::vector<Float3> tangents(numVertices);
-    std::vector<Float3> bitangents(numVertices);
-
-    // Loop through each triangle
-    const uint32 indexSize = indexType == IndexType::Index16Bit ? 2 : 4;
-    for (uint32 i = 0; i < numIndices; i += 3)
-    {
-        uint32 i1 = GetIndex(indices.data(), i + 0, indexSize);
-        uint32 i2 = GetIndex(indices.data(), i + 1, indexSize);
-        uint32 i3 = GetIndex(indices.data(), i + 2, indexSize);
-
-        const Float3& v1 = newVertices[i1].Position;
-        const Float3& v2 = newVertices[i2].Position;
-        const Float3& v3 = newVertices[i3].Position;
-
-        const Float2& w1 = newVertices[i1].TexCoord;
-        const Float2& w2 = newVertices[i2].TexCoord;
-        const Float2& w3 = newVertices[i3].TexCoord;
-
-        float x1 = v2.x - v1.x;
-        float x2 = v3.x - v1.x;
-        float y1 = v2.y - v1.y;
-        float y2 = v3.y - v1.y;
-        float z1 = v2.z - v1.z;
-        float z2 = v3.z - v1.z;
-
-        float s1 = w2.x - w1.x;
-        float s2 = w3.x - w1.x;
-        float t1 = w2.y - w1.y;
-        float t2 = w3.y - w1.y;
-
-        float r = 1.0f / (s1 * t2 - s2 * t1);
-        Float3 sDir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-        Float3 tDir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-        tangents[i1] += sDir;
-        tangents[i2] += sDir;
-        tangents[i3] += sDir;
-
-        bitangents[i1] += tDir;
-        bitangents[i2] += tDir;
-        bitangents[i3] += tDir;
-    }
-
-    for (uint32 i = 0; i < numVertices; ++i)
-    {
-        Float3& n = newVertices[i].Normal;
-        Float3& t = tangents[i];
-
-        // Gram-Schmidt orthogonalize
-        Float3 tangent = (t - n * Float3::Dot(n, t));
-        bool zeroTangent = false;
-        if(tangent.Length() > 0.00001f)
-            Float3::Normalize(tangent);
-        else if(n.Length() > 0.00001f)
-        {
-            tangent = Float3::Perpendicular(n);
-            zeroTangent = true;
-        }
-
-        float sign = 1.0f;
-
-        if(!zeroTangent)
-        {
-            Float3 b;
-            b = Float3::Cross(n, t);
-            sign = (Float3::Dot(b, bitangents[i]) < 0.0f) ? -1.0f : 1.0f;
-        }
-
-        // Store the tangent + bitangent
-        newVertices[i].Tangent = Float3::Normalize(tangent);
-
-        newVertices[i].Bitangent = Float3::Normalize(Float3::Cross(n, tangent));
-        newVertices[i].Bitangent *= sign;
-    }
+    // Compute the tangent frame for each vertex, writing straight into the new vertices
+    std::vector<uint8> newVertices(uint64(numVertices) * sizeof(Vertex));
+    Vertex* dstVertices = reinterpret_cast<Vertex*>(newVertices.data());
+    if(indexType == IndexType::Index16Bit)
+        GenerateTangents(reinterpret_cast<const uint16*>(indices.data()), numIndices, numVertices, vertices.data(),
+                         vertexStride, posOffset, nmlOffset, tcOffset, dstVertices);
+    else
+        GenerateTangents(reinterpret_cast<const uint32*>(indices.data()), numIndices, numVertices, vertices.data(),
+                         vertexStride, posOffset, nmlOffset, tcOffset, dstVertices);
 
     inputElements.clear();
     inputElements.resize(sizeof(VertexInputs) / sizeof(D3D11_INPUT_ELEMENT_DESC));
     memcpy(inputElements.data(), VertexInputs, sizeof(VertexInputs));
 
     vertexStride = sizeof(Vertex);
-    vertices.clear();
-    vertices.resize(numVertices * vertexStride);
-    memcpy(vertices.data(), newVertices.data(), numVertices * vertexStride);
+    vertices.swap(newVertices);
 }
 
 void Mesh::CreateInputElements(const D3DVERTEXELEMENT9* declaration)
@@ -805,6 +895,518 @@ void Mesh::CreateInputElements(const D3DVERTEXELEMENT9* declaration)
     }
 }
 
+// Reorders the triangles in each part for the post-transform vertex cache and then for overdraw,
+// and then reorders the vertices in the order that they're fetched. Also builds the meshlets.
+// With force16BitIndices, a mesh that needs 32-bit indices gets split up with SplitFor16BitIndices.
+void Mesh::OptimizeIndices(bool force16BitIndices)
+{
+    if(numIndices == 0 || numVertices == 0)
+        return;
+
+    const uint32 indexSize = IndexSize();
+    std::vector<uint32> indices32(numIndices);
+    for(uint32 i = 0; i < numIndices; ++i)
+        indices32[i] = GetIndex(indices.data(), i, indexSize);
+
+    importCacheStats = AnalyzeVertexCache(indices32.data(), numIndices, numVertices);
+
+    // Overdraw optimization and meshlets need the positions
+    uint32 positionOffset = uint32(-1);
+    for(uint64 i = 0; i < inputElements.size(); ++i)
+    {
+        if(strcmp(inputElements[i].SemanticName, "POSITION") == 0 && inputElements[i].Format == DXGI_FORMAT_R32G32B32_FLOAT)
+            positionOffset = inputElements[i].AlignedByteOffset;
+    }
+
+    const uint8* positions = positionOffset != uint32(-1) ? vertices.data() + positionOffset : nullptr;
+
+    std::vector<uint32> clusters;
+    for(uint64 partIdx = 0; partIdx < meshParts.size(); ++partIdx)
+    {
+        const MeshPart& part = meshParts[partIdx];
+        if(part.IndexCount == 0)
+            continue;
+
+        Assert_(part.IndexStart + part.IndexCount <= numIndices);
+        uint32* partIndices = &indices32[part.IndexStart];
+
+        // Work on the range of vertices used by the part, so that the per-vertex data stays small
+        uint32 minVertex = UINT32_MAX;
+        uint32 maxVertex = 0;
+        for(uint32 i = 0; i < part.IndexCount; ++i)
+        {
+            minVertex = std::min(minVertex, partIndices[i]);
+            maxVertex = std::max(maxVertex, partIndices[i]);
+        }
+
+        const uint32 numPartVertices = maxVertex - minVertex + 1;
+        for(uint32 i = 0; i < part.IndexCount; ++i)
+            partIndices[i] -= minVertex;
+
+        OptimizeVertexCache(partIndices, part.IndexCount, numPartVertices, DefaultVertexCacheSize, &clusters);
+        if(positions != nullptr)
+            OptimizeOverdraw(partIndices, part.IndexCount, positions + uint64(minVertex) * vertexStride, vertexStride,
+                             numPartVertices, clusters);
+
+        for(uint32 i = 0; i < part.IndexCount; ++i)
+            partIndices[i] += minVertex;
+    }
+
+    numVertices = OptimizeVertexFetch(vertices.data(), vertexStride, numVertices, indices32.data(), numIndices);
+    vertices.resize(uint64(numVertices) * vertexStride);
+
+    // The vertices have moved, so the parts need new vertex ranges
+    for(uint64 partIdx = 0; partIdx < meshParts.size(); ++partIdx)
+    {
+        MeshPart& part = meshParts[partIdx];
+        if(part.IndexCount == 0)
+            continue;
+
+        uint32 minVertex = UINT32_MAX;
+        uint32 maxVertex = 0;
+        for(uint32 i = part.IndexStart; i < part.IndexStart + part.IndexCount; ++i)
+        {
+            minVertex = std::min(minVertex, indices32[i]);
+            maxVertex = std::max(maxVertex, indices32[i]);
+        }
+
+        part.VertexStart = minVertex;
+        part.VertexCount = maxVertex - minVertex + 1;
+    }
+
+    optimizedCacheStats = AnalyzeVertexCache(indices32.data(), numIndices, numVertices);
+
+    if(force16BitIndices && indexType == IndexType::Index32Bit)
+        SplitFor16BitIndices(indices32);
+
+    // Now that the triangles are in their final order, split each part into meshlets for culling
+    meshlets.clear();
+    for(uint64 partIdx = 0; partIdx < meshParts.size(); ++partIdx)
+    {
+        MeshPart& part = meshParts[partIdx];
+        part.MeshletStart = uint32(meshlets.size());
+        if(positionOffset != uint32(-1) && part.IndexCount > 0)
+            BuildMeshlets(indices32.data(), part.IndexStart, part.IndexCount,
+                          vertices.data() + uint64(part.BaseVertex) * vertexStride + positionOffset,
+                          vertexStride, numVertices - part.BaseVertex, meshlets);
+        part.MeshletCount = uint32(meshlets.size()) - part.MeshletStart;
+    }
+
+    for(uint32 i = 0; i < numIndices; ++i)
+    {
+        if(indexType == IndexType::Index32Bit)
+            reinterpret_cast<uint32*>(indices.data())[i] = indices32[i];
+        else
+            reinterpret_cast<uint16*>(indices.data())[i] = uint16(indices32[i]);
+    }
+}
+
+// Splits each part into runs of triangles that reference fewer than 64K vertices, so that the mesh
+// can use 16-bit indices. Every run gets its own copy of the vertices that it uses and becomes a
+// MeshPart with indices relative to its BaseVertex. The triangles don't move, so the runs of a part
+// cover the same index range as the original part did. Vertices are copied in the order that
+// they're first used, which keeps the ordering from OptimizeVertexFetch.
+void Mesh::SplitFor16BitIndices(std::vector<uint32>& indices32)
+{
+    const uint32 MaxPartVertices = 0xFFFF;
+
+    std::vector<uint8> newVertices;
+    newVertices.reserve(vertices.size());
+    std::vector<MeshPart> newParts;
+    newParts.reserve(meshParts.size());
+
+    // The last run that used each vertex, and the vertex's index within that run
+    std::vector<uint32> vertexRun(numVertices, uint32(-1));
+    std::vector<uint32> vertexRemap(numVertices, 0);
+    uint32 runIdx = 0;
+    uint32 numNewVertices = 0;
+
+    for(uint64 partIdx = 0; partIdx < meshParts.size(); ++partIdx)
+    {
+        const MeshPart& part = meshParts[partIdx];
+        const uint32 indexEnd = part.IndexStart + part.IndexCount;
+
+        MeshPart run = part;
+        run.IndexCount = 0;
+        run.VertexStart = numNewVertices;
+        run.VertexCount = 0;
+        run.BaseVertex = numNewVertices;
+
+        for(uint32 triStart = part.IndexStart; triStart < indexEnd; triStart += 3)
+        {
+            uint32 numAdded = 0;
+            for(uint32 i = 0; i < 3; ++i)
+                numAdded += vertexRun[indices32[triStart + i]] != runIdx ? 1 : 0;
+
+            if(run.VertexCount + numAdded > MaxPartVertices)
+            {
+                newParts.push_back(run);
+                ++runIdx;
+
+                run.IndexStart = triStart;
+                run.IndexCount = 0;
+                run.VertexStart = numNewVertices;
+                run.VertexCount = 0;
+                run.BaseVertex = numNewVertices;
+            }
+
+            for(uint32 i = 0; i < 3; ++i)
+            {
+                uint32& index = indices32[triStart + i];
+                if(vertexRun[index] != runIdx)
+                {
+                    vertexRun[index] = runIdx;
+                    vertexRemap[index] = run.VertexCount++;
+
+                    const uint8* vtx = vertices.data() + uint64(index) * vertexStride;
+                    newVertices.insert(newVertices.end(), vtx, vtx + vertexStride);
+                    ++numNewVertices;
+                }
+
+                index = vertexRemap[index];
+            }
+
+            run.IndexCount += 3;
+        }
+
+        newParts.push_back(run);
+        ++runIdx;
+    }
+
+    // OptimizeVertexFetch already dropped unused vertices, so every vertex is copied at least once
+    Assert_(numNewVertices >= numVertices);
+    splitIndexBytesSaved = uint64(numIndices) * 2;
+    splitVertexBytesAdded = uint64(numNewVertices - numVertices) * vertexStride;
+
+    vertices.swap(newVertices);
+    meshParts.swap(newParts);
+    numVertices = numNewVertices;
+    indexType = IndexType::Index16Bit;
+    indices.resize(uint64(numIndices) * 2);
+}
+
+// LODs are generated until there's this many, or until simplification stops making progress
+static const uint32 MaxMeshLODs = 4;
+static const uint32 MinLODTriangles = 128;
+static const float LODReduction = 0.5f;
+static const float MinLODReduction = 0.8f;
+
+// Attribute weights for simplification, relative to squared distances on a unit-sized mesh
+static const float LODNormalWeight = 0.01f;
+static const float LODTexCoordWeight = 0.01f;
+
+// Builds a chain of LODs for each part by repeatedly simplifying the previous level. The LODs only
+// collapse vertices onto other vertices, so they use the part's vertices and BaseVertex, and their
+// indices are appended to the end of the index buffer. Needs to run before CompressVertices.
+void Mesh::GenerateLODs()
+{
+    lods.clear();
+    if(numIndices == 0 || numVertices == 0)
+        return;
+
+    uint32 positionOffset = uint32(-1);
+    uint32 normalOffset = uint32(-1);
+    uint32 texCoordOffset = uint32(-1);
+    for(uint64 i = 0; i < inputElements.size(); ++i)
+    {
+        const D3D11_INPUT_ELEMENT_DESC& element = inputElements[i];
+        if(strcmp(element.SemanticName, "POSITION") == 0 && element.Format == DXGI_FORMAT_R32G32B32_FLOAT)
+            positionOffset = element.AlignedByteOffset;
+        else if(strcmp(element.SemanticName, "NORMAL") == 0 && element.Format == DXGI_FORMAT_R32G32B32_FLOAT)
+            normalOffset = element.AlignedByteOffset;
+        else if(strcmp(element.SemanticName, "TEXCOORD") == 0 && element.SemanticIndex == 0
+                && element.Format == DXGI_FORMAT_R32G32_FLOAT)
+            texCoordOffset = element.AlignedByteOffset;
+    }
+
+    if(positionOffset == uint32(-1))
+        return;
+
+    const uint32 indexSize = IndexSize();
+    std::vector<uint32> indices32(numIndices);
+    for(uint32 i = 0; i < numIndices; ++i)
+        indices32[i] = GetIndex(indices.data(), i, indexSize);
+
+    std::vector<uint32> srcIndices;
+    std::vector<uint32> lodIndices;
+    for(uint64 partIdx = 0; partIdx < meshParts.size(); ++partIdx)
+    {
+        MeshPart& part = meshParts[partIdx];
+        part.LODStart = uint32(lods.size());
+        part.LODCount = 0;
+        if(part.IndexCount < MinLODTriangles * 3 || part.VertexCount == 0)
+            continue;
+
+        // Simplify using the part's range of vertices, like OptimizeIndices does
+        const uint32 vertexOffset = part.VertexStart - part.BaseVertex;
+        const uint8* partVertices = vertices.data() + uint64(part.VertexStart) * vertexStride;
+
+        SimplifyAttribute attributes[2];
+        uint32 numAttributes = 0;
+        if(normalOffset != uint32(-1))
+        {
+            SimplifyAttribute normals = { partVertices + normalOffset, vertexStride, 3, LODNormalWeight };
+            attributes[numAttributes++] = normals;
+        }
+
+        if(texCoordOffset != uint32(-1))
+        {
+            SimplifyAttribute texCoords = { partVertices + texCoordOffset, vertexStride, 2, LODTexCoordWeight };
+            attributes[numAttributes++] = texCoords;
+        }
+
+        srcIndices.assign(indices32.begin() + part.IndexStart, indices32.begin() + part.IndexStart + part.IndexCount);
+        for(uint64 i = 0; i < srcIndices.size(); ++i)
+            srcIndices[i] -= vertexOffset;
+
+        float error = 0.0f;
+        for(uint32 lodIdx = 0; lodIdx < MaxMeshLODs; ++lodIdx)
+        {
+            const uint64 targetIndexCount = uint64(srcIndices.size() * LODReduction) / 3 * 3;
+            lodIndices.resize(srcIndices.size());
+
+            float lodError = 0.0f;
+            const uint64 lodIndexCount = SimplifyMesh(srcIndices.data(), srcIndices.size(), partVertices + positionOffset,
+                                                      vertexStride, part.VertexCount, attributes, numAttributes,
+                                                      targetIndexCount, FloatMax, lodIndices.data(), &lodError);
+            if(lodIndexCount == 0 || lodIndexCount > srcIndices.size() * MinLODReduction)
+                break;
+
+            lodIndices.resize(lodIndexCount);
+            OptimizeVertexCache(lodIndices.data(), lodIndexCount, part.VertexCount);
+
+            // Each level is simplified from the one before it, so the errors add up
+            error += lodError;
+
+            MeshLOD lod;
+            lod.IndexStart = uint32(indices32.size());
+            lod.IndexCount = uint32(lodIndexCount);
+            lod.Error = error;
+            lods.push_back(lod);
+            ++part.LODCount;
+
+            for(uint64 i = 0; i < lodIndexCount; ++i)
+                indices32.push_back(lodIndices[i] + vertexOffset);
+
+            srcIndices.swap(lodIndices);
+        }
+    }
+
+    numIndices = uint32(indices32.size());
+    indices.resize(uint64(numIndices) * indexSize);
+    for(uint32 i = 0; i < numIndices; ++i)
+    {
+        if(indexType == IndexType::Index32Bit)
+            reinterpret_cast<uint32*>(indices.data())[i] = indices32[i];
+        else
+            reinterpret_cast<uint16*>(indices.data())[i] = uint16(indices32[i]);
+    }
+}
+
+// Converts the vertices to the compressed format. Returns false and leaves the vertices untouched
+// if the mesh has elements that can't be compressed, with the reason in failureReason.
+bool Mesh::CompressVertices(std::string& failureReason)
+{
+    Assert_(compressedVertices == false);
+    Assert_(mappedVertices == nullptr);
+
+    // Find the source elements
+    const D3D11_INPUT_ELEMENT_DESC* positionElem = nullptr;
+    const D3D11_INPUT_ELEMENT_DESC* normalElem = nullptr;
+    const D3D11_INPUT_ELEMENT_DESC* tangentElem = nullptr;
+    const D3D11_INPUT_ELEMENT_DESC* bitangentElem = nullptr;
+    std::vector<const D3D11_INPUT_ELEMENT_DESC*> uvElems;
+
+    for(uint64 i = 0; i < inputElements.size(); ++i)
+    {
+        const D3D11_INPUT_ELEMENT_DESC& elem = inputElements[i];
+        if(strcmp(elem.SemanticName, "TEXCOORD") == 0 && elem.Format == DXGI_FORMAT_R32G32_FLOAT)
+        {
+            uvElems.push_back(&elem);
+            continue;
+        }
+
+        if(elem.Format != DXGI_FORMAT_R32G32B32_FLOAT || elem.SemanticIndex != 0)
+        {
+            failureReason = std::string(elem.SemanticName) + ToAnsiString(elem.SemanticIndex)
+                            + " isn't a float3 with a semantic index of 0";
+            return false;
+        }
+
+        if(strcmp(elem.SemanticName, "POSITION") == 0)
+            positionElem = &elem;
+        else if(strcmp(elem.SemanticName, "NORMAL") == 0)
+            normalElem = &elem;
+        else if(strcmp(elem.SemanticName, "TANGENT") == 0)
+            tangentElem = &elem;
+        else if(strcmp(elem.SemanticName, "BITANGENT") == 0)
+            bitangentElem = &elem;
+        else
+        {
+            failureReason = std::string("the compressed format has no place for ") + elem.SemanticName;
+            return false;
+        }
+    }
+
+    if(positionElem == nullptr || normalElem == nullptr || tangentElem == nullptr || bitangentElem == nullptr)
+    {
+        failureReason = "it needs positions, normals, tangents and bitangents";
+        return false;
+    }
+
+    // Build the new layout
+    std::vector<D3D11_INPUT_ELEMENT_DESC> newElements;
+    D3D11_INPUT_ELEMENT_DESC elemDesc;
+    elemDesc.InputSlot = 0;
+    elemDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+    elemDesc.InstanceDataStepRate = 0;
+    elemDesc.SemanticIndex = 0;
+    uint32 currOffset = 0;
+
+    const uint32 positionOffset = currOffset;
+    elemDesc.SemanticName = "POSITION";
+    elemDesc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+    elemDesc.AlignedByteOffset = currOffset;
+    newElements.push_back(elemDesc);
+    currOffset += 8;
+
+    const uint32 normalOffset = currOffset;
+    elemDesc.SemanticName = "NORMAL";
+    elemDesc.Format = DXGI_FORMAT_R16G16_SNORM;
+    elemDesc.AlignedByteOffset = currOffset;
+    newElements.push_back(elemDesc);
+    currOffset += 4;
+
+    const uint32 uvOffset = currOffset;
+    for(uint64 i = 0; i < uvElems.size(); ++i)
+    {
+        elemDesc.SemanticName = "TEXCOORD";
+        elemDesc.SemanticIndex = uvElems[i]->SemanticIndex;
+        elemDesc.Format = DXGI_FORMAT_R16G16_FLOAT;
+        elemDesc.AlignedByteOffset = currOffset;
+        newElements.push_back(elemDesc);
+        currOffset += 4;
+    }
+
+    const uint32 tangentOffset = currOffset;
+    elemDesc.SemanticName = "TANGENT";
+    elemDesc.SemanticIndex = 0;
+    elemDesc.Format = DXGI_FORMAT_R16G16_UINT;
+    elemDesc.AlignedByteOffset = currOffset;
+    newElements.push_back(elemDesc);
+    currOffset += 4;
+
+    const uint32 newStride = currOffset;
+
+    // Positions are quantized relative to the bounding box
+    Float3 minPosition;
+    Float3 maxPosition;
+    ComputeBounds(0, numVertices, minPosition, maxPosition);
+
+    Float3 extents = maxPosition - minPosition;
+    extents.x = std::max(extents.x, FLT_MIN);
+    extents.y = std::max(extents.y, FLT_MIN);
+    extents.z = std::max(extents.z, FLT_MIN);
+
+    std::vector<uint8> newVertices(uint64(numVertices) * newStride);
+    for(uint32 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+    {
+        const uint8* src = &vertices[uint64(vtxIdx) * vertexStride];
+        uint8* dst = &newVertices[uint64(vtxIdx) * newStride];
+
+        const Float3& position = *reinterpret_cast<const Float3*>(src + positionElem->AlignedByteOffset);
+        const Float3 normalizedPos = (position - minPosition) / extents;
+        uint16* dstPosition = reinterpret_cast<uint16*>(dst + positionOffset);
+        dstPosition[0] = QuantizeUNorm16(normalizedPos.x);
+        dstPosition[1] = QuantizeUNorm16(normalizedPos.y);
+        dstPosition[2] = QuantizeUNorm16(normalizedPos.z);
+        dstPosition[3] = 0;
+
+        const Float3 normal = Float3::Normalize(*reinterpret_cast<const Float3*>(src + normalElem->AlignedByteOffset));
+        Float2 octNormal;
+        EncodeOctahedral(&normal.x, &octNormal.x);
+        int16* dstNormal = reinterpret_cast<int16*>(dst + normalOffset);
+        dstNormal[0] = QuantizeSNorm16(octNormal.x);
+        dstNormal[1] = QuantizeSNorm16(octNormal.y);
+
+        for(uint64 i = 0; i < uvElems.size(); ++i)
+        {
+            const Float2& uv = *reinterpret_cast<const Float2*>(src + uvElems[i]->AlignedByteOffset);
+            HALF* dstUV = reinterpret_cast<HALF*>(dst + uvOffset + i * 4);
+            dstUV[0] = XMConvertFloatToHalf(uv.x);
+            dstUV[1] = XMConvertFloatToHalf(uv.y);
+        }
+
+        // The bitangent is rebuilt from the normal and tangent, so we only need its handedness
+        const Float3& tangent = *reinterpret_cast<const Float3*>(src + tangentElem->AlignedByteOffset);
+        const Float3& bitangent = *reinterpret_cast<const Float3*>(src + bitangentElem->AlignedByteOffset);
+        const float bitangentSign = Float3::Dot(Float3::Cross(normal, tangent), bitangent) >= 0.0f ? 1.0f : -1.0f;
+        const Float3 unitTangent = Float3::Normalize(tangent);
+        PackTangent(&unitTangent.x, bitangentSign, reinterpret_cast<uint16*>(dst + tangentOffset));
+    }
+
+    vertices.swap(newVertices);
+    inputElements = newElements;
+    inputElementStrings.clear();
+    vertexStride = newStride;
+
+    compressedVertices = true;
+    positionScale = extents;
+    positionBias = minPosition;
+
+    return true;
+}
+
+void Mesh::ComputeBounds(uint32 vertexStart, uint32 vertexCount, Float3& minPosition, Float3& maxPosition) const
+{
+    Assert_(uint64(vertexStart) + vertexCount <= numVertices);
+
+    uint32 positionOffset = uint32(-1);
+    for(uint64 i = 0; i < inputElements.size(); ++i)
+    {
+        if(strcmp(inputElements[i].SemanticName, "POSITION") == 0)
+        {
+            positionOffset = inputElements[i].AlignedByteOffset;
+            break;
+        }
+    }
+
+    Assert_(positionOffset != uint32(-1));
+
+    minPosition = Float3(FLT_MAX, FLT_MAX, FLT_MAX);
+    maxPosition = Float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    if(vertexCount == 0)
+    {
+        minPosition = maxPosition = Float3(0.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    const uint8* positions = Vertices() + positionOffset;
+    for(uint32 vtxIdx = vertexStart; vtxIdx < vertexStart + vertexCount; ++vtxIdx)
+    {
+        const uint8* src = positions + uint64(vtxIdx) * vertexStride;
+
+        Float3 position;
+        if(compressedVertices)
+        {
+            const uint16* quantized = reinterpret_cast<const uint16*>(src);
+            position.x = DequantizeUNorm16(quantized[0]);
+            position.y = DequantizeUNorm16(quantized[1]);
+            position.z = DequantizeUNorm16(quantized[2]);
+            position = position * positionScale + positionBias;
+        }
+        else
+            position = *reinterpret_cast<const Float3*>(src);
+
+        minPosition.x = std::min(minPosition.x, position.x);
+        minPosition.y = std::min(minPosition.y, position.y);
+        minPosition.z = std::min(minPosition.z, position.z);
+        maxPosition.x = std::max(maxPosition.x, position.x);
+        maxPosition.y = std::max(maxPosition.y, position.y);
+        maxPosition.z = std::max(maxPosition.z, position.z);
+    }
+}
+
 void Mesh::CreateVertexAndIndexBuffers(ID3D11Device* device)
 {
     Assert_(numVertices > 0);
@@ -819,7 +1421,7 @@ void Mesh::CreateVertexAndIndexBuffers(ID3D11Device* device)
     bufferDesc.StructureByteStride = 0;
 
     D3D11_SUBRESOURCE_DATA initData;
-    initData.pSysMem = vertices.data();
+    initData.pSysMem = Vertices();
     initData.SysMemPitch = 0;
     initData.SysMemSlicePitch = 0;
     DXCall(device->CreateBuffer(&bufferDesc, &initData, &vertexBuffer));
@@ -829,7 +1431,7 @@ void Mesh::CreateVertexAndIndexBuffers(ID3D11Device* device)
     bufferDesc.MiscFlags = 0;
     bufferDesc.StructureByteStride = 0;
 
-    initData.pSysMem = indices.data();
+    initData.pSysMem = Indices();
     DXCall(device->CreateBuffer(&bufferDesc, &initData, &indexBuffer));
 }
 
@@ -848,7 +1450,7 @@ void Mesh::Render(ID3D11DeviceContext* context)
     for(size_t i = 0; i < meshParts.size(); ++i)
     {
         MeshPart& meshPart = meshParts[i];
-        context->DrawIndexed(meshPart.IndexCount, meshPart.IndexStart, 0);
+        context->DrawIndexed(meshPart.IndexCount, meshPart.IndexStart, meshPart.BaseVertex);
     }
 }
 
@@ -900,13 +1502,41 @@ void Model::CreateFromSDKMeshFile(ID3D11Device* device, LPCWSTR fileName, const
         meshes[meshIdx].InitFromSDKMesh(device, sdkMesh, meshIdx, generateTangentFrame);
 }
 
-void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool forceSRGB)
+static const wstring modelCacheDir = L"ModelCache\\";
+
+// Bump this whenever the serialized Model format changes, so that stale cache entries get ignored
+static const uint64 ModelCacheVersion = 8;
+
+// Makes a cache file name from the contents of the source file and the import settings
+static wstring MakeModelCacheName(const wchar* fileName, uint32 importFlags, const ModelImportOptions& options)
+{
+    MappedFile file(fileName);
+
+    // GenerateHash takes an int for the size, so large files are hashed in pieces
+    const uint64 MaxChunkSize = 1024 * 1024 * 1024;
+    Hash fileHash;
+    for(uint64 offset = 0; offset < file.Size(); offset += MaxChunkSize)
+    {
+        const uint64 chunkSize = std::min(file.Size() - offset, MaxChunkSize);
+        Hash chunkHash = GenerateHash(file.Data() + offset, int(chunkSize), importFlags);
+        uint64 chunkKey[4] = { fileHash.A, fileHash.B, chunkHash.A, chunkHash.B };
+        fileHash = GenerateHash(chunkKey, sizeof(chunkKey), importFlags);
+    }
+
+    uint64 cacheKey[6] = { fileHash.A, fileHash.B, ModelCacheVersion, options.CompressVertices ? 1 : 0,
+                           options.Force16BitIndices ? 1 : 0, options.GenerateLODs ? 1 : 0 };
+    Hash cacheHash = GenerateHash(cacheKey, sizeof(cacheKey), 0);
+
+    return modelCacheDir + cacheHash.ToString() + L".meshcache";
+}
+
+void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, const ModelImportOptions& options)
 {
     Assert_(FileExists(fileName));
 
-    std::string fileNameAnsi = WStringToAnsi(fileName);
+    Timer loadTimer;
+    importStats = ModelImportStats();
 
-    Assimp::Importer importer;
     uint32 flags = aiProcess_CalcTangentSpace |
                    aiProcess_Triangulate |
                    aiProcess_JoinIdenticalVertices |
@@ -916,6 +1546,48 @@ void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool f
                    aiProcess_OptimizeMeshes |
                    aiProcess_FlipUVs |
                    aiProcess_FlipWindingOrder ;
+
+    // Skip the import entirely if we've already baked out this file with the same flags
+    wstring cacheName;
+    if(options.UseCache)
+    {
+        cacheName = MakeModelCacheName(fileName, flags, options);
+        if(FileExists(cacheName.c_str()))
+        {
+            try
+            {
+                CreateFromMeshCache(device, cacheName.c_str(), GetDirectoryFromFilePath(fileName).c_str(),
+                                    options.ForceSRGB, options.LoadTextures);
+
+                loadTimer.Update();
+                importStats.LoadedFromCache = true;
+                importStats.LoadTime = loadTimer.ElapsedMillisecondsF();
+                importStats.NumMeshes = uint32(meshes.size());
+                return;
+            }
+            catch(const Exception& exception)
+            {
+                importStats.CacheError = exception.GetMessage();
+            }
+            catch(const std::exception& exception)
+            {
+                // Allocation failures and the like from the standard library
+                importStats.CacheError = AnsiToWString(exception.what());
+            }
+
+            // A cache entry that can't be used (corrupt, or from an older version) shouldn't stop the
+            // model from loading, so throw away whatever was read and the entry itself, and import
+            // the model from scratch. The meshes point into the mapped file, so they go first.
+            meshes.clear();
+            meshMaterials.clear();
+            meshCacheFile = nullptr;
+            DeleteFile(cacheName.c_str());
+        }
+    }
+
+    std::string fileNameAnsi = WStringToAnsi(fileName);
+
+    Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(fileNameAnsi, flags);
 
     if(scene == nullptr)
@@ -946,16 +1618,86 @@ void Model::CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool f
            || mat.GetTexture(aiTextureType_HEIGHT, 0, &normalMapPath) == aiReturn_SUCCESS)
             material.NormalMapName = GetFileName(AnsiToWString(normalMapPath.C_Str()).c_str());
 
-        LoadMaterialResources(material, fileDirectory, device, forceSRGB);
+        LoadMaterialResources(material, fileDirectory, device, options.ForceSRGB, options.LoadTextures);
 
         meshMaterials.push_back(material);
     }
 
-    // Initialize the meshes
+    // Initialize the meshes. The meshes are independent, so the CPU-side processing runs on the
+    // thread pool, largest meshes first so that a big mesh doesn't end up running on its own at
+    // the end. The GPU buffers are created afterwards on this thread.
     const uint64 numMeshes = scene->mNumMeshes;
     meshes.resize(numMeshes);
+
+    std::vector<uint32> meshOrder(numMeshes);
+    for(uint64 i = 0; i < numMeshes; ++i)
+        meshOrder[i] = uint32(i);
+    std::sort(meshOrder.begin(), meshOrder.end(), [&](uint32 a, uint32 b)
+    {
+        return scene->mMeshes[a]->mNumFaces > scene->mMeshes[b]->mNumFaces;
+    });
+
+    Timer meshTimer;
+    ParallelFor(numMeshes, 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        for(uint64 i = start; i < end; ++i)
+        {
+            const uint32 meshIdx = meshOrder[i];
+            meshes[meshIdx].InitFromAssimpMeshData(*scene->mMeshes[meshIdx], options);
+        }
+    });
+    meshTimer.Update();
+
+    importStats.MeshProcessingTime = meshTimer.ElapsedMillisecondsF();
+    importStats.NumMeshes = uint32(numMeshes);
     for(uint64 i = 0; i < numMeshes; ++i)
-        meshes[i].InitFromAssimpMesh(device, *scene->mMeshes[i]);
+    {
+        meshes[i].CreateVertexAndIndexBuffers(device);
+        importStats.ImportCacheStats += meshes[i].ImportCacheStats();
+        importStats.OptimizedCacheStats += meshes[i].OptimizedCacheStats();
+        importStats.SplitIndexBytesSaved += meshes[i].SplitIndexBytesSaved();
+        importStats.SplitVertexBytesAdded += meshes[i].SplitVertexBytesAdded();
+        if(options.CompressVertices && meshes[i].HasCompressedVertices() == false)
+            ++importStats.NumUncompressedMeshes;
+    }
+
+    if(options.GenerateLODs)
+    {
+        // Total up the triangles at each detail level. Parts without a full chain count their
+        // coarsest LOD towards the levels that they're missing.
+        importStats.LODTriangles.resize(MaxMeshLODs + 1, 0);
+        for(uint64 meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+        {
+            const Mesh& mesh = meshes[meshIdx];
+            for(uint64 partIdx = 0; partIdx < mesh.MeshParts().size(); ++partIdx)
+            {
+                const MeshPart& part = mesh.MeshParts()[partIdx];
+                uint32 indexCount = part.IndexCount;
+                for(uint32 lodIdx = 0; lodIdx <= MaxMeshLODs; ++lodIdx)
+                {
+                    if(lodIdx > 0 && lodIdx <= part.LODCount)
+                        indexCount = mesh.LODs()[part.LODStart + lodIdx - 1].IndexCount;
+                    importStats.LODTriangles[lodIdx] += indexCount / 3;
+                }
+            }
+        }
+    }
+
+    if(options.UseCache)
+    {
+        // Create the cache directory if it doesn't exist
+        if(DirectoryExists(modelCacheDir.c_str()) == false)
+            Win32Call(CreateDirectory(modelCacheDir.c_str(), nullptr));
+
+        // Write to a temporary file first, so that an interrupted write can't leave behind
+        // a truncated cache entry
+        const wstring tempName = cacheName + L".tmp";
+        WriteMeshCache(tempName.c_str());
+        Win32Call(MoveFileEx(tempName.c_str(), cacheName.c_str(), MOVEFILE_REPLACE_EXISTING));
+    }
+
+    loadTimer.Update();
+    importStats.LoadTime = loadTimer.ElapsedMillisecondsF();
 }
 
 void Model::CreateFromMeshData(ID3D11Device* device, const wchar* fileName, bool forceSRGB)
@@ -964,6 +1706,215 @@ void Model::CreateFromMeshData(ID3D11Device* device, const wchar* fileName, bool
     Serialize(serializer, device, forceSRGB);
 }
 
+// == Mesh cache ==================================================================================
+//
+// Layout of a mesh cache file:
+//   MeshCacheHeader
+//   MeshCacheBlobs for each mesh
+//   Metadata (mesh parts, input elements, materials), written with the regular serializers
+//   Vertex and index data for each mesh, each one starting on a MeshCacheAlignment boundary
+
+static const uint32 MeshCacheMagic = 0x4D43484D;    // "MHCM"
+static const uint32 MeshCacheVersion = 6;
+static const uint64 MeshCacheAlignment = 64;
+
+struct MeshCacheHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint64 FileSize;
+    uint64 NumMeshes;
+    uint64 BlobTableOffset;
+    uint64 MetadataOffset;
+    uint64 MetadataSize;
+};
+
+struct MeshCacheBlobs
+{
+    uint64 VertexOffset;
+    uint64 VertexSize;
+    uint64 IndexOffset;
+    uint64 IndexSize;
+};
+
+static uint64 AlignMeshCacheOffset(uint64 offset)
+{
+    return (offset + MeshCacheAlignment - 1) & ~(MeshCacheAlignment - 1);
+}
+
+static bool IsInFile(uint64 offset, uint64 size, uint64 fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+static bool IsInRange(uint32 start, uint32 count, uint64 rangeSize)
+{
+    return uint64(start) + count <= rangeSize;
+}
+
+// Checks that everything in the metadata that gets used as an offset or an index is in range
+static bool IsCachedMeshValid(const Mesh& mesh, uint64 numMaterials)
+{
+    if(mesh.NumVertices() == 0 || mesh.NumIndices() == 0 || mesh.VertexStride() == 0)
+        return false;
+
+    if(mesh.IndexBufferType() != IndexType::Index16Bit && mesh.IndexBufferType() != IndexType::Index32Bit)
+        return false;
+
+    bool hasPosition = false;
+    const uint32 positionSize = mesh.HasCompressedVertices() ? sizeof(uint16) * 3 : sizeof(Float3);
+    for(uint32 i = 0; i < mesh.NumInputElements(); ++i)
+    {
+        const D3D11_INPUT_ELEMENT_DESC& element = mesh.InputElements()[i];
+        if(strcmp(element.SemanticName, "POSITION") == 0 && hasPosition == false)
+        {
+            if(IsInRange(element.AlignedByteOffset, positionSize, mesh.VertexStride()) == false)
+                return false;
+            hasPosition = true;
+        }
+    }
+
+    if(hasPosition == false)
+        return false;
+
+    const vector<Meshlet>& meshlets = mesh.Meshlets();
+    const vector<MeshLOD>& lods = mesh.LODs();
+    for(uint64 i = 0; i < mesh.MeshParts().size(); ++i)
+    {
+        const MeshPart& part = mesh.MeshParts()[i];
+        if(IsInRange(part.VertexStart, part.VertexCount, mesh.NumVertices()) == false
+           || IsInRange(part.IndexStart, part.IndexCount, mesh.NumIndices()) == false
+           || part.BaseVertex > mesh.NumVertices() || part.MaterialIdx >= numMaterials
+           || IsInRange(part.MeshletStart, part.MeshletCount, meshlets.size()) == false
+           || IsInRange(part.LODStart, part.LODCount, lods.size()) == false)
+            return false;
+    }
+
+    for(uint64 i = 0; i < meshlets.size(); ++i)
+        if(IsInRange(meshlets[i].IndexStart, meshlets[i].IndexCount, mesh.NumIndices()) == false)
+            return false;
+
+    for(uint64 i = 0; i < lods.size(); ++i)
+        if(IsInRange(lods[i].IndexStart, lods[i].IndexCount, mesh.NumIndices()) == false)
+            return false;
+
+    return true;
+}
+
+void Model::WriteMeshCache(const wchar* fileName)
+{
+    MemoryWriteSerializer metadataSerializer;
+    SerializeCacheMetadata(metadataSerializer);
+    const vector<uint8>& metadata = metadataSerializer.Buffer();
+
+    MeshCacheHeader header;
+    header.Magic = MeshCacheMagic;
+    header.Version = MeshCacheVersion;
+    header.NumMeshes = meshes.size();
+    header.BlobTableOffset = sizeof(MeshCacheHeader);
+    header.MetadataOffset = header.BlobTableOffset + sizeof(MeshCacheBlobs) * meshes.size();
+    header.MetadataSize = metadata.size();
+
+    vector<MeshCacheBlobs> blobs(meshes.size());
+    uint64 offset = AlignMeshCacheOffset(header.MetadataOffset + header.MetadataSize);
+    for(uint64 i = 0; i < meshes.size(); ++i)
+    {
+        blobs[i].VertexOffset = offset;
+        blobs[i].VertexSize = meshes[i].VertexDataSize();
+        offset = AlignMeshCacheOffset(offset + blobs[i].VertexSize);
+
+        blobs[i].IndexOffset = offset;
+        blobs[i].IndexSize = meshes[i].IndexDataSize();
+        offset = AlignMeshCacheOffset(offset + blobs[i].IndexSize);
+    }
+
+    header.FileSize = offset;
+
+    File file(fileName, FileOpenMode::Write);
+    file.Write(header);
+    if(blobs.size() > 0)
+        file.Write(blobs.size() * sizeof(MeshCacheBlobs), blobs.data());
+    file.Write(metadata.size(), metadata.data());
+
+    const uint8 padding[MeshCacheAlignment] = { 0 };
+    uint64 fileOffset = header.MetadataOffset + header.MetadataSize;
+    auto writePadding = [&](uint64 nextOffset)
+    {
+        Assert_(nextOffset >= fileOffset && nextOffset - fileOffset < MeshCacheAlignment);
+        file.Write(nextOffset - fileOffset, padding);
+        fileOffset = nextOffset;
+    };
+
+    for(uint64 i = 0; i < meshes.size(); ++i)
+    {
+        writePadding(blobs[i].VertexOffset);
+        file.Write(blobs[i].VertexSize, meshes[i].Vertices());
+        fileOffset += blobs[i].VertexSize;
+
+        writePadding(blobs[i].IndexOffset);
+        file.Write(blobs[i].IndexSize, meshes[i].Indices());
+        fileOffset += blobs[i].IndexSize;
+    }
+
+    writePadding(header.FileSize);
+}
+
+void Model::CreateFromMeshCache(ID3D11Device* device, const wchar* fileName, const wchar* textureDirectory,
+                                bool forceSRGB, bool loadTextures)
+{
+    meshCacheFile = std::make_shared<MappedFile>(fileName);
+    const uint8* fileData = meshCacheFile->Data();
+    const uint64 fileSize = meshCacheFile->Size();
+
+    const wstring corruptError = L"Mesh cache file " + wstring(fileName) + L" is truncated or corrupt";
+
+    if(fileSize < sizeof(MeshCacheHeader))
+        throw Exception(corruptError);
+
+    const MeshCacheHeader& header = *reinterpret_cast<const MeshCacheHeader*>(fileData);
+    if(header.Magic != MeshCacheMagic)
+        throw Exception(L"File " + wstring(fileName) + L" is not a mesh cache file");
+
+    if(header.Version != MeshCacheVersion)
+        throw Exception(L"Mesh cache file " + wstring(fileName) + L" has version " + ToString(header.Version) +
+                        L", expected version " + ToString(MeshCacheVersion));
+
+    if(header.FileSize != fileSize || header.NumMeshes > fileSize / sizeof(MeshCacheBlobs)
+       || IsInFile(header.BlobTableOffset, header.NumMeshes * sizeof(MeshCacheBlobs), fileSize) == false
+       || IsInFile(header.MetadataOffset, header.MetadataSize, fileSize) == false)
+        throw Exception(corruptError);
+
+    // Only the metadata gets copied out of the file, everything else is used in place
+    MemoryReadSerializer serializer(fileData + header.MetadataOffset, header.MetadataSize);
+    SerializeCacheMetadata(serializer);
+    if(meshes.size() != header.NumMeshes)
+        throw Exception(corruptError);
+
+    fileDirectory = textureDirectory;
+
+    const MeshCacheBlobs* blobs = reinterpret_cast<const MeshCacheBlobs*>(fileData + header.BlobTableOffset);
+    for(uint64 i = 0; i < meshes.size(); ++i)
+    {
+        Mesh& mesh = meshes[i];
+        const MeshCacheBlobs& meshBlobs = blobs[i];
+
+        if(IsCachedMeshValid(mesh, meshMaterials.size()) == false
+           || meshBlobs.VertexSize != mesh.VertexDataSize() || meshBlobs.IndexSize != mesh.IndexDataSize()
+           || IsInFile(meshBlobs.VertexOffset, meshBlobs.VertexSize, fileSize) == false
+           || IsInFile(meshBlobs.IndexOffset, meshBlobs.IndexSize, fileSize) == false)
+            throw Exception(corruptError);
+
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.mappedVertices = fileData + meshBlobs.VertexOffset;
+        mesh.mappedIndices = fileData + meshBlobs.IndexOffset;
+        mesh.CreateVertexAndIndexBuffers(device);
+    }
+
+    for(uint64 i = 0; i < meshMaterials.size(); ++i)
+        LoadMaterialResources(meshMaterials[i], fileDirectory, device, forceSRGB, loadTextures);
+}
+
 void Model::GenerateBoxScene(ID3D11Device* device, const Float3& dimensions, const Float3& position,
                              const Quaternion& orientation, const wchar* colorMap,
                              const wchar* normalMap)
@@ -1022,32 +1973,45 @@ void Model::GenerateCorneaScene(ID3D11Device* device)
     meshes[0].InitCornea(device, 0);
 }
 
-void Model::LoadMaterialResources(MeshMaterial& material, const wstring& directory, ID3D11Device* device, bool forceSRGB)
+// The texture cache makes sure that every material shares the same copy of the default textures
+ID3D11ShaderResourceViewPtr Model::DefaultDiffuseMap(ID3D11Device* device)
+{
+    return LoadTexture(device, L"..\\Content\\Textures\\Default.dds");
+}
+
+ID3D11ShaderResourceViewPtr Model::DefaultNormalMap(ID3D11Device* device)
+{
+    return LoadTexture(device, L"..\\Content\\Textures\\DefaultNormalMap.dds");
+}
+
+bool Model::DiffuseMapPath(const MeshMaterial& material, const wstring& directory, wstring& path)
+{
+    path = directory + material.DiffuseMapName;
+    return material.DiffuseMapName.length() > 1 && FileExists(path.c_str());
+}
+
+bool Model::NormalMapPath(const MeshMaterial& material, const wstring& directory, wstring& path)
+{
+    path = directory + material.NormalMapName;
+    return material.NormalMapName.length() > 1 && FileExists(path.c_str());
+}
+
+void Model::LoadMaterialResources(MeshMaterial& material, const wstring& directory, ID3D11Device* device, bool forceSRGB,
+                                  bool loadTextures)
 {
     // Load the diffuse map
-    wstring diffuseMapPath = directory + material.DiffuseMapName;
-    if(material.DiffuseMapName.length() > 1 && FileExists(diffuseMapPath.c_str()))
+    wstring diffuseMapPath;
+    if(loadTextures && DiffuseMapPath(material, directory, diffuseMapPath))
         material.DiffuseMap = LoadTexture(device, diffuseMapPath.c_str(), forceSRGB);
     else
-    {
-        static ID3D11ShaderResourceViewPtr defaultDiffuse;
-        if(defaultDiffuse == nullptr)
-            defaultDiffuse = LoadTexture(device, L"..\\Content\\Textures\\Default.dds");
-        material.DiffuseMap = defaultDiffuse;
-    }
+        material.DiffuseMap = DefaultDiffuseMap(device);
 
     // Load the normal map
-    wstring normalMapPath = directory + material.NormalMapName;
-
-    if(material.NormalMapName.length() > 1 && FileExists(normalMapPath.c_str()))
+    wstring normalMapPath;
+    if(loadTextures && NormalMapPath(material, directory, normalMapPath))
         material.NormalMap = LoadTexture(device, normalMapPath.c_str());
     else
-    {
-        static ID3D11ShaderResourceViewPtr defaultNormalMap;
-        if(defaultNormalMap == nullptr)
-            defaultNormalMap = LoadTexture(device, L"..\\Content\\Textures\\DefaultNormalMap.dds");
-        material.NormalMap = defaultNormalMap;
-    }
+        material.NormalMap = DefaultNormalMap(device);
 }
 
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "..\\InterfacePointers.h"
 #include "..\\SF11_Math.h"
 #include "..\\Serialization.h"
+#include "MeshOptimizer.h"
 
 struct aiMesh;
 
@@ -48,6 +49,16 @@ struct MeshMaterial
     }
 };
 
+// A simplified version of a MeshPart, which uses the same vertices
+struct MeshLOD
+{
+    uint32 IndexStart;
+    uint32 IndexCount;
+
+    // Largest distance that the simplified surface can be from the original one, in object space
+    float Error;
+};
+
 struct MeshPart
 {
     uint32 VertexStart;
@@ -56,7 +67,20 @@ struct MeshPart
     uint32 IndexCount;
     uint32 MaterialIdx;
 
-    MeshPart() : VertexStart(0), VertexCount(0), IndexStart(0), IndexCount(0), MaterialIdx(0)
+    // Range of the mesh's meshlets that cover this part's triangles
+    uint32 MeshletStart;
+    uint32 MeshletCount;
+
+    // Added to the part's indices when drawing. Parts that were split off so that they could use
+    // 16-bit indices have indices relative to VertexStart, everything else uses 0.
+    uint32 BaseVertex;
+
+    // Range of the mesh's LODs for this part, from most to least detailed. The part itself is LOD 0.
+    uint32 LODStart;
+    uint32 LODCount;
+
+    MeshPart() : VertexStart(0), VertexCount(0), IndexStart(0), IndexCount(0), MaterialIdx(0),
+                 MeshletStart(0), MeshletCount(0), BaseVertex(0), LODStart(0), LODCount(0)
     {
     }
 };
@@ -67,6 +91,62 @@ enum class IndexType
     Index32Bit = 1
 };
 
+// Settings for Model::CreateWithAssimp and AsyncModelLoader
+struct ModelImportOptions
+{
+    // Treats the diffuse maps as sRGB even when their format isn't
+    bool ForceSRGB = false;
+
+    // Loads the model from the mesh cache if it's there, and writes it out otherwise
+    bool UseCache = true;
+
+    // Quantized positions, octahedral normals/tangents and half UVs (see VertexCompression.h)
+    bool CompressVertices = false;
+
+    // Meshes with more than 64K vertices are split into parts that each reference fewer than 64K
+    // vertices, so that they can use 16-bit indices
+    bool Force16BitIndices = false;
+
+    // Every part gets a chain of simplified LODs that share its vertices
+    bool GenerateLODs = false;
+
+    // Without this the materials all use the default textures (see AsyncModelLoader)
+    bool LoadTextures = true;
+};
+
+// What the last call to Model::CreateWithAssimp did, so that it can be shown on screen. Only the
+// timings are filled in when the model came from the mesh cache.
+struct ModelImportStats
+{
+    bool LoadedFromCache = false;
+
+    // Why the model's cache entry couldn't be used, if there was one. The entry gets deleted, and
+    // the model is imported again.
+    std::wstring CacheError;
+
+    // Total time for the load, and the time spent processing the meshes on the thread pool, in
+    // milliseconds
+    float LoadTime = 0.0f;
+    float MeshProcessingTime = 0.0f;
+
+    uint32 NumMeshes = 0;
+
+    // Meshes that were left uncompressed because their data doesn't fit the compressed format
+    // (see Mesh::CompressionFailureReason)
+    uint32 NumUncompressedMeshes = 0;
+
+    VertexCacheStats ImportCacheStats;
+    VertexCacheStats OptimizedCacheStats;
+
+    uint64 SplitIndexBytesSaved = 0;
+    uint64 SplitVertexBytesAdded = 0;
+
+    // Triangles in the whole model at each detail level, with LOD 0 first. Parts without a full
+    // chain count their coarsest LOD towards the levels that they're missing. Empty unless
+    // GenerateLODs was set.
+    std::vector<uint64> LODTriangles;
+};
+
 class Mesh
 {
     friend class Model;
@@ -75,7 +155,8 @@ public:
 
     // Init from loaded files
     void InitFromSDKMesh(ID3D11Device* device, SDKMesh& sdkmesh, uint32 meshIdx, bool generateTangents);
-    void InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh);
+    void InitFromAssimpMesh(ID3D11Device* device, const aiMesh& assimpMesh,
+                            const ModelImportOptions& options = ModelImportOptions());
 
     // Procedural generation
     void InitBox(ID3D11Device* device, const Float3& dimensions, const Float3& position,
@@ -95,6 +176,8 @@ public:
 
     std::vector<MeshPart>& MeshParts() { return meshParts; }
     const std::vector<MeshPart>& MeshParts() const { return meshParts; }
+    const std::vector<Meshlet>& Meshlets() const { return meshlets; }
+    const std::vector<MeshLOD>& LODs() const { return lods; }
 
     const D3D11_INPUT_ELEMENT_DESC* InputElements() const { return &inputElements[0]; }
     uint32 NumInputElements() const { return static_cast<uint32>(inputElements.size()); }
@@ -107,10 +190,37 @@ public:
     DXGI_FORMAT IndexBufferFormat() const { return indexType == IndexType::Index32Bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT; }
     uint32 IndexSize() const { return indexType == IndexType::Index32Bit ? 4 : 2; }
 
-    const uint8* Vertices() const { return vertices.data(); }
-    const uint8* Indices() const { return indices.data(); }
+    // These point into the owning Model's mesh cache file when it was loaded with CreateFromMeshCache
+    const uint8* Vertices() const { return mappedVertices != nullptr ? mappedVertices : vertices.data(); }
+    const uint8* Indices() const { return mappedIndices != nullptr ? mappedIndices : indices.data(); }
 
-    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    // Vertex cache efficiency before and after OptimizeIndices, only valid right after importing
+    const VertexCacheStats& ImportCacheStats() const { return importCacheStats; }
+    const VertexCacheStats& OptimizedCacheStats() const { return optimizedCacheStats; }
+
+    // Compressed vertices have 16-bit positions that are decoded with PositionScale/PositionBias,
+    // octahedral normals, half-precision UVs and a packed tangent frame (see VertexCompression.h)
+    bool HasCompressedVertices() const { return compressedVertices; }
+    const Float3& PositionScale() const { return positionScale; }
+    const Float3& PositionBias() const { return positionBias; }
+
+    // Computes the object-space bounds of a range of vertices
+    void ComputeBounds(uint32 vertexStart, uint32 vertexCount, Float3& minPosition, Float3& maxPosition) const;
+
+    // Index memory saved and vertex memory added by splitting the mesh for 16-bit indices,
+    // only valid right after importing
+    uint64 SplitIndexBytesSaved() const { return splitIndexBytesSaved; }
+    uint64 SplitVertexBytesAdded() const { return splitVertexBytesAdded; }
+
+    // Why the import left the vertices uncompressed when they were supposed to be compressed,
+    // only valid right after importing
+    const std::string& CompressionFailureReason() const { return compressionFailureReason; }
+
+    uint64 VertexDataSize() const { return uint64(vertexStride) * numVertices; }
+    uint64 IndexDataSize() const { return uint64(IndexSize()) * numIndices; }
+
+    // Everything except for the vertex and index data
+    template<typename TSerializer> void SerializeMetadata(TSerializer& serializer)
     {
         SerializeRawVector(serializer, meshParts);
 
@@ -120,6 +230,8 @@ public:
 
         SerializeRawVector(serializer, inputElements);
         SerializeItem(serializer, inputElementStrings);
+        if(inputElementStrings.size() != inputElements.size())
+            throw Exception(L"Mesh has a different number of input elements and semantic names");
 
         for(uint64 i = 0; i < inputElements.size(); ++i)
             inputElements[i].SemanticName = inputElementStrings[i].c_str();
@@ -130,13 +242,47 @@ public:
         uint32 idxType = uint32(indexType);
         SerializeItem(serializer, idxType);
         indexType = IndexType(idxType);
+
+        uint32 compressed = compressedVertices ? 1 : 0;
+        SerializeItem(serializer, compressed);
+        compressedVertices = compressed != 0;
+        SerializeItem(serializer, positionScale);
+        SerializeItem(serializer, positionBias);
+
+        SerializeRawVector(serializer, meshlets);
+        SerializeRawVector(serializer, lods);
+    }
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeMetadata(serializer);
+
+        if(TSerializer::IsWriteSerializer() && mappedVertices != nullptr)
+        {
+            // Write out the mapped data using the same layout as SerializeRawVector
+            uint64 vbSize = VertexDataSize();
+            uint64 ibSize = IndexDataSize();
+            SerializeItem(serializer, vbSize);
+            SerializeData(serializer, const_cast<uint8*>(mappedVertices), vbSize);
+            SerializeItem(serializer, ibSize);
+            SerializeData(serializer, const_cast<uint8*>(mappedIndices), ibSize);
+            return;
+        }
+
+        mappedVertices = nullptr;
+        mappedIndices = nullptr;
         SerializeRawVector(serializer, vertices);
         SerializeRawVector(serializer, indices);
     }
 
 protected:
 
+    void InitFromAssimpMeshData(const aiMesh& assimpMesh, const ModelImportOptions& options);
     void GenerateTangentFrame();
+    void OptimizeIndices(bool force16BitIndices = false);
+    void SplitFor16BitIndices(std::vector<uint32>& indices32);
+    void GenerateLODs();
+    bool CompressVertices(std::string& failureReason);
     void CreateInputElements(const D3DVERTEXELEMENT9* declaration);
     void CreateVertexAndIndexBuffers(ID3D11Device* device);
 
@@ -144,6 +290,8 @@ protected:
     ID3D11BufferPtr indexBuffer;
 
     std::vector<MeshPart> meshParts;
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshLOD> lods;
     std::vector<D3D11_INPUT_ELEMENT_DESC> inputElements;
     std::vector<std::string> inputElementStrings;
 
@@ -155,6 +303,21 @@ protected:
 
     std::vector<uint8> vertices;
     std::vector<uint8> indices;
+
+    const uint8* mappedVertices = nullptr;
+    const uint8* mappedIndices = nullptr;
+
+    bool compressedVertices = false;
+    Float3 positionScale = 1.0f;
+    Float3 positionBias;
+
+    VertexCacheStats importCacheStats;
+    VertexCacheStats optimizedCacheStats;
+
+    uint64 splitIndexBytesSaved = 0;
+    uint64 splitVertexBytesAdded = 0;
+
+    std::string compressionFailureReason;
 };
 
 class Model
@@ -168,10 +331,20 @@ public:
                                 bool overrideNormalMaps = false,
                                 bool forceSRGB = false);
 
-    void CreateWithAssimp(ID3D11Device* device, const wchar* fileName, bool forceSRGB = false);
+    // Imported models are baked out to a cache keyed on the file contents and the import settings,
+    // so that later loads can skip Assimp entirely
+    void CreateWithAssimp(ID3D11Device* device, const wchar* fileName,
+                          const ModelImportOptions& options = ModelImportOptions());
 
     void CreateFromMeshData(ID3D11Device* device, const wchar* fileName, bool forceSRGB = false);
 
+    // Versioned binary format that's memory-mapped, with the vertex and index data used in place. The
+    // cache doesn't store where the model came from (identical files in different directories share
+    // an entry), so the materials' textures are loaded from textureDirectory.
+    void CreateFromMeshCache(ID3D11Device* device, const wchar* fileName, const wchar* textureDirectory,
+                             bool forceSRGB = false, bool loadTextures = true);
+    void WriteMeshCache(const wchar* fileName);
+
     // Procedural generation
     void GenerateBoxScene(ID3D11Device* device,
                           const Float3& dimensions = Float3(1.0f, 1.0f, 1.0f),
@@ -195,6 +368,18 @@ public:
     std::vector<Mesh>& Meshes() { return meshes; }
     const std::vector<Mesh>& Meshes() const { return meshes; }
 
+    const std::wstring& FileDirectory() const { return fileDirectory; }
+
+    const ModelImportStats& ImportStats() const { return importStats; }
+
+    // Textures used by materials that don't have their own, or that haven't been loaded yet
+    static ID3D11ShaderResourceViewPtr DefaultDiffuseMap(ID3D11Device* device);
+    static ID3D11ShaderResourceViewPtr DefaultNormalMap(ID3D11Device* device);
+
+    // Builds the path to one of the material's textures, and returns false if it doesn't have one
+    static bool DiffuseMapPath(const MeshMaterial& material, const std::wstring& directory, std::wstring& path);
+    static bool NormalMapPath(const MeshMaterial& material, const std::wstring& directory, std::wstring& path);
+
     // Serialization
     template<typename TSerializer>
     void Serialize(TSerializer& serializer, ID3D11Device* device, bool forceSRGB = false)
@@ -215,11 +400,31 @@ public:
 
 protected:
 
-    static void LoadMaterialResources(MeshMaterial& material, const std::wstring& directory, ID3D11Device* device, bool forceSRGB);
+    static void LoadMaterialResources(MeshMaterial& material, const std::wstring& directory, ID3D11Device* device, bool forceSRGB,
+                                      bool loadTextures = true);
+
+    template<typename TSerializer> void SerializeCacheMetadata(TSerializer& serializer)
+    {
+        uint64 numMeshes = meshes.size();
+        SerializeItem(serializer, numMeshes);
+        serializer.CheckNumItems(numMeshes, 1);
+        if(meshes.size() != numMeshes)
+            meshes.resize(numMeshes);
+
+        for(uint64 i = 0; i < numMeshes; ++i)
+            meshes[i].SerializeMetadata(serializer);
+
+        SerializeItem(serializer, meshMaterials);
+    }
 
     std::vector<Mesh> meshes;
     std::vector<MeshMaterial> meshMaterials;
     std::wstring fileDirectory;
+
+    // Keeps the mesh data alive for models loaded with CreateFromMeshCache
+    std::shared_ptr<MappedFile> meshCacheFile;
+
+    ModelImportStats importStats;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,1055 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "PixelConversion.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #include <immintrin.h>
+    #define PC_X86_ 1
+#else
+    #define PC_X86_ 0
+#endif
+
+// Functions that use AVX2 or F16C are only called after checking the CPU. MSVC lets any function
+// use them, but GCC and Clang need to be told which ones can. They all end with _mm256_zeroupper(),
+// since the rest of the code is built for SSE2, and legacy SSE instructions that run while the upper
+// halves of the YMM registers are dirty pay for a state transition (or a false dependency).
+#if PC_X86_ && defined(_MSC_VER)
+    #include <intrin.h>
+    #define PC_AVX2_FUNCTION_
+#elif PC_X86_
+    #include <cpuid.h>
+    #define PC_AVX2_FUNCTION_ __attribute__((target("avx2,f16c")))
+#endif
+
+namespace SampleFramework11
+{
+
+namespace PixelConversion
+{
+
+// == Helpers =====================================================================================
+
+static uint32_t FloatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float BitsToFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Clamps to [0, 1], with NaN going to 0
+static float Saturate(float value)
+{
+    return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+}
+
+// 2^112, which re-biases the exponent of a half (or a smaller float) to a 32-bit float
+static const uint32_t ExponentScaleBits = 0x77800000;
+
+struct CPUFeatures
+{
+    bool F16C;
+    bool AVX2;
+
+    CPUFeatures() : F16C(false), AVX2(false)
+    {
+        #if PC_X86_
+            uint32_t maxLeaf, ebx, ecx, edx;
+            CPUID(0, maxLeaf, ebx, ecx, edx);
+
+            uint32_t eax;
+            CPUID(1, eax, ebx, ecx, edx);
+            const bool osxsave = (ecx & (1 << 27)) != 0;
+            const bool avx = (ecx & (1 << 28)) != 0;
+            const bool f16c = (ecx & (1 << 29)) != 0;
+
+            // The OS also has to save the YMM registers when switching threads
+            if(osxsave == false || avx == false || (XGetBV() & 0x6) != 0x6)
+                return;
+
+            F16C = f16c;
+            if(maxLeaf >= 7)
+            {
+                CPUID(7, eax, ebx, ecx, edx);
+                AVX2 = (ebx & (1 << 5)) != 0;
+            }
+        #endif
+    }
+
+    #if PC_X86_
+        static void CPUID(uint32_t leaf, uint32_t& eax, uint32_t& ebx, uint32_t& ecx, uint32_t& edx)
+        {
+            #ifdef _MSC_VER
+                int info[4];
+                __cpuidex(info, int(leaf), 0);
+                eax = uint32_t(info[0]);
+                ebx = uint32_t(info[1]);
+                ecx = uint32_t(info[2]);
+                edx = uint32_t(info[3]);
+            #else
+                __cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+            #endif
+        }
+
+        static uint64_t XGetBV()
+        {
+            #ifdef _MSC_VER
+                return _xgetbv(0);
+            #else
+                uint32_t eax, edx;
+                __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+                return eax | (uint64_t(edx) << 32);
+            #endif
+        }
+    #endif
+};
+
+static CPUFeatures Features;
+
+bool HasF16C()
+{
+    return Features.F16C;
+}
+
+bool HasAVX2()
+{
+    return Features.AVX2;
+}
+
+#if PC_X86_
+
+static __m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Loads the RGB channels of 4 texels, with a transpose when they're in RGBA order
+static void LoadRGB4(const float* texels, size_t stride, __m128 rgb[3])
+{
+    if(stride == 4)
+    {
+        __m128 t0 = _mm_loadu_ps(texels);
+        __m128 t1 = _mm_loadu_ps(texels + 4);
+        __m128 t2 = _mm_loadu_ps(texels + 8);
+        __m128 t3 = _mm_loadu_ps(texels + 12);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+        rgb[0] = t0;
+        rgb[1] = t1;
+        rgb[2] = t2;
+        return;
+    }
+
+    for(uint32_t c = 0; c < 3; ++c)
+        rgb[c] = _mm_setr_ps(texels[c], texels[stride + c], texels[stride * 2 + c], texels[stride * 3 + c]);
+}
+
+// Stores the RGB channels of 4 texels, leaving alpha alone
+static void StoreRGB4(const __m128 rgb[3], float* texels, size_t stride)
+{
+    __m128 t0 = rgb[0];
+    __m128 t1 = rgb[1];
+    __m128 t2 = rgb[2];
+    __m128 t3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+    const __m128 texelRGB[4] = { t0, t1, t2, t3 };
+
+    if(stride == 4)
+    {
+        const __m128 alphaMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            const __m128 alpha = _mm_and_ps(_mm_loadu_ps(texels + i * 4), alphaMask);
+            _mm_storeu_ps(texels + i * 4, _mm_or_ps(texelRGB[i], alpha));
+        }
+        return;
+    }
+
+    for(uint32_t i = 0; i < 4; ++i)
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(texels + i * stride), texelRGB[i]);
+        _mm_store_ss(texels + i * stride + 2, _mm_movehl_ps(texelRGB[i], texelRGB[i]));
+    }
+}
+
+// Rounds 4 floats in [0, 1] to integers in [0, scale], going through doubles so that the multiply
+// is exact and the rounding is correct
+static __m128i RoundToUNorm4(__m128 values, double scale)
+{
+    const __m128d scaleD = _mm_set1_pd(scale);
+    const __m128i low = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(values), scaleD));
+    const __m128i high = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(values, values)), scaleD));
+    return _mm_unpacklo_epi64(low, high);
+}
+
+static __m128 Saturate4(__m128 values)
+{
+    // MAXPS returns its second operand for NaN, so NaN becomes 0
+    return _mm_min_ps(_mm_max_ps(values, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+#endif
+
+// == Half ========================================================================================
+
+// Rounds to nearest even. Normal results are rounded by adding just under half of the bits that
+// get shifted out, plus the bit above them. Denormal results are rounded by the FPU, by adding a
+// number that lines the mantissa up with the half's denormal steps.
+static const uint32_t HalfDenormalMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+
+static uint16_t FloatToHalfScalar(float value, bool saturate)
+{
+    if(saturate)
+    {
+        if(value > 65504.0f)
+            value = 65504.0f;
+        else if(value < -65504.0f)
+            value = -65504.0f;
+    }
+
+    const uint32_t signedBits = FloatBits(value);
+    const uint32_t sign = (signedBits >> 16) & 0x8000;
+    const uint32_t bits = signedBits & 0x7FFFFFFF;
+
+    uint32_t half;
+    if(bits >= 0x47800000)
+    {
+        // 2^16 or more, which is past the largest half: infinity, or a quiet NaN
+        half = bits > 0x7F800000 ? 0x7E00 | ((bits >> 13) & 0x3FF) : 0x7C00;
+    }
+    else if(bits < 0x38800000)
+    {
+        const float magic = BitsToFloat(HalfDenormalMagicBits);
+        half = FloatBits(BitsToFloat(bits) + magic) - HalfDenormalMagicBits;
+    }
+    else
+    {
+        half = (bits + 0xC8000FFF + ((bits >> 13) & 1)) >> 13;
+    }
+
+    return uint16_t(half | sign);
+}
+
+static float HalfToFloatScalar(uint16_t half)
+{
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    const uint32_t expMantissa = uint32_t(half & 0x7FFF) << 13;
+    if(expMantissa > 0x0F800000)
+        return BitsToFloat(sign | expMantissa | 0x7FC00000);
+    else if(expMantissa == 0x0F800000)
+        return BitsToFloat(sign | 0x7F800000);
+    return BitsToFloat(sign | FloatBits(BitsToFloat(expMantissa) * BitsToFloat(ExponentScaleBits)));
+}
+
+#if PC_X86_
+
+// The same as FloatToHalfScalar(), giving one half in the low 16 bits of each lane
+static __m128i FloatToHalf4(__m128 values)
+{
+    const __m128i signedBits = _mm_castps_si128(values);
+    const __m128i sign = _mm_srli_epi32(_mm_and_si128(signedBits, _mm_set1_epi32(int(0x80000000))), 16);
+    const __m128i bits = _mm_and_si128(signedBits, _mm_set1_epi32(0x7FFFFFFF));
+
+    const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+    __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(int(0xC8000FFF)));
+    normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(HalfDenormalMagicBits));
+    const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), magic)),
+                                           _mm_castps_si128(magic));
+
+    const __m128i isNaN = _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7F800000));
+    const __m128i nanPayload = _mm_or_si128(_mm_set1_epi32(0x200),
+                                            _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(0x3FF)));
+    const __m128i infNaN = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, nanPayload));
+
+    __m128i half = Select(_mm_cmplt_epi32(bits, _mm_set1_epi32(0x38800000)), denormal, normal);
+    half = Select(_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x477FFFFF)), infNaN, half);
+    return _mm_or_si128(half, sign);
+}
+
+// Takes one half in the low 16 bits of each lane
+static __m128 HalfToFloat4(__m128i halves)
+{
+    const __m128i sign = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+    const __m128i expMantissa = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)), 13);
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(expMantissa), _mm_castsi128_ps(_mm_set1_epi32(ExponentScaleBits)));
+
+    // Infinity and NaN get the maximum exponent, and NaN is made quiet like VCVTPH2PS does
+    const __m128i infNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x0F7FE000));
+    const __m128i isNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x0F800000));
+    const __m128i infNaNBits = _mm_or_si128(_mm_or_si128(expMantissa, _mm_set1_epi32(0x7F800000)),
+                                            _mm_and_si128(isNaN, _mm_set1_epi32(0x00400000)));
+    const __m128i bits = Select(infNaN, infNaNBits, _mm_castps_si128(scaled));
+    return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+}
+
+// Packs two sets of 4 values below 0x10000 into 8 16-bit values. PACKSSDW saturates, so the
+// values get sign-extended first.
+static __m128i PackUInt16(__m128i low, __m128i high)
+{
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+    return _mm_packs_epi32(low, high);
+}
+
+static size_t FloatToHalfSSE2(const float* src, uint16_t* dst, size_t count, bool saturate)
+{
+    const __m128 maxHalf = _mm_set1_ps(65504.0f);
+    const __m128 minHalf = _mm_set1_ps(-65504.0f);
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128 low = _mm_loadu_ps(src + i);
+        __m128 high = _mm_loadu_ps(src + i + 4);
+        if(saturate)
+        {
+            // MINPS and MAXPS return their second operand for NaN, which keeps it as NaN
+            low = _mm_max_ps(minHalf, _mm_min_ps(maxHalf, low));
+            high = _mm_max_ps(minHalf, _mm_min_ps(maxHalf, high));
+        }
+
+        const __m128i halves = PackUInt16(FloatToHalf4(low), FloatToHalf4(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halves);
+    }
+
+    return i;
+}
+
+static size_t HalfToFloatSSE2(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, HalfToFloat4(_mm_unpacklo_epi16(halves, _mm_setzero_si128())));
+        _mm_storeu_ps(dst + i + 4, HalfToFloat4(_mm_unpackhi_epi16(halves, _mm_setzero_si128())));
+    }
+
+    return i;
+}
+
+// VCVTPS2PH rounds to nearest even and converts NaN the same way as FloatToHalfScalar()
+PC_AVX2_FUNCTION_ static size_t FloatToHalfF16C(const float* src, uint16_t* dst, size_t count, bool saturate)
+{
+    const __m256 maxHalf = _mm256_set1_ps(65504.0f);
+    const __m256 minHalf = _mm256_set1_ps(-65504.0f);
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        __m256 low = _mm256_loadu_ps(src + i);
+        __m256 high = _mm256_loadu_ps(src + i + 8);
+        if(saturate)
+        {
+            low = _mm256_max_ps(minHalf, _mm256_min_ps(maxHalf, low));
+            high = _mm256_max_ps(minHalf, _mm256_min_ps(maxHalf, high));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(low, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm256_cvtps_ph(high, 0));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+PC_AVX2_FUNCTION_ static size_t HalfToFloatF16C(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(low));
+        _mm256_storeu_ps(dst + i + 8, _mm256_cvtph_ps(high));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+#endif
+
+void FloatToHalf(const float* src, uint16_t* dst, size_t count, bool saturate)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.F16C ? FloatToHalfF16C(src, dst, count, saturate) : FloatToHalfSSE2(src, dst, count, saturate);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = FloatToHalfScalar(src[i], saturate);
+}
+
+void HalfToFloat(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.F16C ? HalfToFloatF16C(src, dst, count) : HalfToFloatSSE2(src, dst, count);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = HalfToFloatScalar(src[i]);
+}
+
+// == R11G11B10 ===================================================================================
+
+// Small floats have a 5-bit exponent like halves, no sign, and MantissaBits bits of mantissa. The
+// rounding works the same way as it does for halves.
+template<uint32_t MantissaBits> struct SmallFloat
+{
+    static const uint32_t Shift = 23 - MantissaBits;
+    static const uint32_t Infinity = 31 << MantissaBits;
+    static const uint32_t NaN = Infinity | (1 << (MantissaBits - 1));
+    static const uint32_t MaxFinite = Infinity - 1;
+    static const uint32_t MaxFiniteBits = ((127 + 15) << 23) | (((1 << MantissaBits) - 1) << Shift);
+    static const uint32_t DenormalMagicBits = ((127 - 15) + Shift + 1) << 23;
+    static const uint32_t Mask = (1 << (MantissaBits + 5)) - 1;
+
+    static uint32_t Encode(float value)
+    {
+        const uint32_t bits = FloatBits(value);
+        if((bits & 0x7FFFFFFF) > 0x7F800000)
+            return NaN;
+        else if(bits & 0x80000000)
+            return 0;
+        else if(bits == 0x7F800000)
+            return Infinity;
+        else if(bits > MaxFiniteBits)
+            return MaxFinite;
+        else if(bits < 0x38800000)
+            return FloatBits(value + BitsToFloat(DenormalMagicBits)) - DenormalMagicBits;
+        else
+            return (bits + 0xC8000000 + (1 << (Shift - 1)) - 1 + ((bits >> Shift) & 1)) >> Shift;
+    }
+
+    static float Decode(uint32_t encoded)
+    {
+        const uint32_t bits = (encoded & Mask) << Shift;
+        if((encoded & Mask) >= Infinity)
+            return BitsToFloat(bits | 0x7F800000);
+        return BitsToFloat(bits) * BitsToFloat(ExponentScaleBits);
+    }
+
+    #if PC_X86_
+        static __m128i Encode4(__m128 values)
+        {
+            const __m128i bits = _mm_castps_si128(values);
+
+            const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, Shift), _mm_set1_epi32(1));
+            __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(int(0xC8000000 + (1 << (Shift - 1)) - 1)));
+            normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), Shift);
+
+            const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(DenormalMagicBits));
+            const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(values, magic)), _mm_castps_si128(magic));
+
+            // Negative values compare as negative integers, including NaNs with the sign bit set
+            const __m128i isNaN = _mm_cmpgt_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF)), _mm_set1_epi32(0x7F800000));
+            __m128i encoded = Select(_mm_cmplt_epi32(bits, _mm_set1_epi32(0x38800000)), denormal, normal);
+            encoded = Select(_mm_cmpgt_epi32(bits, _mm_set1_epi32(MaxFiniteBits)), _mm_set1_epi32(MaxFinite), encoded);
+            encoded = Select(_mm_cmpeq_epi32(bits, _mm_set1_epi32(0x7F800000)), _mm_set1_epi32(Infinity), encoded);
+            encoded = _mm_andnot_si128(_mm_cmplt_epi32(bits, _mm_setzero_si128()), encoded);
+            return Select(isNaN, _mm_set1_epi32(NaN), encoded);
+        }
+
+        static __m128 Decode4(__m128i encoded)
+        {
+            encoded = _mm_and_si128(encoded, _mm_set1_epi32(Mask));
+            const __m128i bits = _mm_slli_epi32(encoded, Shift);
+            const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(_mm_set1_epi32(ExponentScaleBits)));
+            const __m128i infNaN = _mm_cmpgt_epi32(encoded, _mm_set1_epi32(Infinity - 1));
+            return _mm_castsi128_ps(Select(infNaN, _mm_or_si128(bits, _mm_set1_epi32(0x7F800000)), _mm_castps_si128(scaled)));
+        }
+    #endif
+};
+
+typedef SmallFloat<6> Float11;
+typedef SmallFloat<5> Float10;
+
+void FloatToR11G11B10(const float* src, size_t stride, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 rgb[3];
+            LoadRGB4(src + i * stride, stride, rgb);
+            const __m128i r = Float11::Encode4(rgb[0]);
+            const __m128i g = Float11::Encode4(rgb[1]);
+            const __m128i b = Float10::Encode4(rgb[2]);
+            const __m128i packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 11)), _mm_slli_epi32(b, 22));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+        }
+    #endif
+
+    for(; i < count; ++i)
+    {
+        const float* texel = src + i * stride;
+        dst[i] = Float11::Encode(texel[0]) | (Float11::Encode(texel[1]) << 11) | (Float10::Encode(texel[2]) << 22);
+    }
+}
+
+void R11G11B10ToFloat(const uint32_t* src, float* dst, size_t stride, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        for(; i + 4 <= count; i += 4)
+        {
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128 rgb[3] = { Float11::Decode4(packed), Float11::Decode4(_mm_srli_epi32(packed, 11)),
+                                    Float10::Decode4(_mm_srli_epi32(packed, 22)) };
+            StoreRGB4(rgb, dst + i * stride, stride);
+        }
+    #endif
+
+    for(; i < count; ++i)
+    {
+        float* texel = dst + i * stride;
+        texel[0] = Float11::Decode(src[i]);
+        texel[1] = Float11::Decode(src[i] >> 11);
+        texel[2] = Float10::Decode(src[i] >> 22);
+    }
+}
+
+// == R9G9B9E5 ====================================================================================
+
+// The largest value that can be stored: (511 / 512) * 2^16
+static const float MaxSharedExpValue = 65408.0f;
+
+static uint32_t FloatToR9G9B9E5Scalar(const float* texel)
+{
+    float rgb[3];
+    for(uint32_t c = 0; c < 3; ++c)
+        rgb[c] = texel[c] > 0.0f ? std::min(texel[c], MaxSharedExpValue) : 0.0f;
+    const float maxValue = std::max(std::max(rgb[0], rgb[1]), rgb[2]);
+
+    // floor(log2(maxValue)) comes straight from the exponent bits, which avoids log2f() being off
+    // by one right below a power of two
+    int32_t exponent = std::max(int32_t(FloatBits(maxValue) >> 23) - 127, -16) + 1 + 15;
+    float scale = BitsToFloat(uint32_t(127 + 15 + 9 - exponent) << 23);
+
+    // Rounding the largest channel can carry it over to the next exponent
+    const float scaledMax = maxValue * scale;
+    if(scaledMax >= 511.5f)
+    {
+        ++exponent;
+        scale *= 0.5f;
+    }
+
+    uint32_t encoded = uint32_t(exponent) << 27;
+    for(uint32_t c = 0; c < 3; ++c)
+    {
+        const float scaled = rgb[c] * scale;
+        uint32_t mantissa = uint32_t(scaled);
+        mantissa += (scaled - float(mantissa)) >= 0.5f ? 1 : 0;
+        encoded |= mantissa << (c * 9);
+    }
+
+    return encoded;
+}
+
+void FloatToR9G9B9E5(const float* src, size_t stride, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        const __m128 maxValue = _mm_set1_ps(MaxSharedExpValue);
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 rgb[3];
+            LoadRGB4(src + i * stride, stride, rgb);
+            for(uint32_t c = 0; c < 3; ++c)
+                rgb[c] = _mm_min_ps(_mm_max_ps(rgb[c], _mm_setzero_ps()), maxValue);
+            const __m128 maxRGB = _mm_max_ps(_mm_max_ps(rgb[0], rgb[1]), rgb[2]);
+
+            __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxRGB), 23), _mm_set1_epi32(127));
+            exponent = Select(_mm_cmplt_epi32(exponent, _mm_set1_epi32(-16)), _mm_set1_epi32(-16), exponent);
+            exponent = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+            __m128i scaleBits = _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(127 + 15 + 9), exponent), 23);
+
+            const __m128i carry = _mm_castps_si128(_mm_cmpge_ps(_mm_mul_ps(maxRGB, _mm_castsi128_ps(scaleBits)),
+                                                                _mm_set1_ps(511.5f)));
+            exponent = _mm_sub_epi32(exponent, carry);
+            scaleBits = _mm_sub_epi32(scaleBits, _mm_and_si128(carry, _mm_set1_epi32(1 << 23)));
+            const __m128 scale = _mm_castsi128_ps(scaleBits);
+
+            __m128i encoded = _mm_slli_epi32(exponent, 27);
+            for(uint32_t c = 0; c < 3; ++c)
+            {
+                const __m128 scaled = _mm_mul_ps(rgb[c], scale);
+                __m128i mantissa = _mm_cvttps_epi32(scaled);
+                const __m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(mantissa));
+                mantissa = _mm_sub_epi32(mantissa, _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))));
+                encoded = _mm_or_si128(encoded, _mm_sll_epi32(mantissa, _mm_cvtsi32_si128(c * 9)));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), encoded);
+        }
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = FloatToR9G9B9E5Scalar(src + i * stride);
+}
+
+void R9G9B9E5ToFloat(const uint32_t* src, float* dst, size_t stride, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        for(; i + 4 <= count; i += 4)
+        {
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i scaleBits = _mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(packed, 27), _mm_set1_epi32(127 - 15 - 9)), 23);
+            const __m128 scale = _mm_castsi128_ps(scaleBits);
+            const __m128i mask = _mm_set1_epi32(0x1FF);
+
+            const __m128 rgb[3] =
+            {
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mask)), scale),
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 9), mask)), scale),
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 18), mask)), scale),
+            };
+            StoreRGB4(rgb, dst + i * stride, stride);
+        }
+    #endif
+
+    for(; i < count; ++i)
+    {
+        const float scale = BitsToFloat(((src[i] >> 27) + 127 - 15 - 9) << 23);
+        float* texel = dst + i * stride;
+        for(uint32_t c = 0; c < 3; ++c)
+            texel[c] = float((src[i] >> (c * 9)) & 0x1FF) * scale;
+    }
+}
+
+// == RGBE ========================================================================================
+
+// Channels are clamped to just under 2^127, which is the largest exponent that fits in a byte
+static const uint32_t MaxRGBEBits = 0x7EFFFFFF;
+static const float MinRGBEValue = 1e-32f;
+
+static uint32_t FloatToRGBEScalar(const float* texel)
+{
+    const float maxValue = BitsToFloat(MaxRGBEBits);
+    float rgb[3];
+    for(uint32_t c = 0; c < 3; ++c)
+        rgb[c] = texel[c] > 0.0f ? std::min(texel[c], maxValue) : 0.0f;
+    const float maxRGB = std::max(std::max(rgb[0], rgb[1]), rgb[2]);
+    if(maxRGB < MinRGBEValue)
+        return 0;
+
+    // This is frexp(maxRGB) with the scale being 2^(8 - exponent), straight from the float's bits
+    const uint32_t biasedExponent = FloatBits(maxRGB) >> 23;
+    const float scale = BitsToFloat((261 - biasedExponent) << 23);
+
+    uint32_t encoded = (biasedExponent + 2) << 24;
+    for(uint32_t c = 0; c < 3; ++c)
+        encoded |= uint32_t(rgb[c] * scale) << (c * 8);
+    return encoded;
+}
+
+// Each texel is multiplied by 2^(exponent - 136) in two steps, since that can be too small for a
+// normalized float
+static void RGBEScale(uint32_t exponent, float& scaleA, float& scaleB)
+{
+    scaleA = BitsToFloat(((exponent >> 1) + 127 - 68) << 23);
+    scaleB = BitsToFloat((((exponent + 1) >> 1) + 127 - 68) << 23);
+}
+
+void FloatToRGBE(const float* src, size_t stride, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        const __m128 maxValue = _mm_castsi128_ps(_mm_set1_epi32(MaxRGBEBits));
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 rgb[3];
+            LoadRGB4(src + i * stride, stride, rgb);
+            for(uint32_t c = 0; c < 3; ++c)
+                rgb[c] = _mm_min_ps(_mm_max_ps(rgb[c], _mm_setzero_ps()), maxValue);
+            const __m128 maxRGB = _mm_max_ps(_mm_max_ps(rgb[0], rgb[1]), rgb[2]);
+            const __m128i nonZero = _mm_castps_si128(_mm_cmpge_ps(maxRGB, _mm_set1_ps(MinRGBEValue)));
+
+            const __m128i biasedExponent = _mm_srli_epi32(_mm_castps_si128(maxRGB), 23);
+            const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(261), biasedExponent), 23));
+
+            __m128i encoded = _mm_slli_epi32(_mm_add_epi32(biasedExponent, _mm_set1_epi32(2)), 24);
+            encoded = _mm_or_si128(encoded, _mm_cvttps_epi32(_mm_mul_ps(rgb[0], scale)));
+            encoded = _mm_or_si128(encoded, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(rgb[1], scale)), 8));
+            encoded = _mm_or_si128(encoded, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(rgb[2], scale)), 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_and_si128(encoded, nonZero));
+        }
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = FloatToRGBEScalar(src + i * stride);
+}
+
+void RGBEToFloat(const uint32_t* src, float* dst, size_t stride, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        for(; i + 4 <= count; i += 4)
+        {
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i exponent = _mm_srli_epi32(packed, 24);
+            const __m128i isZero = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+            const __m128i bias = _mm_set1_epi32(127 - 68);
+            const __m128 scaleA = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(exponent, 1), bias), 23));
+            __m128i scaleB = _mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(1)), 1), bias), 23);
+            scaleB = _mm_andnot_si128(isZero, scaleB);
+
+            const __m128i mask = _mm_set1_epi32(0xFF);
+            __m128 rgb[3];
+            for(uint32_t c = 0; c < 3; ++c)
+            {
+                const __m128i mantissa = _mm_and_si128(_mm_srl_epi32(packed, _mm_cvtsi32_si128(c * 8)), mask);
+                rgb[c] = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(mantissa), scaleA), _mm_castsi128_ps(scaleB));
+            }
+            StoreRGB4(rgb, dst + i * stride, stride);
+        }
+    #endif
+
+    for(; i < count; ++i)
+    {
+        const uint32_t exponent = src[i] >> 24;
+        float scaleA, scaleB;
+        RGBEScale(exponent, scaleA, scaleB);
+        if(exponent == 0)
+            scaleB = 0.0f;
+
+        float* texel = dst + i * stride;
+        for(uint32_t c = 0; c < 3; ++c)
+            texel[c] = float((src[i] >> (c * 8)) & 0xFF) * scaleA * scaleB;
+    }
+}
+
+// == sRGB ========================================================================================
+
+static double SRGBToLinearExact(double srgb)
+{
+    if(srgb <= 0.04045)
+        return srgb / 12.92;
+    return pow((srgb + 0.055) / 1.055, 2.4);
+}
+
+// Linear values below 2^-13 always encode to 0, and the rest of [0, 1) is split into buckets by
+// the float's exponent and the top 8 bits of its mantissa. Each bucket stores what its lowest value
+// encodes to, and a bucket never spans more than one encoded value, so one comparison against the
+// next threshold gives the correctly rounded result.
+static const uint32_t SRGBMinExponent = 127 - 13;
+static const uint32_t SRGBNumBuckets = (127 - SRGBMinExponent) * 256;
+
+struct SRGBTables
+{
+    float ToLinear[256];
+    float UNormToFloat[256];
+    uint8_t ToLinear8[256];
+
+    // Thresholds[i] is the smallest float that encodes to i or more
+    float Thresholds[257];
+    uint8_t BucketStart[SRGBNumBuckets];
+
+    SRGBTables()
+    {
+        for(uint32_t i = 0; i < 256; ++i)
+        {
+            const double linear = SRGBToLinearExact(i / 255.0);
+            ToLinear[i] = float(linear);
+            UNormToFloat[i] = i / 255.0f;
+            ToLinear8[i] = uint8_t(linear * 255.0 + 0.5);
+        }
+
+        Thresholds[0] = 0.0f;
+        Thresholds[256] = 2.0f;
+        for(uint32_t i = 1; i < 256; ++i)
+        {
+            const double threshold = SRGBToLinearExact((i - 0.5) / 255.0);
+            uint32_t bits = FloatBits(float(threshold));
+            if(double(BitsToFloat(bits)) < threshold)
+                ++bits;
+            Thresholds[i] = BitsToFloat(bits);
+        }
+
+        uint32_t encoded = 0;
+        for(uint32_t i = 0; i < SRGBNumBuckets; ++i)
+        {
+            const float bucketStart = BitsToFloat((i + (SRGBMinExponent << 8)) << 15);
+            while(bucketStart >= Thresholds[encoded + 1])
+                ++encoded;
+            BucketStart[i] = uint8_t(encoded);
+        }
+    }
+};
+
+static const SRGBTables SRGB;
+
+static uint32_t LinearToSRGB8(float value)
+{
+    if(!(value >= BitsToFloat(SRGBMinExponent << 23)))
+        return 0;
+    if(value >= 1.0f)
+        return 255;
+
+    uint32_t encoded = SRGB.BucketStart[(FloatBits(value) >> 15) - (SRGBMinExponent << 8)];
+    encoded += value >= SRGB.Thresholds[encoded + 1] ? 1 : 0;
+    return encoded;
+}
+
+static uint32_t FloatToUNorm8Scalar(float value)
+{
+    // The multiply is exact in double precision, and 255 * x can't land exactly halfway between
+    // two integers, so rounding half up is the same as rounding to nearest even
+    return uint32_t(double(Saturate(value)) * 255.0 + 0.5);
+}
+
+void SRGBA8ToFloat(const uint32_t* src, float* dst, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        const uint32_t texel = src[i];
+        dst[i * 4 + 0] = SRGB.ToLinear[texel & 0xFF];
+        dst[i * 4 + 1] = SRGB.ToLinear[(texel >> 8) & 0xFF];
+        dst[i * 4 + 2] = SRGB.ToLinear[(texel >> 16) & 0xFF];
+        dst[i * 4 + 3] = SRGB.UNormToFloat[texel >> 24];
+    }
+}
+
+void FloatToSRGBA8(const float* src, uint32_t* dst, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        const float* texel = src + i * 4;
+        dst[i] = LinearToSRGB8(texel[0]) | (LinearToSRGB8(texel[1]) << 8) | (LinearToSRGB8(texel[2]) << 16)
+                 | (FloatToUNorm8Scalar(texel[3]) << 24);
+    }
+}
+
+void SRGBA8ToLinearRGBA8(const uint32_t* src, uint32_t* dst, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        const uint32_t texel = src[i];
+        dst[i] = SRGB.ToLinear8[texel & 0xFF] | (SRGB.ToLinear8[(texel >> 8) & 0xFF] << 8)
+                 | (SRGB.ToLinear8[(texel >> 16) & 0xFF] << 16) | (texel & 0xFF000000);
+    }
+}
+
+// == UNORM =======================================================================================
+
+#if PC_X86_
+
+static size_t UNorm8ToFloatSSE2(const uint8_t* src, float* dst, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+        _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+    }
+
+    return i;
+}
+
+static size_t FloatToUNorm8SSE2(const float* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i low = RoundToUNorm4(Saturate4(_mm_loadu_ps(src + i)), 255.0);
+        const __m128i high = RoundToUNorm4(Saturate4(_mm_loadu_ps(src + i + 4)), 255.0);
+        const __m128i words = _mm_packs_epi32(low, high);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(words, words));
+    }
+
+    return i;
+}
+
+static size_t UNorm16ToFloatSSE2(const uint16_t* src, float* dst, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(65535.0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale));
+    }
+
+    return i;
+}
+
+static size_t FloatToUNorm16SSE2(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i low = RoundToUNorm4(Saturate4(_mm_loadu_ps(src + i)), 65535.0);
+        const __m128i high = RoundToUNorm4(Saturate4(_mm_loadu_ps(src + i + 4)), 65535.0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), PackUInt16(low, high));
+    }
+
+    return i;
+}
+
+PC_AVX2_FUNCTION_ static size_t UNorm8ToFloatAVX2(const uint8_t* src, float* dst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(255.0f);
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m256i low = _mm256_cvtepu8_epi32(bytes);
+        const __m256i high = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+        _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_cvtepi32_ps(low), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_div_ps(_mm256_cvtepi32_ps(high), scale));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+PC_AVX2_FUNCTION_ static size_t FloatToUNorm8AVX2(const float* src, uint8_t* dst, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256d scale = _mm256_set1_pd(255.0);
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i values[4];
+        for(uint32_t j = 0; j < 2; ++j)
+        {
+            const __m256 saturated = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + j * 8), zero), one);
+            const __m256d low = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(saturated)), scale);
+            const __m256d high = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(saturated, 1)), scale);
+            values[j * 2 + 0] = _mm256_cvtpd_epi32(low);
+            values[j * 2 + 1] = _mm256_cvtpd_epi32(high);
+        }
+
+        const __m128i words0 = _mm_packs_epi32(values[0], values[1]);
+        const __m128i words1 = _mm_packs_epi32(values[2], values[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(words0, words1));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+PC_AVX2_FUNCTION_ static size_t UNorm16ToFloatAVX2(const uint16_t* src, float* dst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(65535.0f);
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        const __m256i low = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        const __m256i high = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+        _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_cvtepi32_ps(low), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_div_ps(_mm256_cvtepi32_ps(high), scale));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+PC_AVX2_FUNCTION_ static size_t FloatToUNorm16AVX2(const float* src, uint16_t* dst, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256d scale = _mm256_set1_pd(65535.0);
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m256 saturated = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), zero), one);
+        const __m256d low = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(saturated)), scale);
+        const __m256d high = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(saturated, 1)), scale);
+        const __m128i words = _mm_packus_epi32(_mm256_cvtpd_epi32(low), _mm256_cvtpd_epi32(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), words);
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+#endif
+
+void UNorm8ToFloat(const uint8_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.AVX2 ? UNorm8ToFloatAVX2(src, dst, count) : UNorm8ToFloatSSE2(src, dst, count);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = SRGB.UNormToFloat[src[i]];
+}
+
+void FloatToUNorm8(const float* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.AVX2 ? FloatToUNorm8AVX2(src, dst, count) : FloatToUNorm8SSE2(src, dst, count);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = uint8_t(FloatToUNorm8Scalar(src[i]));
+}
+
+void UNorm16ToFloat(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.AVX2 ? UNorm16ToFloatAVX2(src, dst, count) : UNorm16ToFloatSSE2(src, dst, count);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = src[i] / 65535.0f;
+}
+
+void FloatToUNorm16(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    #if PC_X86_
+        i = Features.AVX2 ? FloatToUNorm16AVX2(src, dst, count) : FloatToUNorm16SSE2(src, dst, count);
+    #endif
+
+    for(; i < count; ++i)
+        dst[i] = uint16_t(double(Saturate(src[i])) * 65535.0 + 0.5);
+}
+
+}
+
+}
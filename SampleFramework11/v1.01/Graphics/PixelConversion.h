@@ -0,0 +1,72 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// Conversions between the pixel formats that the framework reads and writes on the CPU, working on
+// spans of values. Half floats use F16C and the UNORM formats use AVX2 when the CPU has them, with
+// SSE2 or scalar code otherwise, and every path gives the same results. Like BCDecoder.h this is
+// platform-neutral and doesn't include PCH.h.
+//
+// Float to half, R11G11B10 and UNORM conversions round to nearest even, sRGB encoding is correctly
+// rounded, and decoding is exact. Converting NaN to a UNORM or sRGB format gives 0.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace SampleFramework11
+{
+
+namespace PixelConversion
+{
+
+// Half floats. Values past the range of a half become infinity, or are clamped to +/-65504 when
+// saturate is set. NaN stays NaN, and is made quiet.
+void FloatToHalf(const float* src, uint16_t* dst, size_t count, bool saturate = false);
+void HalfToFloat(const uint16_t* src, float* dst, size_t count);
+
+// The packed RGB formats convert count texels, reading or writing 3 floats per texel with stride
+// floats between texels (3 for Float3, 4 for Float4, where decoding leaves alpha alone).
+
+// DXGI_FORMAT_R11G11B10_FLOAT. Negative values become 0, and finite values that are too large are
+// clamped to the largest finite value, which is what XMStoreFloat3PK does.
+void FloatToR11G11B10(const float* src, size_t stride, uint32_t* dst, size_t count);
+void R11G11B10ToFloat(const uint32_t* src, float* dst, size_t stride, size_t count);
+
+// DXGI_FORMAT_R9G9B9E5_SHAREDEXP, encoded the way the D3D spec describes, with the mantissas
+// rounded to nearest relative to the shared exponent
+void FloatToR9G9B9E5(const float* src, size_t stride, uint32_t* dst, size_t count);
+void R9G9B9E5ToFloat(const uint32_t* src, float* dst, size_t stride, size_t count);
+
+// Radiance RGBE, as stored in .hdr files: 8-bit mantissas for R, G and B from the lowest byte up,
+// with a shared exponent in the top byte. Mantissas are truncated like the reference encoder does.
+void FloatToRGBE(const float* src, size_t stride, uint32_t* dst, size_t count);
+void RGBEToFloat(const uint32_t* src, float* dst, size_t stride, size_t count);
+
+// 8-bit sRGB RGBA texels, with R in the lowest byte and linear alpha, to and from 4 floats per
+// texel. These are table-driven rather than vectorized.
+void SRGBA8ToFloat(const uint32_t* src, float* dst, size_t count);
+void FloatToSRGBA8(const float* src, uint32_t* dst, size_t count);
+
+// Decodes the RGB channels of sRGB texels and rounds them back to 8-bit UNORM
+void SRGBA8ToLinearRGBA8(const uint32_t* src, uint32_t* dst, size_t count);
+
+// UNORM values. Encoding clamps to [0, 1].
+void UNorm8ToFloat(const uint8_t* src, float* dst, size_t count);
+void FloatToUNorm8(const float* src, uint8_t* dst, size_t count);
+void UNorm16ToFloat(const uint16_t* src, float* dst, size_t count);
+void FloatToUNorm16(const float* src, uint16_t* dst, size_t count);
+
+// Which of the optional code paths this CPU can use
+bool HasF16C();
+bool HasAVX2();
+
+}
+
+}
@@ -119,6 +119,18 @@ SH9Color ProjectCubemapToSH(ID3D11Device* device, ID3D11ShaderResourceView* cube
 {
     TextureData<Float4> textureData;
     GetTextureData(device, cubeMap, textureData);
+    return ProjectCubemapToSH(textureData);
+}
+
+SH9Color ProjectCubemapToSH(const wchar* ddsFilePath)
+{
+    TextureData<Float4> textureData;
+    GetTextureData(ddsFilePath, textureData);
+    return ProjectCubemapToSH(textureData);
+}
+
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& textureData)
+{
     Assert_(textureData.NumSlices == 6);
     const uint32 width = textureData.Width;
     const uint32 height = textureData.Height;
@@ -16,6 +16,8 @@
 namespace SampleFramework11
 {
 
+template<typename T> struct TextureData;
+
 // Constants
 static const float CosineA0 = 1.0f;
 static const float CosineA1 = 2.0f / 3.0f;
@@ -226,6 +228,10 @@ H4 ConvertToH4(const SH9& sh);
 
 // Lighting environment generation functions
 SH9Color ProjectCubemapToSH(ID3D11Device* device, ID3D11ShaderResourceView* cubeMap);
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& cubeMap);
+
+// Decodes the cube map on the CPU, so no device is needed
+SH9Color ProjectCubemapToSH(const wchar* ddsFilePath);
 
 // Constants
 static const H4 H4Identity = H4(std::sqrt(2.0f * 3.14159f), 0.0f, 0.0f, 0.0f);
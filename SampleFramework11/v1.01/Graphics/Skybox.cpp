@@ -14,6 +14,7 @@
 #include "..\\Utility.h"
 #include "ShaderCompilation.h"
 #include "Textures.h"
+#include "MipGenerator.h"
 #include "Math.h"
 
 namespace SampleFramework11
@@ -320,8 +321,8 @@ void Skybox::RenderSky(ID3D11DeviceContext* context,
     if(skyCache.CubeMap == nullptr)
     {
         const uint64 CubeMapRes = 128;
-        std::vector<Float4> texels;
-        texels.resize(CubeMapRes * CubeMapRes * 6);
+        TextureData<Float4> cubeMapData;
+        cubeMapData.Init(uint32(CubeMapRes), uint32(CubeMapRes), 6);
 
         for(uint64 s = 0; s < 6; ++s)
         {
@@ -333,38 +334,18 @@ void Skybox::RenderSky(ID3D11DeviceContext* context,
                     Float3 radiance = SampleSky(skyCache, dir);
 
                     uint64 idx = (s * CubeMapRes * CubeMapRes) + (y * CubeMapRes) + x;
-                    texels[idx] = Float4(radiance, 1.0f);
+                    cubeMapData.Texels[idx] = Float4(radiance, 1.0f);
                 }
             }
         }
 
-        D3D11_TEXTURE2D_DESC desc;
-        desc.Width = uint32(CubeMapRes);
-        desc.Height = uint32(CubeMapRes);
-        desc.ArraySize = 6;
-        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        desc.CPUAccessFlags = 0;
-        desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        desc.MipLevels = 1;
-        desc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
-        desc.SampleDesc.Count = 1;
-        desc.SampleDesc.Quality = 0;
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-
-        D3D11_SUBRESOURCE_DATA resData[6];
-        for(uint64 i = 0; i < 6; ++i)
-        {
-            resData[i].pSysMem = &texels[i * CubeMapRes * CubeMapRes];
-            resData[i].SysMemPitch = sizeof(texels[0]) * CubeMapRes;
-            resData[i].SysMemSlicePitch = 0;
-        }
+        // Box filtering keeps the bright area around the horizon from ringing in the lower mips
+        GenerateMips(cubeMapData, MipFilter::Box, false, true);
 
         ID3D11DevicePtr device;
         context->GetDevice(&device);
 
-        ID3D11Texture2DPtr texture;
-        DXCall(device->CreateTexture2D(&desc, resData, &texture));
-        DXCall(device->CreateShaderResourceView(texture, nullptr, &skyCache.CubeMap));
+        skyCache.CubeMap = CreateSRVFromTextureData(device, cubeMapData, true);
     }
 
     // Set the pixel shader constants
@@ -18,16 +18,41 @@
 #include "ShaderCompilation.h"
 #include "GraphicsTypes.h"
 #include "TinyEXR.h"
+#include "BCDecoder.h"
+#include "BCEncoder.h"
+#include "MipGenerator.h"
+#include "PixelConversion.h"
+#include "..\\ThreadPool.h"
+#include "..\\Timer.h"
 
 namespace SampleFramework11
 {
 
     // Loads a texture, using either the DDS loader or the WIC loader
-ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB)
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB,
+                                        TextureCompression compression)
 {
     ID3D11DeviceContextPtr context;
     device->GetImmediateContext(&context);
 
+    return LoadTexture(device, context, filePath, forceSRGB, compression);
+}
+
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, ID3D11DeviceContext* context, const wchar* filePath,
+                                        bool forceSRGB, TextureCompression compression)
+{
+    return TextureCache::Global.Load(device, context, filePath, forceSRGB, compression);
+}
+
+static ID3D11ShaderResourceViewPtr LoadCompressedTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB,
+                                                         TextureCompression compression,
+                                                         TextureCompressionStats* compressionStats);
+
+ID3D11ShaderResourceViewPtr LoadTextureUncached(ID3D11Device* device, ID3D11DeviceContext* context,
+                                                const wchar* filePath, bool forceSRGB,
+                                                TextureCompression compression,
+                                                TextureCompressionStats* compressionStats)
+{
     ID3D11ResourcePtr resource;
     ID3D11ShaderResourceViewPtr srv;
 
@@ -39,6 +64,10 @@ ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* fileP
                                                    &resource, &srv, nullptr));
         return srv;
     }
+    else if(compression != TextureCompression::None)
+    {
+        return LoadCompressedTexture(device, filePath, forceSRGB, compression, compressionStats);
+    }
     else
     {
         DXCall(DirectX:: CreateWICTextureFromFileEx(device, context, filePath, 0, D3D11_USAGE_DEFAULT,
@@ -48,6 +77,428 @@ ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* fileP
     }
 }
 
+// == TextureCache ================================================================================
+
+TextureCache TextureCache::Global;
+
+// Builds the key for a texture, using the full path so that different relative paths to the same
+// file end up sharing it. Paths are case-insensitive on Windows, so the key is in lower case.
+static std::wstring TextureCacheKey(const wchar* filePath, bool forceSRGB, TextureCompression compression)
+{
+    std::wstring key;
+    const DWORD pathLength = GetFullPathNameW(filePath, 0, nullptr, nullptr);
+    if(pathLength > 0)
+    {
+        key.resize(pathLength);
+        key.resize(GetFullPathNameW(filePath, pathLength, &key[0], nullptr));
+    }
+    else
+        key = filePath;
+
+    if(key.length() > 0)
+        CharLowerBuffW(&key[0], DWORD(key.length()));
+
+    key += forceSRGB ? L"|srgb" : L"|linear";
+    if(compression != TextureCompression::None)
+        key += L"|bc" + ToString(uint32(compression));
+    return key;
+}
+
+// Returns the size of a single array slice with the given number of mips
+static uint64 MipChainSize(DXGI_FORMAT format, uint32 width, uint32 height, uint32 depth, uint32 numMips)
+{
+    uint64 numBytes = 0;
+    for(uint32 mipIdx = 0; mipIdx < numMips; ++mipIdx)
+    {
+        size_t rowPitch = 0;
+        size_t slicePitch = 0;
+        DirectX::ComputePitch(format, std::max(width >> mipIdx, 1u), std::max(height >> mipIdx, 1u),
+                              rowPitch, slicePitch);
+        numBytes += uint64(slicePitch) * std::max(depth >> mipIdx, 1u);
+    }
+
+    return numBytes;
+}
+
+// Returns the size of the texture's data, including all of its mips and array slices
+static uint64 TextureMemorySize(ID3D11ShaderResourceView* srv)
+{
+    ID3D11ResourcePtr resource;
+    srv->GetResource(&resource);
+
+    D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    resource->GetType(&dimension);
+
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    uint32 width = 1;
+    uint32 height = 1;
+    uint32 depth = 1;
+    uint32 numMips = 1;
+    uint32 numSlices = 1;
+    if(dimension == D3D11_RESOURCE_DIMENSION_TEXTURE1D)
+    {
+        D3D11_TEXTURE1D_DESC desc;
+        ID3D11Texture1DPtr(resource)->GetDesc(&desc);
+        format = desc.Format;
+        width = desc.Width;
+        numMips = desc.MipLevels;
+        numSlices = desc.ArraySize;
+    }
+    else if(dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        ID3D11Texture2DPtr(resource)->GetDesc(&desc);
+        format = desc.Format;
+        width = desc.Width;
+        height = desc.Height;
+        numMips = desc.MipLevels;
+        numSlices = desc.ArraySize;
+    }
+    else if(dimension == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+    {
+        D3D11_TEXTURE3D_DESC desc;
+        ID3D11Texture3DPtr(resource)->GetDesc(&desc);
+        format = desc.Format;
+        width = desc.Width;
+        height = desc.Height;
+        depth = desc.Depth;
+        numMips = desc.MipLevels;
+    }
+    else
+        return 0;
+
+    return MipChainSize(format, width, height, depth, numMips) * numSlices;
+}
+
+ID3D11ShaderResourceViewPtr TextureCache::Load(ID3D11Device* device, ID3D11DeviceContext* context,
+                                               const wchar* filePath, bool forceSRGB,
+                                               TextureCompression compression)
+{
+    const std::wstring key = TextureCacheKey(filePath, forceSRGB, compression);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = entries.find(key);
+        if(entry != entries.end())
+        {
+            ++stats.NumHits;
+            stats.NumBytesSaved += entry->second.NumBytes;
+            return entry->second.SRV;
+        }
+    }
+
+    // Decode outside of the lock, so that other threads can keep loading
+    CacheEntry newEntry;
+    TextureCompressionStats compressionStats;
+    newEntry.SRV = LoadTextureUncached(device, context, filePath, forceSRGB, compression, &compressionStats);
+    newEntry.NumBytes = TextureMemorySize(newEntry.SRV);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.Compression += compressionStats;
+    auto inserted = entries.insert(std::make_pair(key, newEntry));
+    if(inserted.second)
+    {
+        ++stats.NumMisses;
+        ++stats.NumTextures;
+        stats.NumBytes += newEntry.NumBytes;
+    }
+    else
+    {
+        // Another thread finished loading the same texture first
+        ++stats.NumHits;
+        stats.NumBytesSaved += newEntry.NumBytes;
+    }
+
+    return inserted.first->second.SRV;
+}
+
+uint64 TextureCache::Trim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64 numReleased = 0;
+    for(auto entry = entries.begin(); entry != entries.end();)
+    {
+        // The SRV holds a reference to its texture, so the cache's reference is the only one
+        // left if the count is back to 1 after the AddRef/Release pair
+        ID3D11ShaderResourceView* srv = entry->second.SRV;
+        srv->AddRef();
+        if(srv->Release() == 1)
+        {
+            --stats.NumTextures;
+            stats.NumBytes -= entry->second.NumBytes;
+            entry = entries.erase(entry);
+            ++numReleased;
+        }
+        else
+            ++entry;
+    }
+
+    return numReleased;
+}
+
+void TextureCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    stats.NumTextures = 0;
+    stats.NumBytes = 0;
+}
+
+TextureCacheStats TextureCache::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+// == CPU Decoding ================================================================================
+
+// Converts the output of BC::DecodeRows to the type stored in a TextureData. sRGB values are
+// converted to linear, to match what the GPU returns when sampling them.
+static void ConvertTexels(const uint32* src, bool srgb, UByte4N* dst, uint64 numTexels)
+{
+    if(srgb)
+        PixelConversion::SRGBA8ToLinearRGBA8(src, &dst[0].Bits, size_t(numTexels));
+    else
+        memcpy(dst, src, numTexels * sizeof(uint32));
+}
+
+static void ConvertTexels(const uint32* src, bool srgb, Float4* dst, uint64 numTexels)
+{
+    if(srgb)
+        PixelConversion::SRGBA8ToFloat(src, &dst[0].x, size_t(numTexels));
+    else
+        PixelConversion::UNorm8ToFloat(reinterpret_cast<const uint8*>(src), &dst[0].x, size_t(numTexels * 4));
+}
+
+static void ConvertTexels(const Float4* src, Half4* dst, uint64 numTexels)
+{
+    PixelConversion::FloatToHalf(&src[0].x, &dst[0].x, size_t(numTexels * 4));
+}
+
+static void ConvertTexels(const uint32* src, bool srgb, Half4* dst, uint64 numTexels)
+{
+    // Goes through floats, a chunk at a time
+    const uint64 ChunkSize = 256;
+    Float4 floats[ChunkSize];
+    for(uint64 start = 0; start < numTexels; start += ChunkSize)
+    {
+        const uint64 count = std::min(numTexels - start, ChunkSize);
+        ConvertTexels(src + start, srgb, floats, count);
+        ConvertTexels(floats, dst + start, count);
+    }
+}
+
+static void ConvertTexels(const Float4* src, Float4* dst, uint64 numTexels)
+{
+    memcpy(dst, src, numTexels * sizeof(Float4));
+}
+
+static void ConvertTexels(const Float4* src, UByte4N* dst, uint64 numTexels)
+{
+    PixelConversion::FloatToUNorm8(&src[0].x, reinterpret_cast<uint8*>(dst), size_t(numTexels * 4));
+}
+
+// Decodes the top mip of each array slice on the CPU. The slices are split into bands that are one
+// row of blocks tall (or one row of texels for uncompressed formats), which are spread across the
+// thread pool.
+template<typename T>
+static void DecodeTextureData(DXGI_FORMAT format, const DDS::Subresource* slices, uint32 numSlices,
+                              bool forceSRGB, TextureData<T>& texData)
+{
+    const BC::OutputType outputType = BC::GetOutputType(format);
+    if(outputType == BC::OutputType::None)
+        throw Exception(L"Textures with DXGI format " + ToString(uint32(format)) + L" can't be decoded on the CPU");
+
+    const uint32 width = slices[0].Width;
+    const uint32 height = slices[0].Height;
+    texData.Init(width, height, numSlices);
+
+    const bool srgb = BC::IsSRGB(format) || forceSRGB;
+    const uint32 bandHeight = BC::IsBlockCompressed(format) ? 4 : 1;
+    const uint32 numBands = (height + bandHeight - 1) / bandHeight;
+    const uint64 decodedTexelSize = outputType == BC::OutputType::Float ? sizeof(Float4) : sizeof(uint32);
+
+    std::vector<std::vector<uint8>> scratch(NumWorkerThreads());
+    ParallelFor(uint64(numBands) * numSlices, 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        std::vector<uint8>& decoded = scratch[threadIdx];
+        decoded.resize(width * bandHeight * decodedTexelSize);
+
+        for(uint64 bandIdx = start; bandIdx < end; ++bandIdx)
+        {
+            const uint32 sliceIdx = uint32(bandIdx / numBands);
+            const uint32 bandY = uint32(bandIdx % numBands);
+            const uint32 y = bandY * bandHeight;
+            const uint32 numRows = std::min(bandHeight, height - y);
+
+            const DDS::Subresource& slice = slices[sliceIdx];
+            BC::DecodeRows(format, slice.Data + bandY * slice.RowPitch, slice.RowPitch, width, numRows,
+                           decoded.data(), width * decodedTexelSize);
+
+            T* dst = &texData.Texels[(uint64(sliceIdx) * height + y) * width];
+            const uint64 numTexels = uint64(width) * numRows;
+            if(outputType == BC::OutputType::Float)
+                ConvertTexels(reinterpret_cast<const Float4*>(decoded.data()), dst, numTexels);
+            else
+                ConvertTexels(reinterpret_cast<const uint32*>(decoded.data()), srgb, dst, numTexels);
+        }
+    });
+}
+
+template<typename T>
+static void GetTextureData(const wchar* filePath, bool forceSRGB, TextureData<T>& texData)
+{
+    DDS::MappedFile file;
+    if(file.Open(filePath) == false)
+        throw Win32Exception(GetLastError(), (L"Failed to open " + std::wstring(filePath) + L": ").c_str());
+
+    DDS::Texture dds;
+    if(DDS::Parse(file.Data(), file.Size(), dds) != DDS::Result::Ok)
+        throw Exception(L"Failed to parse DDS file " + std::wstring(filePath));
+
+    if(dds.ResourceDimension == DDS::ResourceDimensionTexture3D)
+        throw Exception(L"Volume textures can't be decoded on the CPU (" + std::wstring(filePath) + L")");
+
+    std::vector<DDS::Subresource> subresources(dds.MipCount * dds.ArraySize);
+    size_t width = 0;
+    size_t height = 0;
+    size_t depth = 0;
+    size_t skipMip = 0;
+    if(DDS::GetSubresources(dds, 0, subresources.data(), width, height, depth, skipMip) != DDS::Result::Ok)
+        throw Exception(L"DDS file " + std::wstring(filePath) + L" is truncated");
+
+    // Subresources are ordered by array slice and then by mip, and only the top mips are decoded
+    std::vector<DDS::Subresource> slices(dds.ArraySize);
+    for(uint32 i = 0; i < dds.ArraySize; ++i)
+        slices[i] = subresources[i * dds.MipCount];
+
+    DecodeTextureData(dds.Format, slices.data(), dds.ArraySize, forceSRGB, texData);
+}
+
+void GetTextureData(const wchar* ddsFilePath, TextureData<UByte4N>& textureData, bool forceSRGB)
+{
+    GetTextureData(ddsFilePath, forceSRGB, textureData);
+}
+
+void GetTextureData(const wchar* ddsFilePath, TextureData<Half4>& textureData, bool forceSRGB)
+{
+    GetTextureData(ddsFilePath, forceSRGB, textureData);
+}
+
+void GetTextureData(const wchar* ddsFilePath, TextureData<Float4>& textureData, bool forceSRGB)
+{
+    GetTextureData(ddsFilePath, forceSRGB, textureData);
+}
+
+// == EXR Decoding ================================================================================
+
+template<typename T>
+static void LoadEXRTextureData(const wchar* filePath, int pixelType, uint32 x, uint32 y, uint32 width,
+                               uint32 height, uint32 mipLevel, TextureData<T>& texData)
+{
+    DDS::MappedFile file;
+    if(file.Open(filePath) == false)
+        throw Win32Exception(GetLastError(), (L"Failed to open " + std::wstring(filePath) + L": ").c_str());
+
+    // A size of 0 means the whole mip level
+    const char* errorString = nullptr;
+    if(width == 0 || height == 0)
+    {
+        int fileWidth = 0;
+        int fileHeight = 0;
+        if(GetEXRSizeFromMemory(file.Data(), file.Size(), &fileWidth, &fileHeight, &errorString) != 0)
+            throw Exception(L"Failed to load EXR file " + std::wstring(filePath) + L": " + AnsiToWString(errorString));
+
+        width = std::max(uint32(fileWidth) >> mipLevel, 1u);
+        height = std::max(uint32(fileHeight) >> mipLevel, 1u);
+    }
+
+    texData.Init(width, height, 1);
+
+    T& firstTexel = texData.Texels[0];
+    void* channels[4] = { &firstTexel.x, &firstTexel.y, &firstTexel.z, &firstTexel.w };
+    const char* channelNames[4] = { "R", "G", "B", "A" };
+    const float fillValues[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    EXRStridedRegion region;
+    region.num_channels = 4;
+    region.channel_names = channelNames;
+    region.channels = channels;
+    region.fill_values = fillValues;
+    region.pixel_stride = 4;
+    region.pixel_type = pixelType;
+    region.x = int(x << mipLevel);
+    region.y = int(y << mipLevel);
+    region.width = int(width);
+    region.height = int(height);
+    region.level = int(mipLevel);
+
+    if(LoadStridedEXRFromMemory(&region, file.Data(), file.Size(), &errorString) != 0)
+        throw Exception(L"Failed to load EXR file " + std::wstring(filePath) + L": " + AnsiToWString(errorString));
+}
+
+void LoadEXRTextureData(const wchar* exrFilePath, TextureData<Half4>& textureData, uint32 mipLevel)
+{
+    LoadEXRTextureData(exrFilePath, 1, 0, 0, 0, 0, mipLevel, textureData);
+}
+
+void LoadEXRTextureData(const wchar* exrFilePath, TextureData<Float4>& textureData, uint32 mipLevel)
+{
+    LoadEXRTextureData(exrFilePath, 2, 0, 0, 0, 0, mipLevel, textureData);
+}
+
+void LoadEXRTextureData(const wchar* exrFilePath, uint32 x, uint32 y, uint32 width, uint32 height,
+                        TextureData<Half4>& textureData, uint32 mipLevel)
+{
+    Assert_(width > 0 && height > 0);
+    LoadEXRTextureData(exrFilePath, 1, x, y, width, height, mipLevel, textureData);
+}
+
+void LoadEXRTextureData(const wchar* exrFilePath, uint32 x, uint32 y, uint32 width, uint32 height,
+                        TextureData<Float4>& textureData, uint32 mipLevel)
+{
+    Assert_(width > 0 && height > 0);
+    LoadEXRTextureData(exrFilePath, 2, x, y, width, height, mipLevel, textureData);
+}
+
+// == GPU Readback ================================================================================
+
+// Copies the top mip of a texture to a staging texture and decodes it on the CPU, for formats that
+// BC::DecodeRows supports
+template<typename T>
+static void ReadbackAndDecode(ID3D11Device* device, ID3D11Texture2D* texture, DXGI_FORMAT viewFormat,
+                              TextureData<T>& texData)
+{
+    D3D11_TEXTURE2D_DESC texDesc;
+    texture->GetDesc(&texDesc);
+
+    ID3D11DeviceContextPtr context;
+    device->GetImmediateContext(&context);
+
+    StagingTexture2D stagingTexture;
+    stagingTexture.Initialize(device, texDesc.Width, texDesc.Height, texDesc.Format, 1, 1, 0, texDesc.ArraySize);
+    for(uint32 slice = 0; slice < texDesc.ArraySize; ++slice)
+        context->CopySubresourceRegion(stagingTexture.Texture, slice, 0, 0, 0, texture,
+                                       D3D11CalcSubresource(0, slice, texDesc.MipLevels), nullptr);
+
+    std::vector<DDS::Subresource> slices(texDesc.ArraySize);
+    for(uint32 slice = 0; slice < texDesc.ArraySize; ++slice)
+    {
+        uint32 pitch = 0;
+        slices[slice].Data = reinterpret_cast<const uint8*>(stagingTexture.Map(context, slice, pitch));
+        slices[slice].RowPitch = pitch;
+        slices[slice].Width = texDesc.Width;
+        slices[slice].Height = texDesc.Height;
+        slices[slice].Depth = 1;
+    }
+
+    DecodeTextureData(viewFormat, slices.data(), texDesc.ArraySize, false, texData);
+
+    for(uint32 slice = 0; slice < texDesc.ArraySize; ++slice)
+        stagingTexture.Unmap(context, slice);
+}
+
 template<typename T>
 static void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
                            DXGI_FORMAT outFormat, TextureData<T>& texData)
@@ -57,6 +508,22 @@ static void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textu
 
     static const uint32 TGSize = 16;
 
+    ID3D11Texture2DPtr texture;
+    textureSRV->GetResource(reinterpret_cast<ID3D11Resource**>(&texture));
+
+    D3D11_TEXTURE2D_DESC texDesc;
+    texture->GetDesc(&texDesc);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    textureSRV->GetDesc(&srvDesc);
+
+    // Only formats that the CPU can't decode need the compute shader
+    if(BC::GetOutputType(srvDesc.Format) != BC::OutputType::None && texDesc.SampleDesc.Count == 1)
+    {
+        ReadbackAndDecode(device, texture, srvDesc.Format, texData);
+        return;
+    }
+
     if(decodeTextureCS.Valid() == false)
     {
         CompileOptions opts;
@@ -67,15 +534,6 @@ static void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textu
         decodeTextureArrayCS = CompileCSFromFile(device, shaderPath.c_str(), "DecodeTextureArrayCS", "cs_5_0", opts);
     }
 
-    ID3D11Texture2DPtr texture;
-    textureSRV->GetResource(reinterpret_cast<ID3D11Resource**>(&texture));
-
-    D3D11_TEXTURE2D_DESC texDesc;
-    texture->GetDesc(&texDesc);
-
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-    textureSRV->GetDesc(&srvDesc);
-
     ID3D11ShaderResourceViewPtr sourceSRV = textureSRV;
     uint32 arraySize = texDesc.ArraySize;
     if(srvDesc.ViewDimension == D3D11_SRV_DIMENSION_TEXTURECUBE
@@ -167,43 +625,136 @@ void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
     GetTextureData(device, textureSRV, DXGI_FORMAT_R8G8B8A8_UNORM, textureData);
 }
 
+// Converts texels to one of the formats that CreateSRVFromTextureData() can upload them as,
+// returning false if the format isn't one of them
+static bool PackTexels(const Float4* src, DXGI_FORMAT format, void* dst, uint64 numTexels)
+{
+    const float* floats = &src[0].x;
+    const size_t count = size_t(numTexels);
+    switch(format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        memcpy(dst, src, numTexels * sizeof(Float4));
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        PixelConversion::FloatToHalf(floats, reinterpret_cast<uint16*>(dst), count * 4);
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        PixelConversion::FloatToUNorm16(floats, reinterpret_cast<uint16*>(dst), count * 4);
+        return true;
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        PixelConversion::FloatToR11G11B10(floats, 4, reinterpret_cast<uint32*>(dst), count);
+        return true;
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        PixelConversion::FloatToR9G9B9E5(floats, 4, reinterpret_cast<uint32*>(dst), count);
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        PixelConversion::FloatToUNorm8(floats, reinterpret_cast<uint8*>(dst), count * 4);
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        PixelConversion::FloatToSRGBA8(floats, reinterpret_cast<uint32*>(dst), count);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool PackTexels(const Half4* src, DXGI_FORMAT format, void* dst, uint64 numTexels)
+{
+    // Goes through floats, a chunk at a time
+    const uint64 ChunkSize = 256;
+    Float4 floats[ChunkSize];
+    const uint64 texelSize = BitsPerPixel(format) / 8;
+    for(uint64 start = 0; start < numTexels; start += ChunkSize)
+    {
+        const uint64 count = std::min(numTexels - start, ChunkSize);
+        PixelConversion::HalfToFloat(&src[start].x, &floats[0].x, size_t(count * 4));
+        if(PackTexels(floats, format, reinterpret_cast<uint8*>(dst) + start * texelSize, count) == false)
+            return false;
+    }
+
+    return true;
+}
+
+static bool PackTexels(const UByte4N* src, DXGI_FORMAT format, void* dst, uint64 numTexels)
+{
+    return false;
+}
+
 template<typename T>
-static ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<T>& textureData)
+static ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<T>& textureData,
+                                                            bool cubeMap, DXGI_FORMAT format)
 {
-    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    DXGI_FORMAT texelFormat = DXGI_FORMAT_UNKNOWN;
     if(typeid(T) == typeid(UByte4N))
-        format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texelFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
     else if(typeid(T) == typeid(Half4))
-        format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        texelFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
     else if(typeid(T) == typeid(Float4))
-        format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        texelFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
 
-    Assert_(format != DXGI_FORMAT_UNKNOWN);
+    Assert_(texelFormat != DXGI_FORMAT_UNKNOWN);
+    if(format == DXGI_FORMAT_UNKNOWN)
+        format = texelFormat;
 
-    const uint64 elemSize = sizeof(T);
+    const uint32 numMips = std::max(textureData.NumMips, 1u);
     Assert_(textureData.Texels.size() > 0);
-    Assert_(textureData.Width * textureData.Height * textureData.NumSlices == textureData.Texels.size());
+    Assert_(textureData.MipOffset(numMips) == textureData.Texels.size());
+    Assert_(cubeMap == false || textureData.NumSlices % 6 == 0);
+
+    // Texels that are uploaded in a different format get converted first, in parallel. Every
+    // format keeps the texels in the same order, so they stay at the same offsets.
+    const uint8* texels = reinterpret_cast<const uint8*>(textureData.Texels.data());
+    uint64 elemSize = sizeof(T);
+    std::vector<uint8> packedTexels;
+    if(format != texelFormat)
+    {
+        elemSize = BitsPerPixel(format) / 8;
+        packedTexels.resize(textureData.Texels.size() * elemSize);
+
+        const uint64 TexelsPerWorkItem = 16 * 1024;
+        std::atomic<bool> supported(true);
+        ParallelFor(textureData.Texels.size(), TexelsPerWorkItem, [&](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            if(PackTexels(&textureData.Texels[start], format, &packedTexels[start * elemSize], end - start) == false)
+                supported = false;
+        });
 
+        if(supported == false)
+            throw Exception(L"CreateSRVFromTextureData can't convert the texture data to the requested format");
+
+        texels = packedTexels.data();
+    }
+
+    // D3D wants the subresources ordered by slice and then by mip, which is the other way around
+    // from how TextureData stores them
     std::vector<D3D11_SUBRESOURCE_DATA> subResources;
-    subResources.resize(textureData.NumSlices);
-    for(uint64 i = 0; i < textureData.NumSlices; ++i)
+    subResources.resize(textureData.NumSlices * numMips);
+    for(uint32 mipLevel = 0; mipLevel < numMips; ++mipLevel)
     {
-        subResources[i].pSysMem = &textureData.Texels[textureData.Width * textureData.Height * i];
-        subResources[i].SysMemPitch = elemSize * textureData.Width;
-        subResources[i].SysMemSlicePitch = 0;
+        const uint64 mipWidth = textureData.MipWidth(mipLevel);
+        const uint64 mipHeight = textureData.MipHeight(mipLevel);
+        const uint64 mipOffset = textureData.MipOffset(mipLevel);
+        for(uint64 i = 0; i < textureData.NumSlices; ++i)
+        {
+            D3D11_SUBRESOURCE_DATA& subResource = subResources[i * numMips + mipLevel];
+            subResource.pSysMem = texels + (mipOffset + mipWidth * mipHeight * i) * elemSize;
+            subResource.SysMemPitch = uint32(elemSize * mipWidth);
+            subResource.SysMemSlicePitch = 0;
+        }
     }
 
     D3D11_TEXTURE2D_DESC texDesc;
     texDesc.Width = textureData.Width;
     texDesc.Height = textureData.Height;
-    texDesc.MipLevels = 1;
+    texDesc.MipLevels = numMips;
     texDesc.ArraySize = textureData.NumSlices;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     texDesc.SampleDesc.Count = 1;
     texDesc.SampleDesc.Quality = 0;
     texDesc.Usage = D3D11_USAGE_IMMUTABLE;
     texDesc.CPUAccessFlags = 0;
-    texDesc.MiscFlags = 0;
+    texDesc.MiscFlags = cubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
     texDesc.Format = format;
     ID3D11Texture2DPtr texture;
     DXCall(device->CreateTexture2D(&texDesc, subResources.data(), &texture));
@@ -214,19 +765,339 @@ static ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device
     return srv;
 }
 
-ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<UByte4N>& textureData)
+ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<UByte4N>& textureData,
+                                                     bool cubeMap, DXGI_FORMAT format)
+{
+    return CreateSRVFromTextureData<UByte4N>(device, textureData, cubeMap, format);
+}
+
+ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<Half4>& textureData,
+                                                     bool cubeMap, DXGI_FORMAT format)
+{
+    return CreateSRVFromTextureData<Half4>(device, textureData, cubeMap, format);
+}
+
+ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<Float4>& textureData,
+                                                     bool cubeMap, DXGI_FORMAT format)
+{
+    return CreateSRVFromTextureData<Float4>(device, textureData, cubeMap, format);
+}
+
+// == Block Compression ===========================================================================
+
+float TextureCompressionStats::PSNR() const
+{
+    if(NumSamples == 0)
+        return 0.0f;
+
+    const double mse = SquaredError / NumSamples;
+    if(mse <= 0.0)
+        return FLT_MAX;
+
+    return float(10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+float TextureCompressionStats::EncodeThroughput() const
+{
+    // Texels per microsecond is the same as megapixels per second
+    return EncodeMicroseconds > 0 ? float(double(NumTexelsEncoded) / EncodeMicroseconds) : 0.0f;
+}
+
+TextureCompressionStats& TextureCompressionStats::operator+=(const TextureCompressionStats& other)
+{
+    NumEncoded += other.NumEncoded;
+    NumLoadedFromCache += other.NumLoadedFromCache;
+    NumTexelsEncoded += other.NumTexelsEncoded;
+    EncodeMicroseconds += other.EncodeMicroseconds;
+    SquaredError += other.SquaredError;
+    NumSamples += other.NumSamples;
+    UncompressedBytes += other.UncompressedBytes;
+    CompressedBytes += other.CompressedBytes;
+    return *this;
+}
+
+static DXGI_FORMAT CompressedFormat(TextureCompression compression, bool forceSRGB)
+{
+    switch(compression)
+    {
+    case TextureCompression::BC1:
+        return forceSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+    case TextureCompression::BC4:
+        return DXGI_FORMAT_BC4_UNORM;
+    case TextureCompression::BC5:
+        return DXGI_FORMAT_BC5_UNORM;
+    case TextureCompression::BC7:
+        return forceSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+void LoadWICTextureData(const wchar* filePath, TextureData<UByte4N>& textureData)
+{
+    ScratchImage loaded;
+    DXCall(LoadFromWICFile(filePath, WIC_FLAGS_IGNORE_SRGB, nullptr, loaded));
+
+    const Image* image = loaded.GetImage(0, 0, 0);
+    ScratchImage converted;
+    if(image->format != DXGI_FORMAT_R8G8B8A8_UNORM)
+    {
+        DXCall(Convert(*image, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, 0.5f, converted));
+        image = converted.GetImage(0, 0, 0);
+    }
+
+    textureData.Init(uint32(image->width), uint32(image->height), 1);
+    for(uint64 y = 0; y < image->height; ++y)
+        memcpy(&textureData.Texels[y * image->width], image->pixels + y * image->rowPitch,
+               image->width * sizeof(UByte4N));
+}
+
+// A row of 4x4 blocks in one mip of one array slice, which is the unit of work for encoding
+struct BlockRow
+{
+    uint32 MipLevel;
+    uint32 Slice;
+    uint32 Row;
+};
+
+void CompressTextureData(const TextureData<UByte4N>& textureData, DXGI_FORMAT format, bool cubeMap,
+                         std::vector<uint8>& ddsFileData, TextureCompressionStats* stats)
+{
+    if(BC::CanEncode(format) == false)
+        throw Exception(L"CompressTextureData can't encode to DXGI format " + ToString(uint32(format)));
+
+    const uint32 numMips = std::max(textureData.NumMips, 1u);
+    const uint32 numSlices = textureData.NumSlices;
+    Assert_(textureData.Texels.size() > 0);
+    Assert_(textureData.MipOffset(numMips) == textureData.Texels.size());
+    Assert_(cubeMap == false || numSlices % 6 == 0);
+
+    DDS::DDS_HEADER header;
+    DDS::DDS_HEADER_DXT10 headerDXT10;
+    DDS::MakeHeaders(format, textureData.Width, textureData.Height, numMips, numSlices, cubeMap,
+                     header, headerDXT10);
+
+    // The surfaces are stored by slice and then by mip, which is the other way around from how
+    // TextureData stores them
+    const uint64 headersSize = sizeof(DDS::Magic) + sizeof(header) + sizeof(headerDXT10);
+    std::vector<uint64> mipRowBytes(numMips);
+    std::vector<uint64> surfaceOffsets(numSlices * numMips);
+    std::vector<BlockRow> blockRows;
+    uint64 fileSize = headersSize;
+    for(uint32 sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+    {
+        for(uint32 mipLevel = 0; mipLevel < numMips; ++mipLevel)
+        {
+            size_t numBytes = 0;
+            size_t rowBytes = 0;
+            size_t numRows = 0;
+            DDS::GetSurfaceInfo(textureData.MipWidth(mipLevel), textureData.MipHeight(mipLevel), format,
+                                &numBytes, &rowBytes, &numRows);
+
+            mipRowBytes[mipLevel] = rowBytes;
+            surfaceOffsets[sliceIdx * numMips + mipLevel] = fileSize;
+            fileSize += numBytes;
+
+            for(uint32 rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            {
+                BlockRow blockRow = { mipLevel, sliceIdx, rowIdx };
+                blockRows.push_back(blockRow);
+            }
+        }
+    }
+
+    ddsFileData.resize(fileSize);
+    uint8* fileData = ddsFileData.data();
+    memcpy(fileData, &DDS::Magic, sizeof(DDS::Magic));
+    memcpy(fileData + sizeof(DDS::Magic), &header, sizeof(header));
+    memcpy(fileData + sizeof(DDS::Magic) + sizeof(header), &headerDXT10, sizeof(headerDXT10));
+
+    // Returns the first texel of a row of blocks, along with how many rows of texels it covers
+    auto blockRowTexels = [&](const BlockRow& blockRow, uint32& numTexelRows)
+    {
+        const uint64 mipWidth = textureData.MipWidth(blockRow.MipLevel);
+        const uint32 mipHeight = textureData.MipHeight(blockRow.MipLevel);
+        const uint32 y = blockRow.Row * 4;
+        numTexelRows = std::min(mipHeight - y, 4u);
+        return &textureData.Texels[textureData.MipOffset(blockRow.MipLevel) + mipWidth * (mipHeight * blockRow.Slice + y)];
+    };
+
+    auto blockRowData = [&](const BlockRow& blockRow)
+    {
+        return fileData + surfaceOffsets[blockRow.Slice * numMips + blockRow.MipLevel] +
+               mipRowBytes[blockRow.MipLevel] * blockRow.Row;
+    };
+
+    Timer timer;
+    ParallelFor(blockRows.size(), 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        for(uint64 i = start; i < end; ++i)
+        {
+            const BlockRow& blockRow = blockRows[i];
+            const uint32 mipWidth = textureData.MipWidth(blockRow.MipLevel);
+            uint32 numTexelRows = 0;
+            const UByte4N* texels = blockRowTexels(blockRow, numTexelRows);
+            BC::EncodeRows(format, texels, mipWidth * sizeof(UByte4N), mipWidth, numTexelRows,
+                           blockRowData(blockRow), mipRowBytes[blockRow.MipLevel]);
+        }
+    });
+    timer.Update();
+
+    if(stats == nullptr)
+        return;
+
+    stats->NumEncoded += 1;
+    stats->NumTexelsEncoded += textureData.Texels.size();
+    stats->EncodeMicroseconds += uint64(timer.ElapsedMicroseconds());
+    stats->UncompressedBytes += textureData.Texels.size() * sizeof(UByte4N);
+    stats->CompressedBytes += fileSize - headersSize;
+
+    // Decode the blocks again and compare them with the source, only counting the channels that
+    // the format stores. BC1 skips texels that were encoded as transparent, since their color is
+    // always decoded as black. Each row of blocks sums up its own error, so that the total doesn't
+    // depend on how the work was split between threads.
+    uint32 numChannels = 4;
+    if(format == DXGI_FORMAT_BC4_UNORM)
+        numChannels = 1;
+    else if(format == DXGI_FORMAT_BC5_UNORM)
+        numChannels = 2;
+    else if(format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB)
+        numChannels = 3;
+    const bool skipTransparent = numChannels == 3;
+
+    std::vector<double> rowErrors(blockRows.size(), 0.0);
+    std::vector<uint64> rowSamples(blockRows.size(), 0);
+    ParallelFor(blockRows.size(), 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        std::vector<uint32> decoded;
+        for(uint64 i = start; i < end; ++i)
+        {
+            const BlockRow& blockRow = blockRows[i];
+            const uint32 mipWidth = textureData.MipWidth(blockRow.MipLevel);
+            uint32 numTexelRows = 0;
+            const UByte4N* texels = blockRowTexels(blockRow, numTexelRows);
+
+            decoded.resize(mipWidth * numTexelRows);
+            BC::DecodeRows(format, blockRowData(blockRow), mipRowBytes[blockRow.MipLevel], mipWidth, numTexelRows,
+                           decoded.data(), mipWidth * sizeof(uint32));
+
+            uint64 squaredError = 0;
+            uint64 numSamples = 0;
+            for(uint64 texelIdx = 0; texelIdx < decoded.size(); ++texelIdx)
+            {
+                const uint32 src = texels[texelIdx].Bits;
+                if(skipTransparent && (src >> 24) < 128)
+                    continue;
+
+                for(uint32 c = 0; c < numChannels; ++c)
+                {
+                    const int32 diff = int32((src >> (c * 8)) & 0xFF) - int32((decoded[texelIdx] >> (c * 8)) & 0xFF);
+                    squaredError += uint64(diff * diff);
+                }
+                numSamples += numChannels;
+            }
+
+            rowErrors[i] = double(squaredError);
+            rowSamples[i] = numSamples;
+        }
+    });
+
+    for(uint64 i = 0; i < blockRows.size(); ++i)
+    {
+        stats->SquaredError += rowErrors[i];
+        stats->NumSamples += rowSamples[i];
+    }
+}
+
+std::wstring CompressedTexturePath(const wchar* filePath, TextureCompression compression, bool forceSRGB)
 {
-    return CreateSRVFromTextureData<UByte4N>(device, textureData);
+    static const wchar* CompressionNames[] = { L"", L"BC1", L"BC4", L"BC5", L"BC7" };
+    StaticAssert_(ArraySize_(CompressionNames) == uint64(TextureCompression::NumValues));
+    Assert_(compression != TextureCompression::None && compression < TextureCompression::NumValues);
+
+    std::wstring path = filePath;
+    path += L".";
+    path += CompressionNames[uint64(compression)];
+    if(BC::IsSRGB(CompressedFormat(compression, forceSRGB)))
+        path += L"_SRGB";
+    path += L".dds";
+    return path;
 }
 
-ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<Half4>& textureData)
+// Does the work for CompressTexture, and hands back the DDS file so that it can be used without
+// reading it back in
+static void CompressTexture(const wchar* filePath, TextureCompression compression, bool forceSRGB,
+                            std::vector<uint8>& ddsFileData, TextureCompressionStats& stats)
 {
-    return CreateSRVFromTextureData<Half4>(device, textureData);
+    const DXGI_FORMAT format = CompressedFormat(compression, forceSRGB);
+    if(format == DXGI_FORMAT_UNKNOWN)
+        throw Exception(L"CompressTexture needs a compression format");
+
+    TextureData<UByte4N> textureData;
+    LoadWICTextureData(filePath, textureData);
+    GenerateMips(textureData, MipFilter::Box, BC::IsSRGB(format));
+    CompressTextureData(textureData, format, false, ddsFileData, &stats);
+
+    // Write to a temporary file first, so that an interrupted write can't leave behind a truncated
+    // file that's newer than the source. Two threads can be compressing the same image, so the
+    // temporary name includes the thread ID.
+    const std::wstring cachePath = CompressedTexturePath(filePath, compression, forceSRGB);
+    const std::wstring tempPath = cachePath + L"." + ToString(GetCurrentThreadId()) + L".tmp";
+    {
+        File file(tempPath.c_str(), FileOpenMode::Write);
+        file.Write(ddsFileData.size(), ddsFileData.data());
+    }
+    Win32Call(MoveFileEx(tempPath.c_str(), cachePath.c_str(), MOVEFILE_REPLACE_EXISTING));
 }
 
-ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device, const TextureData<Float4>& textureData)
+void CompressTexture(const wchar* filePath, TextureCompression compression, bool forceSRGB,
+                     TextureCompressionStats* stats)
 {
-    return CreateSRVFromTextureData<Float4>(device, textureData);
+    std::vector<uint8> ddsFileData;
+    TextureCompressionStats textureStats;
+    CompressTexture(filePath, compression, forceSRGB, ddsFileData, textureStats);
+    if(stats != nullptr)
+        *stats += textureStats;
+}
+
+// Uses the cached DDS file if it's newer than the source image, otherwise compresses the image
+// and creates the texture straight from the new DDS file
+static ID3D11ShaderResourceViewPtr LoadCompressedTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB,
+                                                         TextureCompression compression,
+                                                         TextureCompressionStats* compressionStats)
+{
+    ID3D11ResourcePtr resource;
+    ID3D11ShaderResourceViewPtr srv;
+    TextureCompressionStats textureStats;
+
+    const std::wstring cachePath = CompressedTexturePath(filePath, compression, forceSRGB);
+    if(FileExists(cachePath.c_str()) && GetFileTimestamp(cachePath.c_str()) >= GetFileTimestamp(filePath))
+    {
+        DXCall(DirectX::CreateDDSTextureFromFileEx(device, cachePath.c_str(), 0, D3D11_USAGE_DEFAULT,
+                                                   D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+                                                   &resource, &srv, nullptr));
+
+        D3D11_TEXTURE2D_DESC desc;
+        ID3D11Texture2DPtr(resource)->GetDesc(&desc);
+        textureStats.NumLoadedFromCache = 1;
+        textureStats.UncompressedBytes = MipChainSize(DXGI_FORMAT_R8G8B8A8_UNORM, desc.Width, desc.Height, 1,
+                                                      desc.MipLevels) * desc.ArraySize;
+        textureStats.CompressedBytes = MipChainSize(desc.Format, desc.Width, desc.Height, 1,
+                                                    desc.MipLevels) * desc.ArraySize;
+    }
+    else
+    {
+        std::vector<uint8> ddsFileData;
+        CompressTexture(filePath, compression, forceSRGB, ddsFileData, textureStats);
+        DXCall(DirectX::CreateDDSTextureFromMemoryEx(device, ddsFileData.data(), ddsFileData.size(), 0,
+                                                     D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+                                                     &resource, &srv, nullptr));
+    }
+
+    if(compressionStats != nullptr)
+        *compressionStats += textureStats;
+
+    return srv;
 }
 
 void SaveTextureAsDDS(ID3D11ShaderResourceView* srv, const wchar* filePath)
@@ -256,46 +1127,48 @@ void SaveTextureAsEXR(ID3D11ShaderResourceView* srv, const wchar* filePath)
     ID3D11DevicePtr device;
     srv->GetDevice(&device);
 
+    // Half textures are read back and written as-is, without a round trip through floats
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    srv->GetDesc(&srvDesc);
+    if(srvDesc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+    {
+        TextureData<Half4> textureData;
+        GetTextureData(device, srv, textureData);
+        SaveTextureAsEXR(textureData, filePath);
+        return;
+    }
+
     TextureData<Float4> textureData;
     GetTextureData(device, srv, textureData);
 
     SaveTextureAsEXR(textureData, filePath);
 }
 
-void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath)
+// Writes the RGB channels of the top mip straight from the texels, since the EXR writer
+// can read interleaved data
+template<typename T> static void SaveTextureAsEXR(const TextureData<T>& texture, int pixelType, const wchar* filePath)
 {
     Assert_(texture.Texels.size() > 0);
     Assert_(texture.Width > 0 && texture.Height > 0);
     Assert_(texture.NumSlices == 1);
 
-    const uint64 numTexels = texture.Texels.size();
-    std::vector<float> channelDataR;
-    std::vector<float> channelDataG;
-    std::vector<float> channelDataB;
-    channelDataR.resize(numTexels);
-    channelDataG.resize(numTexels);
-    channelDataB.resize(numTexels);
-    for(uint64 i = 0; i < numTexels; ++i)
-    {
-        channelDataR[i] = texture.Texels[i].x;
-        channelDataG[i] = texture.Texels[i].y;
-        channelDataB[i] = texture.Texels[i].z;
-    }
-
-    float* imageChannels[3] = { channelDataB.data(), channelDataG.data(), channelDataR.data() };
+    const T& firstTexel = texture.Texels[0];
+    const void* imageChannels[3] = { &firstTexel.z, &firstTexel.y, &firstTexel.x };
     const char* channelNames[3] = { "B", "G", "R" };
 
-    EXRImage exrImage;
+    EXRStridedImage exrImage;
     exrImage.num_channels = 3;
+    exrImage.channel_names = channelNames;
+    exrImage.channels = imageChannels;
+    exrImage.pixel_stride = 4;
+    exrImage.pixel_type = pixelType;
     exrImage.width = texture.Width;
     exrImage.height = texture.Height;
-    exrImage.channel_names = channelNames;
-    exrImage.images = imageChannels;
 
     std::string filePathAnsi = WStringToAnsi(filePath);
 
     const char* errorString = nullptr;
-    int returnCode = SaveMultiChannelEXR(&exrImage, filePathAnsi.c_str(), &errorString);
+    int returnCode = SaveStridedEXR(&exrImage, filePathAnsi.c_str(), &errorString);
     if(returnCode != 0)
     {
         AssertFail_("%s", errorString);
@@ -303,6 +1176,16 @@ void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath)
     }
 }
 
+void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath)
+{
+    SaveTextureAsEXR(texture, 2, filePath);
+}
+
+void SaveTextureAsEXR(const TextureData<Half4>& texture, const wchar* filePath)
+{
+    SaveTextureAsEXR(texture, 1, filePath);
+}
+
 void SaveTextureAsPNG(ID3D11ShaderResourceView* srv, const wchar* filePath)
 {
     ID3D11ResourcePtr texture;
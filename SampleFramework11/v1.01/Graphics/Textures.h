@@ -22,22 +22,149 @@ struct Half4;
 struct UByte4N;
 class File;
 
-// Texture loading
-ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB = false);
+// Block compression that can be applied to non-DDS textures when they're loaded. The compressed
+// texture is cached as a DDS file next to the source image (see CompressedTexturePath), and the
+// cached copy is used as long as it's newer than the source.
+enum class TextureCompression
+{
+    None = 0,
+    BC1,        // RGB with 1-bit alpha, 4 bits per texel
+    BC4,        // Single channel (R), 4 bits per texel
+    BC5,        // Two channels (RG), 8 bits per texel, for normal maps
+    BC7,        // RGBA, 8 bits per texel
+
+    NumValues
+};
+
+struct TextureCompressionStats
+{
+    uint64 NumEncoded = 0;
+    uint64 NumLoadedFromCache = 0;
+
+    // Texels encoded (including mips) and how long it took, summed over the encoded textures
+    uint64 NumTexelsEncoded = 0;
+    uint64 EncodeMicroseconds = 0;
+
+    // Squared error of the decoded texels and the number of channel values that it was summed
+    // over, for working out the PSNR of the encoded textures
+    double SquaredError = 0.0;
+    uint64 NumSamples = 0;
+
+    // Memory used by the textures as RGBA8 with a full mip chain, and after compression
+    uint64 UncompressedBytes = 0;
+    uint64 CompressedBytes = 0;
+
+    float PSNR() const;                 // In dB
+    float EncodeThroughput() const;     // In megapixels per second
+    uint64 BytesSaved() const { return UncompressedBytes - CompressedBytes; }
+
+    TextureCompressionStats& operator+=(const TextureCompressionStats& other);
+};
+
+// Texture loading, which goes through TextureCache::Global so that a file is only loaded once
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, const wchar* filePath, bool forceSRGB = false,
+                                        TextureCompression compression = TextureCompression::None);
+
+// Same as above, except that mip generation for non-DDS textures is done on the given context.
+// Passing a deferred context makes it safe to call from any thread.
+ID3D11ShaderResourceViewPtr LoadTexture(ID3D11Device* device, ID3D11DeviceContext* context, const wchar* filePath,
+                                        bool forceSRGB = false,
+                                        TextureCompression compression = TextureCompression::None);
+
+// Loads a texture without going through TextureCache::Global. DDS files are always loaded as-is,
+// and compression is only applied to images that go through WIC.
+ID3D11ShaderResourceViewPtr LoadTextureUncached(ID3D11Device* device, ID3D11DeviceContext* context,
+                                                const wchar* filePath, bool forceSRGB = false,
+                                                TextureCompression compression = TextureCompression::None,
+                                                TextureCompressionStats* compressionStats = nullptr);
+
+struct TextureCacheStats
+{
+    uint64 NumHits = 0;
+    uint64 NumMisses = 0;
+    uint64 NumTextures = 0;
+
+    // GPU memory used by the cached textures, and the memory that cache hits would have
+    // allocated if they had loaded their own copy
+    uint64 NumBytes = 0;
+    uint64 NumBytesSaved = 0;
+
+    // Summed over the compressed textures that missed the cache
+    TextureCompressionStats Compression;
+};
+
+// Shares textures between LoadTexture calls, keyed by the full path of the file, whether it was
+// loaded as sRGB and how it was compressed. The cache holds a reference to every texture it hands out, so that they stay
+// alive as long as something is using them. Textures that nothing else refers to anymore are only
+// released by Trim() or Clear(), and AsyncModelLoader trims the cache every time it finishes
+// loading a model. It's safe to use from multiple threads, although two threads
+// loading the same file at the same time will both decode it and only one copy will be kept.
+class TextureCache
+{
+
+public:
+
+    ID3D11ShaderResourceViewPtr Load(ID3D11Device* device, ID3D11DeviceContext* context, const wchar* filePath,
+                                     bool forceSRGB = false,
+                                     TextureCompression compression = TextureCompression::None);
 
+    // Releases textures that are only referenced by the cache, and returns how many were released
+    uint64 Trim();
+    void Clear();
+
+    TextureCacheStats Stats() const;
+
+    static TextureCache Global;
+
+protected:
+
+    struct CacheEntry
+    {
+        ID3D11ShaderResourceViewPtr SRV;
+        uint64 NumBytes;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::wstring, CacheEntry> entries;
+    TextureCacheStats stats;
+};
+
+// Texels are stored mip-major: every array slice of mip 0, followed by every slice of mip 1, and
+// so on. Data with a single mip level is just the slices one after another.
 template<typename T> struct TextureData
 {
     std::vector<T> Texels;
     uint32 Width = 0;
     uint32 Height = 0;
     uint32 NumSlices = 0;
+    uint32 NumMips = 1;
 
-    void Init(uint32 width, uint32 height, uint32 numSlices)
+    void Init(uint32 width, uint32 height, uint32 numSlices, uint32 numMips = 1)
     {
         Width = width;
         Height = height;
         NumSlices = numSlices;
-        Texels.resize(width * height * numSlices);
+        NumMips = numMips;
+        Texels.resize(MipOffset(numMips));
+    }
+
+    uint32 MipWidth(uint32 mipLevel) const
+    {
+        return std::max(Width >> mipLevel, 1u);
+    }
+
+    uint32 MipHeight(uint32 mipLevel) const
+    {
+        return std::max(Height >> mipLevel, 1u);
+    }
+
+    // Index of the first texel of a mip level
+    uint64 MipOffset(uint32 mipLevel) const
+    {
+        uint64 offset = 0;
+        for(uint32 i = 0; i < mipLevel; ++i)
+            offset += uint64(MipWidth(i)) * MipHeight(i) * NumSlices;
+        return offset;
     }
 
     template<typename TSerializer> void Serialize(TSerializer& serializer)
@@ -46,10 +173,12 @@ template<typename T> struct TextureData
         SerializeItem(serializer, Width);
         SerializeItem(serializer, Height);
         SerializeItem(serializer, NumSlices);
+        SerializeItem(serializer, NumMips);
     }
 };
 
-// Decode a texture and copies it to the CPU
+// Decode a texture and copies it to the CPU. Formats that BC::DecodeRows supports are copied back
+// as-is and decoded on the CPU, and everything else is decoded with a compute shader.
 void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
                     TextureData<UByte4N>& textureData);
 
@@ -59,19 +188,70 @@ void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
 void GetTextureData(ID3D11Device* device, ID3D11ShaderResourceView* textureSRV,
                     TextureData<Float4>& textureData);
 
+// Decodes the top mip of every array slice in a DDS file on the CPU, without needing a device.
+// sRGB formats (or any 8-bit format, when forceSRGB is set) are converted to linear.
+void GetTextureData(const wchar* ddsFilePath, TextureData<UByte4N>& textureData, bool forceSRGB = false);
+void GetTextureData(const wchar* ddsFilePath, TextureData<Half4>& textureData, bool forceSRGB = false);
+void GetTextureData(const wchar* ddsFilePath, TextureData<Float4>& textureData, bool forceSRGB = false);
+
+// Decodes an OpenEXR file on the CPU, with its scanline blocks uncompressed in parallel. The R, G,
+// B and A channels are read, with alpha set to 1 when the file doesn't have it. A mipLevel above 0
+// box-filters the image down while it's decoded, so the full-size image is never allocated.
+void LoadEXRTextureData(const wchar* exrFilePath, TextureData<Half4>& textureData, uint32 mipLevel = 0);
+void LoadEXRTextureData(const wchar* exrFilePath, TextureData<Float4>& textureData, uint32 mipLevel = 0);
+
+// Decodes a width x height region whose top-left corner is at (x, y) in the given mip level. Only
+// the blocks that overlap the region are uncompressed. Texels past the edge of the image are
+// clamped to the edge.
+void LoadEXRTextureData(const wchar* exrFilePath, uint32 x, uint32 y, uint32 width, uint32 height,
+                        TextureData<Half4>& textureData, uint32 mipLevel = 0);
+void LoadEXRTextureData(const wchar* exrFilePath, uint32 x, uint32 y, uint32 width, uint32 height,
+                        TextureData<Float4>& textureData, uint32 mipLevel = 0);
+
+// Creates an immutable texture with every mip level and array slice of the data. With cubeMap set,
+// the slices are treated as cube faces, and NumSlices needs to be a multiple of 6. The texture
+// uses the format that matches the texel type unless one is given: Half4 and Float4 data can be
+// converted to R32G32B32A32_FLOAT, R16G16B16A16_FLOAT, R16G16B16A16_UNORM, R11G11B10_FLOAT,
+// R9G9B9E5_SHAREDEXP, R8G8B8A8_UNORM or R8G8B8A8_UNORM_SRGB on the CPU before it's uploaded.
 ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device,
-                                                     const TextureData<UByte4N>& textureData);
+                                                     const TextureData<UByte4N>& textureData,
+                                                     bool cubeMap = false,
+                                                     DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
 
 ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device,
-                                                     const TextureData<Half4>& textureData);
+                                                     const TextureData<Half4>& textureData,
+                                                     bool cubeMap = false,
+                                                     DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
 
 ID3D11ShaderResourceViewPtr CreateSRVFromTextureData(ID3D11Device* device,
-                                                     const TextureData<Float4>& textureData);
+                                                     const TextureData<Float4>& textureData,
+                                                     bool cubeMap = false,
+                                                     DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
+
+// Loads a PNG, JPEG, BMP or TIFF through WIC as 8-bit RGBA, without converting sRGB to linear
+void LoadWICTextureData(const wchar* filePath, TextureData<UByte4N>& textureData);
+
+// Block-compresses every mip and array slice of the data on the CPU, in parallel, and writes out
+// a complete DDS file. format needs to be one that BC::CanEncode() accepts. The stats (including
+// the PSNR, which takes an extra pass to decode the blocks) are only gathered when they're asked for.
+void CompressTextureData(const TextureData<UByte4N>& textureData, DXGI_FORMAT format, bool cubeMap,
+                         std::vector<uint8>& ddsFileData, TextureCompressionStats* stats = nullptr);
+
+// Where LoadTexture caches the compressed copy of an image, which is the source path with the
+// format tacked on (Diffuse.png becomes Diffuse.png.BC7_SRGB.dds)
+std::wstring CompressedTexturePath(const wchar* filePath, TextureCompression compression, bool forceSRGB = false);
+
+// Generates mips for an image, compresses it and writes it to CompressedTexturePath(), which is
+// what LoadTexture does when the cached copy is missing or out of date. Doesn't need a device,
+// so it can be used to bake textures offline.
+void CompressTexture(const wchar* filePath, TextureCompression compression, bool forceSRGB = false,
+                     TextureCompressionStats* stats = nullptr);
 
 void SaveTextureAsDDS(ID3D11ShaderResourceView* srv, const wchar* filePath);
 void SaveTextureAsDDS(ID3D11Resource* texture, const wchar* filePath);
 void SaveTextureAsEXR(ID3D11ShaderResourceView* srv, const wchar* filePath);
 void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath);
+void SaveTextureAsEXR(const TextureData<Half4>& texture, const wchar* filePath);
 void SaveTextureAsPNG(ID3D11ShaderResourceView* srv, const wchar* filePath);
 void SaveTextureAsPNG(ID3D11Resource* texture, const wchar* filePath);
 
@@ -163,4 +343,248 @@ template<typename T> static XMVECTOR SampleCubemap(Float3 direction, const Textu
     return SampleTexture2D(uv, faceIdx, texData);
 }
 
+// == Packet Sampling Functions ===================================================================
+
+// These sample 4 UVs or directions at once, and return exactly what SampleTexture2D and
+// SampleCubemap return for each of them. The coordinates are passed in SoA form (one vector of
+// U coordinates, one of V, and so on), and the address math and cube face selection are done for
+// all 4 lanes at once without branching. Each sample comes back as its own RGBA vector.
+
+// Texel indices and lerp amounts for bilinearly sampling 4 UVs
+struct BilinearFootprint4
+{
+    uint64 Indices[4][4];   // [sample][top-left, top-right, bottom-left, bottom-right]
+    XMVECTOR LerpX;
+    XMVECTOR LerpY;
+};
+
+// Same as Frac, followed by wrapping negative values into [0, 1]
+inline XMVECTOR WrapFrac4(FXMVECTOR x)
+{
+    const XMVECTOR frac = XMVectorSubtract(x, XMVectorTruncate(x));
+    return XMVectorSelect(frac, XMVectorAdd(XMVectorReplicate(1.0f), frac), XMVectorLess(frac, XMVectorZero()));
+}
+
+inline void ComputeBilinearFootprint4(FXMVECTOR u, FXMVECTOR v, const uint32 arraySlices[4], uint32 texWidth,
+                                      uint32 texHeight, uint32 numSlices, BilinearFootprint4& footprint)
+{
+    const float texSizeX = float(texWidth);
+    const float texSizeY = float(texHeight);
+    const XMVECTOR samplePosX = XMVectorMultiply(WrapFrac4(XMVectorSubtract(u, XMVectorReplicate(0.5f / texSizeX))),
+                                                 XMVectorReplicate(texSizeX));
+    const XMVECTOR samplePosY = XMVectorMultiply(WrapFrac4(XMVectorSubtract(v, XMVectorReplicate(0.5f / texSizeY))),
+                                                 XMVectorReplicate(texSizeY));
+
+    // Clamping before truncating gives the same result as clamping the integer, and keeps the
+    // math in float registers (SSE2 has no integer min)
+    const XMVECTOR maxX = XMVectorReplicate(float(texWidth - 1));
+    const XMVECTOR maxY = XMVectorReplicate(float(texHeight - 1));
+    const XMVECTOR x0 = XMVectorTruncate(XMVectorMin(samplePosX, maxX));
+    const XMVECTOR y0 = XMVectorTruncate(XMVectorMin(samplePosY, maxY));
+    const XMVECTOR x1 = XMVectorMin(XMVectorAdd(x0, XMVectorReplicate(1.0f)), maxX);
+    const XMVECTOR y1 = XMVectorMin(XMVectorAdd(y0, XMVectorReplicate(1.0f)), maxY);
+
+    footprint.LerpX = XMVectorSubtract(samplePosX, XMVectorTruncate(samplePosX));
+    footprint.LerpY = XMVectorSubtract(samplePosY, XMVectorTruncate(samplePosY));
+
+    XMUINT4 x0i, x1i, y0i, y1i;
+    XMStoreUInt4(&x0i, XMConvertVectorFloatToUInt(x0, 0));
+    XMStoreUInt4(&x1i, XMConvertVectorFloatToUInt(x1, 0));
+    XMStoreUInt4(&y0i, XMConvertVectorFloatToUInt(y0, 0));
+    XMStoreUInt4(&y1i, XMConvertVectorFloatToUInt(y1, 0));
+
+    const uint32* x0s = &x0i.x;
+    const uint32* x1s = &x1i.x;
+    const uint32* y0s = &y0i.x;
+    const uint32* y1s = &y1i.x;
+    numSlices = std::max<uint32>(numSlices, 1);
+    for(uint32 i = 0; i < 4; ++i)
+    {
+        const uint64 sliceOffset = uint64(std::min(arraySlices[i], numSlices)) * texWidth * texHeight;
+        const uint64 row0 = sliceOffset + uint64(y0s[i]) * texWidth;
+        const uint64 row1 = sliceOffset + uint64(y1s[i]) * texWidth;
+        footprint.Indices[i][0] = row0 + x0s[i];
+        footprint.Indices[i][1] = row0 + x1s[i];
+        footprint.Indices[i][2] = row1 + x0s[i];
+        footprint.Indices[i][3] = row1 + x1s[i];
+    }
+}
+
+template<typename T> static void PrefetchBilinearFootprint4(const BilinearFootprint4& footprint, const T* texels)
+{
+    for(uint32 i = 0; i < 4; ++i)
+    {
+        _mm_prefetch(reinterpret_cast<const char*>(texels + footprint.Indices[i][0]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(texels + footprint.Indices[i][2]), _MM_HINT_T0);
+    }
+}
+
+template<typename T> static void SampleBilinearFootprint4(const BilinearFootprint4& footprint, const T* texels,
+                                                          XMVECTOR results[4])
+{
+    const XMVECTOR lerpXs[4] = { XMVectorSplatX(footprint.LerpX), XMVectorSplatY(footprint.LerpX),
+                                 XMVectorSplatZ(footprint.LerpX), XMVectorSplatW(footprint.LerpX) };
+    const XMVECTOR lerpYs[4] = { XMVectorSplatX(footprint.LerpY), XMVectorSplatY(footprint.LerpY),
+                                 XMVectorSplatZ(footprint.LerpY), XMVectorSplatW(footprint.LerpY) };
+    for(uint32 i = 0; i < 4; ++i)
+    {
+        const uint64* indices = footprint.Indices[i];
+        const XMVECTOR top = XMVectorLerpV(texels[indices[0]].ToSIMD(), texels[indices[1]].ToSIMD(), lerpXs[i]);
+        const XMVECTOR bottom = XMVectorLerpV(texels[indices[2]].ToSIMD(), texels[indices[3]].ToSIMD(), lerpXs[i]);
+        results[i] = XMVectorLerpV(top, bottom, lerpYs[i]);
+    }
+}
+
+// Picks the cube face for 4 directions with the same tie-breaking as SampleCubemap, and returns
+// the face UVs along with the face indices
+inline void ComputeCubemapUVs4(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, XMVECTOR& u, XMVECTOR& v,
+                               uint32 faceIndices[4])
+{
+    const XMVECTOR negX = XMVectorNegate(x);
+    const XMVECTOR negY = XMVectorNegate(y);
+    const XMVECTOR negZ = XMVectorNegate(z);
+    const XMVECTOR maxComponent = XMVectorMax(XMVectorMax(XMVectorAbs(x), XMVectorAbs(y)), XMVectorAbs(z));
+
+    // Start with the lowest priority face and let the earlier ones overwrite it, which matches the
+    // order of the if/else chain in SampleCubemap. Lanes that match no face (NaNs) keep its defaults.
+    XMVECTOR face = XMVectorZero();
+    XMVECTOR numU = y;
+    XMVECTOR numV = z;
+    XMVECTOR denom = XMVectorReplicate(1.0f);
+
+    const XMVECTOR faceNumUs[6] = { negZ, z, x, x, x, negX };
+    const XMVECTOR faceNumVs[6] = { negY, negY, z, negZ, negY, negY };
+    const XMVECTOR faceDenoms[6] = { x, negX, y, negY, z, negZ };
+    for(int32 faceIdx = 5; faceIdx >= 0; --faceIdx)
+    {
+        const XMVECTOR mask = XMVectorEqual(faceDenoms[faceIdx], maxComponent);
+        face = XMVectorSelect(face, XMVectorReplicate(float(faceIdx)), mask);
+        numU = XMVectorSelect(numU, faceNumUs[faceIdx], mask);
+        numV = XMVectorSelect(numV, faceNumVs[faceIdx], mask);
+        denom = XMVectorSelect(denom, faceDenoms[faceIdx], mask);
+    }
+
+    const XMVECTOR half = XMVectorReplicate(0.5f);
+    u = XMVectorAdd(XMVectorMultiply(XMVectorDivide(numU, denom), half), half);
+    v = XMVectorAdd(XMVectorMultiply(XMVectorDivide(numV, denom), half), half);
+
+    XMUINT4 faces;
+    XMStoreUInt4(&faces, XMConvertVectorFloatToUInt(face, 0));
+    faceIndices[0] = faces.x;
+    faceIndices[1] = faces.y;
+    faceIndices[2] = faces.z;
+    faceIndices[3] = faces.w;
+}
+
+template<typename T> static void SampleTexture2D4(FXMVECTOR u, FXMVECTOR v, uint32 arraySlice,
+                                                  const TextureData<T>& texData, XMVECTOR results[4])
+{
+    const uint32 arraySlices[4] = { arraySlice, arraySlice, arraySlice, arraySlice };
+    BilinearFootprint4 footprint;
+    ComputeBilinearFootprint4(u, v, arraySlices, texData.Width, texData.Height, texData.NumSlices, footprint);
+    SampleBilinearFootprint4(footprint, texData.Texels.data(), results);
+}
+
+template<typename T> static void SampleCubemap4(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, const TextureData<T>& texData,
+                                                XMVECTOR results[4])
+{
+    Assert_(texData.NumSlices == 6);
+
+    XMVECTOR u, v;
+    uint32 faceIndices[4];
+    ComputeCubemapUVs4(x, y, z, u, v, faceIndices);
+
+    BilinearFootprint4 footprint;
+    ComputeBilinearFootprint4(u, v, faceIndices, texData.Width, texData.Height, texData.NumSlices, footprint);
+    SampleBilinearFootprint4(footprint, texData.Texels.data(), results);
+}
+
+// Samples arrays of UVs or directions, 4 at a time. The footprint of the next packet is computed
+// and prefetched before the current one is loaded, so that the cache misses overlap with the
+// filtering math. The tail is padded by repeating the last coordinate.
+template<typename T> static void SampleTexture2D(const Float2* uvs, uint64 numSamples, uint32 arraySlice,
+                                                 const TextureData<T>& texData, Float4* results)
+{
+    if(numSamples == 0)
+        return;
+
+    const T* texels = texData.Texels.data();
+    const uint32 arraySlices[4] = { arraySlice, arraySlice, arraySlice, arraySlice };
+    auto computeFootprint = [&](uint64 start, BilinearFootprint4& footprint)
+    {
+        Float2 packet[4];
+        for(uint64 i = 0; i < 4; ++i)
+            packet[i] = uvs[std::min(start + i, numSamples - 1)];
+
+        const XMVECTOR u = XMVectorSet(packet[0].x, packet[1].x, packet[2].x, packet[3].x);
+        const XMVECTOR v = XMVectorSet(packet[0].y, packet[1].y, packet[2].y, packet[3].y);
+        ComputeBilinearFootprint4(u, v, arraySlices, texData.Width, texData.Height, texData.NumSlices, footprint);
+    };
+
+    BilinearFootprint4 footprints[2];
+    computeFootprint(0, footprints[0]);
+    for(uint64 start = 0; start < numSamples; start += 4)
+    {
+        const BilinearFootprint4& footprint = footprints[(start / 4) % 2];
+        if(start + 4 < numSamples)
+        {
+            BilinearFootprint4& nextFootprint = footprints[(start / 4 + 1) % 2];
+            computeFootprint(start + 4, nextFootprint);
+            PrefetchBilinearFootprint4(nextFootprint, texels);
+        }
+
+        XMVECTOR samples[4];
+        SampleBilinearFootprint4(footprint, texels, samples);
+
+        const uint64 count = std::min<uint64>(numSamples - start, 4);
+        for(uint64 i = 0; i < count; ++i)
+            results[start + i] = Float4(samples[i]);
+    }
+}
+
+template<typename T> static void SampleCubemap(const Float3* directions, uint64 numSamples,
+                                               const TextureData<T>& texData, Float4* results)
+{
+    Assert_(texData.NumSlices == 6);
+    if(numSamples == 0)
+        return;
+
+    const T* texels = texData.Texels.data();
+    auto computeFootprint = [&](uint64 start, BilinearFootprint4& footprint)
+    {
+        Float3 packet[4];
+        for(uint64 i = 0; i < 4; ++i)
+            packet[i] = directions[std::min(start + i, numSamples - 1)];
+
+        const XMVECTOR x = XMVectorSet(packet[0].x, packet[1].x, packet[2].x, packet[3].x);
+        const XMVECTOR y = XMVectorSet(packet[0].y, packet[1].y, packet[2].y, packet[3].y);
+        const XMVECTOR z = XMVectorSet(packet[0].z, packet[1].z, packet[2].z, packet[3].z);
+
+        XMVECTOR u, v;
+        uint32 faceIndices[4];
+        ComputeCubemapUVs4(x, y, z, u, v, faceIndices);
+        ComputeBilinearFootprint4(u, v, faceIndices, texData.Width, texData.Height, texData.NumSlices, footprint);
+    };
+
+    BilinearFootprint4 footprints[2];
+    computeFootprint(0, footprints[0]);
+    for(uint64 start = 0; start < numSamples; start += 4)
+    {
+        const BilinearFootprint4& footprint = footprints[(start / 4) % 2];
+        if(start + 4 < numSamples)
+        {
+            BilinearFootprint4& nextFootprint = footprints[(start / 4 + 1) % 2];
+            computeFootprint(start + 4, nextFootprint);
+            PrefetchBilinearFootprint4(nextFootprint, texels);
+        }
+
+        XMVECTOR samples[4];
+        SampleBilinearFootprint4(footprint, texels, samples);
+
+        const uint64 count = std::min<uint64>(numSamples - start, 4);
+        for(uint64 i = 0; i < count; ++i)
+            results[start + i] = Float4(samples[i]);
+    }
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// This file doesn't use the precompiled header, so that it can be built on other platforms
+
+#include "VertexCompression.h"
+
+#include <math.h>
+
+namespace SampleFramework11
+{
+
+static float SignNotZero(float x)
+{
+    return x >= 0.0f ? 1.0f : -1.0f;
+}
+
+void EncodeOctahedral(const float n[3], float e[2])
+{
+    const float l1Norm = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if(l1Norm == 0.0f)
+    {
+        e[0] = e[1] = 0.0f;
+        return;
+    }
+
+    const float x = n[0] / l1Norm;
+    const float y = n[1] / l1Norm;
+    if(n[2] < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals
+        e[0] = (1.0f - fabsf(y)) * SignNotZero(x);
+        e[1] = (1.0f - fabsf(x)) * SignNotZero(y);
+    }
+    else
+    {
+        e[0] = x;
+        e[1] = y;
+    }
+}
+
+void DecodeOctahedral(const float e[2], float n[3])
+{
+    float x = e[0];
+    float y = e[1];
+    const float z = 1.0f - fabsf(x) - fabsf(y);
+    const float t = std::min(std::max(-z, 0.0f), 1.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    const float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+    n[0] = x * invLength;
+    n[1] = y * invLength;
+    n[2] = z * invLength;
+}
+
+void PackTangent(const float tangent[3], float bitangentSign, uint16_t packed[2])
+{
+    float e[2];
+    EncodeOctahedral(tangent, e);
+    packed[0] = QuantizeUNorm16(e[0] * 0.5f + 0.5f);
+
+    const uint16_t y = uint16_t(std::min(std::max(e[1] * 0.5f + 0.5f, 0.0f), 1.0f) * 32767.0f + 0.5f);
+    packed[1] = uint16_t(y << 1) | (bitangentSign >= 0.0f ? 1 : 0);
+}
+
+void UnpackTangent(const uint16_t packed[2], float tangent[3], float& bitangentSign)
+{
+    float e[2];
+    e[0] = DequantizeUNorm16(packed[0]) * 2.0f - 1.0f;
+    e[1] = (packed[1] >> 1) / 32767.0f * 2.0f - 1.0f;
+    bitangentSign = (packed[1] & 1) ? 1.0f : -1.0f;
+    DecodeOctahedral(e, tangent);
+}
+
+}
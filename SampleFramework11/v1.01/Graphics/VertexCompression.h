@@ -0,0 +1,55 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// This header is platform-neutral, and doesn't include PCH.h, so that the encoding can be tested
+// on its own (see Tests/VertexCompressionTests.cpp). Vectors are passed as arrays of floats, so a
+// Float2 or Float3 can be passed with &v.x.
+
+#include <stdint.h>
+#include <algorithm>
+
+namespace SampleFramework11
+{
+
+// CPU-side encoding and decoding for the compressed vertex format. The decoding functions
+// match the ones in VertexCompression.hlsl.
+
+inline uint16_t QuantizeUNorm16(float x)
+{
+    return uint16_t(std::min(std::max(x, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+inline float DequantizeUNorm16(uint16_t x)
+{
+    return x / 65535.0f;
+}
+
+inline int16_t QuantizeSNorm16(float x)
+{
+    const float scaled = std::min(std::max(x, -1.0f), 1.0f) * 32767.0f;
+    return int16_t(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+inline float DequantizeSNorm16(int16_t x)
+{
+    return std::max(x / 32767.0f, -1.0f);
+}
+
+// Maps a unit vector onto the octahedron, and unfolds it into a square in [-1, 1]
+void EncodeOctahedral(const float n[3], float e[2]);
+void DecodeOctahedral(const float e[2], float n[3]);
+
+// Stores an octahedral tangent as 16 + 15 bits, with the sign of the bitangent in the lowest
+// bit. The bitangent is reconstructed as cross(normal, tangent) * sign.
+void PackTangent(const float tangent[3], float bitangentSign, uint16_t packed[2]);
+void UnpackTangent(const uint16_t packed[2], float tangent[3], float& bitangentSign);
+
+}
@@ -132,6 +132,11 @@ using namespace DirectX::PackedVector;
 #include <cstdio>
 #include <cstdarg>
 #include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 // AntTweakBar
 #include "..\\..\\Externals\\AntTweakBar\\include\\AntTweakBar.h"
@@ -23,22 +23,35 @@ class FileReadSerializer
 private:
 
     File file;
+    uint64 fileSize = 0;
+    uint64 offset = 0;
 
 public:
 
     explicit FileReadSerializer(const wchar* path)
     {
         file.Open(path, FileOpenMode::Read);
+        fileSize = file.Size();
     }
 
     template<typename T> void SerializeItem(T& data)
     {
-        file.Read(data);
+        SerializeData(sizeof(T), &data);
     }
 
     void SerializeData(uint64 size, void* data)
     {
+        if(size > fileSize - offset)
+            throw Exception(L"Attempted to read past the end of the serialized data");
+
         file.Read(size, data);
+        offset += size;
+    }
+
+    void CheckNumItems(uint64 numItems, uint64 itemSize)
+    {
+        if(numItems > (fileSize - offset) / itemSize)
+            throw Exception(L"Serialized item count is larger than the remaining data");
     }
 
     static bool IsReadSerializer() { return true; }
@@ -69,10 +82,86 @@ public:
         file.Write(size, data);
     }
 
+    void CheckNumItems(uint64 numItems, uint64 itemSize)
+    {
+    }
+
     static bool IsReadSerializer() { return false; }
     static bool IsWriteSerializer() { return true; }
 };
 
+// Reads from a block of memory that's owned by the caller, such as a memory-mapped file
+class MemoryReadSerializer
+{
+
+private:
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    uint64 offset = 0;
+
+public:
+
+    MemoryReadSerializer(const void* data_, uint64 size_) : data(reinterpret_cast<const uint8*>(data_)), size(size_)
+    {
+    }
+
+    template<typename T> void SerializeItem(T& item)
+    {
+        SerializeData(sizeof(T), &item);
+    }
+
+    void SerializeData(uint64 numBytes, void* dst)
+    {
+        if(numBytes > size - offset)
+            throw Exception(L"Attempted to read past the end of the serialized data");
+
+        memcpy(dst, data + offset, numBytes);
+        offset += numBytes;
+    }
+
+    void CheckNumItems(uint64 numItems, uint64 itemSize)
+    {
+        if(numItems > (size - offset) / itemSize)
+            throw Exception(L"Serialized item count is larger than the remaining data");
+    }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+class MemoryWriteSerializer
+{
+
+private:
+
+    std::vector<uint8> buffer;
+
+public:
+
+    template<typename T> void SerializeItem(const T& item)
+    {
+        SerializeData(sizeof(T), &item);
+    }
+
+    void SerializeData(uint64 numBytes, const void* src)
+    {
+        const uint64 offset = buffer.size();
+        buffer.resize(offset + numBytes);
+        if(numBytes > 0)
+            memcpy(&buffer[offset], src, numBytes);
+    }
+
+    void CheckNumItems(uint64 numItems, uint64 itemSize)
+    {
+    }
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+
+    const std::vector<uint8>& Buffer() const { return buffer; }
+};
+
 class ComputeSizeSerializer
 {
 
@@ -92,6 +181,10 @@ public:
         numBytes += size;
     }
 
+    void CheckNumItems(uint64 numItems, uint64 itemSize)
+    {
+    }
+
     static bool IsReadSerializer() { return false; }
     static bool IsWriteSerializer() { return true; }
 
@@ -199,11 +292,15 @@ void SerializeRawArray(TSerializer& serializer, TValue* array, uint64 numElement
     SerializeData(serializer, array, sizeof(TValue) * numElements);
 }
 
+// Reading a count checks it against the data that's left before anything gets allocated, so that
+// corrupt data throws an Exception instead of a huge allocation. Every serialized element takes up
+// at least one byte.
 template<typename TSerializer, typename TVector>
 void SerializeItem(TSerializer& serializer, std::vector<TVector>& vec)
 {
     uint64 numElements = vec.size();
     SerializeItem(serializer, numElements);
+    serializer.CheckNumItems(numElements, 1);
     if(vec.size() != numElements)
         vec.resize(numElements);
 
@@ -218,6 +315,7 @@ void SerializeRawVector(TSerializer& serializer, std::vector<TVector>& vec)
 {
     uint64 numElements = vec.size();
     SerializeItem(serializer, numElements);
+    serializer.CheckNumItems(numElements, sizeof(TVector));
     if(vec.size() != numElements)
         vec.resize(numElements);
 
@@ -232,6 +330,7 @@ void SerializeItem(TSerializer& serializer, std::basic_string<TString>& str)
 {
     uint64 numChars = str.length();
     SerializeItem(serializer, numChars);
+    serializer.CheckNumItems(numChars, sizeof(TString));
     if(str.length() != numChars)
         str.resize(numChars);
 
@@ -0,0 +1,32 @@
+//=================================================================================================
+//
+//	MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+//=================================================================================================
+// Decoding for the compressed vertex format, see Graphics/VertexCompression.h
+//=================================================================================================
+
+// Decodes a unit vector from an unfolded octahedron in [-1, 1]
+float3 DecodeOctahedral(in float2 e)
+{
+	float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+// Decodes a tangent stored as 16 + 15 bits, with the bitangent sign in the lowest bit
+float3 UnpackTangent(in uint2 packed, out float bitangentSign)
+{
+	float2 e;
+	e.x = (packed.x / 65535.0f) * 2.0f - 1.0f;
+	e.y = ((packed.y >> 1) / 32767.0f) * 2.0f - 1.0f;
+	bitangentSign = (packed.y & 1) ? 1.0f : -1.0f;
+	return DecodeOctahedral(e);
+}
@@ -0,0 +1,189 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ThreadPool.h"
+#include "Assert.h"
+
+namespace SampleFramework11
+{
+
+// Set for worker threads, and for the calling thread while it's running a loop
+static __declspec(thread) bool insideParallelFor = false;
+
+ThreadPool ThreadPool::GlobalPool;
+
+ThreadPool::ThreadPool() : numThreads(0), currJob(nullptr), jobGeneration(0), shuttingDown(false)
+{
+    numWorkersInJob = 0;
+}
+
+ThreadPool::~ThreadPool()
+{
+    Shutdown();
+}
+
+void ThreadPool::Initialize(uint32 numThreads_)
+{
+    std::lock_guard<std::mutex> initLock(initMutex);
+    if(numThreads > 0)
+        return;
+
+    if(numThreads_ == 0)
+        numThreads_ = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+
+    shuttingDown = false;
+    jobGeneration = 0;
+    currJob = nullptr;
+
+    // The thread calling ParallelFor is always thread 0
+    workers.reserve(numThreads_ - 1);
+    for(uint32 i = 1; i < numThreads_; ++i)
+        workers.push_back(std::thread(&ThreadPool::WorkerThread, this, i));
+
+    numThreads = numThreads_;
+}
+
+void ThreadPool::Shutdown()
+{
+    std::lock_guard<std::mutex> initLock(initMutex);
+    if(numThreads == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        shuttingDown = true;
+    }
+    queueCV.notify_all();
+
+    for(uint64 i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    workers.clear();
+    numThreads = 0;
+}
+
+void ThreadPool::RunJob(Job& job, uint32 threadIdx)
+{
+    while(true)
+    {
+        const uint64 start = job.NextItem.fetch_add(job.GrainSize);
+        if(start >= job.Count)
+            break;
+
+        const uint64 end = std::min(start + job.GrainSize, job.Count);
+        try
+        {
+            (*job.Func)(start, end, threadIdx);
+        }
+        catch(...)
+        {
+            // Keep the first exception for the calling thread, and stop handing out items
+            std::lock_guard<std::mutex> exceptionLock(job.ExceptionMutex);
+            if(job.Exception == nullptr)
+                job.Exception = std::current_exception();
+            job.NextItem = job.Count;
+            break;
+        }
+    }
+}
+
+void ThreadPool::WorkerThread(uint32 threadIdx)
+{
+    insideParallelFor = true;
+
+    uint64 lastGeneration = 0;
+    while(true)
+    {
+        Job* job = nullptr;
+
+        {
+            std::unique_lock<std::mutex> queueLock(queueMutex);
+            queueCV.wait(queueLock, [&]() { return shuttingDown || jobGeneration != lastGeneration; });
+
+            if(shuttingDown)
+                return;
+
+            lastGeneration = jobGeneration;
+            job = currJob;
+
+            // The job can already be finished and retired by the time we wake up
+            if(job == nullptr)
+                continue;
+
+            ++numWorkersInJob;
+        }
+
+        RunJob(*job, threadIdx);
+
+        --numWorkersInJob;
+    }
+}
+
+void ThreadPool::ParallelFor(uint64 count, uint64 grainSize, const ParallelForFunc& func)
+{
+    if(count == 0)
+        return;
+
+    grainSize = std::max<uint64>(grainSize, 1);
+
+    Initialize();
+
+    // Run serially if there's nothing to split up, if we're being called from inside of another
+    // loop, or if another thread is already using the pool
+    bool serial = numThreads <= 1 || count <= grainSize || insideParallelFor;
+    std::unique_lock<std::mutex> jobLock(jobMutex, std::defer_lock);
+    if(serial == false)
+        serial = jobLock.try_lock() == false;
+
+    if(serial)
+    {
+        func(0, count, 0);
+        return;
+    }
+
+    insideParallelFor = true;
+
+    Job job;
+    job.Func = &func;
+    job.Count = count;
+    job.GrainSize = grainSize;
+    job.NextItem = 0;
+
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        currJob = &job;
+        ++jobGeneration;
+    }
+    queueCV.notify_all();
+
+    RunJob(job, 0);
+
+    // Retire the job so that late-waking workers don't pick it up, and then wait for any
+    // workers that are still holding a pointer to it. They finish off any items they've
+    // already grabbed before letting go of it.
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        currJob = nullptr;
+    }
+
+    while(numWorkersInJob.load() > 0)
+        std::this_thread::yield();
+
+    insideParallelFor = false;
+
+    if(job.Exception != nullptr)
+    {
+        jobLock.unlock();
+        std::rethrow_exception(job.Exception);
+    }
+}
+
+}
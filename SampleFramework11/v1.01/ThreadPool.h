@@ -0,0 +1,88 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+namespace SampleFramework11
+{
+
+// Processes the items in [start, end). threadIdx is in the range [0, NumThreads()), and can
+// be used to index into per-thread scratch data.
+typedef std::function<void(uint64 start, uint64 end, uint32 threadIdx)> ParallelForFunc;
+
+// A simple pool of worker threads for data-parallel loops. The calling thread always takes part
+// in the work, and ParallelFor doesn't return until every item has been processed. Nested calls
+// (or calls from a second thread while a loop is already running) fall back to running serially
+// on the calling thread, so it's always safe to call. If func throws on any thread, no more items
+// are handed out, and the first exception is rethrown from ParallelFor once all of the threads
+// have stopped working on the loop.
+class ThreadPool
+{
+
+public:
+
+    static ThreadPool GlobalPool;
+
+    ThreadPool();
+    ~ThreadPool();
+
+    // Pass 0 to use one thread per hardware thread. Does nothing if already initialized.
+    void Initialize(uint32 numThreads = 0);
+    void Shutdown();
+
+    uint32 NumThreads() const { return numThreads; }
+
+    void ParallelFor(uint64 count, uint64 grainSize, const ParallelForFunc& func);
+
+protected:
+
+    struct Job
+    {
+        const ParallelForFunc* Func;
+        uint64 Count;
+        uint64 GrainSize;
+        std::atomic<uint64> NextItem;
+
+        std::mutex ExceptionMutex;
+        std::exception_ptr Exception;
+    };
+
+    void WorkerThread(uint32 threadIdx);
+    static void RunJob(Job& job, uint32 threadIdx);
+
+    std::vector<std::thread> workers;
+    uint32 numThreads;
+
+    std::mutex initMutex;
+    std::mutex jobMutex;
+    std::mutex queueMutex;
+    std::condition_variable queueCV;
+
+    Job* currJob;
+    uint64 jobGeneration;
+    std::atomic<uint32> numWorkersInJob;
+    bool shuttingDown;
+};
+
+// Runs func over [0, count) using the global thread pool
+inline void ParallelFor(uint64 count, uint64 grainSize, const ParallelForFunc& func)
+{
+    ThreadPool::GlobalPool.ParallelFor(count, grainSize, func);
+}
+
+// Returns the number of threads that ParallelFor can use, which is also the range of threadIdx
+inline uint32 NumWorkerThreads()
+{
+    ThreadPool::GlobalPool.Initialize();
+    return ThreadPool::GlobalPool.NumThreads();
+}
+
+}
@@ -44,6 +44,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "TinyEXR.h"
 
+// == SF11 Changes START ==========================================================================
+#include <atomic>
+#include "ThreadPool.h"
+#include "Graphics\\PixelConversion.h"
+// == SF11 Changes END ==========================================================================
+
 namespace {
 
 namespace miniz {
@@ -7365,6 +7371,433 @@ int LoadMultiChannelEXR(EXRImage *exrImage, const char *filename,
   return 0; // OK
 }
 
+// == SF11 Changes START ==========================================================================
+namespace {
+
+// Header and offset table of a single-part scanline image, along with the
+// layout of the uncompressed lines inside a block
+struct ScanlineLayout {
+  int width;
+  int height;
+  int compression;
+  int linesPerBlock;
+  std::vector<ChannelInfo> channels;
+  std::vector<int> channelOffsets; // Offset of each channel in a line, in bytes
+  int lineSize;                    // Size of a line with every channel, in bytes
+  std::vector<long long> offsets;
+};
+
+int ParseScanlineLayout(ScanlineLayout &layout, const unsigned char *data,
+                        size_t size, const char **err) {
+  const char *head = reinterpret_cast<const char *>(data);
+  const char *marker = head;
+
+  // Header check.
+  {
+    const char header[] = {0x76, 0x2f, 0x31, 0x01};
+
+    if (data == NULL || size < 8 || memcmp(marker, header, 4) != 0) {
+      if (err) {
+        (*err) = "Header mismatch.";
+      }
+      return -3;
+    }
+    marker += 4;
+  }
+
+  // Version, scanline.
+  {
+    // must be [2, 0, 0, 0]
+    if (marker[0] != 2 || marker[1] != 0 || marker[2] != 0 || marker[3] != 0) {
+      if (err) {
+        (*err) = "Unsupported version or scanline.";
+      }
+      return -4;
+    }
+
+    marker += 4;
+  }
+
+  int dataWindow[4] = {0, 0, -1, -1};
+  layout.compression = -1;
+  layout.channels.clear();
+
+  // Read attributes
+  for (;;) {
+    if (marker >= head + size) {
+      if (err) {
+        (*err) = "Truncated header.";
+      }
+      return -4;
+    }
+
+    std::string attrName;
+    std::string attrType;
+    std::vector<unsigned char> attrData;
+    const char *marker_next = ReadAttribute(attrName, attrType, attrData, marker);
+    if (marker_next == NULL) {
+      marker++; // skip '\0'
+      break;
+    }
+
+    if (attrName.compare("compression") == 0) {
+      layout.compression = attrData.at(0);
+    } else if (attrName.compare("channels") == 0) {
+      ReadChannelInfo(layout.channels, attrData);
+    } else if (attrName.compare("dataWindow") == 0) {
+      memcpy(dataWindow, &attrData.at(0), sizeof(dataWindow));
+      if (IsBigEndian()) {
+        for (int i = 0; i < 4; i++) {
+          swap4(reinterpret_cast<unsigned int*>(&dataWindow[i]));
+        }
+      }
+    }
+
+    marker = marker_next;
+  }
+
+  // No compression and ZIPS store one line per block, ZIP stores 16
+  if (layout.compression == 0 || layout.compression == 2) {
+    layout.linesPerBlock = 1;
+  } else if (layout.compression == 3) {
+    layout.linesPerBlock = 16;
+  } else {
+    if (err) {
+      (*err) = "Unsupported compression type.";
+    }
+    return -5;
+  }
+
+  layout.width = dataWindow[2] - dataWindow[0] + 1;
+  layout.height = dataWindow[3] - dataWindow[1] + 1;
+  if (layout.width <= 0 || layout.height <= 0) {
+    if (err) {
+      (*err) = "Invalid data window.";
+    }
+    return -7;
+  }
+
+  if (layout.channels.empty()) {
+    if (err) {
+      (*err) = "Invalid channels format.";
+    }
+    return -6;
+  }
+
+  layout.channelOffsets.resize(layout.channels.size());
+  layout.lineSize = 0;
+  for (size_t c = 0; c < layout.channels.size(); c++) {
+    const ChannelInfo &info = layout.channels[c];
+    if ((info.pixelType != 1 && info.pixelType != 2) || info.xSampling != 1 ||
+        info.ySampling != 1) {
+      if (err) {
+        (*err) = "Unsupported channel format.";
+      }
+      return -6;
+    }
+
+    layout.channelOffsets[c] = layout.lineSize;
+    layout.lineSize += (info.pixelType == 1 ? 2 : 4) * layout.width;
+  }
+
+  // Read offset tables.
+  int numBlocks = (layout.height + layout.linesPerBlock - 1) / layout.linesPerBlock;
+  if (size_t(marker - head) + sizeof(long long) * numBlocks > size) {
+    if (err) {
+      (*err) = "Truncated offset table.";
+    }
+    return -8;
+  }
+
+  layout.offsets.resize(numBlocks);
+  for (int i = 0; i < numBlocks; i++) {
+    long long offset;
+    memcpy(&offset, marker, sizeof(long long));
+    if (IsBigEndian()) {
+      swap8(reinterpret_cast<unsigned long long*>(&offset));
+    }
+    marker += sizeof(long long);
+
+    if (offset < 0 || size_t(offset) + 8 > size) {
+      if (err) {
+        (*err) = "Invalid offset table.";
+      }
+      return -8;
+    }
+    layout.offsets[i] = offset;
+  }
+
+  return 0;
+}
+
+// Uncompresses one block of lines into buf, returning false if the block is
+// damaged. Samples are converted to the native byte order.
+bool DecodeScanlineBlock(std::vector<unsigned char> &buf,
+                         const ScanlineLayout &layout,
+                         const unsigned char *data, size_t size, int block) {
+  const unsigned char *blockData = data + layout.offsets[block];
+
+  // 4 byte: scan line
+  // 4 byte: data size
+  // ~     : pixel data(uncompressed or compressed)
+  int dataLen;
+  memcpy(&dataLen, blockData + 4, sizeof(int));
+  if (IsBigEndian()) {
+    swap4(reinterpret_cast<unsigned int*>(&dataLen));
+  }
+  if (dataLen <= 0 || size_t(layout.offsets[block]) + 8 + dataLen > size) {
+    return false;
+  }
+
+  const int numLines = std::min(layout.linesPerBlock,
+                                layout.height - block * layout.linesPerBlock);
+  const unsigned long blockSize = (unsigned long)(numLines) * layout.lineSize;
+  buf.resize(blockSize);
+
+  // Blocks that don't get any smaller when compressed are stored as-is
+  if ((unsigned long)(dataLen) == blockSize) {
+    memcpy(&buf.at(0), blockData + 8, blockSize);
+  } else if (layout.compression == 0) {
+    return false;
+  } else {
+    unsigned long outSize = blockSize;
+    DecompressZip(&buf.at(0), outSize, blockData + 8, dataLen);
+    if (outSize != blockSize) {
+      return false;
+    }
+  }
+
+  if (IsBigEndian()) {
+    for (int y = 0; y < numLines; y++) {
+      for (size_t c = 0; c < layout.channels.size(); c++) {
+        unsigned char *samples =
+            &buf.at(y * layout.lineSize + layout.channelOffsets[c]);
+        for (int x = 0; x < layout.width; x++) {
+          if (layout.channels[c].pixelType == 1) {
+            swap2(reinterpret_cast<unsigned short*>(samples) + x);
+          } else {
+            swap4(reinterpret_cast<unsigned int*>(samples) + x);
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+int GetEXRSizeFromMemory(const unsigned char *data, size_t size, int *width,
+                         int *height, const char **err) {
+  if (width == NULL || height == NULL) {
+    if (err) {
+      (*err) = "Invalid argument.";
+    }
+    return -1;
+  }
+
+  ScanlineLayout layout;
+  int ret = ParseScanlineLayout(layout, data, size, err);
+  if (ret != 0) {
+    return ret;
+  }
+
+  (*width) = layout.width;
+  (*height) = layout.height;
+
+  return 0; // OK
+}
+
+int LoadStridedEXRFromMemory(const EXRStridedRegion *region,
+                             const unsigned char *data, size_t size,
+                             const char **err) {
+  if (region == NULL || region->num_channels <= 0 ||
+      (region->pixel_type != 1 && region->pixel_type != 2) ||
+      region->width <= 0 || region->height <= 0 || region->x < 0 ||
+      region->y < 0 || region->level < 0 || region->level > 24) {
+    if (err) {
+      (*err) = "Invalid argument.";
+    }
+    return -1;
+  }
+
+  ScanlineLayout layout;
+  int ret = ParseScanlineLayout(layout, data, size, err);
+  if (ret != 0) {
+    return ret;
+  }
+
+  if (region->x >= layout.width || region->y >= layout.height) {
+    if (err) {
+      (*err) = "Region is outside of the image.";
+    }
+    return -1;
+  }
+
+  // Output channels that the file doesn't have get their fill value
+  const int numChannels = region->num_channels;
+  std::vector<int> srcChannels(numChannels, -1);
+  for (int c = 0; c < numChannels; c++) {
+    for (size_t i = 0; i < layout.channels.size(); i++) {
+      if (region->channel_names[c] != NULL &&
+          layout.channels[i].name.compare(region->channel_names[c]) == 0) {
+        srcChannels[c] = int(i);
+      }
+    }
+  }
+
+  // Each output pixel averages a scale x scale square of file pixels, with
+  // anything past the right or bottom edge clamped to the edge
+  const int scale = 1 << region->level;
+  const float weight = 1.0f / (float(scale) * float(scale));
+  const int outWidth = region->width;
+  const size_t outRowSize = size_t(outWidth) * region->pixel_stride;
+
+  // Work items cover a few blocks' worth of lines. Threads keep their last
+  // uncompressed block around, since the next row usually needs it too.
+  struct ThreadScratch {
+    std::vector<unsigned char> block;
+    int blockIdx;
+    std::vector<float> sums;
+    std::vector<float> samples;
+    std::vector<unsigned short> halves;
+  };
+  std::vector<ThreadScratch> scratch(SampleFramework11::NumWorkerThreads());
+  for (size_t i = 0; i < scratch.size(); i++) {
+    scratch[i].blockIdx = -1;
+  }
+
+  const uint64 rowsPerWorkItem =
+      std::max(4 * layout.linesPerBlock / scale, 1);
+
+  // The part of each line that the region reads from
+  const int spanWidth =
+      std::min(region->x + outWidth * scale, layout.width) - region->x;
+  std::atomic<bool> damaged(false);
+
+  SampleFramework11::ParallelFor(region->height, rowsPerWorkItem,
+                                 [&](uint64 startRow, uint64 endRow,
+                                     uint32 threadIdx) {
+    ThreadScratch &ts = scratch[threadIdx];
+    ts.sums.resize(size_t(numChannels) * outWidth);
+    ts.samples.resize(spanWidth);
+    ts.halves.resize(outWidth);
+
+    for (int oy = int(startRow); oy < int(endRow); oy++) {
+      if (damaged) {
+        return;
+      }
+
+      std::fill(ts.sums.begin(), ts.sums.end(), 0.0f);
+
+      for (int dy = 0; dy < scale; dy++) {
+        const int sy = std::min(region->y + oy * scale + dy, layout.height - 1);
+        const int block = sy / layout.linesPerBlock;
+        if (block != ts.blockIdx) {
+          ts.blockIdx = -1;
+          if (DecodeScanlineBlock(ts.block, layout, data, size, block) == false) {
+            damaged = true;
+            return;
+          }
+          ts.blockIdx = block;
+        }
+
+        const unsigned char *line =
+            &ts.block.at((sy - block * layout.linesPerBlock) * layout.lineSize);
+
+        for (int c = 0; c < numChannels; c++) {
+          const int srcChannel = srcChannels[c];
+          if (srcChannel < 0) {
+            continue;
+          }
+
+          const unsigned char *samples = line + layout.channelOffsets[srcChannel];
+          const int pixelType = layout.channels[srcChannel].pixelType;
+          float *sums = &ts.sums[size_t(c) * outWidth];
+
+          // Half samples going to half outputs at full size are copied
+          // as-is, so that they don't pick up any rounding
+          if (scale == 1 && pixelType == 1 && region->pixel_type == 1) {
+            unsigned short *dst =
+                reinterpret_cast<unsigned short *>(region->channels[c]) +
+                oy * outRowSize;
+            const unsigned short *src =
+                reinterpret_cast<const unsigned short *>(samples);
+            for (int ox = 0; ox < outWidth; ox++) {
+              dst[ox * region->pixel_stride] =
+                  src[std::min(region->x + ox, layout.width - 1)];
+            }
+            continue;
+          }
+
+          // Half samples are converted to floats for the part of the line
+          // that the region covers
+          const float *span;
+          if (pixelType == 1) {
+            SampleFramework11::PixelConversion::HalfToFloat(
+                reinterpret_cast<const unsigned short *>(samples) + region->x,
+                &ts.samples[0], spanWidth);
+            span = &ts.samples[0];
+          } else {
+            span = reinterpret_cast<const float *>(samples) + region->x;
+          }
+
+          for (int ox = 0; ox < outWidth; ox++) {
+            const int sx = ox * scale;
+            float sum = 0.0f;
+            for (int dx = 0; dx < scale; dx++) {
+              sum += span[std::min(sx + dx, spanWidth - 1)];
+            }
+            sums[ox] += sum;
+          }
+        }
+      }
+
+      for (int c = 0; c < numChannels; c++) {
+        const int srcChannel = srcChannels[c];
+        if (scale == 1 && srcChannel >= 0 && region->pixel_type == 1 &&
+            layout.channels[srcChannel].pixelType == 1) {
+          continue; // Already copied
+        }
+
+        const float fill = region->fill_values ? region->fill_values[c] : 0.0f;
+        float *sums = &ts.sums[size_t(c) * outWidth];
+        for (int ox = 0; ox < outWidth; ox++) {
+          sums[ox] = srcChannel >= 0 ? sums[ox] * weight : fill;
+        }
+
+        if (region->pixel_type == 1) {
+          SampleFramework11::PixelConversion::FloatToHalf(sums, &ts.halves[0],
+                                                          outWidth);
+          unsigned short *dst =
+              reinterpret_cast<unsigned short *>(region->channels[c]) +
+              oy * outRowSize;
+          for (int ox = 0; ox < outWidth; ox++) {
+            dst[ox * region->pixel_stride] = ts.halves[ox];
+          }
+        } else {
+          float *dst = reinterpret_cast<float *>(region->channels[c]) +
+                       oy * outRowSize;
+          for (int ox = 0; ox < outWidth; ox++) {
+            dst[ox * region->pixel_stride] = sums[ox];
+          }
+        }
+      }
+    }
+  });
+
+  if (damaged) {
+    if (err) {
+      (*err) = "Damaged scanline block.";
+    }
+    return -9;
+  }
+
+  return 0; // OK
+}
+// == SF11 Changes END ==========================================================================
+
 // @deprecated
 #if 0
 int SaveEXR(const float *in_rgba, int width, int height, const char *filename,
@@ -7537,6 +7970,7 @@ int SaveEXR(const float *in_rgba, int width, int height, const char *filename,
 }
 #endif
 
+// == SF11 Changes START ==========================================================================
 int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
                         const char **err) {
   if (exrImage == NULL || filename == NULL) {
@@ -7546,6 +7980,33 @@ int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
     return -1;
   }
 
+  std::vector<const void *> channels(exrImage->num_channels);
+  for (int c = 0; c < exrImage->num_channels; c++) {
+    channels[c] = exrImage->images[c];
+  }
+
+  EXRStridedImage image;
+  image.num_channels = exrImage->num_channels;
+  image.channel_names = exrImage->channel_names;
+  image.channels = channels.empty() ? NULL : &channels.at(0);
+  image.pixel_stride = 1;
+  image.pixel_type = 2; // FLOAT
+  image.width = exrImage->width;
+  image.height = exrImage->height;
+
+  return SaveStridedEXR(&image, filename, err);
+}
+
+int SaveStridedEXR(const EXRStridedImage *image, const char *filename,
+                   const char **err) {
+  if (image == NULL || filename == NULL || image->num_channels <= 0 ||
+      (image->pixel_type != 1 && image->pixel_type != 2)) {
+    if (err) {
+      (*err) = "Invalid argument.";
+    }
+    return -1;
+  }
+
   FILE *fp = fopen(filename, "wb");
   if (!fp) {
     if (err) {
@@ -7568,20 +8029,18 @@ int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
     assert(n == 4);
   }
 
-  int numScanlineBlocks = 16; // 16 for ZIP compression.
-
   // Write attributes.
   {
     std::vector<unsigned char> data;
 
     std::vector<ChannelInfo> channels;
-    for (int c = 0; c < exrImage->num_channels; c++) {
+    for (int c = 0; c < image->num_channels; c++) {
       ChannelInfo info;
       info.pLinear = 0;
       info.pixelType = 1; // Assume HALF
       info.xSampling = 1;
       info.ySampling = 1;
-      info.name = std::string(exrImage->channel_names[c]);
+      info.name = std::string(image->channel_names[c]);
       channels.push_back(info);
     }
 
@@ -7602,7 +8061,7 @@ int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
   }
 
   {
-    int data[4] = {0, 0, exrImage->width - 1, exrImage->height - 1};
+    int data[4] = {0, 0, image->width - 1, image->height - 1};
     if (IsBigEndian()) {
       swap4(reinterpret_cast<unsigned int*>(&data[0]));
       swap4(reinterpret_cast<unsigned int*>(&data[1]));
@@ -7644,7 +8103,7 @@ int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
   }
 
   {
-    float w = (float)exrImage->width;
+    float w = (float)image->width;
     if (IsBigEndian()) {
       swap4(reinterpret_cast<unsigned int*>(&w));
     }
@@ -7657,98 +8116,150 @@ int SaveMultiChannelEXR(const EXRImage *exrImage, const char *filename,
     fwrite(&e, 1, 1, fp);
   }
 
-  int numBlocks = exrImage->height / numScanlineBlocks;
-  if (numBlocks * numScanlineBlocks < exrImage->height) {
+  const int numScanlineBlocks = 16; // 16 for ZIP compression.
+  int numBlocks = image->height / numScanlineBlocks;
+  if (numBlocks * numScanlineBlocks < image->height) {
     numBlocks++;
   }
 
+  // The offset table comes before the blocks, so space is reserved for it
+  // here and it's filled in once every block has been written
   std::vector<long long> offsets(numBlocks);
+  const long offsetTablePos = ftell(fp);
+  if (fwrite(&offsets.at(0), 1, sizeof(long long) * numBlocks, fp) !=
+      sizeof(long long) * numBlocks) {
+    fclose(fp);
+    if (err) {
+      (*err) = "Failed to write a file.";
+    }
+    return -1;
+  }
 
-  size_t headerSize = ftell(fp); // sizeof(header)
-  long long offset =
-      headerSize +
-      numBlocks * sizeof(long long); // sizeof(header) + sizeof(offsetTable)
-
-  std::vector<unsigned char> data;
-
-
-  bool isBigEndian = IsBigEndian();
-
-  for (int i = 0; i < numBlocks; i++) {
-    int startY = numScanlineBlocks * i;
-    int endY = std::min(numScanlineBlocks * (i + 1), exrImage->height);
-    int h = endY - startY;
-
-    std::vector<unsigned short> buf(exrImage->num_channels * exrImage->width *
-                                    h);
-
-    for (int y = 0; y < h; y++) {
-      for (int c = 0; c < exrImage->num_channels; c++) {
-        for (int x = 0; x < exrImage->width; x++) {
-          FP32 f32;
-          f32.f = exrImage->images[c][(y + startY) * exrImage->width + x];
-
-          FP16 h16;
-          h16 = float_to_half_full(f32);
+  const bool isBigEndian = IsBigEndian();
+  const int numChannels = image->num_channels;
+  const int width = image->width;
+
+  // Blocks are converted and compressed in parallel. Whichever thread
+  // finishes the next block in file order writes it out, along with any
+  // blocks after it that are already done, so they're streamed to disk in
+  // order without holding the whole compressed image in memory.
+  std::vector<std::vector<unsigned char> > blocks(numBlocks);
+  std::vector<unsigned char> blockReady(numBlocks, 0);
+  std::mutex writeMutex;
+  int nextBlockToWrite = 0;
+  long long offset = offsetTablePos + sizeof(long long) * numBlocks;
+  bool writeFailed = false;
+
+  std::vector<std::vector<unsigned short> > halfScratch(
+      SampleFramework11::NumWorkerThreads());
+  std::vector<std::vector<float> > floatScratch(
+      SampleFramework11::NumWorkerThreads());
+
+  SampleFramework11::ParallelFor(numBlocks, 1, [&](uint64 startBlock, uint64 endBlock,
+                                                   uint32 threadIdx) {
+    std::vector<unsigned short> &buf = halfScratch[threadIdx];
+    std::vector<float> &floatRow = floatScratch[threadIdx];
+    floatRow.resize(width);
+    for (int i = int(startBlock); i < int(endBlock); i++) {
+      int startY = numScanlineBlocks * i;
+      int endY = std::min(numScanlineBlocks * (i + 1), image->height);
+      int h = endY - startY;
+
+      buf.resize(numChannels * width * h);
+
+      for (int y = 0; y < h; y++) {
+        for (int c = 0; c < numChannels; c++) {
+          unsigned short *dst = &buf.at(numChannels * y * width + c * width);
+          const size_t srcStart = size_t(y + startY) * width * image->pixel_stride;
+
+          if (image->pixel_type == 1) {
+            const unsigned short *src =
+                reinterpret_cast<const unsigned short *>(image->channels[c]) + srcStart;
+            for (int x = 0; x < width; x++) {
+              dst[x] = src[x * image->pixel_stride];
+            }
+          } else {
+            // Floats are gathered into a row so that they can be converted
+            // with SIMD, and clamped so that they don't turn into infinity
+            const float *src =
+                reinterpret_cast<const float *>(image->channels[c]) + srcStart;
+            if (image->pixel_stride != 1) {
+              for (int x = 0; x < width; x++) {
+                floatRow[x] = src[x * image->pixel_stride];
+              }
+              src = &floatRow[0];
+            }
+            SampleFramework11::PixelConversion::FloatToHalf(src, dst, width,
+                                                            true);
+          }
 
           if (isBigEndian) {
-            swap2(reinterpret_cast<unsigned short*>(&h16.u));
+            for (int x = 0; x < width; x++) {
+              swap2(&dst[x]);
+            }
           }
-
-          // Assume increasing Y
-          buf[exrImage->num_channels * y * exrImage->width +
-              c * exrImage->width + x] = h16.u;
         }
       }
-    }
 
-    int bound = miniz::mz_compressBound(buf.size() * sizeof(unsigned short));
-
-    std::vector<unsigned char> block(
-        miniz::mz_compressBound(buf.size() * sizeof(unsigned short)));
-    unsigned long long outSize = block.size();
-
-    CompressZip(&block.at(0), outSize,
-                reinterpret_cast<const unsigned char *>(&buf.at(0)),
-                buf.size() * sizeof(unsigned short));
-
-    // 4 byte: scan line
-    // 4 byte: data size
-    // ~     : pixel data(compressed)
-    std::vector<unsigned char> header(8);
-    unsigned int dataLen = outSize; // truncate
-    memcpy(&header.at(0), &startY, sizeof(int));
-    memcpy(&header.at(4), &dataLen, sizeof(unsigned int));
-
-    if (IsBigEndian()) {
-      swap4(reinterpret_cast<unsigned int*>(&header.at(0)));
-      swap4(reinterpret_cast<unsigned int*>(&header.at(4)));
-    }
+      // 4 byte: scan line
+      // 4 byte: data size
+      // ~     : pixel data(compressed)
+      std::vector<unsigned char> &block = blocks[i];
+      block.resize(8 + miniz::mz_compressBound(buf.size() * sizeof(unsigned short)));
+      unsigned long long outSize = block.size() - 8;
+
+      CompressZip(&block.at(8), outSize,
+                  reinterpret_cast<const unsigned char *>(&buf.at(0)),
+                  buf.size() * sizeof(unsigned short));
+
+      unsigned int dataLen = outSize; // truncate
+      memcpy(&block.at(0), &startY, sizeof(int));
+      memcpy(&block.at(4), &dataLen, sizeof(unsigned int));
+      if (isBigEndian) {
+        swap4(reinterpret_cast<unsigned int*>(&block.at(0)));
+        swap4(reinterpret_cast<unsigned int*>(&block.at(4)));
+      }
+      block.resize(8 + dataLen);
+
+      std::lock_guard<std::mutex> lock(writeMutex);
+      blockReady[i] = 1;
+      while (nextBlockToWrite < numBlocks && blockReady[nextBlockToWrite]) {
+        std::vector<unsigned char> &readyBlock = blocks[nextBlockToWrite];
+        if (writeFailed == false &&
+            fwrite(&readyBlock.at(0), 1, readyBlock.size(), fp) != readyBlock.size()) {
+          writeFailed = true;
+        }
 
-    data.insert(data.end(), header.begin(), header.end());
-    data.insert(data.end(), block.begin(), block.begin() + dataLen);
+        offsets[nextBlockToWrite] = offset;
+        if (isBigEndian) {
+          swap8(reinterpret_cast<unsigned long long*>(&offsets[nextBlockToWrite]));
+        }
+        offset += readyBlock.size();
 
-    offsets[i] = offset;
-    if (IsBigEndian()) {
-      swap8(reinterpret_cast<unsigned long long*>(&offsets[i]));
+        std::vector<unsigned char>().swap(readyBlock);
+        nextBlockToWrite++;
+      }
     }
-    offset += dataLen + 8; // 8 = sizeof(blockHeader)
-  }
+  });
 
-  {
+  if (writeFailed == false) {
+    fseek(fp, offsetTablePos, SEEK_SET);
     size_t n = fwrite(&offsets.at(0), 1, sizeof(unsigned long long) * numBlocks, fp);
-    assert(n == sizeof(unsigned long long) * numBlocks);
-  }
-
-  {
-    size_t n = fwrite(&data.at(0), 1, data.size(), fp);
-    assert(n == data.size());
+    writeFailed = n != sizeof(unsigned long long) * numBlocks;
   }
 
   fclose(fp);
 
+  if (writeFailed) {
+    if (err) {
+      (*err) = "Failed to write a file.";
+    }
+    return -1;
+  }
+
   return 0; // OK
 }
+// == SF11 Changes END ==========================================================================
 
 int LoadDeepEXR(DeepImage *deepImage, const char *filename, const char **err) {
   if (deepImage == NULL) {
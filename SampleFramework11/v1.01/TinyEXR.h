@@ -77,6 +77,61 @@ extern int LoadMultiChannelEXR(EXRImage *image, const char *filename,
 extern int SaveMultiChannelEXR(const EXRImage *image, const char *filename,
                                const char **err);
 
+// == SF11 Changes START ==========================================================================
+typedef struct {
+  int num_channels;
+  const char **channel_names; // Must be sorted alphabetically, like OpenEXR expects
+  const void **channels;      // channels[c] points to the value of channel c for the first pixel
+  int pixel_stride;           // Number of values between pixels: 1 for planar data, 4 for RGBA
+  int pixel_type;             // Type of the input values: 1 = half, 2 = float
+  int width;
+  int height;
+} EXRStridedImage;
+
+// Saves a single-frame OpenEXR image from channels that can be interleaved
+// in memory, such as the texels of an RGBA texture. Channels are stored as
+// half and compressed with ZIP, with the scanline blocks compressed in
+// parallel on the framework's thread pool and written to the file in order.
+// Float values are rounded to nearest even, and values past the range of a
+// half are clamped to +/-65504 instead of becoming infinity.
+// Return 0 if success
+// Returns error string in `err` when there's an error
+extern int SaveStridedEXR(const EXRStridedImage *image, const char *filename,
+                          const char **err);
+
+typedef struct {
+  int num_channels;
+  const char **channel_names; // File channel to read into each output channel
+  void **channels;            // channels[c] points to output channel c of the first pixel
+  const float *fill_values;   // Written to channels that the file doesn't have, or NULL for 0
+  int pixel_stride;           // Number of values between pixels, rows are width pixels apart
+  int pixel_type;             // Type of the output values: 1 = half, 2 = float
+  int x;                      // Top-left corner of the region, in pixels of the full image
+  int y;
+  int width;                  // Size of the output
+  int height;
+  int level;                  // Output pixels average 2^level x 2^level pixels of the image
+} EXRStridedRegion;
+
+// Reads the size of the data window of a single-frame scanline OpenEXR
+// image that's already in memory.
+// Return 0 if success
+// Returns error string in `err` when there's an error
+extern int GetEXRSizeFromMemory(const unsigned char *data, size_t size,
+                                int *width, int *height, const char **err);
+
+// Loads a region of a single-frame scanline OpenEXR image that's already in
+// memory, optionally box-filtered down to a lower mip level. Only the blocks
+// that overlap the region are uncompressed, and they're uncompressed in
+// parallel on the framework's thread pool. Half and float channels are
+// supported, with no compression, ZIPS or ZIP.
+// Return 0 if success
+// Returns error string in `err` when there's an error
+extern int LoadStridedEXRFromMemory(const EXRStridedRegion *region,
+                                    const unsigned char *data, size_t size,
+                                    const char **err);
+// == SF11 Changes END ==========================================================================
+
 // Loads single-frame OpenEXR deep image.
 // Application must free memory of variables in DeepImage(image, offset_table)
 // Return 0 if success
@@ -0,0 +1,191 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// Checks the skyline allocator's placement, failure handling and stats, and packs a large number
+// of random rectangle sets to make sure that nothing ever overlaps or leaves the atlas
+
+#include "TestUtils.h"
+
+#include <Graphics/AtlasAllocator.h>
+
+#include <math.h>
+#include <random>
+
+using namespace SampleFramework11;
+
+// Every allocated rectangle has to be inside the atlas, and at least the padding away from the others
+static bool RectsAreValid(const AtlasRect* rects, uint32_t count, uint32_t width, uint32_t height, uint32_t padding)
+{
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        const AtlasRect& a = rects[i];
+        if(a.Width == 0 || a.Height == 0)
+            continue;
+
+        if(a.X + a.Width > width || a.Y + a.Height > height)
+            return false;
+
+        for(uint32_t j = i + 1; j < count; ++j)
+        {
+            const AtlasRect& b = rects[j];
+            if(b.Width == 0 || b.Height == 0)
+                continue;
+
+            const bool separateX = a.X + a.Width + padding <= b.X || b.X + b.Width + padding <= a.X;
+            const bool separateY = a.Y + a.Height + padding <= b.Y || b.Y + b.Height + padding <= a.Y;
+            if(separateX == false && separateY == false)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void TestBottomLeftPlacement()
+{
+    AtlasAllocator allocator;
+    allocator.Initialize(1024, 1024);
+
+    AtlasRect rects[4];
+    Check_(allocator.Allocate(512, 256, rects[0]));
+    Check_(allocator.Allocate(512, 512, rects[1]));
+    Check_(allocator.Allocate(256, 256, rects[2]));
+    Check_(allocator.Allocate(1024, 256, rects[3]));
+
+    // The lowest spot always wins, and the narrowest segment breaks ties
+    Check_(rects[0].X == 0 && rects[0].Y == 0);
+    Check_(rects[1].X == 512 && rects[1].Y == 0);
+    Check_(rects[2].X == 0 && rects[2].Y == 256);
+    Check_(rects[3].X == 0 && rects[3].Y == 512);
+    Check_(RectsAreValid(rects, 4, 1024, 1024, 0));
+
+    // 256x256 of the bottom-left corner is trapped beneath the skyline
+    const AtlasStats& stats = allocator.Stats();
+    Check_(stats.NumAllocations == 4 && stats.NumFailedAllocations == 0);
+    Check_(stats.AllocatedArea == 512 * 256 + 512 * 512 + 256 * 256 + 1024 * 256);
+    Check_(stats.SkylineArea == 1024 * 768);
+    Check_(fabsf(stats.Occupancy - 0.6875f) < 1e-6f);
+    Check_(fabsf(stats.Fragmentation - 1.0f / 12.0f) < 1e-6f);
+}
+
+static void TestExactFit()
+{
+    // With padding, rectangles that are exactly (size - padding) fill the atlas, since the padding
+    // of the last row and column can hang off the edge
+    AtlasAllocator allocator;
+    allocator.Initialize(1024, 1024, 16);
+
+    const uint32_t sizes[4] = { 504, 504, 504, 504 };
+    AtlasRect rects[4];
+    Check_(allocator.Repack(sizes, sizes, 4, rects));
+    Check_(RectsAreValid(rects, 4, 1024, 1024, 16));
+    Check_(allocator.Stats().NumFailedAllocations == 0);
+    Check_(allocator.Stats().AllocatedArea == 4 * 504 * 504);
+
+    // One more texel and there's only room for one of them, in either direction
+    const uint32_t bigSizes[4] = { 505, 505, 505, 505 };
+    Check_(allocator.Repack(bigSizes, bigSizes, 4, rects) == false);
+    Check_(allocator.Stats().NumAllocations == 1 && allocator.Stats().NumFailedAllocations == 3);
+
+    uint32_t numEmpty = 0;
+    for(uint32_t i = 0; i < 4; ++i)
+        numEmpty += rects[i] == AtlasRect() ? 1 : 0;
+    Check_(numEmpty == 3);
+}
+
+static void TestFailedAllocations()
+{
+    AtlasAllocator allocator;
+    allocator.Initialize(256, 128);
+
+    AtlasRect rect;
+    Check_(allocator.Allocate(257, 16, rect) == false);
+    Check_(allocator.Allocate(16, 129, rect) == false);
+    Check_(allocator.Allocate(256, 128, rect));
+    Check_(allocator.Allocate(1, 1, rect) == false);
+    Check_(allocator.Stats().NumAllocations == 1 && allocator.Stats().NumFailedAllocations == 3);
+    Check_(allocator.Stats().Occupancy == 1.0f);
+
+    // Reset clears everything, including the stats
+    allocator.Reset();
+    Check_(allocator.Stats().NumAllocations == 0 && allocator.Stats().NumFailedAllocations == 0);
+    Check_(allocator.Allocate(128, 128, rect) && rect.X == 0 && rect.Y == 0);
+}
+
+static void TestRandomRepacks()
+{
+    std::mt19937 rng(26);
+
+    const uint32_t NumPacks = 200000;
+    const uint32_t MaxRects = 12;
+
+    uint32_t numFullyPacked = 0;
+    for(uint32_t packIdx = 0; packIdx < NumPacks; ++packIdx)
+    {
+        const uint32_t width = 64 + rng() % 4033;
+        const uint32_t height = 64 + rng() % 4033;
+        const uint32_t padding = rng() % 2 == 0 ? 0 : 16;
+        const uint32_t count = 1 + rng() % MaxRects;
+
+        uint32_t widths[MaxRects];
+        uint32_t heights[MaxRects];
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            widths[i] = 1 + rng() % (width / 2);
+            heights[i] = rng() % 4 == 0 ? widths[i] : 1 + rng() % (height / 2);
+        }
+
+        AtlasAllocator allocator;
+        allocator.Initialize(width, height, padding);
+
+        AtlasRect rects[MaxRects];
+        const bool packed = allocator.Repack(widths, heights, count, rects);
+
+        if(Check_(RectsAreValid(rects, count, width, height, padding)) == false)
+        {
+            printf("Pack %u (%ux%u, padding %u) has overlapping rectangles\n", packIdx, width, height, padding);
+            break;
+        }
+
+        // The results come back in the same order as the inputs, and only failures are left empty
+        uint32_t numAllocated = 0;
+        uint64_t allocatedArea = 0;
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            if(rects[i].Width == 0)
+                continue;
+
+            Check_(rects[i].Width == widths[i] && rects[i].Height == heights[i]);
+            ++numAllocated;
+            allocatedArea += uint64_t(widths[i]) * heights[i];
+        }
+
+        const AtlasStats& stats = allocator.Stats();
+        Check_(packed == (numAllocated == count));
+        Check_(stats.NumAllocations == numAllocated && stats.NumAllocations + stats.NumFailedAllocations == count);
+        Check_(stats.AllocatedArea == allocatedArea);
+        Check_(stats.Occupancy >= 0.0f && stats.Occupancy <= 1.0f);
+        Check_(stats.Fragmentation >= 0.0f && stats.Fragmentation <= 1.0f);
+
+        numFullyPacked += packed ? 1 : 0;
+    }
+
+    printf("Packed %u random sets of up to %u rectangles, %u of them without any failures\n", NumPacks,
+           MaxRects, numFullyPacked);
+}
+
+int main()
+{
+    TestBottomLeftPlacement();
+    TestExactFit();
+    TestFailedAllocations();
+    TestRandomRepacks();
+
+    return TestResult("AtlasAllocatorTests");
+}
@@ -0,0 +1,161 @@
+//=================================================================================================
+//
+//  Low-Resolution Rendering Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+// Checks the SSE depth min/max reduction against a plain scalar loop, and then measures its
+// throughput on 1080p, 4K and 8K depth buffers. The multithreaded numbers split the buffer into
+// the same 64K-texel work items that ReduceRawDepthCPU hands to ParallelFor. Threads are started
+// for every run here instead of being kept in a pool, so they slightly under-report what the
+// sample gets at the smaller sizes.
+
+#include "TestUtils.h"
+
+#include <DepthReductionKernel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const uint64_t GrainSize = 64 * 1024;
+static const uint32_t NumRuns = 20;
+
+static void ReduceScalar(const float* texels, uint64_t numTexels, float& minDepth, float& maxDepth)
+{
+    for(uint64_t i = 0; i < numTexels; ++i)
+    {
+        minDepth = std::min(minDepth, texels[i]);
+        if(texels[i] < 1.0f)
+            maxDepth = std::max(maxDepth, texels[i]);
+    }
+}
+
+static void ReduceMultithreaded(const float* texels, uint64_t numTexels, uint32_t numThreads,
+                                float& minDepth, float& maxDepth)
+{
+    std::atomic<uint64_t> nextItem(0);
+    std::vector<float> threadMins(numThreads, 1.0f);
+    std::vector<float> threadMaxes(numThreads, -1.0f);
+
+    auto worker = [&](uint32_t threadIdx)
+    {
+        while(true)
+        {
+            const uint64_t start = nextItem.fetch_add(GrainSize);
+            if(start >= numTexels)
+                break;
+            const uint64_t end = std::min(start + GrainSize, numTexels);
+            ReduceRawDepthRange(texels + start, end - start, threadMins[threadIdx], threadMaxes[threadIdx]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(uint32_t i = 1; i < numThreads; ++i)
+        threads.push_back(std::thread(worker, i));
+    worker(0);
+    for(uint64_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    for(uint32_t i = 0; i < numThreads; ++i)
+    {
+        minDepth = std::min(minDepth, threadMins[i]);
+        maxDepth = std::max(maxDepth, threadMaxes[i]);
+    }
+}
+
+// Random depths with about a fifth of the texels left at the far plane, like a scene with sky
+static std::vector<float> MakeDepthBuffer(uint64_t numTexels, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<float> texels(numTexels);
+    for(uint64_t i = 0; i < numTexels; ++i)
+        texels[i] = uniform(rng) < 0.2f ? 1.0f : uniform(rng) * 0.9f + 0.05f;
+    return texels;
+}
+
+static void TestMatchesScalar()
+{
+    // Sizes that leave a partial SSE block and a partial work item at the end
+    const uint64_t sizes[] = { 0, 1, 15, 16, 17, 1023, GrainSize - 1, GrainSize * 3 + 7 };
+    for(uint64_t size : sizes)
+    {
+        std::vector<float> texels = MakeDepthBuffer(size, uint32_t(size));
+
+        float expectedMin = 1.0f, expectedMax = -1.0f;
+        ReduceScalar(texels.data(), size, expectedMin, expectedMax);
+
+        float minDepth = 1.0f, maxDepth = -1.0f;
+        ReduceRawDepthRange(texels.data(), size, minDepth, maxDepth);
+        Check_(minDepth == expectedMin);
+        Check_(maxDepth == expectedMax);
+
+        minDepth = 1.0f, maxDepth = -1.0f;
+        ReduceMultithreaded(texels.data(), size, 4, minDepth, maxDepth);
+        Check_(minDepth == expectedMin);
+        Check_(maxDepth == expectedMax);
+    }
+
+    // Every texel skipped leaves the max untouched
+    std::vector<float> sky(1000, 1.0f);
+    float minDepth = 1.0f, maxDepth = -1.0f;
+    ReduceRawDepthRange(sky.data(), sky.size(), minDepth, maxDepth);
+    Check_(minDepth == 1.0f);
+    Check_(maxDepth == -1.0f);
+}
+
+// Returns the fastest of NumRuns runs, in milliseconds
+template<typename T> static double TimeBest(T func)
+{
+    double best = 1e30;
+    for(uint32_t run = 0; run < NumRuns; ++run)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        func();
+        const auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return best;
+}
+
+static void BenchmarkResolution(const char* name, uint32_t width, uint32_t height, uint32_t numThreads)
+{
+    const uint64_t numTexels = uint64_t(width) * height;
+    const std::vector<float> texels = MakeDepthBuffer(numTexels, width);
+    const double numBytes = double(numTexels) * sizeof(float);
+
+    float expectedMin = 1.0f, expectedMax = -1.0f;
+    float minDepth = 1.0f, maxDepth = -1.0f;
+    const double scalarTime = TimeBest([&]() { ReduceScalar(texels.data(), numTexels, expectedMin, expectedMax); });
+    const double sseTime = TimeBest([&]() { ReduceRawDepthRange(texels.data(), numTexels, minDepth, maxDepth); });
+    Check_(minDepth == expectedMin && maxDepth == expectedMax);
+
+    minDepth = 1.0f, maxDepth = -1.0f;
+    const double mtTime = TimeBest([&]() { ReduceMultithreaded(texels.data(), numTexels, numThreads, minDepth, maxDepth); });
+    Check_(minDepth == expectedMin && maxDepth == expectedMax);
+
+    printf("%-5s %4ux%-4u  scalar %7.3f ms (%5.1f GB/s)  SSE %7.3f ms (%5.1f GB/s)  SSE on %u thread(s) %7.3f ms (%5.1f GB/s)\n",
+           name, width, height, scalarTime, numBytes / (scalarTime * 1e6), sseTime, numBytes / (sseTime * 1e6),
+           numThreads, mtTime, numBytes / (mtTime * 1e6));
+}
+
+int main()
+{
+    TestMatchesScalar();
+
+    const uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    BenchmarkResolution("1080p", 1920, 1080, numThreads);
+    BenchmarkResolution("4K", 3840, 2160, numThreads);
+    BenchmarkResolution("8K", 7680, 4320, numThreads);
+
+    return TestResult("DepthReductionBenchmark");
+}
@@ -0,0 +1,191 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// Builds draw lists for a synthetic scene, runs them through NullDrawBackend before and after
+// sorting, and reports how many state changes the sort saves
+
+#include "TestUtils.h"
+
+#include <Graphics/DrawList.h>
+
+#include <string.h>
+#include <random>
+
+using namespace SampleFramework11;
+
+static const uint32_t NumShaders = 2;
+static const uint32_t NumMeshes = 64;
+static const uint32_t NumMaterials = 24;
+static const uint32_t NumPackets = 4096;
+
+// Stand-ins for the backend objects, the list only compares their addresses
+static uint8_t shaders[NumShaders * 2];
+static uint8_t meshBuffers[NumMeshes * 3];
+static uint8_t materialSRVs[NumMaterials * 2];
+static uint8_t shadowMapSRV;
+
+static DrawPacket MakePacket(uint32_t shaderIdx, uint32_t meshIdx, uint32_t materialIdx, uint32_t depth, uint32_t id)
+{
+    DrawPacket packet;
+    packet.SortKey = MakeDrawSortKey(shaderIdx, meshIdx, materialIdx, depth);
+    packet.VS = &shaders[shaderIdx * 2 + 0];
+    packet.PS = &shaders[shaderIdx * 2 + 1];
+    packet.InputLayout = &meshBuffers[meshIdx * 3 + 0];
+    packet.VertexBuffer = &meshBuffers[meshIdx * 3 + 1];
+    packet.IndexBuffer = &meshBuffers[meshIdx * 3 + 2];
+    packet.VertexStride = shaderIdx == 0 ? 56 : 24;
+    packet.IndexSize = meshIdx % 2 == 0 ? 2 : 4;
+    packet.PSSRVs[0] = &materialSRVs[materialIdx * 2 + 0];
+    packet.PSSRVs[1] = &materialSRVs[materialIdx * 2 + 1];
+    packet.PSSRVs[2] = &shadowMapSRV;
+    packet.NumPSSRVs = 3;
+
+    // Used to identify the packet after sorting
+    packet.IndexStart = id;
+    packet.IndexCount = 3;
+    return packet;
+}
+
+static void PrintStats(const char* name, const DrawStats& stats)
+{
+    printf("%-9s %llu draws, %llu state changes (shaders %llu, input layouts %llu, vertex buffers %llu, "
+           "index buffers %llu, SRVs %llu, constants %llu)\n", name,
+           (unsigned long long)stats.NumDraws, (unsigned long long)stats.NumStateChanges(),
+           (unsigned long long)stats.NumShaderChanges, (unsigned long long)stats.NumInputLayoutChanges,
+           (unsigned long long)stats.NumVertexBufferChanges, (unsigned long long)stats.NumIndexBufferChanges,
+           (unsigned long long)stats.NumSRVChanges, (unsigned long long)stats.NumConstantUpdates);
+}
+
+// Packets in random order, like a scene that's walked in the order that its meshes were loaded
+static void TestSceneBatching()
+{
+    std::mt19937 rng(1234);
+
+    DrawList list;
+    for(uint32_t i = 0; i < NumPackets; ++i)
+    {
+        const uint32_t meshIdx = rng() % NumMeshes;
+        const uint32_t shaderIdx = meshIdx % NumShaders;
+        const uint32_t materialIdx = rng() % NumMaterials;
+        list.AddPacket(MakePacket(shaderIdx, meshIdx, materialIdx, rng() & 0xFFFFFF, i));
+    }
+
+    NullDrawBackend unsortedBackend;
+    list.Submit(unsortedBackend);
+
+    list.Sort();
+
+    NullDrawBackend sortedBackend;
+    list.Submit(sortedBackend);
+
+    PrintStats("Unsorted:", unsortedBackend.Stats);
+    PrintStats("Sorted:", sortedBackend.Stats);
+
+    Check_(unsortedBackend.Stats.NumDraws == NumPackets);
+    Check_(sortedBackend.Stats.NumDraws == NumPackets);
+
+    // Every shader, mesh and material combination only needs to be bound once after sorting
+    Check_(sortedBackend.Stats.NumShaderChanges == NumShaders);
+    Check_(sortedBackend.Stats.NumVertexBufferChanges == NumMeshes);
+    Check_(sortedBackend.Stats.NumSRVChanges <= NumMeshes * NumMaterials);
+    Check_(sortedBackend.Stats.NumStateChanges() < unsortedBackend.Stats.NumStateChanges() / 4);
+
+    // Sorted by key, with every packet still in the list exactly once
+    std::vector<bool> seen(NumPackets, false);
+    for(uint64_t i = 0; i < list.NumPackets(); ++i)
+    {
+        const DrawPacket& packet = list.Packet(i);
+        if(i > 0)
+            Check_(list.Packet(i - 1).SortKey <= packet.SortKey);
+
+        Check_(seen[packet.IndexStart] == false);
+        seen[packet.IndexStart] = true;
+    }
+}
+
+// Packets with equal keys have to keep the order that they were added in
+static void TestStableSort()
+{
+    DrawList list;
+    for(uint32_t i = 0; i < 1000; ++i)
+        list.AddPacket(MakePacket(0, (999 - i) % 7, 0, 0, i));
+
+    list.Sort();
+
+    for(uint64_t i = 1; i < list.NumPackets(); ++i)
+    {
+        const DrawPacket& prev = list.Packet(i - 1);
+        const DrawPacket& packet = list.Packet(i);
+        Check_(prev.SortKey <= packet.SortKey);
+        if(prev.SortKey == packet.SortKey)
+            Check_(prev.IndexStart < packet.IndexStart);
+    }
+}
+
+// Records the constants that reach the backend, to check that they're filtered and copied correctly
+class ConstantsBackend : public NullDrawBackend
+{
+
+public:
+
+    std::vector<float> Values;
+
+    virtual void SetConstants(const void* data, uint32_t size) override
+    {
+        float value = 0.0f;
+        Check_(size == sizeof(value));
+        memcpy(&value, data, sizeof(value));
+        Values.push_back(value);
+    }
+};
+
+static void TestRedundantStateFiltering()
+{
+    DrawList list;
+
+    const float scales[2] = { 1.5f, 4.0f };
+    const uint32_t offsets[2] = { list.AddConstants(&scales[0], sizeof(float)),
+                                  list.AddConstants(&scales[1], sizeof(float)) };
+    Check_(offsets[0] % 16 == 0 && offsets[1] % 16 == 0);
+
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        DrawPacket packet = MakePacket(1, 3, 5, 0, i);
+        packet.ConstantsOffset = offsets[i / 4];
+        packet.ConstantsSize = sizeof(float);
+        list.AddPacket(packet);
+    }
+
+    ConstantsBackend backend;
+    list.Submit(backend);
+
+    Check_(backend.Stats.NumDraws == 8);
+    Check_(backend.Stats.NumShaderChanges == 1);
+    Check_(backend.Stats.NumInputLayoutChanges == 1);
+    Check_(backend.Stats.NumVertexBufferChanges == 1);
+    Check_(backend.Stats.NumIndexBufferChanges == 1);
+    Check_(backend.Stats.NumSRVChanges == 1);
+    Check_(backend.Stats.NumConstantUpdates == 2);
+    Check_(backend.Values.size() == 2 && backend.Values[0] == scales[0] && backend.Values[1] == scales[1]);
+
+    // Reset leaves an empty list that doesn't submit anything
+    list.Reset();
+    NullDrawBackend emptyBackend;
+    list.Submit(emptyBackend);
+    Check_(list.NumPackets() == 0 && emptyBackend.Stats.NumDraws == 0);
+}
+
+int main()
+{
+    TestSceneBatching();
+    TestStableSort();
+    TestRedundantStateFiltering();
+
+    return TestResult("DrawListTests");
+}
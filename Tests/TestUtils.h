@@ -0,0 +1,40 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+// Minimal checking helpers for the standalone test programs. A failed check prints where it
+// happened and makes the program return a non-zero exit code, which is what CTest looks at.
+
+#include <stdio.h>
+
+static int NumFailedChecks = 0;
+
+#define Check_(x) CheckImpl(x, #x, __FILE__, __LINE__)
+
+inline bool CheckImpl(bool result, const char* expression, const char* file, int line)
+{
+    if(result == false)
+    {
+        printf("%s(%d): check failed: %s\n", file, line, expression);
+        ++NumFailedChecks;
+    }
+
+    return result;
+}
+
+inline int TestResult(const char* testName)
+{
+    if(NumFailedChecks > 0)
+        printf("%s: %d check(s) failed\n", testName, NumFailedChecks);
+    else
+        printf("%s: all checks passed\n", testName);
+
+    return NumFailedChecks > 0 ? 1 : 0;
+}
@@ -0,0 +1,233 @@
+//=================================================================================================
+//
+//  MJP's DX11 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+// Round-trips values through the compressed vertex encodings, and checks the quantization bounds,
+// the sign handling and the worst-case error against the limits that the format is meant to hit
+
+#include "TestUtils.h"
+
+#include <Graphics/VertexCompression.h>
+
+#include <math.h>
+#include <random>
+
+using namespace SampleFramework11;
+
+static const float Pi = 3.14159265f;
+
+// Limits for the angle between an encoded vector and the original one, in degrees
+static const float MaxOctahedralError = 0.001f;
+static const float MaxNormalError = 0.005f;
+static const float MaxTangentError = 0.008f;
+
+static float AngleBetween(const float a[3], const float b[3])
+{
+    const float lengthA = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    const float lengthB = sqrtf(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+    const float cosAngle = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / (lengthA * lengthB);
+
+    // acos loses too much precision for tiny angles, so use the length of the cross product
+    const float cross[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    const float sinAngle = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) / (lengthA * lengthB);
+    return atan2f(sinAngle, cosAngle) * 180.0f / Pi;
+}
+
+// The axes, the diagonals and vectors right next to the equator are where the octahedral fold
+// and the sign handling are most likely to go wrong. The rest are spread over the sphere.
+static std::vector<float> MakeTestVectors()
+{
+    std::vector<float> vectors;
+    const float tiny = 1e-6f;
+    const float special[][3] =
+    {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 1.0f, 1.0f }, { -1.0f, -1.0f, -1.0f },
+        { 1.0f, -1.0f, -1.0f }, { -1.0f, 1.0f, -1.0f }, { 1.0f, 1.0f, -tiny }, { -1.0f, 1.0f, tiny },
+        { 1.0f, -tiny, -tiny }, { tiny, -1.0f, -tiny }, { -tiny, tiny, -1.0f }, { 0.0f, -0.0f, -1.0f },
+    };
+
+    for(const float* v : special)
+        vectors.insert(vectors.end(), v, v + 3);
+
+    std::mt19937 rng(34);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    for(uint32_t i = 0; i < 200000; ++i)
+    {
+        float z = uniform(rng);
+        float phi = uniform(rng) * Pi;
+        float r = sqrtf(std::max(1.0f - z * z, 0.0f));
+        vectors.push_back(r * cosf(phi));
+        vectors.push_back(r * sinf(phi));
+        vectors.push_back(z);
+    }
+
+    for(uint64_t i = 0; i < vectors.size(); i += 3)
+    {
+        float* v = &vectors[i];
+        const float invLength = 1.0f / sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        v[0] *= invLength;
+        v[1] *= invLength;
+        v[2] *= invLength;
+    }
+
+    return vectors;
+}
+
+// Decoded components can only lose their sign when they're within the error of zero
+static bool SignsMatch(const float original[3], const float decoded[3], float maxError)
+{
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        if(fabsf(original[i]) > maxError && (original[i] < 0.0f) != (decoded[i] < 0.0f))
+            return false;
+    }
+
+    return true;
+}
+
+static void TestUNorm16()
+{
+    Check_(QuantizeUNorm16(0.0f) == 0);
+    Check_(QuantizeUNorm16(1.0f) == 65535);
+    Check_(QuantizeUNorm16(-0.5f) == 0);
+    Check_(QuantizeUNorm16(2.0f) == 65535);
+    Check_(DequantizeUNorm16(0) == 0.0f);
+    Check_(DequantizeUNorm16(65535) == 1.0f);
+
+    float maxError = 0.0f;
+    for(uint32_t i = 0; i <= 1000000; ++i)
+    {
+        const float x = i / 1000000.0f;
+        maxError = std::max(maxError, fabsf(DequantizeUNorm16(QuantizeUNorm16(x)) - x));
+    }
+
+    // Rounding to the nearest step is off by at most half a step
+    Check_(maxError <= 0.5f / 65535.0f + 1e-7f);
+
+    for(uint32_t x = 0; x <= 65535; ++x)
+        Check_(QuantizeUNorm16(DequantizeUNorm16(uint16_t(x))) == x);
+}
+
+static void TestSNorm16()
+{
+    Check_(QuantizeSNorm16(0.0f) == 0);
+    Check_(QuantizeSNorm16(-0.0f) == 0);
+    Check_(QuantizeSNorm16(1.0f) == 32767);
+    Check_(QuantizeSNorm16(-1.0f) == -32767);
+    Check_(QuantizeSNorm16(3.0f) == 32767);
+    Check_(QuantizeSNorm16(-3.0f) == -32767);
+
+    // -32768 isn't written by the encoder, but it has to decode to -1 like it does on the GPU
+    Check_(DequantizeSNorm16(-32768) == -1.0f);
+    Check_(DequantizeSNorm16(-32767) == -1.0f);
+    Check_(DequantizeSNorm16(32767) == 1.0f);
+
+    float maxError = 0.0f;
+    for(int32_t i = -1000000; i <= 1000000; ++i)
+    {
+        const float x = i / 1000000.0f;
+        const int16_t quantized = QuantizeSNorm16(x);
+
+        // Rounding is symmetric around zero, so flipping the sign flips the result
+        Check_(QuantizeSNorm16(-x) == -quantized);
+        maxError = std::max(maxError, fabsf(DequantizeSNorm16(quantized) - x));
+    }
+
+    Check_(maxError <= 0.5f / 32767.0f + 1e-7f);
+
+    for(int32_t x = -32767; x <= 32767; ++x)
+        Check_(QuantizeSNorm16(DequantizeSNorm16(int16_t(x))) == x);
+}
+
+static void TestOctahedral(const std::vector<float>& vectors)
+{
+    // A zero vector encodes to the center instead of dividing by zero
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    float e[2] = { 1.0f, 1.0f };
+    EncodeOctahedral(zero, e);
+    Check_(e[0] == 0.0f && e[1] == 0.0f);
+
+    float maxError = 0.0f;
+    float maxQuantizedError = 0.0f;
+    uint32_t numBadSigns = 0;
+    for(uint64_t i = 0; i < vectors.size(); i += 3)
+    {
+        const float* n = &vectors[i];
+        EncodeOctahedral(n, e);
+        Check_(fabsf(e[0]) <= 1.0f && fabsf(e[1]) <= 1.0f);
+
+        float decoded[3];
+        DecodeOctahedral(e, decoded);
+        maxError = std::max(maxError, AngleBetween(n, decoded));
+        numBadSigns += SignsMatch(n, decoded, 1e-5f) ? 0 : 1;
+
+        // Normals are stored as 2 SNORM16 values, see Mesh::CompressVertices
+        const float quantized[2] = { DequantizeSNorm16(QuantizeSNorm16(e[0])), DequantizeSNorm16(QuantizeSNorm16(e[1])) };
+        DecodeOctahedral(quantized, decoded);
+        maxQuantizedError = std::max(maxQuantizedError, AngleBetween(n, decoded));
+        numBadSigns += SignsMatch(n, decoded, 1e-3f) ? 0 : 1;
+    }
+
+    printf("Octahedral normals: max error %.5f degrees unquantized, %.5f degrees as SNORM16\n", maxError,
+           maxQuantizedError);
+
+    Check_(maxError <= MaxOctahedralError);
+    Check_(maxQuantizedError <= MaxNormalError);
+    Check_(numBadSigns == 0);
+}
+
+static void TestTangents(const std::vector<float>& vectors)
+{
+    float maxError = 0.0f;
+    uint32_t numBadSigns = 0;
+    uint32_t numBadBitangentSigns = 0;
+    for(uint64_t i = 0; i < vectors.size(); i += 3)
+    {
+        const float* tangent = &vectors[i];
+        const float bitangentSign = (i / 3) % 2 == 0 ? 1.0f : -1.0f;
+
+        uint16_t packed[2];
+        PackTangent(tangent, bitangentSign, packed);
+
+        float decoded[3];
+        float decodedSign = 0.0f;
+        UnpackTangent(packed, decoded, decodedSign);
+
+        maxError = std::max(maxError, AngleBetween(tangent, decoded));
+        numBadSigns += SignsMatch(tangent, decoded, 1e-3f) ? 0 : 1;
+        numBadBitangentSigns += decodedSign == bitangentSign ? 0 : 1;
+    }
+
+    printf("Packed tangents: max error %.5f degrees\n", maxError);
+
+    Check_(maxError <= MaxTangentError);
+    Check_(numBadSigns == 0);
+    Check_(numBadBitangentSigns == 0);
+
+    // A zero sign counts as positive
+    const float tangent[3] = { 0.0f, 1.0f, 0.0f };
+    uint16_t packed[2];
+    float decoded[3];
+    float decodedSign = 0.0f;
+    PackTangent(tangent, 0.0f, packed);
+    UnpackTangent(packed, decoded, decodedSign);
+    Check_(decodedSign == 1.0f);
+}
+
+int main()
+{
+    const std::vector<float> vectors = MakeTestVectors();
+
+    TestUNorm16();
+    TestSNorm16();
+    TestOctahedral(vectors);
+    TestTangents(vectors);
+
+    return TestResult("VertexCompressionTests");
+}